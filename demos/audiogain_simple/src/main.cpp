@@ -0,0 +1,413 @@
+﻿#include "dp/cli.h"
+#include "dp/common/primitives.h"
+#include "dp/audio/audioformat.h"
+
+#include "gain.h"
+#include "ringbuffer.h"
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+const auto  PERIOD_FRAMES = 480;
+const auto  CHANNELS = 2;
+const auto  REPEATS = 100000;
+
+// 読み出しを比べるリングバッファの周期数
+// 折り返しをまたぐ読み出しも含まれるよう、周期の大きさの整数倍にはしない
+const auto  RING_PERIODS = 7;
+
+typedef std::chrono::steady_clock   Clock;
+
+typedef std::function<
+    void (
+        dp::Byte *
+    )
+> Process;
+
+// 1周期分の処理にかかる平均時間をナノ秒で返す
+double measure(
+    const Process & _PROCESS
+    , dp::Byte *    _buffer
+)
+{
+    const auto  BEGIN = Clock::now();
+
+    for( dp::Int i = 0 ; i < REPEATS ; i++ ) {
+        _PROCESS( _buffer );
+    }
+
+    return std::chrono::duration_cast< std::chrono::duration< double, std::nano > >( Clock::now() - BEGIN ).count() / REPEATS;
+}
+
+// 1周期分を書き込んでから_READで読み出す処理の平均時間から、書き込みのみの平均時間を引いてナノ秒で返す
+double measureRingRead(
+    const Process &             _READ
+    , RingBuffer< dp::Byte > &  _ringBuffer
+    , const dp::Byte *          _SOURCE
+    , std::size_t               _size
+    , dp::Byte *                _buffer
+)
+{
+    const auto  WRITE_NANOSECONDS = measure(
+        [
+            &_ringBuffer
+            , _SOURCE
+            , _size
+        ]
+        (
+            dp::Byte *
+        )
+        {
+            _ringBuffer.write(
+                _SOURCE
+                , _size
+            );
+            _ringBuffer.skip( _size );
+        }
+        , _buffer
+    );
+
+    const auto  NANOSECONDS = measure(
+        [
+            &_READ
+            , &_ringBuffer
+            , _SOURCE
+            , _size
+        ]
+        (
+            dp::Byte *  _buffer
+        )
+        {
+            _ringBuffer.write(
+                _SOURCE
+                , _size
+            );
+            _READ( _buffer );
+        }
+        , _buffer
+    );
+
+    return NANOSECONDS - WRITE_NANOSECONDS;
+}
+
+void printResult(
+    const char *    _NAME
+    , double        _nanoseconds
+    , double        _memcpyNanoseconds
+)
+{
+    std::printf( "  %-24s %8.1fns (memcpy比 %.2f倍)\n", _NAME, _nanoseconds, _nanoseconds / _memcpyNanoseconds );
+}
+
+// 48kHzステレオ1周期分のバッファに対して、memcpyと各カーネルの処理時間を比べる
+void benchmark(
+    dp::AudioFormat _audioFormat
+    , const char *  _NAME
+)
+{
+    const auto  SAMPLE_SIZE = _audioFormat == dp::AudioFormat::U8 ? 1 : 2;
+    const auto  SIZE = PERIOD_FRAMES * CHANNELS * SAMPLE_SIZE;
+
+    std::vector< dp::Byte > source( SIZE );
+    for( auto & byte : source ) {
+        byte = static_cast< dp::Byte >( std::rand() );
+    }
+    std::vector< dp::Byte > buffer( source );
+
+    const auto  MEMCPY_NANOSECONDS = measure(
+        [
+            &source
+            , SIZE
+        ]
+        (
+            dp::Byte *  _buffer
+        )
+        {
+            std::memcpy(
+                _buffer
+                , source.data()
+                , SIZE
+            );
+        }
+        , buffer.data()
+    );
+
+    GainStage   constantStage;
+    setGain(
+        constantStage
+        , 0.5f
+        , 0
+    );
+    const auto  CONSTANT_NANOSECONDS = measure(
+        [
+            &constantStage
+            , _audioFormat
+        ]
+        (
+            dp::Byte *  _buffer
+        )
+        {
+            applyGain(
+                constantStage
+                , _audioFormat
+                , CHANNELS
+                , _buffer
+                , PERIOD_FRAMES
+            );
+        }
+        , buffer.data()
+    );
+
+    const auto  RAMP_NANOSECONDS = measure(
+        [
+            _audioFormat
+        ]
+        (
+            dp::Byte *  _buffer
+        )
+        {
+            applyGainRamp(
+                _audioFormat
+                , CHANNELS
+                , _buffer
+                , PERIOD_FRAMES
+                , 1
+                , -1.0f / PERIOD_FRAMES
+            );
+        }
+        , buffer.data()
+    );
+
+    std::vector< dp::Byte > mixBuffer( source );
+    const auto  ADD_NANOSECONDS = measure(
+        [
+            &source
+            , _audioFormat
+        ]
+        (
+            dp::Byte *  _buffer
+        )
+        {
+            addAudio(
+                _audioFormat
+                , _buffer
+                , source.data()
+                , PERIOD_FRAMES * CHANNELS
+            );
+        }
+        , mixBuffer.data()
+    );
+
+    std::printf( "%s (%dフレーム、%dチャンネル)\n", _NAME, PERIOD_FRAMES, CHANNELS );
+    printResult(
+        "memcpy"
+        , MEMCPY_NANOSECONDS
+        , MEMCPY_NANOSECONDS
+    );
+    printResult(
+        "一定のゲイン(固定小数点)"
+        , CONSTANT_NANOSECONDS
+        , MEMCPY_NANOSECONDS
+    );
+    printResult(
+        "フェード(浮動小数点)"
+        , RAMP_NANOSECONDS
+        , MEMCPY_NANOSECONDS
+    );
+    printResult(
+        "クロスフェードの加算"
+        , ADD_NANOSECONDS
+        , MEMCPY_NANOSECONDS
+    );
+}
+
+// 再生コールバックでのトラックのリングバッファからの読み出しを想定し、
+// memcpyのみの読み出し、読み出した後にゲインをかける場合、読み出しと同時にゲインをかける場合を比べる
+void benchmarkRingRead(
+    dp::AudioFormat _audioFormat
+    , const char *  _NAME
+)
+{
+    const auto  SAMPLE_SIZE = _audioFormat == dp::AudioFormat::U8 ? 1 : 2;
+    const auto  FRAME_SIZE = CHANNELS * SAMPLE_SIZE;
+    const auto  SIZE = PERIOD_FRAMES * FRAME_SIZE;
+
+    std::vector< dp::Byte > source( SIZE );
+    for( auto & byte : source ) {
+        byte = static_cast< dp::Byte >( std::rand() );
+    }
+    std::vector< dp::Byte > buffer( SIZE );
+
+    RingBuffer< dp::Byte >  ringBuffer( SIZE * RING_PERIODS );
+
+    const auto  READ_NANOSECONDS = measureRingRead(
+        [
+            &ringBuffer
+            , SIZE
+        ]
+        (
+            dp::Byte *  _buffer
+        )
+        {
+            ringBuffer.read(
+                _buffer
+                , SIZE
+            );
+        }
+        , ringBuffer
+        , source.data()
+        , SIZE
+        , buffer.data()
+    );
+
+    // 一定のゲインと、計測中に終わらない長さのフェードのそれぞれで比べる
+    const dp::Float GAINS[] = {
+        0.5f,
+        0.0f,
+    };
+    const dp::UInt  RAMP_FRAMES[] = {
+        0,
+        static_cast< dp::UInt >( -1 ),
+    };
+    const char *    LABELS[] = {
+        "一定のゲイン",
+        "フェード",
+    };
+
+    std::printf( "%s リングバッファからの読み出し\n", _NAME );
+    printResult(
+        "memcpy"
+        , READ_NANOSECONDS
+        , READ_NANOSECONDS
+    );
+
+    for( dp::UInt i = 0 ; i < 2 ; i++ ) {
+        GainStage   separateStage;
+        setGain(
+            separateStage
+            , GAINS[ i ]
+            , RAMP_FRAMES[ i ]
+        );
+        const auto  SEPARATE_NANOSECONDS = measureRingRead(
+            [
+                &ringBuffer
+                , &separateStage
+                , _audioFormat
+                , SIZE
+            ]
+            (
+                dp::Byte *  _buffer
+            )
+            {
+                ringBuffer.read(
+                    _buffer
+                    , SIZE
+                );
+                applyGain(
+                    separateStage
+                    , _audioFormat
+                    , CHANNELS
+                    , _buffer
+                    , PERIOD_FRAMES
+                );
+            }
+            , ringBuffer
+            , source.data()
+            , SIZE
+            , buffer.data()
+        );
+
+        // 周期の大きさはフレームの整数倍のため、折り返しでフレームが分かれることはない
+        GainStage   fusedStage;
+        setGain(
+            fusedStage
+            , GAINS[ i ]
+            , RAMP_FRAMES[ i ]
+        );
+        const auto  FUSED_NANOSECONDS = measureRingRead(
+            [
+                &ringBuffer
+                , &fusedStage
+                , _audioFormat
+                , FRAME_SIZE
+                , SIZE
+            ]
+            (
+                dp::Byte *  _buffer
+            )
+            {
+                ringBuffer.read(
+                    _buffer
+                    , SIZE
+                    , [
+                        &fusedStage
+                        , _audioFormat
+                        , FRAME_SIZE
+                    ]
+                    (
+                        dp::Byte *          _destination
+                        , const dp::Byte *  _SOURCE
+                        , std::size_t       _count
+                    )
+                    {
+                        applyGain(
+                            fusedStage
+                            , _audioFormat
+                            , CHANNELS
+                            , _destination
+                            , _SOURCE
+                            , _count / FRAME_SIZE
+                        );
+                    }
+                );
+            }
+            , ringBuffer
+            , source.data()
+            , SIZE
+            , buffer.data()
+        );
+
+        const auto  SEPARATE_LABEL = std::string( LABELS[ i ] ) + "(読み出し後)";
+        const auto  FUSED_LABEL = std::string( LABELS[ i ] ) + "(読み出しと同時)";
+        printResult(
+            SEPARATE_LABEL.c_str()
+            , SEPARATE_NANOSECONDS
+            , READ_NANOSECONDS
+        );
+        printResult(
+            FUSED_LABEL.c_str()
+            , FUSED_NANOSECONDS
+            , READ_NANOSECONDS
+        );
+    }
+}
+
+dp::Int dpMain(
+    dp::Args &
+)
+{
+    benchmark(
+        dp::AudioFormat::U8
+        , "U8"
+    );
+    benchmark(
+        dp::AudioFormat::S16LE
+        , "S16LE"
+    );
+
+    benchmarkRingRead(
+        dp::AudioFormat::U8
+        , "U8"
+    );
+    benchmarkRingRead(
+        dp::AudioFormat::S16LE
+        , "S16LE"
+    );
+
+    return 0;
+}
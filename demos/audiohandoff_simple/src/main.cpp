@@ -0,0 +1,336 @@
+﻿#include "dp/cli.h"
+#include "dp/common/primitives.h"
+#include "dp/common/stringconverter.h"
+#include "dp/audio/audioformat.h"
+
+#include "audiooutput.h"
+#include "realtimecheck.h"
+#include "option.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+const auto  SAMPLE_RATE = 48000;
+const auto  DEFAULT_SECONDS = 10;
+const auto  RUNS = 3;
+
+const dp::UInt  DEFAULT_CHANNELS[] = {
+    2,
+    8,
+    32,
+    64,
+};
+
+DEFINE_REALTIME_ALLOCATION_CHECK
+
+typedef std::chrono::steady_clock   Clock;
+
+// 出力先での波形データの読み込みとして、8バイト単位の和を求める
+// NULL_FASTは波形データを読まずに破棄するため、これがないとコピーの有無による差を測れない
+std::uint64_t addChecksum(
+    std::uint64_t   _checksum
+    , const void *  _DATA
+    , dp::ULong     _size
+)
+{
+    const auto  DATA = static_cast< const dp::Byte * >( _DATA );
+
+    dp::ULong   i = 0;
+    for( ; i + sizeof( std::uint64_t ) <= _size ; i += sizeof( std::uint64_t ) ) {
+        std::uint64_t   value;
+        std::memcpy(
+            &value
+            , DATA + i
+            , sizeof( value )
+        );
+
+        _checksum += value;
+    }
+
+    for( ; i < _size ; i++ ) {
+        _checksum += DATA[ i ];
+    }
+
+    return _checksum;
+}
+
+// メモリ上に展開済みの波形データを、先頭から順に出力先へ渡す
+// _handOffがtrueならsetPlayDataEventHandler()で領域を直接渡し、falseなら従来どおりバッファへコピーする
+// 出力された波形データは全て読み込み、_checksumにaddChecksum()の結果を格納する
+// 出力の開始から終了までの時間を返す
+Clock::duration render(
+    const std::vector< dp::Byte > & _SOURCE
+    , dp::UInt                      _channels
+    , dp::Bool                      _handOff
+    , std::uint64_t &               _checksum
+)
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    dp::Bool                ended = false;
+
+    AudioOutputKey  key;
+    key.type = AudioOutputType::NULL_FAST;
+
+    AudioOutputInfo info;
+
+    setEndEventHandler(
+        info
+        , [
+            &mutex
+            , &cond
+            , &ended
+        ]
+        (
+            AudioOutput &
+        )
+        {
+            std::unique_lock< std::mutex >  lock( mutex );
+
+            ended = true;
+
+            cond.notify_one();
+        }
+    );
+
+    _checksum = 0;
+    setPresentEventHandler(
+        info
+        , [
+            &_checksum
+        ]
+        (
+            AudioOutput &
+            , const void *  _DATA
+            , dp::ULong     _size
+        )
+        {
+            _checksum = addChecksum(
+                _checksum
+                , _DATA
+                , _size
+            );
+        }
+    );
+
+    dp::ULong   offset = 0;
+    if( _handOff ) {
+        setPlayDataEventHandler(
+            info
+            , [
+                &_SOURCE
+                , &offset
+            ]
+            (
+                AudioOutput &
+                , const void * &    _data
+                , dp::ULong         _bufferSize
+            ) -> dp::ULong
+            {
+                RealtimeScope   realtimeScope;
+
+                const auto  SIZE = std::min(
+                    _bufferSize
+                    , static_cast< dp::ULong >( _SOURCE.size() - offset )
+                );
+
+                _data = _SOURCE.data() + offset;
+                offset += SIZE;
+
+                return SIZE;
+            }
+        );
+    } else {
+        setPlayEventHandler(
+            info
+            , [
+                &_SOURCE
+                , &offset
+            ]
+            (
+                AudioOutput &
+                , void *            _buffer
+                , dp::ULong         _bufferSize
+            ) -> dp::ULong
+            {
+                RealtimeScope   realtimeScope;
+
+                const auto  SIZE = std::min(
+                    _bufferSize
+                    , static_cast< dp::ULong >( _SOURCE.size() - offset )
+                );
+
+                std::memcpy(
+                    _buffer
+                    , _SOURCE.data() + offset
+                    , SIZE
+                );
+                offset += SIZE;
+
+                return SIZE;
+            }
+        );
+    }
+
+    const auto  BEGIN = Clock::now();
+
+    std::unique_ptr< AudioOutput >  outputUnique(
+        newAudioOutput(
+            key
+            , info
+            , dp::AudioFormat::S16LE
+            , SAMPLE_RATE
+            , _channels
+        )
+    );
+    if( outputUnique.get() == nullptr ) {
+        std::printf( "出力の開始に失敗\n" );
+
+        return Clock::duration::zero();
+    }
+
+    std::unique_lock< std::mutex >  lock( mutex );
+
+    cond.wait(
+        lock
+        , [
+            &ended
+        ]
+        {
+            return ended;
+        }
+    );
+
+    return Clock::now() - BEGIN;
+}
+
+// 受け渡し方ごとにRUNS回出力し、最短の時間を採用する
+void benchmark(
+    dp::UInt    _channels
+    , dp::UInt  _seconds
+)
+{
+    std::vector< dp::Byte > source( static_cast< std::size_t >( SAMPLE_RATE ) * _seconds * _channels * sizeof( std::int16_t ) );
+    for( auto & byte : source ) {
+        byte = static_cast< dp::Byte >( std::rand() );
+    }
+
+    const auto  SOURCE_CHECKSUM = addChecksum(
+        0
+        , source.data()
+        , source.size()
+    );
+
+    auto        copyElapsed = Clock::duration::max();
+    auto        handOffElapsed = Clock::duration::max();
+    dp::Bool    mismatched = false;
+    for( dp::UInt i = 0 ; i < RUNS ; i++ ) {
+        std::uint64_t   checksum;
+
+        copyElapsed = std::min(
+            copyElapsed
+            , render(
+                source
+                , _channels
+                , false
+                , checksum
+            )
+        );
+        mismatched = mismatched || checksum != SOURCE_CHECKSUM;
+
+        handOffElapsed = std::min(
+            handOffElapsed
+            , render(
+                source
+                , _channels
+                , true
+                , checksum
+            )
+        );
+        mismatched = mismatched || checksum != SOURCE_CHECKSUM;
+    }
+
+    const auto  COPY_SECONDS = std::chrono::duration_cast< std::chrono::duration< double > >( copyElapsed ).count();
+    const auto  HAND_OFF_SECONDS = std::chrono::duration_cast< std::chrono::duration< double > >( handOffElapsed ).count();
+    const auto  SOURCE_MEGABYTES = source.size() / ( 1024.0 * 1024.0 );
+
+    // コピーは読み込みと書き込みで波形データの2倍の転送を伴う
+    const auto  REALTIME_SAVED_MEGABYTES = 2.0 * SAMPLE_RATE * _channels * sizeof( std::int16_t ) / ( 1024.0 * 1024.0 );
+
+    std::printf( "%uチャンネル (%.1fMB):\n", _channels, SOURCE_MEGABYTES );
+    std::printf( "  コピー: %.2fms (%.0fMB/s)\n", COPY_SECONDS * 1000, SOURCE_MEGABYTES / COPY_SECONDS );
+    std::printf( "  受け渡し: %.2fms (%.0fMB/s)\n", HAND_OFF_SECONDS * 1000, SOURCE_MEGABYTES / HAND_OFF_SECONDS );
+    std::printf( "  削減した時間: %.2fms (%.1f%%)\n", ( COPY_SECONDS - HAND_OFF_SECONDS ) * 1000, ( 1 - HAND_OFF_SECONDS / COPY_SECONDS ) * 100 );
+    std::printf( "  仮想スピーカーの実時間再生で削減されるメモリ転送量: %.2fMB/s\n", REALTIME_SAVED_MEGABYTES );
+    if( mismatched ) {
+        std::printf( "  出力された波形データのチェックサムが不一致\n" );
+    }
+}
+
+dp::Int dpMain(
+    dp::Args &  _args
+)
+{
+    std::vector< dp::UInt > channelCounts;
+    dp::UInt                seconds = DEFAULT_SECONDS;
+
+    for( std::size_t i = 1 ; i < _args.size() ; i++ ) {
+        dp::String  name;
+        dp::UInt    value;
+        if( parseValueOption(
+            _args[ i ]
+            , name
+            , value
+        ) ) {
+            if( name == "--channels" && value > 0 ) {
+                channelCounts.push_back( value );
+
+                continue;
+            } else if( name == "--seconds" && value > 0 ) {
+                seconds = value;
+
+                continue;
+            }
+        }
+
+        dp::String  command;
+        dp::toString(
+            command
+            , _args[ 0 ]
+        );
+
+        std::printf( "使い方: %s [--channels=チャンネル数...] [--seconds=秒]\n", command.c_str() );
+
+        return 1;
+    }
+
+    if( channelCounts.empty() ) {
+        channelCounts.assign(
+            std::begin( DEFAULT_CHANNELS )
+            , std::end( DEFAULT_CHANNELS )
+        );
+    }
+
+    std::printf( "S16LE %uHz %u秒分を、実時間の制約がない出力先へ渡し、出力先で全て読み込んでチェックサムを求める\n", SAMPLE_RATE, seconds );
+    std::printf( "実スピーカーはdp::AudioPlayerのバッファへの書き込みが必要なため、受け渡しでもコピーは削減されない\n" );
+
+    for( const auto & CHANNELS : channelCounts ) {
+        benchmark(
+            CHANNELS
+            , seconds
+        );
+    }
+
+    printRealtimeCheck();
+
+    return 0;
+}
@@ -0,0 +1,518 @@
+﻿#include "dp/cli.h"
+#include "dp/common/primitives.h"
+#include "dp/common/stringconverter.h"
+#include "dp/audio/audioformat.h"
+#include "dp/common/thread.h"
+
+#include "audiooutput.h"
+#include "ringbuffer.h"
+#include "realtimecheck.h"
+#include "option.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+const auto  SAMPLE_RATE = 48000;
+const auto  FRAME_SIZE = sizeof( std::int16_t );
+const std::int16_t  IMPULSE = 0x7fff;
+
+const auto  EVENT_INTERVAL_MILLISECONDS = 20;
+const auto  EVENTS = 1024;
+const auto  DEFAULT_SECONDS = 5;
+
+const auto  CLOCK_SAMPLE_MILLISECONDS = 2;
+
+DEFINE_REALTIME_ALLOCATION_CHECK
+
+typedef std::chrono::steady_clock   Clock;
+
+// 入力イベントの発生時刻を、再生コールバックを経て出力までの間受け渡す
+struct LatencyProbe
+{
+    RingBuffer< dp::Long >  pendingEvents;     // イベントスレッド→再生コールバック
+    RingBuffer< dp::Long >  renderedEvents;    // 再生コールバック→出力イベント
+
+    dp::ULong               renderedFrames;
+    dp::ULong               maxFrames;
+    std::atomic< dp::ULong > droppedEvents;
+
+    std::vector< double >   latencies;
+
+    // 出力開始を予約した場合、予約したフレームが実際に出力された時刻を求める
+    std::atomic< dp::ULong >    startFrame;
+    std::atomic< dp::Long >     startNanoseconds;
+    dp::ULong                   presentedFrames;
+
+    explicit LatencyProbe(
+        dp::ULong   _maxFrames
+    )
+        : pendingEvents( EVENTS )
+        , renderedEvents( EVENTS )
+        , renderedFrames( 0 )
+        , maxFrames( _maxFrames )
+        , droppedEvents( 0 )
+        , startFrame( AUDIO_OUTPUT_START_PENDING )
+        , startNanoseconds( 0 )
+        , presentedFrames( 0 )
+    {
+        this->latencies.reserve( EVENTS * 16 );
+    }
+};
+
+typedef std::vector< AudioOutputPosition > AudioOutputPositions;
+
+dp::Long toNanoseconds(
+    const Clock::time_point &   _TIME
+)
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >( _TIME.time_since_epoch() ).count();
+}
+
+// 入力イベントを模して、不定の間隔で発生時刻を送る
+void generateEvents(
+    LatencyProbe &                      _probe
+    , const std::atomic< dp::Bool > &   _STOPPED
+)
+{
+    while( _STOPPED == false ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( EVENT_INTERVAL_MILLISECONDS + std::rand() % EVENT_INTERVAL_MILLISECONDS ) );
+
+        const auto  NOW = toNanoseconds( Clock::now() );
+        if( _probe.pendingEvents.write(
+            &NOW
+            , 1
+        ) <= 0 ) {
+            _probe.droppedEvents++;
+        }
+    }
+}
+
+// 届いたイベントごとにインパルスを1つ書き込む
+dp::ULong renderEvents(
+    LatencyProbe &  _probe
+    , void *        _buffer
+    , dp::ULong     _bufferSize
+)
+{
+    if( _probe.renderedFrames >= _probe.maxFrames ) {
+        return 0;
+    }
+
+    const auto  FRAMES = _bufferSize / FRAME_SIZE;
+    auto        samples = static_cast< std::int16_t * >( _buffer );
+
+    std::memset(
+        samples
+        , 0
+        , FRAMES * FRAME_SIZE
+    );
+
+    dp::Long    eventTime;
+    for( dp::ULong i = 0 ; i < FRAMES && _probe.pendingEvents.read(
+        &eventTime
+        , 1
+    ) > 0 ; i++ ) {
+        samples[ i ] = IMPULSE;
+
+        _probe.renderedEvents.write(
+            &eventTime
+            , 1
+        );
+    }
+
+    _probe.renderedFrames += FRAMES;
+
+    return FRAMES * FRAME_SIZE;
+}
+
+// 出力されたバッファからインパルスを探し、イベント発生から出力までの時間を求める
+void presentEvents(
+    LatencyProbe &          _probe
+    , const AudioOutput &   _OUTPUT
+    , const void *          _BUFFER
+    , dp::ULong             _bufferSize
+)
+{
+    const auto  NOW = toNanoseconds( Clock::now() );
+    const auto  SAMPLES = static_cast< const std::int16_t * >( _BUFFER );
+    const auto  FRAMES = _bufferSize / FRAME_SIZE;
+
+    const auto  START_FRAME = _probe.startFrame.load();
+    if( START_FRAME >= _probe.presentedFrames && START_FRAME < _probe.presentedFrames + FRAMES ) {
+        _probe.startNanoseconds = NOW + static_cast< dp::Long >( START_FRAME - _probe.presentedFrames ) * 1000000000 / _OUTPUT.sampleRate;
+    }
+    _probe.presentedFrames += FRAMES;
+
+    for( dp::ULong i = 0 ; i < FRAMES ; i++ ) {
+        if( SAMPLES[ i ] != IMPULSE ) {
+            continue;
+        }
+
+        dp::Long    eventTime;
+        if( _probe.renderedEvents.read(
+            &eventTime
+            , 1
+        ) <= 0 ) {
+            break;
+        }
+
+        const auto  PRESENT_TIME = NOW + static_cast< dp::Long >( i ) * 1000000000 / _OUTPUT.sampleRate;
+
+        _probe.latencies.push_back( ( PRESENT_TIME - eventTime ) * 1e-6 );
+    }
+}
+
+void printLatencies(
+    std::vector< double > & _latencies
+)
+{
+    if( _latencies.empty() ) {
+        std::printf( "イベントが出力されなかった\n" );
+
+        return;
+    }
+
+    std::sort(
+        _latencies.begin()
+        , _latencies.end()
+    );
+
+    const auto  LAST = _latencies.size() - 1;
+
+    std::printf( "計測したイベント数: %u\n", static_cast< dp::UInt >( _latencies.size() ) );
+    std::printf(
+        "出力遅延: min=%.2fms p50=%.2fms p99=%.2fms max=%.2fms\n"
+        , _latencies.front()
+        , _latencies[ LAST * 50 / 100 ]
+        , _latencies[ LAST * 99 / 100 ]
+        , _latencies.back()
+    );
+}
+
+// 再生位置を実時間と比べ、ずれの最大値と逆行した回数を表示する
+void printPlaybackClock(
+    const AudioOutputPositions &    _POSITIONS
+)
+{
+    if( _POSITIONS.size() < 2 ) {
+        return;
+    }
+
+    const auto &    FIRST = _POSITIONS.front();
+
+    double      maxError = 0;
+    dp::UInt    backwards = 0;
+    for( std::size_t i = 1 ; i < _POSITIONS.size() ; i++ ) {
+        const auto &    POSITION = _POSITIONS[ i ];
+
+        const auto  FRAME_MILLISECONDS = ( POSITION.frame - FIRST.frame ) * 1000.0 / SAMPLE_RATE;
+        const auto  TIME_MILLISECONDS = std::chrono::duration_cast< std::chrono::duration< double, std::milli > >( POSITION.time - FIRST.time ).count();
+
+        maxError = std::max(
+            maxError
+            , std::abs( FRAME_MILLISECONDS - TIME_MILLISECONDS )
+        );
+
+        if( POSITION.frame < _POSITIONS[ i - 1 ].frame ) {
+            backwards++;
+        }
+    }
+
+    std::printf( "再生位置の取得回数: %u\n", static_cast< dp::UInt >( _POSITIONS.size() ) );
+    std::printf( "再生位置と実時間のずれ: 最大%.3fms\n", maxError );
+    std::printf( "再生位置が逆行した回数: %u\n", backwards );
+}
+
+void measureLatency(
+    const AudioOutputInfo & _REQUEST
+    , dp::UInt              _seconds
+    , dp::UInt              _startMilliseconds
+)
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    dp::Bool                ended = false;
+
+    LatencyProbe    probe( static_cast< dp::ULong >( SAMPLE_RATE ) * _seconds );
+
+    // 実デバイスからは出力を取り出せないため、ループバックの代わりに
+    // 実時間で出力を模すNULL_REALTIMEの仮想スピーカーを使う
+    AudioOutputKey  key;
+    key.type = AudioOutputType::NULL_REALTIME;
+
+    auto    info = _REQUEST;
+
+    if( _startMilliseconds > 0 ) {
+        setStartFrame(
+            info
+            , AUDIO_OUTPUT_START_PENDING
+        );
+    }
+
+    setEndEventHandler(
+        info
+        , [
+            &mutex
+            , &cond
+            , &ended
+        ]
+        (
+            AudioOutput &
+        )
+        {
+            std::unique_lock< std::mutex >  lock( mutex );
+
+            ended = true;
+
+            cond.notify_one();
+        }
+    );
+    setPlayEventHandler(
+        info
+        , [
+            &probe
+        ]
+        (
+            AudioOutput &
+            , void *            _buffer
+            , dp::ULong         _bufferSize
+        ) -> dp::ULong
+        {
+            RealtimeScope   realtimeScope;
+
+            return renderEvents(
+                probe
+                , _buffer
+                , _bufferSize
+            );
+        }
+    );
+    setPresentEventHandler(
+        info
+        , [
+            &probe
+        ]
+        (
+            AudioOutput &       _output
+            , const void *      _BUFFER
+            , dp::ULong         _bufferSize
+        )
+        {
+            presentEvents(
+                probe
+                , _output
+                , _BUFFER
+                , _bufferSize
+            );
+        }
+    );
+
+    std::unique_ptr< AudioOutput >  outputUnique(
+        newAudioOutput(
+            key
+            , info
+            , dp::AudioFormat::S16LE
+            , SAMPLE_RATE
+            , 1
+        )
+    );
+    if( outputUnique.get() == nullptr ) {
+        std::printf( "出力の開始に失敗\n" );
+
+        return;
+    }
+    auto &  output = *outputUnique;
+
+    // 無音の出力が始まってから、その_startMilliseconds後のフレームに出力開始を予約する
+    Clock::time_point   scheduledStartTime;
+    if( _startMilliseconds > 0 ) {
+        AudioOutputPosition position;
+        while( getPlaybackPosition(
+            output
+            , position
+        ) == false ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+
+        const auto  START_FRAME = position.frame + static_cast< dp::ULong >( SAMPLE_RATE ) * _startMilliseconds / 1000;
+
+        probe.startFrame = START_FRAME;
+        scheduledStartTime = position.time + std::chrono::milliseconds( _startMilliseconds );
+
+        scheduleAudioOutputStart(
+            output
+            , START_FRAME
+        );
+
+        // 出力開始前のイベントは遅延の計測から外す
+        std::this_thread::sleep_until( scheduledStartTime );
+    }
+
+    std::atomic< dp::Bool > stopped( false );
+    std::thread eventThread(
+        [
+            &probe
+            , &stopped
+        ]
+        {
+            generateEvents(
+                probe
+                , stopped
+            );
+        }
+    );
+    dp::ThreadJoiner    eventThreadJoiner( &eventThread );
+
+    // 終了を待つ間、一定間隔で再生位置を取得する
+    AudioOutputPositions    positions;
+    positions.reserve( _seconds * 1000 / CLOCK_SAMPLE_MILLISECONDS + 1000 );
+    {
+        std::unique_lock< std::mutex >  lock( mutex );
+
+        while( ended == false ) {
+            cond.wait_for(
+                lock
+                , std::chrono::milliseconds( CLOCK_SAMPLE_MILLISECONDS )
+            );
+
+            AudioOutputPosition position;
+            if( getPlaybackPosition(
+                output
+                , position
+            ) ) {
+                positions.push_back( position );
+            }
+        }
+    }
+
+    stopped = true;
+
+    AudioOutputParameters   parameters;
+    if( getAudioOutputParameters(
+        *outputUnique
+        , parameters
+    ) ) {
+        const auto  PERIOD_MILLISECONDS = parameters.periodFrames * 1000.0 / SAMPLE_RATE;
+
+        std::printf( "周期: %uフレーム (%.2fms)\n", parameters.periodFrames, PERIOD_MILLISECONDS );
+        std::printf( "実時間優先度: %s\n", parameters.realtimeScheduling ? "有効" : "無効" );
+        if( parameters.bufferingKnown ) {
+            std::printf( "バッファ数: %u\n", parameters.bufferCount );
+            std::printf( "出力先に溜まる最大の長さ: %.2fms\n", parameters.latencyFrames * 1000.0 / SAMPLE_RATE );
+            std::printf(
+                "理論上の出力遅延: %.2fms～%.2fms\n"
+                , ( parameters.bufferCount - 1 ) * PERIOD_MILLISECONDS
+                , parameters.bufferCount * PERIOD_MILLISECONDS
+            );
+        } else {
+            std::printf( "バッファ数・出力先に溜まる長さ: 不明(出力先から取得できない)\n" );
+        }
+    }
+
+    printLatencies( probe.latencies );
+
+    printPlaybackClock( positions );
+
+    if( _startMilliseconds > 0 && probe.startNanoseconds != 0 ) {
+        std::printf( "予約した出力開始時刻とのずれ: %.3fms\n", ( probe.startNanoseconds - toNanoseconds( scheduledStartTime ) ) * 1e-6 );
+    }
+
+    if( probe.droppedEvents > 0 ) {
+        std::printf( "取りこぼしたイベント数: %llu\n", probe.droppedEvents.load() );
+    }
+    printRealtimeCheck();
+}
+
+dp::Int dpMain(
+    dp::Args &  _args
+)
+{
+    AudioOutputInfo info;
+    dp::UInt        seconds = DEFAULT_SECONDS;
+    dp::UInt        startMilliseconds = 0;
+
+    for( std::size_t i = 1 ; i < _args.size() ; i++ ) {
+        dp::String  option;
+        dp::toString(
+            option
+            , _args[ i ]
+        );
+
+        if( option == "--rt" ) {
+            setRealtimeScheduling(
+                info
+                , true
+            );
+
+            continue;
+        }
+
+        dp::String  name;
+        dp::UInt    value;
+        if( parseValueOption(
+            _args[ i ]
+            , name
+            , value
+        ) ) {
+            if( name == "--latency" ) {
+                setLatency(
+                    info
+                    , value
+                );
+
+                continue;
+            } else if( name == "--period" ) {
+                setPeriodFrames(
+                    info
+                    , value
+                );
+
+                continue;
+            } else if( name == "--buffers" ) {
+                setBufferCount(
+                    info
+                    , value
+                );
+
+                continue;
+            } else if( name == "--seconds" && value > 0 ) {
+                seconds = value;
+
+                continue;
+            } else if( name == "--start" && value > 0 ) {
+                startMilliseconds = value;
+
+                continue;
+            }
+        }
+
+        dp::String  command;
+        dp::toString(
+            command
+            , _args[ 0 ]
+        );
+
+        std::printf( "使い方: %s [--latency=ミリ秒] [--period=フレーム数] [--buffers=バッファ数] [--rt] [--seconds=秒] [--start=ミリ秒]\n", command.c_str() );
+
+        return 1;
+    }
+
+    measureLatency(
+        info
+        , seconds
+        , startMilliseconds
+    );
+
+    return 0;
+}
@@ -0,0 +1,529 @@
+﻿#include "dp/cli.h"
+#include "dp/common/primitives.h"
+#include "dp/common/stringconverter.h"
+#include "dp/audio/audioformat.h"
+#include "dp/common/thread.h"
+
+#include "speaker.h"
+#include "audiooutput.h"
+#include "wav.h"
+#include "audiostream.h"
+#include "audioconvert.h"
+#include "mixer.h"
+#include "realtimecheck.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+
+const auto  STREAM_BUFFER_MILLISECONDS = 250;
+const auto  READ_FRAMES = 1024;
+const auto  MIX_FRAMES = 4096;
+const auto  FRAME_SIZE = sizeof( std::int16_t ) * 2;
+
+const auto  BENCHMARK_SAMPLE_RATE = 48000;
+const auto  BENCHMARK_PERIOD_FRAMES = 480;
+const auto  BENCHMARK_PERIOD_SECONDS = static_cast< double >( BENCHMARK_PERIOD_FRAMES ) / BENCHMARK_SAMPLE_RATE;
+const auto  BENCHMARK_PERIODS = 100;    // ボイス数ごとに計測する周期の数(音声1秒分)
+const auto  BENCHMARK_RESOLUTION = 100; // 最大ボイス数の探索は、その1/100の幅まで絞り込む
+
+DEFINE_REALTIME_ALLOCATION_CHECK
+
+struct VoiceSource
+{
+    WavReader                       reader;
+    std::unique_ptr< AudioStream >  streamUnique;
+    dp::Bool                        ended;
+
+    VoiceSource(
+    )
+        : ended( false )
+    {
+    }
+};
+
+typedef std::vector< std::unique_ptr< VoiceSource > > VoiceSources;
+
+void waitEnd(
+    std::mutex &                _mutex
+    , std::condition_variable & _cond
+    , const dp::Bool &          _ENDED
+)
+{
+    std::unique_lock< std::mutex >  lock( _mutex );
+
+    _cond.wait(
+        lock
+        , [
+            &_ENDED
+        ]
+        {
+            return _ENDED;
+        }
+    );
+}
+
+dp::Bool openVoiceSources(
+    VoiceSources &      _sources
+    , dp::UInt &        _sampleRate
+    , const dp::Args &  _ARGS
+    , std::size_t       _argIndex
+)
+{
+    for( std::size_t i = _argIndex ; i < _ARGS.size() ; i++ ) {
+        const auto &    FILE_PATH = _ARGS[ i ];
+
+        std::unique_ptr< VoiceSource >  sourceUnique( new VoiceSource );
+        auto &                          reader = sourceUnique->reader;
+        if( openWav(
+            FILE_PATH
+            , reader
+        ) == false ) {
+            std::printf( "ファイルの解析に失敗[%u]\n", static_cast< dp::UInt >( i ) );
+
+            continue;
+        }
+
+        if( _sources.empty() ) {
+            _sampleRate = reader.sampleRate;
+        } else if( reader.sampleRate != _sampleRate ) {
+            std::printf( "サンプリングレートが不一致のため除外[%u]\n", static_cast< dp::UInt >( i ) );
+
+            continue;
+        }
+
+        sourceUnique->streamUnique.reset(
+            new AudioStream(
+                _sampleRate * FRAME_SIZE * STREAM_BUFFER_MILLISECONDS / 1000
+                , dp::AudioFormat::S16LE
+                , FRAME_SIZE
+            )
+        );
+
+        _sources.push_back( std::move( sourceUnique ) );
+    }
+
+    return _sources.empty() == false;
+}
+
+// 各ボイスのリングバッファへ、S16LEステレオに変換した波形データを順に書き込む
+void produceVoices(
+    VoiceSources &                      _sources
+    , const std::atomic< dp::Bool > &   _STOPPED
+)
+{
+    dp::UInt    maxFrameSize = 0;
+    for( const auto & SOURCE : _sources ) {
+        maxFrameSize = std::max(
+            maxFrameSize
+            , SOURCE->reader.frameSize
+        );
+    }
+
+    WaveData                    readBuffer( READ_FRAMES * maxFrameSize );
+    std::vector< std::int16_t > convertBuffer( READ_FRAMES * 2 );
+
+    while( _STOPPED == false ) {
+        dp::Bool    active = false;
+        dp::Bool    progressed = false;
+
+        for( auto & source : _sources ) {
+            if( source->ended ) {
+                continue;
+            }
+            active = true;
+
+            if( source->streamUnique->ringBuffer.getWritableSize() < READ_FRAMES * FRAME_SIZE ) {
+                continue;
+            }
+
+            auto &  reader = source->reader;
+
+            dp::ULong   size = READ_FRAMES * reader.frameSize;
+            if( readWavData(
+                reader
+                , readBuffer.data()
+                , size
+            ) == false || size <= 0 ) {
+                endAudioStream( *( source->streamUnique ) );
+                source->ended = true;
+
+                continue;
+            }
+
+            const auto  FRAMES = size / reader.frameSize;
+
+            convertToS16Stereo(
+                reader.audioFormat
+                , reader.channels
+                , readBuffer.data()
+                , FRAMES
+                , convertBuffer.data()
+            );
+
+            tryWriteAudioStream(
+                *( source->streamUnique )
+                , convertBuffer.data()
+                , FRAMES * FRAME_SIZE
+            );
+
+            progressed = true;
+        }
+
+        if( active == false ) {
+            break;
+        }
+
+        if( progressed == false ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+        }
+    }
+}
+
+void playVoices(
+    const AudioOutputKey &  _KEY
+    , VoiceSources &        _sources
+    , dp::UInt              _sampleRate
+)
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    dp::Bool                ended = false;
+
+    AudioOutputInfo info;
+
+    // ファイルごとに1ボイスを割り当てる
+    Mixer   mixer(
+        static_cast< dp::UInt >( _sources.size() )
+        , MIX_FRAMES
+        , isRealtimeAudioOutput( _KEY.type )
+    );
+
+    std::atomic< dp::Bool > stopped( false );
+    std::thread producerThread(
+        [
+            &_sources
+            , &stopped
+        ]
+        {
+            produceVoices(
+                _sources
+                , stopped
+            );
+        }
+    );
+    dp::ThreadJoiner    producerThreadJoiner( &producerThread );
+
+    // ボイスは左から右へ等間隔に配置する
+    const auto  VOICES = _sources.size();
+    for( std::size_t i = 0 ; i < VOICES ; i++ ) {
+        const auto  PAN = VOICES > 1 ? -1 + 2 * static_cast< dp::Float >( i ) / ( VOICES - 1 ) : 0;
+
+        addVoice(
+            mixer
+            , *( _sources[ i ]->streamUnique )
+            , 1
+            , PAN
+        );
+    }
+
+    setEndEventHandler(
+        info
+        , [
+            &mutex
+            , &cond
+            , &ended
+        ]
+        (
+            AudioOutput &
+        )
+        {
+            std::unique_lock< std::mutex >  lock( mutex );
+
+            ended = true;
+
+            cond.notify_one();
+        }
+    );
+    setPlayEventHandler(
+        info
+        , [
+            &mixer
+        ]
+        (
+            AudioOutput &
+            , void *            _buffer
+            , dp::ULong         _bufferSize
+        ) -> dp::ULong
+        {
+            RealtimeScope   realtimeScope;
+
+            if( getPlayingVoices( mixer ) <= 0 ) {
+                return 0;
+            }
+
+            return mix(
+                mixer
+                , _buffer
+                , _bufferSize
+            );
+        }
+    );
+
+    std::unique_ptr< AudioOutput >  outputUnique(
+        newAudioOutput(
+            _KEY
+            , info
+            , dp::AudioFormat::S16LE
+            , _sampleRate
+            , 2
+        )
+    );
+    if( outputUnique.get() == nullptr ) {
+        std::printf( "出力の開始に失敗\n" );
+
+        stopped = true;
+
+        return;
+    }
+
+    waitEnd(
+        mutex
+        , cond
+        , ended
+    );
+
+    stopped = true;
+
+    for( std::size_t i = 0 ; i < VOICES ; i++ ) {
+        std::printf( "ボイス[%u]のアンダーラン回数: %llu\n", static_cast< dp::UInt >( i ), _sources[ i ]->streamUnique->underruns.load() );
+    }
+    printRealtimeCheck();
+}
+
+struct BenchmarkResult
+{
+    double  meanSeconds;
+    double  p99Seconds;
+    double  maxSeconds;
+};
+
+// 48kHzステレオのボイスを_voices個、1周期(BENCHMARK_PERIOD_FRAMESフレーム)ずつBENCHMARK_PERIODS回合成する
+// ボイスごとに別のリングバッファを持ち、毎周期書き込み直すため、メモリ帯域やキャッシュの影響も計測に含まれる
+BenchmarkResult measureMix(
+    dp::UInt    _voices
+)
+{
+    Mixer   mixer(
+        _voices
+        , BENCHMARK_PERIOD_FRAMES
+        , true
+    );
+
+    std::vector< std::int16_t > noise( BENCHMARK_PERIOD_FRAMES * 2 );
+    for( auto & sample : noise ) {
+        sample = static_cast< std::int16_t >( std::rand() - RAND_MAX / 2 );
+    }
+
+    std::vector< std::int16_t > output( BENCHMARK_PERIOD_FRAMES * 2 );
+
+    std::vector< std::unique_ptr< AudioStream > >   streams;
+    for( dp::UInt i = 0 ; i < _voices ; i++ ) {
+        std::unique_ptr< AudioStream >  streamUnique(
+            new AudioStream(
+                BENCHMARK_PERIOD_FRAMES * FRAME_SIZE
+                , dp::AudioFormat::S16LE
+                , FRAME_SIZE
+            )
+        );
+
+        addVoice(
+            mixer
+            , *streamUnique
+            , 1.0f / _voices
+            , 0
+        );
+
+        streams.push_back( std::move( streamUnique ) );
+    }
+
+    std::vector< double >   seconds;
+    for( dp::Int i = 0 ; i < BENCHMARK_PERIODS ; i++ ) {
+        for( auto & stream : streams ) {
+            tryWriteAudioStream(
+                *stream
+                , noise.data()
+                , noise.size() * sizeof( std::int16_t )
+            );
+        }
+
+        const auto  BEGIN = std::chrono::steady_clock::now();
+
+        mix(
+            mixer
+            , output.data()
+            , output.size() * sizeof( std::int16_t )
+        );
+
+        seconds.push_back( std::chrono::duration_cast< std::chrono::duration< double > >( std::chrono::steady_clock::now() - BEGIN ).count() );
+    }
+
+    std::sort(
+        seconds.begin()
+        , seconds.end()
+    );
+
+    double  total = 0;
+    for( const auto & SECONDS : seconds ) {
+        total += SECONDS;
+    }
+
+    BenchmarkResult result;
+    result.meanSeconds = total / seconds.size();
+    result.p99Seconds = seconds[ ( seconds.size() * 99 + 99 ) / 100 - 1 ];
+    result.maxSeconds = seconds.back();
+
+    return result;
+}
+
+// 99%の周期で、1周期分の合成が周期の長さ(10ms)に収まるかを返す
+dp::Bool benchmarkVoices(
+    dp::UInt    _voices
+)
+{
+    const auto  RESULT = measureMix( _voices );
+    const auto  SUSTAINED = RESULT.p99Seconds <= BENCHMARK_PERIOD_SECONDS;
+
+    std::printf(
+        "ボイス数 %7u: 平均 %7.3fms p99 %7.3fms 最大 %7.3fms %s\n"
+        , _voices
+        , RESULT.meanSeconds * 1000
+        , RESULT.p99Seconds * 1000
+        , RESULT.maxSeconds * 1000
+        , SUSTAINED ? "維持可能" : "維持不可"
+    );
+
+    return SUSTAINED;
+}
+
+// 1周期の合成が周期の長さに収まる最大のボイス数を、実際に合成して求める
+// ボイス数を倍にしながら収まらなくなる数を見つけ、その間を二分探索する
+void benchmark(
+)
+{
+    std::printf( "48kHzステレオ、%uフレーム(%.0fms)周期、%u周期ずつ計測\n", BENCHMARK_PERIOD_FRAMES, BENCHMARK_PERIOD_SECONDS * 1000, BENCHMARK_PERIODS );
+
+    dp::UInt    sustained = 0;
+    dp::UInt    unsustained = MIXER_DEFAULT_VOICES;
+    while( benchmarkVoices( unsustained ) ) {
+        sustained = unsustained;
+        unsustained *= 2;
+    }
+
+    while( unsustained - sustained > std::max( 1u, sustained / BENCHMARK_RESOLUTION ) ) {
+        const auto  VOICES = ( sustained + unsustained ) / 2;
+
+        if( benchmarkVoices( VOICES ) ) {
+            sustained = VOICES;
+        } else {
+            unsustained = VOICES;
+        }
+    }
+
+    std::printf( "1コアで維持可能なボイス数(実測): %u\n", sustained );
+}
+
+dp::Int dpMain(
+    dp::Args &  _args
+)
+{
+    dp::String  command;
+    dp::toString(
+        command
+        , _args[ 0 ]
+    );
+
+    if( _args.size() < 2 ) {
+        std::printf( "使い方: %s [--null | --null-fast | --wavout=出力ファイルパス] ファイルパス...\n", command.c_str() );
+        std::printf( "        %s --bench [ボイス数]\n", command.c_str() );
+        std::printf( "        (ボイス数を省略した場合は、1コアで維持可能なボイス数を探索する)\n" );
+
+        return 1;
+    }
+
+    dp::String  option;
+    dp::toString(
+        option
+        , _args[ 1 ]
+    );
+
+    if( option == "--bench" ) {
+        if( _args.size() < 3 ) {
+            benchmark();
+
+            return 0;
+        }
+
+        dp::String  voicesString;
+        dp::toString(
+            voicesString
+            , _args[ 2 ]
+        );
+
+        benchmarkVoices(
+            std::max(
+                1
+                , std::atoi( voicesString.c_str() )
+            )
+        );
+
+        return 0;
+    }
+
+    VirtualSpeakers virtualSpeakers;
+
+    std::size_t argIndex = 1;
+    while( argIndex < _args.size() && parseVirtualSpeakerOption(
+        virtualSpeakers
+        , _args[ argIndex ]
+    ) ) {
+        argIndex++;
+    }
+
+    VoiceSources    sources;
+    dp::UInt        sampleRate = 0;
+    if( openVoiceSources(
+        sources
+        , sampleRate
+        , _args
+        , argIndex
+    ) == false ) {
+        std::printf( "再生可能なファイルがない\n" );
+
+        return 1;
+    }
+
+    std::unique_ptr< AudioOutputKey >   keyUnique( getAudioOutputKey( virtualSpeakers ) );
+    if( keyUnique.get() == nullptr ) {
+        std::printf( "スピーカーの検索に失敗\n" );
+
+        return 1;
+    }
+    const auto &    KEY = *keyUnique;
+
+    playVoices(
+        KEY
+        , sources
+        , sampleRate
+    );
+
+    return 0;
+}
@@ -1,177 +1,448 @@
 ﻿#include "dp/cli.h"
 #include "dp/common/primitives.h"
 #include "dp/common/stringconverter.h"
-#include "dp/audio/speakermanager.h"
-#include "dp/audio/speakerkey.h"
 #include "dp/audio/audioformat.h"
-#include "dp/audio/audioplayer.h"
+#include "dp/common/thread.h"
 
+#include "speaker.h"
+#include "audiooutput.h"
 #include "wav.h"
-
+#include "audiostream.h"
+#include "realtimecheck.h"
+#include "playeventrecorder.h"
+#include "playlist.h"
+#include "audioconvert.h"
+#include "gain.h"
+#include "analyzer.h"
+#include "option.h"
+
+#include <vector>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
+#include <atomic>
 #include <chrono>
-#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <cstdio>
 
-void waitForFindSpeakerKey(
+const auto  STREAM_BUFFER_MILLISECONDS = 500;
+const auto  READ_FRAMES = 4096;
+const auto  COLLECT_RECORDS_MILLISECONDS = 1000;
+
+typedef std::vector< dp::Utf32 > FilePaths;
+
+struct PlayOptions
+{
+    dp::Bool    recordPlayEvents;
+    dp::UInt    gainPercent;
+    dp::UInt    fadeMilliseconds;       // 再生開始のフェードイン、再生終了のフェードアウトの長さ
+    dp::UInt    crossfadeMilliseconds;  // トラックの切り替えで重ねる長さ
+    dp::Bool    meter;                  // 出力中の波形データを解析し、レベルと帯域ごとの値を表示する
+};
+
+DEFINE_REALTIME_ALLOCATION_CHECK
+
+void waitEnd(
     std::mutex &                _mutex
     , std::condition_variable & _cond
-    , dp::SpeakerKeyUnique &    _keyUnique
+    , const dp::Bool &          _ENDED
 )
 {
     std::unique_lock< std::mutex >  lock( _mutex );
 
-    _cond.wait_for(
+    _cond.wait(
         lock
-        , std::chrono::seconds( 5 )
         , [
-            &_keyUnique
+            &_ENDED
         ]
         {
-            return _keyUnique.get() != nullptr;
+            return _ENDED;
         }
     );
 }
 
-void foundSpeakerKey(
-    std::mutex &                _mutex
-    , std::condition_variable & _cond
-    , dp::SpeakerKeyUnique &    _keyUnique
-    , dp::SpeakerKeyUnique &    _foundKeyUnique
+dp::Float toDecibels(
+    dp::Float   _amplitude
 )
 {
-    std::unique_lock< std::mutex >  lock( _mutex );
+    return _amplitude > 0 ? std::max(
+        -99.0f
+        , 20 * std::log10( _amplitude )
+    ) : -99.0f;
+}
 
-    _keyUnique = std::move( _foundKeyUnique );
+void printMeters(
+    const AudioAnalyzer &   _ANALYZER
+)
+{
+    for( dp::UInt i = 0 ; i < _ANALYZER.channels ; i++ ) {
+        AnalyzerResult  result;
+        if( getAnalyzerResult(
+            _ANALYZER
+            , i
+            , result
+        ) == false ) {
+            return;
+        }
 
-    _cond.notify_one();
+        std::printf( "ch%u: ピーク=%6.1fdB RMS=%6.1fdB 帯域[dB]:", i, toDecibels( result.peak ), toDecibels( result.rms ) );
+        for( const auto & BAND : result.bands ) {
+            std::printf( " %5.1f", toDecibels( BAND ) );
+        }
+        std::printf( "\n" );
+    }
 }
 
-dp::SpeakerKey * getSpeakerKey(
+void printAnalyzerCost(
+    const AudioAnalyzer &   _ANALYZER
 )
 {
-    std::mutex              mutex;
-    std::condition_variable cond;
-    dp::SpeakerKeyUnique    keyUnique;
+    const auto  ANALYZED_FRAMES = _ANALYZER.analyzedFrames.load();
+    if( ANALYZED_FRAMES <= 0 ) {
+        return;
+    }
 
-    auto    infoUnique = dp::unique( dp::newSpeakerManagerInfo() );
-    if( infoUnique.get() == nullptr ) {
-        std::printf( "dp::SpeakerManagerInfoの生成に失敗\n" );
+    // 音声1秒分を1チャンネル解析するのにかかったCPU時間
+    const auto  ANALYZED_SECONDS = static_cast< double >( ANALYZED_FRAMES ) / _ANALYZER.sampleRate;
+    const auto  MILLISECONDS_PER_CHANNEL = _ANALYZER.analysisNanoseconds.load() * 1e-6 / ANALYZED_SECONDS / _ANALYZER.channels;
 
-        return nullptr;
-    }
-    auto &  info = *infoUnique;
+    std::printf( "解析した長さ: %.1f秒 (%uチャンネル)\n", ANALYZED_SECONDS, _ANALYZER.channels );
+    std::printf( "解析のCPU時間: 1チャンネルあたり音声1秒につき%.3fms (CPU使用率%.3f%%)\n", MILLISECONDS_PER_CHANNEL, MILLISECONDS_PER_CHANNEL / 10 );
+    std::printf( "解析に回せなかったフレーム数: %llu\n", _ANALYZER.droppedFrames.load() );
+}
 
-    dp::setConnectEventHandler(
-        info
+// 待機中、定期的に再生コールバックの記録を回収し、解析結果を表示する
+// 不要なものはnullptrとする
+void waitEnd(
+    std::mutex &                _mutex
+    , std::condition_variable & _cond
+    , const dp::Bool &          _ENDED
+    , PlayEventRecorder *       _recorder
+    , const AudioAnalyzer *     _ANALYZER
+)
+{
+    std::unique_lock< std::mutex >  lock( _mutex );
+
+    while( _cond.wait_for(
+        lock
+        , std::chrono::milliseconds( COLLECT_RECORDS_MILLISECONDS )
         , [
-            &mutex
-            , &cond
-            , &keyUnique
+            &_ENDED
         ]
-        (
-            dp::SpeakerManager &        _manager
-            , dp::SpeakerKeyUnique &&   _keyUnique
-            , dp::Bool                  _connected
-        )
         {
-            if( _connected == false ) {
-                return;
+            return _ENDED;
+        }
+    ) == false ) {
+        if( _recorder != nullptr ) {
+            collectPlayEventRecords( *_recorder );
+        }
+
+        if( _ANALYZER != nullptr ) {
+            printMeters( *_ANALYZER );
+        }
+    }
+}
+
+// 出力フォーマットへ変換したトラックを、順にPlaylistへ積む
+// 次のトラックは現在のトラックの書き込みを始める前に開いておき、ヘッダ解析とファイルオープンを切り替え時点から外す
+// _fadeOutFramesが0でなければ、全トラックの長さが確定した時点で末尾のフェードアウトを予約する
+void producePlaylist(
+    std::unique_ptr< WavReader > &      _firstReaderUnique
+    , const FilePaths &                 _FILE_PATHS
+    , Playlist &                        _playlist
+    , GainStage &                       _gainStage
+    , dp::UInt                          _fadeOutFrames
+    , dp::UInt                          _crossfadeFrames
+    , const std::atomic< dp::Bool > &   _STOPPED
+    , std::mutex &                      _mutex
+    , std::condition_variable &         _cond
+    , dp::Bool &                        _prefilled
+)
+{
+    // 出力フォーマットは最初のトラックに合わせる
+    const auto  AUDIO_FORMAT = _firstReaderUnique->audioFormat;
+    const auto  SAMPLE_RATE = _firstReaderUnique->sampleRate;
+    const auto  CHANNELS = _firstReaderUnique->channels;
+    const auto  FRAME_SIZE = _firstReaderUnique->frameSize;
+
+    WaveData        readBuffer;
+    WaveData        convertBuffer;
+    AudioConverter  converter;
+
+    // 出力するフレーム数の合計
+    // クロスフェードで重なる分は、Playlistと同じくgetPlaylistCrossfadeFrames()で求める
+    dp::ULong   totalFrames = 0;
+    dp::ULong   previousRestFrames = 0;     // 前のトラックのうち、その前のトラックと重ならない長さ
+    dp::Bool    previousTrack = false;
+
+    auto        readerUnique = std::move( _firstReaderUnique );
+    std::size_t nextIndex = 1;
+    while( readerUnique.get() != nullptr && _STOPPED == false ) {
+        auto &  reader = *readerUnique;
+
+        collectPlaylistStreams( _playlist );
+
+        // Playlistがクロスフェードの2倍まで読まずに残すため、その分を加えた容量とする
+        auto    stream = new AudioStream(
+            ( static_cast< std::size_t >( SAMPLE_RATE ) * STREAM_BUFFER_MILLISECONDS / 1000 + _crossfadeFrames * 2 ) * FRAME_SIZE
+            , AUDIO_FORMAT
+            , FRAME_SIZE
+        );
+        while( queuePlaylistStream(
+            _playlist
+            , stream
+        ) == false ) {
+            if( _STOPPED ) {
+                delete stream;
+
+                break;
+            }
+
+            std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+        }
+        if( _STOPPED ) {
+            break;
+        }
+
+        std::unique_ptr< WavReader >    nextReaderUnique;
+        for( ; nextIndex < _FILE_PATHS.size() && nextReaderUnique.get() == nullptr ; nextIndex++ ) {
+            nextReaderUnique.reset( new WavReader );
+            if( openWav(
+                _FILE_PATHS[ nextIndex ]
+                , *nextReaderUnique
+            ) == false ) {
+                std::printf( "ファイルの解析に失敗したため除外[%u]\n", static_cast< dp::UInt >( nextIndex ) );
+
+                nextReaderUnique.reset();
             }
+        }
+
+        initAudioConverter(
+            converter
+            , reader.audioFormat
+            , reader.sampleRate
+            , reader.channels
+            , AUDIO_FORMAT
+            , SAMPLE_RATE
+            , CHANNELS
+        );
 
-            if( keyUnique.get() != nullptr ) {
-                return;
+        readBuffer.resize( READ_FRAMES * reader.frameSize );
+
+        dp::ULong   trackFrames = 0;
+        while( 1 ) {
+            dp::ULong   size = readBuffer.size();
+            if( readWavData(
+                reader
+                , readBuffer.data()
+                , size
+            ) == false ) {
+                break;
             }
 
-            foundSpeakerKey(
-                mutex
-                , cond
-                , keyUnique
-                , _keyUnique
+            if( size <= 0 ) {
+                break;
+            }
+
+            const auto  FRAMES = convertAudio(
+                converter
+                , readBuffer.data()
+                , size / reader.frameSize
+                , convertBuffer
             );
+
+            if( writeAudioStream(
+                *stream
+                , convertBuffer.data()
+                , FRAMES * FRAME_SIZE
+                , _STOPPED
+            ) == false ) {
+                break;
+            }
+            trackFrames += FRAMES;
+
+            // 最初のブロックを書き込んだ時点で再生を開始できる
+            // 以降のブロックは出力先の準備と並行して書き込む
+            if( _prefilled == false ) {
+                std::unique_lock< std::mutex >  lock( _mutex );
+
+                _prefilled = true;
+
+                _cond.notify_one();
+            }
         }
-    );
 
-    auto    managerUnique = dp::unique(
-        dp::newSpeakerManager(
-            info
-        )
-    );
-    if( managerUnique.get() == nullptr ) {
-        std::printf( "dp::SpeakerManagerの生成に失敗\n" );
+        endAudioStream( *stream );
+
+        dp::ULong   overlapFrames = 0;
+        if( previousTrack && _crossfadeFrames > 0 ) {
+            overlapFrames = getPlaylistCrossfadeFrames(
+                _crossfadeFrames
+                , previousRestFrames
+                , trackFrames
+            );
+        }
+
+        totalFrames += trackFrames - overlapFrames;
+        previousRestFrames = trackFrames - overlapFrames;
+        previousTrack = true;
 
-        return nullptr;
+        readerUnique = std::move( nextReaderUnique );
     }
 
-    std::printf( "スピーカーを検索中…\n" );
+    if( _fadeOutFrames > 0 && _STOPPED == false ) {
+        const auto  FADE_OUT_FRAMES = std::min(
+            totalFrames
+            , static_cast< dp::ULong >( _fadeOutFrames )
+        );
 
-    waitForFindSpeakerKey(
-        mutex
-        , cond
-        , keyUnique
-    );
+        fadeOut(
+            _gainStage
+            , static_cast< dp::UInt >( FADE_OUT_FRAMES )
+            , totalFrames - FADE_OUT_FRAMES
+        );
+    }
+
+    endPlaylist( _playlist );
+
+    std::unique_lock< std::mutex >  lock( _mutex );
 
-    return keyUnique.release();
+    _prefilled = true;
+
+    _cond.notify_one();
 }
 
-void waitEnd(
-    std::mutex &                _mutex
-    , std::condition_variable & _cond
-    , const dp::Bool &          _ENDED
+double toMilliseconds(
+    std::chrono::steady_clock::duration _duration
 )
 {
-    std::unique_lock< std::mutex >  lock( _mutex );
+    return std::chrono::duration_cast< std::chrono::duration< double, std::milli > >( _duration ).count();
+}
 
-    _cond.wait(
-        lock
-        , [
-            &_ENDED
-        ]
-        {
-            return _ENDED;
-        }
-    );
+// 再生開始までの時間と、その内訳を表示する
+void printTimeToFirstAudio(
+    const AudioOutput &                             _OUTPUT
+    , const SpeakerFinder &                         _FINDER
+    , const std::chrono::steady_clock::time_point & _START
+    , const std::chrono::steady_clock::time_point & _PREFILLED
+)
+{
+    std::chrono::steady_clock::time_point   firstPlayTime;
+    if( getFirstPlayTime(
+        _OUTPUT
+        , firstPlayTime
+    ) == false ) {
+        return;
+    }
+
+    std::printf( "再生開始までの時間: %.1fms\n", toMilliseconds( firstPlayTime - _START ) );
+
+    std::printf( "  スピーカーの検索: %.1fms\n", toMilliseconds( _FINDER.foundTime - _START ) );
+    std::printf( "  最初のブロックの読み込み: %.1fms\n", toMilliseconds( _PREFILLED - _START ) );
 }
 
-void playAudio(
-    const dp::SpeakerKey &  _KEY
-    , dp::AudioFormat       _audioFormat
-    , dp::UInt              _sampleRate
-    , dp::UInt              _channels
-    , const WaveData &      _WAVE_DATA
+// _STARTは再生開始までの時間の計測起点
+void playPlaylist(
+    SpeakerFinder &                                 _finder
+    , std::unique_ptr< WavReader > &                _firstReaderUnique
+    , const FilePaths &                             _FILE_PATHS
+    , const PlayOptions &                           _OPTIONS
+    , const std::chrono::steady_clock::time_point & _START
 )
 {
     std::mutex              mutex;
     std::condition_variable cond;
     dp::Bool                ended = false;
 
-    auto    infoUnique = dp::unique( dp::newAudioPlayerInfo() );
-    if( infoUnique.get() == nullptr ) {
-        std::printf( "dp::AudioPlayerInfoの生成に失敗\n" );
+    AudioOutputInfo info;
 
-        return;
-    }
-    auto &  info = *infoUnique;
+    const auto  AUDIO_FORMAT = _firstReaderUnique->audioFormat;
+    const auto  SAMPLE_RATE = _firstReaderUnique->sampleRate;
+    const auto  CHANNELS = _firstReaderUnique->channels;
+    const auto  FRAME_SIZE = _firstReaderUnique->frameSize;
 
-    auto        waveDataPtr = _WAVE_DATA.data();
-    const auto  END_OF_WAVE_DATA = waveDataPtr + _WAVE_DATA.size();
+    Playlist    playlist(
+        AUDIO_FORMAT
+        , FRAME_SIZE
+    );
 
-    dp::setStartEventHandler(
-        info
-        , [
+    const auto  CROSSFADE_FRAMES = SAMPLE_RATE * _OPTIONS.crossfadeMilliseconds / 1000;
+    setPlaylistCrossfade(
+        playlist
+        , CROSSFADE_FRAMES
+    );
+
+    // 再生開始前にゲインとフェードインを予約しておく
+    GainStage   gainStage;
+
+    const auto  GAIN = _OPTIONS.gainPercent / 100.0f;
+    const auto  FADE_FRAMES = SAMPLE_RATE * _OPTIONS.fadeMilliseconds / 1000;
+    setGain(
+        gainStage
+        , FADE_FRAMES > 0 ? 0 : GAIN
+        , GAIN
+        , FADE_FRAMES
+        , 0
+    );
+    // トラックのリングバッファからの読み出しと同じ走査でゲインをかける
+    setPlaylistGainStage(
+        playlist
+        , &gainStage
+    );
+
+    std::atomic< dp::Bool > stopped( false );
+    dp::Bool                prefilled = false;
+    std::thread producerThread(
+        [
+            &_firstReaderUnique
+            , &_FILE_PATHS
+            , &playlist
+            , &gainStage
+            , FADE_FRAMES
+            , CROSSFADE_FRAMES
+            , &stopped
+            , &mutex
+            , &cond
+            , &prefilled
         ]
-        (
-            dp::AudioPlayer &   _audioPlayer
-        )
         {
-            dp::pause(
-                _audioPlayer
-                , false
+            producePlaylist(
+                _firstReaderUnique
+                , _FILE_PATHS
+                , playlist
+                , gainStage
+                , FADE_FRAMES
+                , CROSSFADE_FRAMES
+                , stopped
+                , mutex
+                , cond
+                , prefilled
             );
         }
     );
-    dp::setEndEventHandler(
+    dp::ThreadJoiner    producerThreadJoiner( &producerThread );
+
+    // スピーカーの検索と並行して最初のブロックを読み込む
+    waitEnd(
+        mutex
+        , cond
+        , prefilled
+    );
+    const auto  PREFILLED = std::chrono::steady_clock::now();
+
+    const auto  KEY = waitAudioOutputKey( _finder );
+    if( KEY == nullptr ) {
+        std::printf( "スピーカーの検索に失敗\n" );
+
+        stopped = true;
+
+        return;
+    }
+
+    setEndEventHandler(
         info
         , [
             &mutex
@@ -179,7 +450,7 @@ void playAudio(
             , &ended
         ]
         (
-            dp::AudioPlayer &
+            AudioOutput &
         )
         {
             std::unique_lock< std::mutex >  lock( mutex );
@@ -189,111 +460,202 @@ void playAudio(
             cond.notify_one();
         }
     );
-    dp::setPlayEventHandler(
-        info
-        , [
-            &waveDataPtr
-            , END_OF_WAVE_DATA
-        ]
-        (
-            dp::AudioPlayer &
-            , void *            _buffer
-            , dp::ULong         _bufferSize
-        ) -> dp::ULong
-        {
-            if( waveDataPtr >= END_OF_WAVE_DATA ) {
-                return 0;
-            }
-
-            const auto  WAVE_DATA_SIZE = END_OF_WAVE_DATA - waveDataPtr;
-            if( _bufferSize > WAVE_DATA_SIZE ) {
-                _bufferSize = WAVE_DATA_SIZE;
-            }
 
-            std::memcpy(
-                _buffer
-                , waveDataPtr
-                , _bufferSize
-            );
+    std::unique_ptr< PlayEventRecorder >    recorderUnique;
+    if( _OPTIONS.recordPlayEvents ) {
+        recorderUnique.reset( new PlayEventRecorder( SAMPLE_RATE * FRAME_SIZE ) );
 
-            waveDataPtr += _bufferSize;
+        setRecordingPlaylistPlayEventHandler(
+            info
+            , playlist
+            , *recorderUnique
+        );
+    } else {
+        setPlaylistPlayEventHandler(
+            info
+            , playlist
+        );
+    }
 
-            return _bufferSize;
+    // 出力より後に破棄されるよう、出力の前に生成する
+    std::unique_ptr< AudioAnalyzer >    analyzerUnique;
+    if( _OPTIONS.meter ) {
+        analyzerUnique.reset(
+            newAudioAnalyzer(
+                AUDIO_FORMAT
+                , SAMPLE_RATE
+                , CHANNELS
+            )
+        );
+        if( analyzerUnique.get() == nullptr ) {
+            std::printf( "非対応のフォーマットのため解析しない\n" );
         }
-    );
 
-    auto    audioPlayerUnique = dp::unique(
-        dp::newAudioPlayer(
-            _KEY
+        setAnalyzer(
+            info
+            , analyzerUnique.get()
+        );
+    }
+
+    std::unique_ptr< AudioOutput >  outputUnique(
+        newAudioOutput(
+            *KEY
             , info
-            , _audioFormat
-            , _sampleRate
-            , _channels
+            , AUDIO_FORMAT
+            , SAMPLE_RATE
+            , CHANNELS
         )
     );
-    if( audioPlayerUnique.get() == nullptr ) {
-        std::printf( "dp::AudioPlayerの生成に失敗\n" );
+    if( outputUnique.get() == nullptr ) {
+        std::printf( "出力の開始に失敗\n" );
+
+        stopped = true;
 
         return;
     }
 
-    waitEnd(
-        mutex
-        , cond
-        , ended
+    if( recorderUnique.get() != nullptr || analyzerUnique.get() != nullptr ) {
+        waitEnd(
+            mutex
+            , cond
+            , ended
+            , recorderUnique.get()
+            , analyzerUnique.get()
+        );
+    } else {
+        waitEnd(
+            mutex
+            , cond
+            , ended
+        );
+    }
+
+    stopped = true;
+
+    printTimeToFirstAudio(
+        *outputUnique
+        , _finder
+        , _START
+        , PREFILLED
     );
+
+    if( recorderUnique.get() != nullptr ) {
+        printPlayEventSummary( *recorderUnique );
+    }
+
+    if( analyzerUnique.get() != nullptr ) {
+        printAnalyzerCost( *analyzerUnique );
+    }
+
+    std::printf( "再生したトラック数: %llu\n", playlist.finishedTracks.load() );
+    std::printf( "アンダーラン回数: %llu\n", playlist.underruns.load() );
+    printRealtimeCheck();
 }
 
 dp::Int dpMain(
     dp::Args &  _args
 )
 {
-    if( _args.size() < 2 ) {
+    const auto  START = std::chrono::steady_clock::now();
+
+    PlayOptions     options;
+    options.recordPlayEvents = false;
+    options.gainPercent = 100;
+    options.fadeMilliseconds = 0;
+    options.crossfadeMilliseconds = 0;
+    options.meter = false;
+
+    VirtualSpeakers virtualSpeakers;
+
+    std::size_t argIndex = 1;
+    for( ; argIndex < _args.size() ; argIndex++ ) {
+        dp::String  option;
+        dp::toString(
+            option
+            , _args[ argIndex ]
+        );
+
+        dp::String  name;
+        dp::UInt    value;
+
+        if( option == "--stats" ) {
+            options.recordPlayEvents = true;
+        } else if( option == "--meter" ) {
+            options.meter = true;
+        } else if( parseVirtualSpeakerOption(
+            virtualSpeakers
+            , _args[ argIndex ]
+        ) ) {
+            continue;
+        } else if( parseValueOption(
+            option
+            , name
+            , value
+        ) && name == "--gain" ) {
+            options.gainPercent = std::min(
+                value
+                , static_cast< dp::UInt >( GAIN_MAX * 100 )
+            );
+        } else if( parseValueOption(
+            option
+            , name
+            , value
+        ) && name == "--fade" ) {
+            options.fadeMilliseconds = value;
+        } else if( parseValueOption(
+            option
+            , name
+            , value
+        ) && name == "--crossfade" ) {
+            options.crossfadeMilliseconds = value;
+        } else {
+            break;
+        }
+    }
+
+    if( argIndex >= _args.size() ) {
         dp::String  command;
         dp::toString(
             command
             , _args[ 0 ]
         );
 
-        std::printf( "使い方: %s ファイルパス\n", command.c_str() );
+        std::printf( "使い方: %s [--stats] [--meter] [--gain=パーセント] [--fade=ミリ秒] [--crossfade=ミリ秒] [--null | --null-fast | --wavout=出力ファイルパス] ファイルパス...\n", command.c_str() );
 
         return 1;
     }
 
-    const auto &    FILE_PATH = _args[ 1 ];
-
-    auto    keyUnique = dp::unique( getSpeakerKey() );
-    if( keyUnique.get() == nullptr ) {
+    // ファイルの読み込みと並行してスピーカーを検索する
+    std::unique_ptr< SpeakerFinder >    finderUnique( newSpeakerFinder( virtualSpeakers ) );
+    if( finderUnique.get() == nullptr ) {
         std::printf( "スピーカーの検索に失敗\n" );
 
         return 1;
     }
-    const auto &    KEY = *keyUnique;
-
-    dp::AudioFormat audioFormat;
-    dp::UInt        sampleRate;
-    dp::UInt        channels;
-    WaveData        waveData;
-    if( readWav(
-        FILE_PATH
-        , audioFormat
-        , sampleRate
-        , channels
-        , waveData
+    auto &  finder = *finderUnique;
+
+    const FilePaths filePaths(
+        _args.begin() + argIndex
+        , _args.end()
+    );
+
+    std::unique_ptr< WavReader >    firstReaderUnique( new WavReader );
+    if( openWav(
+        filePaths.front()
+        , *firstReaderUnique
     ) == false ) {
         std::printf( "ファイルの解析に失敗\n" );
 
         return 1;
     }
 
-    playAudio(
-        KEY
-        , audioFormat
-        , sampleRate
-        , channels
-        , waveData
+    playPlaylist(
+        finder
+        , firstReaderUnique
+        , filePaths
+        , options
+        , START
     );
-    waveData = std::move( WaveData() );
 
     return 0;
 }
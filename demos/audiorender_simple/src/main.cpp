@@ -0,0 +1,357 @@
+﻿#include "dp/cli.h"
+#include "dp/common/primitives.h"
+#include "dp/common/stringconverter.h"
+
+#include "audiooutput.h"
+#include "wav.h"
+#include "option.h"
+#include "elapsed.h"
+
+#include <memory>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+
+#if defined( LINUX )
+#   include <limits.h>
+#   include <stdlib.h>
+#endif
+
+typedef std::chrono::steady_clock   Clock;
+
+typedef std::set< dp::String > PathSet;
+
+// 同じファイルを指すパスが一致するよう、絶対パスへ変換する
+// 変換できない場合(Linuxでは存在しないパス)はfalseを返す
+dp::Bool toAbsolutePath(
+    dp::String &            _absolutePath
+    , const dp::String &    _PATH
+)
+{
+#if defined( LINUX )
+    char    path[ PATH_MAX ];
+    if( realpath(
+        _PATH.c_str()
+        , path
+    ) == nullptr ) {
+        return false;
+    }
+
+    _absolutePath = path;
+#elif defined( WINDOWS )
+    char    path[ _MAX_PATH ];
+    if( _fullpath(
+        path
+        , _PATH.c_str()
+        , sizeof( path )
+    ) == nullptr ) {
+        return false;
+    }
+
+    // 大文字と小文字を区別しない
+    _absolutePath = path;
+    for( auto & c : _absolutePath ) {
+        c = static_cast< char >( std::tolower( static_cast< unsigned char >( c ) ) );
+    }
+#else
+    _absolutePath = _PATH;
+#endif
+
+    return true;
+}
+
+// 出力ディレクトリに入力ファイルと同じ名前で書き出す
+// _absolutePathには、入力ファイルのパスと比較するための絶対パスを格納する
+dp::Bool toOutputPath(
+    dp::Utf32 &             _outputPath
+    , dp::String &          _absolutePath
+    , const dp::String &    _OUTPUT_DIRECTORY
+    , const dp::String &    _INPUT_PATH
+)
+{
+    const auto  SEPARATOR_INDEX = _INPUT_PATH.find_last_of( "/\\" );
+    const auto  FILE_NAME = SEPARATOR_INDEX == dp::String::npos ? _INPUT_PATH : _INPUT_PATH.substr( SEPARATOR_INDEX + 1 );
+    const auto  OUTPUT_PATH = _OUTPUT_DIRECTORY + "/" + FILE_NAME;
+
+    // 出力ファイルがまだない場合は、出力ディレクトリの絶対パスから求める
+    if( toAbsolutePath(
+        _absolutePath
+        , OUTPUT_PATH
+    ) == false ) {
+        if( toAbsolutePath(
+            _absolutePath
+            , _OUTPUT_DIRECTORY
+        ) == false ) {
+            return false;
+        }
+
+        _absolutePath += "/" + FILE_NAME;
+    }
+
+    return dp::toUtf32(
+        _outputPath
+        , OUTPUT_PATH
+    );
+}
+
+void waitEnd(
+    std::mutex &                _mutex
+    , std::condition_variable & _cond
+    , const dp::Bool &          _ENDED
+)
+{
+    std::unique_lock< std::mutex >  lock( _mutex );
+
+    _cond.wait(
+        lock
+        , [
+            &_ENDED
+        ]
+        {
+            return _ENDED;
+        }
+    );
+}
+
+// WAVファイル出力の仮想スピーカーへ、再生時と同じ再生コールバックで波形データを渡す
+// 実時間の制約がないため、再生コールバック内で直接ファイルを読み込む
+dp::Bool render(
+    const dp::Utf32 &   _INPUT_PATH
+    , const dp::Utf32 & _OUTPUT_PATH
+    , dp::UInt          _periodFrames
+    , double &          _seconds
+)
+{
+    WavReader   reader;
+    if( openWav(
+        _INPUT_PATH
+        , reader
+    ) == false ) {
+        return false;
+    }
+
+    _seconds = static_cast< double >( reader.dataSize / reader.frameSize ) / reader.sampleRate;
+
+    std::mutex              mutex;
+    std::condition_variable cond;
+    dp::Bool                ended = false;
+    dp::Bool                failed = false;
+
+    AudioOutputInfo info;
+
+    setEndEventHandler(
+        info
+        , [
+            &mutex
+            , &cond
+            , &ended
+        ]
+        (
+            AudioOutput &
+        )
+        {
+            std::unique_lock< std::mutex >  lock( mutex );
+
+            ended = true;
+
+            cond.notify_one();
+        }
+    );
+    setPlayEventHandler(
+        info
+        , [
+            &reader
+            , &failed
+        ]
+        (
+            AudioOutput &
+            , void *            _buffer
+            , dp::ULong         _bufferSize
+        ) -> dp::ULong
+        {
+            dp::ULong   size = _bufferSize - _bufferSize % reader.frameSize;
+            if( readWavData(
+                reader
+                , _buffer
+                , size
+            ) == false ) {
+                failed = true;
+
+                return 0;
+            }
+
+            return size;
+        }
+    );
+    setPeriodFrames(
+        info
+        , _periodFrames
+    );
+
+    AudioOutputKey  key;
+    key.type = AudioOutputType::WAV_FILE;
+    key.filePath = _OUTPUT_PATH;
+
+    std::unique_ptr< AudioOutput >  outputUnique(
+        newAudioOutput(
+            key
+            , info
+            , reader.audioFormat
+            , reader.sampleRate
+            , reader.channels
+        )
+    );
+    if( outputUnique.get() == nullptr ) {
+        return false;
+    }
+
+    waitEnd(
+        mutex
+        , cond
+        , ended
+    );
+
+    return failed == false;
+}
+
+dp::Int dpMain(
+    dp::Args &  _args
+)
+{
+    dp::UInt    periodFrames = 0;
+
+    std::size_t argIndex = 1;
+    for( ; argIndex < _args.size() ; argIndex++ ) {
+        dp::String  option;
+        dp::toString(
+            option
+            , _args[ argIndex ]
+        );
+
+        dp::String  name;
+        dp::UInt    value;
+        if( parseValueOption(
+            option
+            , name
+            , value
+        ) && name == "--period" && value > 0 ) {
+            periodFrames = value;
+        } else {
+            break;
+        }
+    }
+
+    if( argIndex + 2 > _args.size() ) {
+        dp::String  command;
+        dp::toString(
+            command
+            , _args[ 0 ]
+        );
+
+        std::printf( "使い方: %s [--period=フレーム数] 出力ディレクトリ ファイルパス...\n", command.c_str() );
+
+        return 1;
+    }
+
+    dp::String  outputDirectory;
+    dp::toString(
+        outputDirectory
+        , _args[ argIndex ]
+    );
+    argIndex++;
+
+    // 書き出しで入力ファイルを上書きしないよう、全入力ファイルの絶対パスを控えておく
+    PathSet inputPaths;
+    for( auto i = argIndex ; i < _args.size() ; i++ ) {
+        dp::String  inputPath;
+        dp::String  absolutePath;
+        if( dp::toString(
+            inputPath
+            , _args[ i ]
+        ) && toAbsolutePath(
+            absolutePath
+            , inputPath
+        ) ) {
+            inputPaths.insert( absolutePath );
+        }
+    }
+    PathSet outputPaths;
+
+    dp::UInt    renderedFiles = 0;
+    double      totalSeconds = 0;
+
+    const auto  BEGIN = Clock::now();
+
+    for( ; argIndex < _args.size() ; argIndex++ ) {
+        dp::String  inputPath;
+        dp::Utf32   outputPath;
+        dp::String  absoluteOutputPath;
+        if( dp::toString(
+            inputPath
+            , _args[ argIndex ]
+        ) == false || toOutputPath(
+            outputPath
+            , absoluteOutputPath
+            , outputDirectory
+            , inputPath
+        ) == false ) {
+            std::printf( "出力ファイルパスの生成に失敗[%u]\n", static_cast< dp::UInt >( argIndex ) );
+
+            continue;
+        }
+
+        if( inputPaths.count( absoluteOutputPath ) > 0 ) {
+            std::printf( "出力ファイルが入力ファイルと同じため書き出さない[%u]\n", static_cast< dp::UInt >( argIndex ) );
+
+            continue;
+        }
+
+        if( outputPaths.insert( absoluteOutputPath ).second == false ) {
+            std::printf( "出力ファイル名が重複するため書き出さない[%u]\n", static_cast< dp::UInt >( argIndex ) );
+
+            continue;
+        }
+
+        const auto  FILE_BEGIN = Clock::now();
+
+        double  seconds;
+        if( render(
+            _args[ argIndex ]
+            , outputPath
+            , periodFrames
+            , seconds
+        ) == false ) {
+            std::printf( "書き出しに失敗[%u]\n", static_cast< dp::UInt >( argIndex ) );
+
+            continue;
+        }
+
+        const auto  ELAPSED_SECONDS = toSeconds( Clock::now() - FILE_BEGIN );
+
+        dp::String  filePath;
+        dp::toString(
+            filePath
+            , outputPath
+        );
+        std::printf( "%s: 音声%.2f秒を%.2fmsで書き出し(実時間比%.0f倍)\n", filePath.c_str(), seconds, ELAPSED_SECONDS * 1000, seconds / ELAPSED_SECONDS );
+
+        renderedFiles++;
+        totalSeconds += seconds;
+    }
+
+    const auto  ELAPSED_SECONDS = toSeconds( Clock::now() - BEGIN );
+
+    std::printf( "書き出したファイル数: %u\n", renderedFiles );
+    std::printf( "音声の長さの合計: %.2f秒\n", totalSeconds );
+    std::printf( "所要時間: %.3f秒\n", ELAPSED_SECONDS );
+    if( ELAPSED_SECONDS > 0 ) {
+        std::printf( "実時間比: %.0f倍\n", totalSeconds / ELAPSED_SECONDS );
+        std::printf( "ファイル数毎秒: %.1f\n", renderedFiles / ELAPSED_SECONDS );
+    }
+
+    return renderedFiles > 0 ? 0 : 1;
+}
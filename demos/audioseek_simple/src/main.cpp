@@ -0,0 +1,618 @@
+﻿#include "dp/cli.h"
+#include "dp/common/primitives.h"
+#include "dp/common/stringconverter.h"
+#include "dp/audio/audioformat.h"
+#include "dp/common/thread.h"
+
+#include "speaker.h"
+#include "audiooutput.h"
+#include "wav.h"
+#include "audiostream.h"
+#include "realtimecheck.h"
+#include "option.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+
+const auto  STREAM_BUFFER_MILLISECONDS = 250;
+const auto  READ_FRAMES = 1024;
+
+const auto  DEFAULT_SEEKS = 50;
+const auto  DEFAULT_INTERVAL_MILLISECONDS = 300;
+const auto  AUDIBLE_TIMEOUT_MILLISECONDS = 2000;
+
+const auto  DEFAULT_BENCHMARK_SEEKS = 10000;
+const auto  BENCHMARK_READ_FRAMES = 4096;
+
+DEFINE_REALTIME_ALLOCATION_CHECK
+
+typedef std::chrono::steady_clock   Clock;
+
+// シークの要求と、その波形データが出力されるまでの経過を受け渡す
+// シークのn回目の要求は、AudioStreamのn世代目の破棄要求に対応する
+struct SeekProbe
+{
+    // 制御スレッド→生産者スレッド
+    std::atomic< dp::ULong >    requestedGeneration;
+    std::atomic< dp::ULong >    targetFrame;
+
+    // 生産者スレッド→制御スレッド
+    std::atomic< dp::ULong >    handledGeneration;
+    std::atomic< dp::Long >     repositionNanoseconds;  // seekWav()にかかった時間
+    std::atomic< dp::Long >     flushNanoseconds;       // 破棄の完了を待った時間
+
+    // 再生コールバック→制御スレッド
+    // 破棄後の波形データを書き込み始めた、出力先のフレーム
+    std::atomic< dp::ULong >    audibleGeneration;
+    std::atomic< dp::ULong >    audibleFrame;
+
+    // 再生コールバック側の変数
+    dp::Bool    waiting;
+
+    SeekProbe(
+    )
+        : requestedGeneration( 0 )
+        , targetFrame( 0 )
+        , handledGeneration( 0 )
+        , repositionNanoseconds( 0 )
+        , flushNanoseconds( 0 )
+        , audibleGeneration( 0 )
+        , audibleFrame( 0 )
+        , waiting( false )
+    {
+    }
+};
+
+dp::Long toNanoseconds(
+    const Clock::duration & _DURATION
+)
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >( _DURATION ).count();
+}
+
+// RAND_MAXが小さい環境でも長いファイル全体から選べるよう、複数回の乱数を連結する
+dp::ULong randomFrame(
+    dp::ULong   _frames
+)
+{
+    if( _frames <= 0 ) {
+        return 0;
+    }
+
+    const auto  VALUE = ( static_cast< dp::ULong >( std::rand() ) << 30 )
+        ^ ( static_cast< dp::ULong >( std::rand() ) << 15 )
+        ^ static_cast< dp::ULong >( std::rand() )
+    ;
+
+    return VALUE % _frames;
+}
+
+void printMilliseconds(
+    const char *                _NAME
+    , std::vector< double > &   _values
+)
+{
+    if( _values.empty() ) {
+        return;
+    }
+
+    std::sort(
+        _values.begin()
+        , _values.end()
+    );
+
+    const auto  LAST = _values.size() - 1;
+
+    std::printf(
+        "%s: min=%.3fms p50=%.3fms p99=%.3fms max=%.3fms\n"
+        , _NAME
+        , _values.front()
+        , _values[ LAST * 50 / 100 ]
+        , _values[ LAST * 99 / 100 ]
+        , _values.back()
+    );
+}
+
+// シークの要求を受けると、読み込み位置を移して溜まったデータを破棄させ、移動先から先読みをやり直す
+// ファイルの終端に達してもストリームは終端とせず、次のシークを待つ
+void produceStream(
+    WavReader &                         _reader
+    , AudioStream &                     _stream
+    , SeekProbe &                       _probe
+    , const std::atomic< dp::Bool > &   _STOPPED
+)
+{
+    WaveData    buffer( READ_FRAMES * _reader.frameSize );
+    dp::ULong   bufferedSize = 0;
+    dp::ULong   writtenSize = 0;
+    dp::Bool    eof = false;
+
+    dp::ULong   handledGeneration = 0;
+
+    while( _STOPPED == false ) {
+        const auto  REQUESTED_GENERATION = _probe.requestedGeneration.load( std::memory_order_acquire );
+        if( REQUESTED_GENERATION != handledGeneration ) {
+            const auto  BEGIN = Clock::now();
+
+            if( seekWav(
+                _reader
+                , _probe.targetFrame.load( std::memory_order_relaxed )
+            ) == false ) {
+                break;
+            }
+
+            const auto  REPOSITIONED = Clock::now();
+
+            waitAudioStreamFlushed(
+                _stream
+                , requestFlushAudioStream( _stream )
+                , _STOPPED
+            );
+
+            bufferedSize = 0;
+            writtenSize = 0;
+            eof = false;
+
+            handledGeneration = REQUESTED_GENERATION;
+
+            _probe.repositionNanoseconds = toNanoseconds( REPOSITIONED - BEGIN );
+            _probe.flushNanoseconds = toNanoseconds( Clock::now() - REPOSITIONED );
+            _probe.handledGeneration.store(
+                handledGeneration
+                , std::memory_order_release
+            );
+        }
+
+        if( writtenSize >= bufferedSize && eof == false ) {
+            dp::ULong   size = buffer.size();
+            if( readWavData(
+                _reader
+                , buffer.data()
+                , size
+            ) == false ) {
+                break;
+            }
+
+            bufferedSize = size;
+            writtenSize = 0;
+            eof = size <= 0;
+        }
+
+        if( writtenSize < bufferedSize ) {
+            const auto  WRITTEN_SIZE = tryWriteAudioStream(
+                _stream
+                , buffer.data() + writtenSize
+                , bufferedSize - writtenSize
+            );
+            writtenSize += WRITTEN_SIZE;
+
+            if( WRITTEN_SIZE > 0 ) {
+                continue;
+            }
+        }
+
+        // シークの要求に素早く応えるため、短い間隔で確認する
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+
+    endAudioStream( _stream );
+}
+
+// 破棄後の波形データを最初に書き込んだ出力先のフレームを記録する
+dp::ULong readSeekStream(
+    AudioStream &       _stream
+    , SeekProbe &       _probe
+    , AudioOutput &     _output
+    , void *            _buffer
+    , dp::ULong         _bufferSize
+)
+{
+    if( flushAudioStream( _stream ) ) {
+        _probe.waiting = true;
+    }
+
+    const auto  READABLE_SIZE = _stream.ringBuffer.getReadableSize();
+
+    const auto  SIZE = readAudioStream(
+        _stream
+        , _output
+        , _buffer
+        , _bufferSize
+    );
+
+    // 破棄直後はリングバッファが空のため、読み込めたデータはバッファの先頭から並ぶ
+    if( _probe.waiting && READABLE_SIZE > 0 ) {
+        _probe.waiting = false;
+
+        _probe.audibleFrame.store(
+            _output.renderedFrames
+            , std::memory_order_relaxed
+        );
+        _probe.audibleGeneration.store(
+            _stream.flushedGeneration.load( std::memory_order_relaxed )
+            , std::memory_order_release
+        );
+    }
+
+    return SIZE;
+}
+
+// ランダムな位置へ一定間隔でシークし、要求から移動先の波形データが出力されるまでの時間を計測する
+void measureSeek(
+    const AudioOutputKey &  _KEY
+    , WavReader &           _reader
+    , dp::UInt              _seeks
+    , dp::UInt              _intervalMilliseconds
+)
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    dp::Bool                ended = false;
+
+    AudioStream stream(
+        static_cast< std::size_t >( _reader.sampleRate ) * _reader.frameSize * STREAM_BUFFER_MILLISECONDS / 1000
+        , _reader.audioFormat
+        , _reader.frameSize
+    );
+
+    SeekProbe   probe;
+
+    AudioOutputInfo info;
+
+    setEndEventHandler(
+        info
+        , [
+            &mutex
+            , &cond
+            , &ended
+        ]
+        (
+            AudioOutput &
+        )
+        {
+            std::unique_lock< std::mutex >  lock( mutex );
+
+            ended = true;
+
+            cond.notify_one();
+        }
+    );
+    setPlayEventHandler(
+        info
+        , [
+            &stream
+            , &probe
+        ]
+        (
+            AudioOutput &       _output
+            , void *            _buffer
+            , dp::ULong         _bufferSize
+        ) -> dp::ULong
+        {
+            RealtimeScope   realtimeScope;
+
+            return readSeekStream(
+                stream
+                , probe
+                , _output
+                , _buffer
+                , _bufferSize
+            );
+        }
+    );
+
+    std::atomic< dp::Bool > stopped( false );
+    std::thread producerThread(
+        [
+            &_reader
+            , &stream
+            , &probe
+            , &stopped
+        ]
+        {
+            produceStream(
+                _reader
+                , stream
+                , probe
+                , stopped
+            );
+        }
+    );
+    dp::ThreadJoiner    producerThreadJoiner( &producerThread );
+
+    std::unique_ptr< AudioOutput >  outputUnique(
+        newAudioOutput(
+            _KEY
+            , info
+            , _reader.audioFormat
+            , _reader.sampleRate
+            , _reader.channels
+        )
+    );
+    if( outputUnique.get() == nullptr ) {
+        std::printf( "出力の開始に失敗\n" );
+
+        stopped = true;
+
+        return;
+    }
+    const auto &    OUTPUT = *outputUnique;
+
+    // 移動先の直後に終端へ達して無音にならないよう、シークの間隔の2倍を残した範囲から選ぶ
+    const auto  FRAMES = _reader.dataSize / _reader.frameSize;
+    const auto  TAIL_FRAMES = static_cast< dp::ULong >( _reader.sampleRate ) * _intervalMilliseconds * 2 / 1000;
+    const auto  SEEKABLE_FRAMES = FRAMES > TAIL_FRAMES ? FRAMES - TAIL_FRAMES : 1;
+
+    std::vector< double >   repositionMilliseconds;
+    std::vector< double >   flushMilliseconds;
+    std::vector< double >   audibleMilliseconds;
+    dp::UInt                timeouts = 0;
+
+    for( dp::UInt i = 0 ; i < _seeks ; i++ ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( _intervalMilliseconds ) );
+
+        const dp::ULong GENERATION = i + 1;
+
+        const auto  REQUEST_TIME = Clock::now();
+
+        probe.targetFrame.store(
+            randomFrame( SEEKABLE_FRAMES )
+            , std::memory_order_relaxed
+        );
+        probe.requestedGeneration.store(
+            GENERATION
+            , std::memory_order_release
+        );
+
+        const auto  TIMEOUT = REQUEST_TIME + std::chrono::milliseconds( AUDIBLE_TIMEOUT_MILLISECONDS );
+
+        while( probe.audibleGeneration.load( std::memory_order_acquire ) < GENERATION && Clock::now() < TIMEOUT ) {
+            std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+        }
+        if( probe.audibleGeneration.load( std::memory_order_acquire ) < GENERATION ) {
+            timeouts++;
+
+            continue;
+        }
+        const auto  AUDIBLE_FRAME = probe.audibleFrame.load( std::memory_order_relaxed );
+
+        // 再生位置が移動先の先頭フレームを越えたら、越えた分を差し引いて出力された時刻を求める
+        AudioOutputPosition position;
+        dp::Bool            audible = false;
+        while( Clock::now() < TIMEOUT ) {
+            if( getPlaybackPosition(
+                OUTPUT
+                , position
+            ) && position.frame >= AUDIBLE_FRAME ) {
+                audible = true;
+
+                break;
+            }
+
+            std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+        }
+        if( audible == false ) {
+            timeouts++;
+
+            continue;
+        }
+
+        const auto  AUDIBLE_TIME = position.time - std::chrono::nanoseconds( static_cast< dp::Long >( position.frame - AUDIBLE_FRAME ) * 1000000000 / OUTPUT.sampleRate );
+
+        audibleMilliseconds.push_back( toNanoseconds( AUDIBLE_TIME - REQUEST_TIME ) * 1e-6 );
+
+        if( probe.handledGeneration.load( std::memory_order_acquire ) >= GENERATION ) {
+            repositionMilliseconds.push_back( probe.repositionNanoseconds * 1e-6 );
+            flushMilliseconds.push_back( probe.flushNanoseconds * 1e-6 );
+        }
+    }
+
+    stopped = true;
+
+    {
+        std::unique_lock< std::mutex >  lock( mutex );
+
+        cond.wait(
+            lock
+            , [
+                &ended
+            ]
+            {
+                return ended;
+            }
+        );
+    }
+
+    AudioOutputParameters   parameters;
+    if( getAudioOutputParameters(
+        OUTPUT
+        , parameters
+    ) ) {
+        if( parameters.bufferingKnown ) {
+            std::printf( "出力先に溜まる最大の長さ: %.2fms\n", parameters.latencyFrames * 1000.0 / OUTPUT.sampleRate );
+        } else {
+            std::printf( "出力先に溜まる最大の長さ: 不明(出力先から取得できない)\n" );
+        }
+    }
+
+    std::printf( "シーク回数: %u (計測できなかった回数: %u)\n", _seeks, timeouts );
+    printMilliseconds(
+        "読み込み位置の移動"
+        , repositionMilliseconds
+    );
+    printMilliseconds(
+        "溜まったデータの破棄"
+        , flushMilliseconds
+    );
+    printMilliseconds(
+        "要求から出力まで"
+        , audibleMilliseconds
+    );
+    std::printf( "アンダーラン回数: %llu\n", stream.underruns.load() );
+    printRealtimeCheck();
+}
+
+// ランダムな位置へのシークと、移動先からの読み込みを繰り返し、1回あたりの時間を計測する
+// ファイルがOSのキャッシュに載っていない場合は、ストレージの読み込み時間を含む
+void benchmark(
+    WavReader & _reader
+    , dp::UInt  _seeks
+)
+{
+    const auto  FRAMES = _reader.dataSize / _reader.frameSize;
+
+    WaveData    buffer( BENCHMARK_READ_FRAMES * _reader.frameSize );
+
+    std::vector< double >   seekMilliseconds;
+    seekMilliseconds.reserve( _seeks );
+
+    const auto  BEGIN = Clock::now();
+
+    for( dp::UInt i = 0 ; i < _seeks ; i++ ) {
+        const auto  SEEK_BEGIN = Clock::now();
+
+        if( seekWav(
+            _reader
+            , randomFrame( FRAMES )
+        ) == false ) {
+            return;
+        }
+
+        dp::ULong   size = buffer.size();
+        if( readWavData(
+            _reader
+            , buffer.data()
+            , size
+        ) == false ) {
+            return;
+        }
+
+        seekMilliseconds.push_back( toNanoseconds( Clock::now() - SEEK_BEGIN ) * 1e-6 );
+    }
+
+    const auto  ELAPSED_SECONDS = std::chrono::duration_cast< std::chrono::duration< double > >( Clock::now() - BEGIN ).count();
+
+    std::printf( "波形データ: %lluフレーム (%.1f秒, %.1fMB)\n", FRAMES, static_cast< double >( FRAMES ) / _reader.sampleRate, _reader.encodedDataSize / ( 1024.0 * 1024.0 ) );
+    std::printf( "シーク回数: %u (1回あたり%uフレーム読み込み)\n", _seeks, BENCHMARK_READ_FRAMES );
+    printMilliseconds(
+        "シークと読み込み"
+        , seekMilliseconds
+    );
+    std::printf( "秒間シーク回数: %.0f\n", _seeks / ELAPSED_SECONDS );
+}
+
+dp::Int dpMain(
+    dp::Args &  _args
+)
+{
+    VirtualSpeakers virtualSpeakers;
+    dp::Bool        bench = false;
+    dp::UInt        seeks = 0;
+    dp::UInt        intervalMilliseconds = DEFAULT_INTERVAL_MILLISECONDS;
+
+    std::size_t argIndex = 1;
+    for( ; argIndex < _args.size() ; argIndex++ ) {
+        if( parseVirtualSpeakerOption(
+            virtualSpeakers
+            , _args[ argIndex ]
+        ) ) {
+            continue;
+        }
+
+        dp::String  option;
+        dp::toString(
+            option
+            , _args[ argIndex ]
+        );
+
+        if( option == "--bench" ) {
+            bench = true;
+
+            continue;
+        }
+
+        dp::String  name;
+        dp::UInt    value;
+        if( parseValueOption(
+            _args[ argIndex ]
+            , name
+            , value
+        ) ) {
+            if( name == "--seeks" && value > 0 ) {
+                seeks = value;
+
+                continue;
+            } else if( name == "--interval" && value > 0 ) {
+                intervalMilliseconds = value;
+
+                continue;
+            }
+        }
+
+        break;
+    }
+
+    if( argIndex + 1 != _args.size() ) {
+        dp::String  command;
+        dp::toString(
+            command
+            , _args[ 0 ]
+        );
+
+        std::printf( "使い方: %s [--null] [--seeks=回数] [--interval=ミリ秒] ファイルパス\n", command.c_str() );
+        std::printf( "        %s --bench [--seeks=回数] ファイルパス\n", command.c_str() );
+
+        return 1;
+    }
+
+    WavReader   reader;
+    if( openWav(
+        _args[ argIndex ]
+        , reader
+    ) == false ) {
+        std::printf( "ファイルの解析に失敗\n" );
+
+        return 1;
+    }
+
+    if( bench ) {
+        benchmark(
+            reader
+            , seeks > 0 ? seeks : DEFAULT_BENCHMARK_SEEKS
+        );
+
+        return 0;
+    }
+
+    std::unique_ptr< AudioOutputKey >   keyUnique( getAudioOutputKey( virtualSpeakers ) );
+    if( keyUnique.get() == nullptr ) {
+        std::printf( "スピーカーの検索に失敗\n" );
+
+        return 1;
+    }
+    const auto &    KEY = *keyUnique;
+
+    // 出力された時刻は実時間の出力先でのみ意味を持つ
+    if( isRealtimeAudioOutput( KEY.type ) == false ) {
+        std::printf( "実時間の出力先(スピーカーか--null)を指定すること\n" );
+
+        return 1;
+    }
+
+    measureSeek(
+        KEY
+        , reader
+        , seeks > 0 ? seeks : DEFAULT_SEEKS
+        , intervalMilliseconds
+    );
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+﻿#ifndef COMMON_ADPCM_H
+#define COMMON_ADPCM_H
+
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+const dp::UInt  ADPCM_CHANNELS_MAX = 8;
+
+enum class AdpcmFormat
+{
+    IMA,
+    MS,
+};
+
+// ADPCMのブロックをS16LEへ展開する
+// ブロックは互いに独立しているため、ファイルを先頭から順に1ブロックずつ展開できる
+struct AdpcmDecoder
+{
+    AdpcmFormat format;
+    dp::UInt    channels;
+    dp::UInt    blockSize;
+    dp::UInt    samplesPerBlock;
+
+    // MS-ADPCMの予測係数(係数1、係数2の組)
+    std::vector< std::int16_t > coefficients;
+};
+
+// _blockSizeバイトのブロックに含まれるフレーム数を返す
+// 末尾の短いブロックにも対応する
+std::size_t getAdpcmBlockFrames(
+    const AdpcmDecoder &
+    , std::size_t
+);
+
+// MS-ADPCMの標準の予測係数を設定する
+void setDefaultMsAdpcmCoefficients(
+    AdpcmDecoder &
+);
+
+// _blockSizeバイトのブロックを展開し、展開したフレーム数を返す
+// _destinationにはgetAdpcmBlockFrames()フレーム分の領域が必要
+// ブロックが壊れている場合は0を返す
+std::size_t decodeAdpcmBlock(
+    const AdpcmDecoder &
+    , const dp::Byte *
+    , std::size_t
+    , std::int16_t *
+);
+
+#endif  // COMMON_ADPCM_H
@@ -0,0 +1,122 @@
+﻿#ifndef COMMON_ANALYZER_H
+#define COMMON_ANALYZER_H
+
+#include "ringbuffer.h"
+#include "fft.h"
+
+#include "dp/audio/audioformat.h"
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+
+const auto  ANALYZER_FFT_SIZE = 1024;
+const auto  ANALYZER_BANDS = 10;
+const auto  ANALYZER_CHANNELS_MAX = 8;
+
+// 値はフルスケールを1とした振幅
+// 帯域ごとの値は、その帯域の成分の実効値となる
+struct AnalyzerResult
+{
+    dp::Float   peak;
+    dp::Float   rms;
+    dp::Float   bands[ ANALYZER_BANDS ];
+};
+
+struct AnalyzerChannel
+{
+    std::atomic< dp::Float >    peak;
+    std::atomic< dp::Float >    rms;
+    std::atomic< dp::Float >    bands[ ANALYZER_BANDS ];
+};
+
+// 出力先へ渡す波形データを再生コールバックからリングバッファへ写し、解析スレッドでFFTにかける
+// 解析はANALYZER_FFT_SIZEフレームごとに重ねずに行う
+// U8とS16LEのみ対応する
+struct AudioAnalyzer
+{
+    dp::AudioFormat audioFormat;
+    dp::UInt        sampleRate;
+    dp::UInt        channels;
+    dp::UInt        frameSize;
+
+    // 再生コールバック→解析スレッド
+    // 空きが足りない場合はバッファ単位で捨てる
+    RingBuffer< dp::Byte >      samples;
+    std::atomic< dp::ULong >    droppedFrames;
+
+    // 解析結果
+    // 解析スレッドが書き込み、sequenceが奇数の間は書き換え中を表す
+    std::atomic< dp::ULong >    sequence;
+    AnalyzerChannel             results[ ANALYZER_CHANNELS_MAX ];
+
+    // 解析したフレーム数と、解析にかかった時間(ナノ秒)
+    std::atomic< dp::ULong >    analyzedFrames;
+    std::atomic< dp::Long >     analysisNanoseconds;
+
+    // 解析スレッドの変数
+    Fft                         fft;
+    std::vector< dp::Float >    window;
+    dp::Float                   windowPower;
+    std::vector< std::size_t >  bandBins;   // 帯域ごとの先頭のビン、末尾に終端のビン
+    std::vector< dp::Byte >     block;
+    std::vector< dp::Float >    real;
+    std::vector< dp::Float >    imaginary;
+
+    std::atomic< dp::Bool > stopped;
+    std::thread             thread;
+
+    AudioAnalyzer(
+        dp::AudioFormat
+        , dp::UInt
+        , dp::UInt
+    );
+
+    ~AudioAnalyzer(
+    );
+};
+
+// 生成と同時に解析スレッドを開始する
+// 非対応のフォーマット、チャンネル数の場合はnullptrを返す
+AudioAnalyzer * newAudioAnalyzer(
+    dp::AudioFormat
+    , dp::UInt
+    , dp::UInt
+);
+
+// 解析結果をブロックせずに取得する
+// まだ解析していない場合はfalseを返す
+dp::Bool getAnalyzerResult(
+    const AudioAnalyzer &
+    , dp::UInt
+    , AnalyzerResult &
+);
+
+// 再生コールバックから呼び出す
+// コピーのみを行い、ロック・メモリ確保・システムコールは行わない(RealtimeScopeで検査する)
+inline void tapAudioAnalyzer(
+    AudioAnalyzer &     _analyzer
+    , const void *      _BUFFER
+    , std::size_t       _frames
+)
+{
+    const auto  SIZE = _frames * _analyzer.frameSize;
+
+    if( _analyzer.samples.getWritableSize() < SIZE ) {
+        _analyzer.droppedFrames.fetch_add(
+            _frames
+            , std::memory_order_relaxed
+        );
+
+        return;
+    }
+
+    _analyzer.samples.write(
+        static_cast< const dp::Byte * >( _BUFFER )
+        , SIZE
+    );
+}
+
+#endif  // COMMON_ANALYZER_H
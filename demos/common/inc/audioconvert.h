@@ -0,0 +1,61 @@
+﻿#ifndef COMMON_AUDIOCONVERT_H
+#define COMMON_AUDIOCONVERT_H
+
+#include "dp/audio/audioformat.h"
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// _audioFormat、_channelsの波形データ_framesフレーム分を、S16LEステレオへ変換する
+// モノラルは両チャンネルへ複製し、3チャンネル以上は先頭2チャンネルのみを使用する
+void convertToS16Stereo(
+    dp::AudioFormat
+    , dp::UInt
+    , const void *
+    , std::size_t
+    , std::int16_t *
+);
+
+// フォーマット、チャンネル数、サンプリングレートを変換する
+// サンプリングレートは線形補間で変換し、ブロック境界をまたいで補間できるよう直前のフレームを保持する
+// チャンネル数が増える場合、モノラルは全チャンネルへ複製し、それ以外は無音で埋める
+// チャンネル数がモノラルへ減る場合は全チャンネルを平均する
+struct AudioConverter
+{
+    dp::AudioFormat sourceFormat;
+    dp::UInt        sourceSampleRate;
+    dp::UInt        sourceChannels;
+
+    dp::AudioFormat destinationFormat;
+    dp::UInt        destinationSampleRate;
+    dp::UInt        destinationChannels;
+
+    dp::Bool            passthrough;
+    double              step;
+    double              position;
+    std::vector< float >    previousFrame;
+    std::vector< float >    sourceBuffer;
+};
+
+void initAudioConverter(
+    AudioConverter &
+    , dp::AudioFormat
+    , dp::UInt
+    , dp::UInt
+    , dp::AudioFormat
+    , dp::UInt
+    , dp::UInt
+);
+
+// 変換元の_framesフレーム分を変換して_destinationへ格納し、変換後のフレーム数を返す
+// _destinationは必要に応じて拡張される
+std::size_t convertAudio(
+    AudioConverter &
+    , const void *
+    , std::size_t
+    , std::vector< dp::Byte > &
+);
+
+#endif  // COMMON_AUDIOCONVERT_H
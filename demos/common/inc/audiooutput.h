@@ -0,0 +1,334 @@
+﻿#ifndef COMMON_AUDIOOUTPUT_H
+#define COMMON_AUDIOOUTPUT_H
+
+#include "wav.h"
+#include "analyzer.h"
+
+#include "dp/audio/speakermanager.h"
+#include "dp/audio/speakerkey.h"
+#include "dp/audio/audioplayer.h"
+#include "dp/audio/audioformat.h"
+#include "dp/common/primitives.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+// 出力先の種別
+// SPEAKER以外は実デバイスを使わない仮想スピーカーで、
+// 再生コールバックを同じ手順で呼び出すため、サウンドデバイスのない環境でも再生処理を実行できる
+enum class AudioOutputType
+{
+    SPEAKER,
+    NULL_REALTIME,  // 実時間の速度で波形データを読み捨てる
+    NULL_FAST,      // 可能な限りの速度で波形データを読み捨てる
+    WAV_FILE,       // 可能な限りの速度でWAVファイルへ書き出す
+};
+
+// 再生コールバックに実時間の制約がある出力先ならtrueを返す
+inline dp::Bool isRealtimeAudioOutput(
+    AudioOutputType _type
+)
+{
+    return _type == AudioOutputType::SPEAKER || _type == AudioOutputType::NULL_REALTIME;
+}
+
+struct AudioOutputKey
+{
+    AudioOutputType         type;
+    dp::SpeakerKeyUnique    speakerKeyUnique;
+    dp::Utf32               filePath;
+};
+
+typedef std::unique_ptr< AudioOutputKey > AudioOutputKeyUnique;
+
+struct VirtualSpeaker
+{
+    AudioOutputType type;
+    dp::Utf32       filePath;
+};
+
+typedef std::vector< VirtualSpeaker > VirtualSpeakers;
+
+// --null、--null-fast、--wavout=ファイルパスを仮想スピーカーとして解釈する
+// 該当しないオプションの場合はfalseを返す
+dp::Bool parseVirtualSpeakerOption(
+    VirtualSpeakers &
+    , const dp::Utf32 &
+);
+
+struct AudioOutputManager;
+
+typedef std::function<
+    void (
+        AudioOutputManager &
+        , AudioOutputKeyUnique &&
+        , dp::Bool
+    )
+> AudioOutputConnectEventHandler;
+
+struct AudioOutputManagerInfo
+{
+    AudioOutputConnectEventHandler  connectEventHandler;
+    VirtualSpeakers                 virtualSpeakers;
+};
+
+typedef decltype( dp::unique( static_cast< dp::SpeakerManager * >( nullptr ) ) ) SpeakerManagerUnique;
+
+struct AudioOutputManager
+{
+    AudioOutputManagerInfo  info;
+    SpeakerManagerUnique    speakerManagerUnique;
+};
+
+void setConnectEventHandler(
+    AudioOutputManagerInfo &
+    , const AudioOutputConnectEventHandler &
+);
+
+void addVirtualSpeaker(
+    AudioOutputManagerInfo &
+    , const VirtualSpeaker &
+);
+
+// 仮想スピーカーは生成時に接続イベントを発行し、実スピーカーはdp::SpeakerManagerの接続イベントを中継する
+// 仮想スピーカーがある場合、dp::SpeakerManagerの生成に失敗しても処理を続ける
+AudioOutputManager * newAudioOutputManager(
+    const AudioOutputManagerInfo &
+);
+
+struct AudioOutput;
+
+typedef std::function<
+    void (
+        AudioOutput &
+    )
+> AudioOutputEndEventHandler;
+
+typedef std::function<
+    dp::ULong (
+        AudioOutput &
+        , void *
+        , dp::ULong
+    )
+> AudioOutputPlayEventHandler;
+
+// 出力先のフォーマットで用意済みの波形データを、コピーせずに受け渡す再生コールバック
+// 最大_bufferSizeバイトの波形データの先頭を_dataに格納し、そのバイト数を返す
+// 仮想スピーカーは_dataの指す領域をそのまま出力し、実スピーカーはdp::AudioPlayerのバッファへ1回だけコピーする
+// _dataの指す領域は、プレゼントイベントでその波形データが通知されるまで書き換えないこと
+typedef std::function<
+    dp::ULong (
+        AudioOutput &
+        , const void * &
+        , dp::ULong
+    )
+> AudioOutputPlayDataEventHandler;
+
+// 仮想スピーカーで、再生コールバックが書き込んだ波形データが出力される時点で呼び出される
+// 遅延を測るためのループバックとして使う
+typedef std::function<
+    void (
+        AudioOutput &
+        , const void *
+        , dp::ULong
+    )
+> AudioOutputPresentEventHandler;
+
+// 再生コールバックの波形データの出力開始を、scheduleAudioOutputStart()で指定するまで保留する
+const auto  AUDIO_OUTPUT_START_PENDING = static_cast< dp::ULong >( -1 );
+
+// 遅延に関する値が0の場合は出力先の既定値を使う
+// 実スピーカーではdp::AudioPlayerへ渡す手段がないため、遅延に関する値は反映されない(指定した場合は警告を表示する)
+struct AudioOutputInfo
+{
+    AudioOutputEndEventHandler      endEventHandler;
+    AudioOutputPlayEventHandler     playEventHandler;
+    AudioOutputPlayDataEventHandler playDataEventHandler;
+    AudioOutputPresentEventHandler  presentEventHandler;
+
+    dp::UInt    latencyMilliseconds;    // 出力先に溜める波形データの長さの上限
+    dp::UInt    periodFrames;           // 1回の再生コールバックで要求するフレーム数
+    dp::UInt    bufferCount;            // 出力先に溜める周期の数
+    dp::Bool    realtimeScheduling;     // 再生コールバックを呼び出すスレッドを実時間優先度にする
+
+    // nullptrでなければ、再生コールバックが返した波形データを解析へ回す
+    AudioAnalyzer * analyzer;
+
+    // 出力先のこのフレームから再生コールバックの波形データを出力し、それまでは無音を出力する
+    dp::ULong   startFrame;
+
+    AudioOutputInfo(
+    );
+};
+
+// 出力先が実際に採用した値
+struct AudioOutputParameters
+{
+    dp::UInt    periodFrames;
+    dp::Bool    realtimeScheduling;
+
+    // 出力先に溜める量を取得できた場合のみtrue
+    // 実スピーカーはdp::AudioPlayerから取得できず、NULL_FAST・WAV_FILEは実時間で出力しないため溜める量を持たない
+    // falseの場合、bufferCountとlatencyFramesは0で、遅延が0であることを表すものではない
+    dp::Bool    bufferingKnown;
+    dp::UInt    bufferCount;
+    dp::UInt    latencyFrames;
+};
+
+// 出力先でtimeの時点に出力されているフレーム
+// フレームは出力の開始からの通し番号で、開始前の無音も含む
+struct AudioOutputPosition
+{
+    dp::ULong                               frame;
+    std::chrono::steady_clock::time_point   time;
+};
+
+typedef decltype( dp::unique( static_cast< dp::AudioPlayer * >( nullptr ) ) ) AudioPlayerUnique;
+
+struct AudioOutput
+{
+    AudioOutputInfo info;
+
+    AudioOutputType type;
+    dp::AudioFormat audioFormat;
+    dp::UInt        sampleRate;
+    dp::UInt        channels;
+    dp::UInt        frameSize;
+    dp::UInt        periodFrames;
+    dp::UInt        bufferCount;
+
+    // 後に宣言したメンバをコールバックが参照するため、デストラクタで最初に破棄する
+    AudioPlayerUnique   audioPlayerUnique;
+
+    // 再生コールバックの初回呼び出しで確定する値
+    std::atomic< dp::UInt > callbackFrames;
+    std::atomic< dp::Bool > realtimeScheduled;
+
+    // 再生コールバックが初めて波形データを返した時刻(steady_clockのエポックからのナノ秒)
+    // 未到達の場合は0
+    std::atomic< dp::Long > firstPlayNanoseconds;
+
+    // 再生位置の基準点
+    // clockNanosecondsの時点でclockFramesを出力しており、以降はclockLimitFramesまで実時間で進むものとする
+    // 出力側のスレッドが書き込み、clockSequenceが奇数の間は書き換え中を表す
+    std::atomic< dp::ULong >    clockSequence;
+    std::atomic< dp::ULong >    clockFrames;
+    std::atomic< dp::ULong >    clockLimitFrames;
+    std::atomic< dp::Long >     clockNanoseconds;
+
+    std::atomic< dp::ULong >    startFrame;
+    std::atomic< dp::Bool >     started;    // 再生コールバックの波形データの出力を開始した
+
+    // 出力側のスレッドの変数
+    dp::ULong   renderedFrames;     // 再生コールバックが書き込んだフレーム数
+    dp::ULong   presentedFrames;    // 仮想スピーカーが出力したフレーム数
+    dp::ULong   lastRenderedFrames; // 直前の再生コールバックで書き込んだフレーム数
+
+    // 仮想スピーカー用
+    WavWriter               wavWriter;
+    std::atomic< dp::Bool > stopped;
+    std::thread             thread;
+
+    AudioOutput(
+    );
+
+    ~AudioOutput(
+    );
+};
+
+void setEndEventHandler(
+    AudioOutputInfo &
+    , const AudioOutputEndEventHandler &
+);
+
+void setPlayEventHandler(
+    AudioOutputInfo &
+    , const AudioOutputPlayEventHandler &
+);
+
+// コピーが必要な場合に使う再生コールバックも合わせて設定する
+void setPlayDataEventHandler(
+    AudioOutputInfo &
+    , const AudioOutputPlayDataEventHandler &
+);
+
+void setPresentEventHandler(
+    AudioOutputInfo &
+    , const AudioOutputPresentEventHandler &
+);
+
+void setLatency(
+    AudioOutputInfo &
+    , dp::UInt
+);
+
+void setPeriodFrames(
+    AudioOutputInfo &
+    , dp::UInt
+);
+
+void setBufferCount(
+    AudioOutputInfo &
+    , dp::UInt
+);
+
+void setRealtimeScheduling(
+    AudioOutputInfo &
+    , dp::Bool
+);
+
+// AudioAnalyzerは出力と同じフォーマット、チャンネル数で生成し、出力の破棄まで有効であること
+void setAnalyzer(
+    AudioOutputInfo &
+    , AudioAnalyzer *
+);
+
+void setStartFrame(
+    AudioOutputInfo &
+    , dp::ULong
+);
+
+// 出力開始の保留を解除し、出力先の_frameフレーム目から再生コールバックの波形データを出力する
+// 既に出力を開始している場合はfalseを返す
+dp::Bool scheduleAudioOutputStart(
+    AudioOutput &
+    , dp::ULong
+);
+
+// 出力先で現在出力されているフレームを求める
+// 仮想スピーカーでは出力の時刻から、実スピーカーでは再生コールバックの呼び出し時刻から推定する
+// 実スピーカーのdp::AudioPlayerはデバイスの再生位置を返さないため、
+// 再生コールバックが呼ばれた時点で直前のバッファの出力が始まったものとみなす
+// 出力を開始する前はfalseを返す
+dp::Bool getPlaybackPosition(
+    const AudioOutput &
+    , AudioOutputPosition &
+);
+
+// 再生コールバックが呼び出される前など、値が確定していない場合はfalseを返す
+dp::Bool getAudioOutputParameters(
+    const AudioOutput &
+    , AudioOutputParameters &
+);
+
+// 再生コールバックが初めて波形データを返した時刻を取得する
+// 未到達の場合はfalseを返す
+dp::Bool getFirstPlayTime(
+    const AudioOutput &
+    , std::chrono::steady_clock::time_point &
+);
+
+// 生成と同時に再生を開始する
+AudioOutput * newAudioOutput(
+    const AudioOutputKey &
+    , const AudioOutputInfo &
+    , dp::AudioFormat
+    , dp::UInt
+    , dp::UInt
+);
+
+#endif  // COMMON_AUDIOOUTPUT_H
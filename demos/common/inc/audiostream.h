@@ -0,0 +1,342 @@
+﻿#ifndef COMMON_AUDIOSTREAM_H
+#define COMMON_AUDIOSTREAM_H
+
+#include "ringbuffer.h"
+#include "realtimecheck.h"
+#include "audiooutput.h"
+
+#include "dp/audio/audioformat.h"
+#include "dp/common/primitives.h"
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstddef>
+
+// 相手側のスレッドを待つ場合の1回の待機時間
+// 空回りでコアを占有しないよう、実時間の制約がない側の待機は全てスリープとする
+const auto  AUDIO_STREAM_WAIT_MILLISECONDS = 2;
+
+// dp::AudioPlayerへ波形データを供給するストリーム
+// 生産者スレッドがwriteAudioStream()で書き込み、再生コールバックがreadAudioStream()で読み出す
+// 再生コールバック側はロック・メモリ確保・システムコールを一切行わない(RealtimeScopeで検査する)
+// ただし実時間の制約がない出力先では、生産者を待つ間のみwaitAudioStreamProducer()で待機する
+struct AudioStream
+{
+    RingBuffer< dp::Byte >      ringBuffer;
+    dp::UInt                    frameSize;
+    dp::Byte                    silence;
+
+    std::atomic< dp::Bool >     ended;
+    std::atomic< dp::ULong >    underruns;
+
+    // シーク時の破棄要求
+    // 生産者がflushRequestを進め、消費者が溜まったデータを破棄してflushedGenerationを追いつかせる
+    std::atomic< dp::ULong >    flushRequest;
+    std::atomic< dp::ULong >    flushedGeneration;
+
+    // 消費者側の変数
+    // 破棄してから次にデータが揃うまでの間は、不足をアンダーランとして数えない
+    dp::Bool                    refilling;
+
+    AudioStream(
+        std::size_t         _capacity
+        , dp::AudioFormat   _audioFormat
+        , dp::UInt          _frameSize
+    )
+        : ringBuffer( _capacity )
+        , frameSize( _frameSize )
+        , silence( _audioFormat == dp::AudioFormat::U8 ? 0x80 : 0x00 )
+        , ended( false )
+        , underruns( 0 )
+        , flushRequest( 0 )
+        , flushedGeneration( 0 )
+        , refilling( false )
+    {
+    }
+};
+
+// 書き込めた分だけ書き込み、書き込んだバイト数を返す
+// 書き込みはフレーム単位で行われる
+inline std::size_t tryWriteAudioStream(
+    AudioStream &       _stream
+    , const void *      _DATA
+    , std::size_t       _size
+)
+{
+    auto    size = _stream.ringBuffer.getWritableSize();
+    if( size > _size ) {
+        size = _size;
+    }
+    size -= size % _stream.frameSize;
+
+    return _stream.ringBuffer.write(
+        static_cast< const dp::Byte * >( _DATA )
+        , size
+    );
+}
+
+// 全て書き込むか、_STOPPEDがtrueになるまで待機する
+inline dp::Bool writeAudioStream(
+    AudioStream &                       _stream
+    , const void *                      _DATA
+    , std::size_t                       _size
+    , const std::atomic< dp::Bool > &   _STOPPED
+)
+{
+    auto    data = static_cast< const dp::Byte * >( _DATA );
+
+    while( _size > 0 ) {
+        if( _STOPPED.load( std::memory_order_relaxed ) ) {
+            return false;
+        }
+
+        const auto  WRITTEN_SIZE = tryWriteAudioStream(
+            _stream
+            , data
+            , _size
+        );
+        if( WRITTEN_SIZE <= 0 ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( AUDIO_STREAM_WAIT_MILLISECONDS ) );
+
+            continue;
+        }
+
+        data += WRITTEN_SIZE;
+        _size -= WRITTEN_SIZE;
+    }
+
+    return true;
+}
+
+// 生産者スレッドから、これ以上データを書き込まないことを通知する
+inline void endAudioStream(
+    AudioStream &   _stream
+)
+{
+    _stream.ended.store(
+        true
+        , std::memory_order_release
+    );
+}
+
+// 生産者スレッドから、書き込み済みのデータの破棄を要求し、要求の世代を返す
+// 要求してからisAudioStreamFlushed()がtrueを返すまでは書き込まないこと
+inline dp::ULong requestFlushAudioStream(
+    AudioStream &   _stream
+)
+{
+    const auto  GENERATION = _stream.flushRequest.load( std::memory_order_relaxed ) + 1;
+
+    _stream.flushRequest.store(
+        GENERATION
+        , std::memory_order_release
+    );
+
+    return GENERATION;
+}
+
+// 生産者スレッドから呼び出す
+inline dp::Bool isAudioStreamFlushed(
+    AudioStream &   _stream
+    , dp::ULong     _generation
+)
+{
+    return _stream.flushedGeneration.load( std::memory_order_acquire ) >= _generation;
+}
+
+// 生産者スレッドから呼び出す
+// 破棄が完了するか、_STOPPEDがtrueになるまで待機する
+inline dp::Bool waitAudioStreamFlushed(
+    AudioStream &                       _stream
+    , dp::ULong                         _generation
+    , const std::atomic< dp::Bool > &   _STOPPED
+)
+{
+    while( isAudioStreamFlushed(
+        _stream
+        , _generation
+    ) == false ) {
+        if( _STOPPED.load( std::memory_order_relaxed ) ) {
+            return false;
+        }
+
+        std::this_thread::sleep_for( std::chrono::milliseconds( AUDIO_STREAM_WAIT_MILLISECONDS ) );
+    }
+
+    return true;
+}
+
+// 消費者スレッドから呼び出す
+// 破棄の要求があれば溜まったデータをコピーせずに読み捨て、trueを返す
+inline dp::Bool flushAudioStream(
+    AudioStream &   _stream
+)
+{
+    const auto  REQUEST = _stream.flushRequest.load( std::memory_order_acquire );
+    if( REQUEST == _stream.flushedGeneration.load( std::memory_order_relaxed ) ) {
+        return false;
+    }
+
+    _stream.ringBuffer.skip( _stream.ringBuffer.getReadableSize() );
+    _stream.refilling = true;
+
+    _stream.flushedGeneration.store(
+        REQUEST
+        , std::memory_order_release
+    );
+
+    return true;
+}
+
+// 再生コールバックから呼び出す
+// データが不足した場合、終端でなければ無音で埋めてアンダーランとして数える
+inline dp::ULong readAudioStream(
+    AudioStream &   _stream
+    , void *        _buffer
+    , dp::ULong     _bufferSize
+)
+{
+    auto    buffer = static_cast< dp::Byte * >( _buffer );
+
+    _bufferSize -= _bufferSize % _stream.frameSize;
+
+    flushAudioStream( _stream );
+
+    auto    size = _stream.ringBuffer.read(
+        buffer
+        , _bufferSize
+    );
+    if( size >= _bufferSize ) {
+        _stream.refilling = false;
+
+        return size;
+    }
+
+    if( _stream.ended.load( std::memory_order_acquire ) ) {
+        // 終端通知の直前に書き込まれた分を読み残さないよう、もう一度読み込む
+        size += _stream.ringBuffer.read(
+            buffer + size
+            , _bufferSize - size
+        );
+
+        return size;
+    }
+
+    std::memset(
+        buffer + size
+        , _stream.silence
+        , _bufferSize - size
+    );
+
+    if( _stream.refilling == false ) {
+        _stream.underruns.fetch_add(
+            1
+            , std::memory_order_relaxed
+        );
+    }
+
+    return _bufferSize;
+}
+
+// 実時間の制約がない出力先の再生コールバックで、生産者の書き込みを待つ
+// 待機はRealtimeScopeの検査から除く
+inline void waitAudioStreamProducer(
+)
+{
+    NonRealtimeScope    nonRealtimeScope;
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( AUDIO_STREAM_WAIT_MILLISECONDS ) );
+}
+
+// 実時間の制約がない出力先の再生コールバックから呼び出す
+// データが不足した場合は無音で埋めず、生産者の書き込みを待つ
+inline dp::ULong waitReadAudioStream(
+    AudioStream &   _stream
+    , void *        _buffer
+    , dp::ULong     _bufferSize
+)
+{
+    auto    buffer = static_cast< dp::Byte * >( _buffer );
+
+    _bufferSize -= _bufferSize % _stream.frameSize;
+
+    dp::ULong   size = 0;
+    while( size < _bufferSize ) {
+        // 破棄の要求があれば、この呼び出しで読み込んだ分も破棄して読み直す
+        if( flushAudioStream( _stream ) ) {
+            size = 0;
+        }
+
+        const auto  ENDED = _stream.ended.load( std::memory_order_acquire );
+
+        size += _stream.ringBuffer.read(
+            buffer + size
+            , _bufferSize - size
+        );
+
+        if( ENDED ) {
+            break;
+        }
+
+        if( size < _bufferSize ) {
+            waitAudioStreamProducer();
+        }
+    }
+
+    return size;
+}
+
+// 出力先に応じた方法でAudioStreamから読み込む
+inline dp::ULong readAudioStream(
+    AudioStream &           _stream
+    , const AudioOutput &   _OUTPUT
+    , void *                _buffer
+    , dp::ULong             _bufferSize
+)
+{
+    if( isRealtimeAudioOutput( _OUTPUT.type ) ) {
+        return readAudioStream(
+            _stream
+            , _buffer
+            , _bufferSize
+        );
+    } else {
+        return waitReadAudioStream(
+            _stream
+            , _buffer
+            , _bufferSize
+        );
+    }
+}
+
+inline void setAudioStreamPlayEventHandler(
+    AudioOutputInfo &       _info
+    , AudioStream &         _stream
+)
+{
+    setPlayEventHandler(
+        _info
+        , [
+            &_stream
+        ]
+        (
+            AudioOutput &       _output
+            , void *            _buffer
+            , dp::ULong         _bufferSize
+        ) -> dp::ULong
+        {
+            RealtimeScope   realtimeScope;
+
+            return readAudioStream(
+                _stream
+                , _output
+                , _buffer
+                , _bufferSize
+            );
+        }
+    );
+}
+
+#endif  // COMMON_AUDIOSTREAM_H
@@ -0,0 +1,91 @@
+﻿#ifndef COMMON_CUBE_H
+#define COMMON_CUBE_H
+
+#include "dp/common/primitives.h"
+#include "dp/opengl/gl.h"
+
+#include <cstddef>
+
+// 中心が原点で一辺の長さが2の立方体を、面ごとに2つの三角形で並べた頂点座標
+// 各頂点の色は、座標の正の成分をそのまま使う
+const dp::Int   CUBE_VERTICES[][ 3 ] = {
+    { -1,  1,  1 },
+    { -1, -1,  1 },
+    {  1, -1,  1 },
+
+    { -1,  1,  1 },
+    {  1, -1,  1 },
+    {  1,  1,  1 },
+
+
+    { -1,  1, -1 },
+    { -1,  1,  1 },
+    {  1,  1,  1 },
+
+    { -1,  1, -1 },
+    {  1,  1,  1 },
+    {  1,  1, -1 },
+
+
+    { -1, -1, -1 },
+    { -1,  1, -1 },
+    {  1,  1, -1 },
+
+    { -1, -1, -1 },
+    {  1,  1, -1 },
+    {  1, -1, -1 },
+
+
+    { -1, -1,  1 },
+    { -1, -1, -1 },
+    {  1, -1, -1 },
+
+    { -1, -1,  1 },
+    {  1, -1, -1 },
+    {  1, -1,  1 },
+
+
+    {  1,  1,  1 },
+    {  1, -1,  1 },
+    {  1, -1, -1 },
+
+    {  1,  1,  1 },
+    {  1, -1, -1 },
+    {  1,  1, -1 },
+
+
+    { -1,  1, -1 },
+    { -1, -1, -1 },
+    { -1, -1,  1 },
+
+    { -1,  1, -1 },
+    { -1, -1,  1 },
+    { -1,  1,  1 },
+};
+
+const auto  CUBE_VERTEX_COUNT = sizeof( CUBE_VERTICES ) / sizeof( CUBE_VERTICES[ 0 ] );
+
+// 頂点バッファへ渡す頂点
+struct CubeVertex
+{
+    dp::GLfloat position[ 3 ];
+    dp::GLfloat color[ 3 ];
+};
+
+// CUBE_VERTEX_COUNT個の頂点に座標と色を設定する
+inline void setCubeVertices(
+    CubeVertex *    _vertices
+)
+{
+    for( std::size_t i = 0 ; i < CUBE_VERTEX_COUNT ; i++ ) {
+        const auto &    VERTEX = CUBE_VERTICES[ i ];
+        auto &          vertex = _vertices[ i ];
+
+        for( std::size_t j = 0 ; j < 3 ; j++ ) {
+            vertex.position[ j ] = static_cast< dp::GLfloat >( VERTEX[ j ] );
+            vertex.color[ j ] = static_cast< dp::GLfloat >( VERTEX[ j ] >= 0 ? VERTEX[ j ] : 0 );
+        }
+    }
+}
+
+#endif  // COMMON_CUBE_H
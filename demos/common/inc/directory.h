@@ -0,0 +1,30 @@
+﻿#ifndef COMMON_DIRECTORY_H
+#define COMMON_DIRECTORY_H
+
+#include "dp/common/primitives.h"
+
+#include <vector>
+
+struct DirectoryEntry
+{
+    dp::String  name;
+    dp::Bool    directory;
+};
+
+typedef std::vector< DirectoryEntry > DirectoryEntries;
+
+// _PATH直下のエントリを列挙する
+// "."と".."は含まない
+// dpにディレクトリを扱う機能がないため、OSのAPIを直接使う
+dp::Bool readDirectory(
+    const dp::String &
+    , DirectoryEntries &
+);
+
+// _PATHと_NAMEを区切り文字でつなぐ
+dp::String joinPath(
+    const dp::String &
+    , const dp::String &
+);
+
+#endif  // COMMON_DIRECTORY_H
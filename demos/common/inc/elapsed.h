@@ -0,0 +1,11 @@
+﻿#ifndef COMMON_ELAPSED_H
+#define COMMON_ELAPSED_H
+
+#include <chrono>
+
+// 計測した経過時間を表示用の秒数にする
+double toSeconds(
+    std::chrono::steady_clock::duration
+);
+
+#endif  // COMMON_ELAPSED_H
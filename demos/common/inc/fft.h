@@ -0,0 +1,36 @@
+﻿#ifndef COMMON_FFT_H
+#define COMMON_FFT_H
+
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <cstddef>
+
+// 複素数の順方向FFT
+// 実部と虚部を別の配列で持ち、最初の2段を基数4、以降を基数2のバタフライで処理する
+// SSE2が利用可能な場合、基数2の段は4組のバタフライをまとめて処理する
+struct Fft
+{
+    std::size_t                 size;
+    std::vector< std::size_t >  bitReversed;
+
+    // 基数2の段ごとの回転因子
+    // 半分の長さが_halfの段の回転因子は、_half - 4の位置から_half個並ぶ
+    std::vector< dp::Float >    twiddleReal;
+    std::vector< dp::Float >    twiddleImaginary;
+};
+
+// _sizeは8以上の2のべき乗であること
+void initFft(
+    Fft &
+    , std::size_t
+);
+
+// _real、_imaginaryのFft::size個の要素を、その場で変換する
+void runFft(
+    const Fft &
+    , dp::Float *
+    , dp::Float *
+);
+
+#endif  // COMMON_FFT_H
@@ -0,0 +1,28 @@
+﻿#ifndef COMMON_FRAMECLOCK_H
+#define COMMON_FRAMECLOCK_H
+
+#include "dp/common/primitives.h"
+
+#include <chrono>
+
+// 一定のフレームレートで描画の時刻を刻む
+// 描画要求を送るスレッドがwaitNextFrame()で待ち、返された時刻からアニメーションを求める
+struct FrameClock
+{
+    std::chrono::steady_clock::duration     interval;
+    std::chrono::steady_clock::time_point   start;
+    dp::ULong                               frames;         // 刻んだフレーム数
+    dp::ULong                               skippedFrames;  // 待ちが遅れて飛ばしたフレーム数
+
+    FrameClock(
+        dp::UInt    // フレームレート
+    );
+};
+
+// 次のフレームの予定時刻まで待ち、開始からその時刻までの経過秒数を返す
+// 予定時刻を過ぎていた場合は待たず、間に合わなかったフレームは飛ばす
+double waitNextFrame(
+    FrameClock &
+);
+
+#endif  // COMMON_FRAMECLOCK_H
@@ -0,0 +1,80 @@
+﻿#ifndef COMMON_FRAMEPROFILER_H
+#define COMMON_FRAMEPROFILER_H
+
+#include "glext.h"
+
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <chrono>
+#include <cstddef>
+
+const std::size_t   FRAME_PROFILER_HISTORY = 4096;
+const std::size_t   FRAME_PROFILER_QUERIES = 2;
+const std::size_t   FRAME_PROFILER_BUCKETS = 24;
+
+// 直近FRAME_PROFILER_HISTORYフレームの計測値(ナノ秒)と、その分布
+// 分布の区間iはマイクロ秒で[2^i, 2^(i+1))、区間0は1マイクロ秒未満を含む
+struct FrameTimeHistory
+{
+    std::vector< dp::Long > nanoseconds;    // 古いものから上書きする
+    std::size_t             next;
+    std::size_t             count;
+    dp::ULong               buckets[ FRAME_PROFILER_BUCKETS ];
+};
+
+struct FrameTimeSummary
+{
+    std::size_t count;
+    dp::Long    mean;
+    dp::Long    p50;
+    dp::Long    p99;
+    dp::Long    max;
+};
+
+// フレームごとのCPU時間と、GL_TIME_ELAPSEDクエリによるGPU時間を記録する
+// GPU時間は2つのクエリを交互に使い、前のフレームの結果を待たずに取得できた場合のみ読み出す
+// 描画スレッドからのみ呼び出すこと
+struct FrameProfiler
+{
+    dp::Bool    initialized;
+    dp::Bool    gpuTimerAvailable;
+
+    GLQueryProcs    procs;
+    GLExtUInt       queries[ FRAME_PROFILER_QUERIES ];
+    dp::Bool        queryPending[ FRAME_PROFILER_QUERIES ];
+    std::size_t     currentQuery;
+    dp::ULong       droppedGpuFrames;   // 次に使うまでに結果が得られなかったフレーム数
+
+    std::chrono::steady_clock::time_point   frameBegin;
+
+    FrameTimeHistory    cpu;
+    FrameTimeHistory    gpu;
+
+    FrameProfiler(
+    );
+};
+
+// GLコンテキストをカレントにした状態で、フレームの描画の前後に呼び出す
+// 最初の呼び出しでクエリを生成し、GPU時間は2フレーム目から記録する
+// GL_TIME_ELAPSEDが使えない場合はCPU時間のみ記録する
+void beginProfiledFrame(
+    FrameProfiler &
+);
+
+void endProfiledFrame(
+    FrameProfiler &
+);
+
+// 記録がない場合はfalseを返す
+dp::Bool summarizeFrameTimes(
+    const FrameTimeHistory &
+    , FrameTimeSummary &
+);
+
+// CPU時間とGPU時間の平均・p50・p99・最大と分布を表示する
+void printFrameProfiler(
+    const FrameProfiler &
+);
+
+#endif  // COMMON_FRAMEPROFILER_H
@@ -0,0 +1,121 @@
+﻿#ifndef COMMON_GAIN_H
+#define COMMON_GAIN_H
+
+#include "ringbuffer.h"
+
+#include "dp/audio/audioformat.h"
+#include "dp/common/primitives.h"
+
+#include <cstddef>
+
+const auto  GAIN_MAX = 2.0f;
+
+struct GainCommand
+{
+    dp::Float   startGain;      // hasStartGainがtrueの場合の変化の開始値
+    dp::Float   gain;
+    dp::ULong   startFrame;
+    dp::UInt    rampFrames;
+    dp::Bool    hasStartGain;   // falseの場合は開始フレーム時点のゲインから変化させる
+    dp::Bool    immediate;      // trueの場合はstartFrameによらず、次に処理するフレームから変化させる
+};
+
+// 再生コールバック内で波形データにゲインをかける
+// ゲインの変更は制御スレッドからコマンドとして送り、再生コールバックが指定のフレームから1サンプル単位で反映する
+// 制御スレッドは同時には1つに限る
+// 開始フレームを指定するコマンドは開始フレームの順に送ること
+struct GainStage
+{
+    RingBuffer< GainCommand >   commands;
+    RingBuffer< GainCommand >   immediateCommands;  // 待機中の開始フレーム指定のコマンドを追い越して反映する
+
+    // 再生コールバック側の変数
+    dp::ULong   frames;         // これまでに処理したフレーム数
+    dp::Float   gain;
+    dp::Float   targetGain;
+    dp::Float   step;
+    dp::UInt    rampRestFrames;
+    GainCommand pendingCommand;
+    dp::Bool    pending;
+
+    GainStage(
+    );
+};
+
+// _startFrame以降で、_rampFramesフレームかけて_gainへ線形に変化させる
+// _startFrameを過ぎてから反映された場合は、予定どおりのフレームで変化し終わるよう途中から変化させる
+// コマンドが溢れた場合はfalseを返す
+dp::Bool setGain(
+    GainStage &
+    , dp::Float
+    , dp::UInt
+    , dp::ULong
+);
+
+// 次に処理するフレームから変化させる
+// 開始フレームを待っているコマンドがあっても、その前に反映する
+dp::Bool setGain(
+    GainStage &
+    , dp::Float
+    , dp::UInt
+);
+
+// _startFrame以降で、_startGainから_rampFramesフレームかけて_gainへ線形に変化させる
+// 開始値と目標値を1つのコマンドで送るため、コマンドが溢れても一部だけが反映されることはない
+dp::Bool setGain(
+    GainStage &
+    , dp::Float
+    , dp::Float
+    , dp::UInt
+    , dp::ULong
+);
+
+// 現在のゲインから_framesフレームかけて無音にする
+dp::Bool fadeOut(
+    GainStage &
+    , dp::UInt
+    , dp::ULong
+);
+
+// 再生コールバックから呼び出す
+// 等倍の区間は何もせず、一定のゲインの区間は固定小数点、変化中の区間は浮動小数点で処理する
+void applyGain(
+    GainStage &
+    , dp::AudioFormat
+    , dp::UInt
+    , void *
+    , std::size_t
+);
+
+// 再生コールバックから呼び出す
+// _SOURCEの_framesフレームにゲインをかけて_destinationへ書き出す
+// 読み込みと書き出しを1回の走査で行うため、コピーしてからゲインをかけるより読み書きが少ない
+// _destinationと_SOURCEは同じでもよいが、一部だけ重なってはならない
+void applyGain(
+    GainStage &
+    , dp::AudioFormat
+    , dp::UInt
+    , void *
+    , const void *
+    , std::size_t
+);
+
+// _framesフレームに、_gainから1フレームごとに_stepずつ変化するゲインをかける
+void applyGainRamp(
+    dp::AudioFormat
+    , dp::UInt
+    , void *
+    , std::size_t
+    , dp::Float
+    , dp::Float
+);
+
+// _samplesサンプル分の_SOURCEを_destinationへ飽和させながら加算する
+void addAudio(
+    dp::AudioFormat
+    , void *
+    , const void *
+    , std::size_t
+);
+
+#endif  // COMMON_GAIN_H
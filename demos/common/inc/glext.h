@@ -0,0 +1,186 @@
+﻿#ifndef COMMON_GLEXT_H
+#define COMMON_GLEXT_H
+
+#include "dp/opengl/gl.h"
+#include "dp/common/primitives.h"
+
+#include <cstddef>
+
+// dp::gl*に含まれないGL関数
+// ドライバから直接取得するため、呼び出し規約はGLの既定に合わせる
+#if defined( _MSC_VER )
+#   define GLEXT_APIENTRY   __stdcall
+#else
+#   define GLEXT_APIENTRY
+#endif
+
+typedef unsigned int    GLExtUInt;
+typedef unsigned char   GLExtBoolean;
+typedef dp::ULong       GLExtUInt64;
+typedef std::ptrdiff_t  GLExtSizeiptr;
+
+const dp::GLenum    GLEXT_UNSIGNED_BYTE = 0x1401;
+const dp::GLenum    GLEXT_FLOAT = 0x1406;
+const dp::GLenum    GLEXT_RGBA = 0x1908;
+const dp::GLenum    GLEXT_VENDOR = 0x1F00;
+const dp::GLenum    GLEXT_RENDERER = 0x1F01;
+const dp::GLenum    GLEXT_VERSION = 0x1F02;
+const dp::GLenum    GLEXT_VERTEX_ARRAY = 0x8074;
+const dp::GLenum    GLEXT_COLOR_ARRAY = 0x8076;
+const dp::GLenum    GLEXT_RGBA8 = 0x8058;
+const dp::GLenum    GLEXT_DEPTH_COMPONENT24 = 0x81A6;
+const dp::GLenum    GLEXT_PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+const dp::GLenum    GLEXT_PROGRAM_BINARY_LENGTH = 0x8741;
+const dp::GLenum    GLEXT_NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+const dp::GLenum    GLEXT_QUERY_RESULT = 0x8866;
+const dp::GLenum    GLEXT_QUERY_RESULT_AVAILABLE = 0x8867;
+const dp::GLenum    GLEXT_ARRAY_BUFFER = 0x8892;
+const dp::GLenum    GLEXT_TIME_ELAPSED = 0x88BF;
+const dp::GLenum    GLEXT_STATIC_DRAW = 0x88E4;
+const dp::GLenum    GLEXT_FRAGMENT_SHADER = 0x8B30;
+const dp::GLenum    GLEXT_VERTEX_SHADER = 0x8B31;
+const dp::GLenum    GLEXT_COMPILE_STATUS = 0x8B81;
+const dp::GLenum    GLEXT_LINK_STATUS = 0x8B82;
+const dp::GLenum    GLEXT_INFO_LOG_LENGTH = 0x8B84;
+const dp::GLenum    GLEXT_FRAMEBUFFER_COMPLETE = 0x8CD5;
+const dp::GLenum    GLEXT_COLOR_ATTACHMENT0 = 0x8CE0;
+const dp::GLenum    GLEXT_DEPTH_ATTACHMENT = 0x8D00;
+const dp::GLenum    GLEXT_FRAMEBUFFER = 0x8D40;
+const dp::GLenum    GLEXT_RENDERBUFFER = 0x8D41;
+
+// バッファオブジェクトと頂点配列オブジェクト、およびdp::gl*にない固定機能の行列操作
+// 頂点配列オブジェクトはGL3.0以降のため、それ未満のドライバではロードに失敗する
+// 生成したオブジェクトはGLコンテキストの破棄とともに解放されるため、削除の関数は持たない
+struct GLExtProcs
+{
+    const dp::Byte * ( GLEXT_APIENTRY * getString )( dp::GLenum );
+
+    void ( GLEXT_APIENTRY * genBuffers )( dp::GLsizei, GLExtUInt * );
+    void ( GLEXT_APIENTRY * bindBuffer )( dp::GLenum, GLExtUInt );
+    void ( GLEXT_APIENTRY * bufferData )( dp::GLenum, GLExtSizeiptr, const void *, dp::GLenum );
+
+    void ( GLEXT_APIENTRY * genVertexArrays )( dp::GLsizei, GLExtUInt * );
+    void ( GLEXT_APIENTRY * bindVertexArray )( GLExtUInt );
+
+    void ( GLEXT_APIENTRY * enableClientState )( dp::GLenum );
+    void ( GLEXT_APIENTRY * vertexPointer )( dp::GLint, dp::GLenum, dp::GLsizei, const void * );
+    void ( GLEXT_APIENTRY * colorPointer )( dp::GLint, dp::GLenum, dp::GLsizei, const void * );
+    void ( GLEXT_APIENTRY * drawArrays )( dp::GLenum, dp::GLint, dp::GLsizei );
+
+    void ( GLEXT_APIENTRY * pushMatrix )();
+    void ( GLEXT_APIENTRY * popMatrix )();
+    void ( GLEXT_APIENTRY * multMatrixf )( const dp::GLfloat * );
+};
+
+// GLコンテキストをカレントにした状態で呼び出す
+// 取得できない関数があった場合はfalseを返す
+dp::Bool loadGLExtProcs(
+    GLExtProcs &
+);
+
+// 固定機能の行列の直接設定
+// GL1.0の関数のため、バージョンによらずロードできる
+struct GLMatrixProcs
+{
+    void ( GLEXT_APIENTRY * loadMatrixf )( const dp::GLfloat * );
+    void ( GLEXT_APIENTRY * multMatrixf )( const dp::GLfloat * );
+};
+
+// GLコンテキストをカレントにした状態で呼び出す
+// 取得できない関数があった場合はfalseを返す
+dp::Bool loadGLMatrixProcs(
+    GLMatrixProcs &
+);
+
+// フレームバッファオブジェクトと、描画結果の読み出し
+// ウィンドウを持たないGLコンテキストの描画先として使用する
+struct GLFramebufferProcs
+{
+    void ( GLEXT_APIENTRY * genFramebuffers )( dp::GLsizei, GLExtUInt * );
+    void ( GLEXT_APIENTRY * bindFramebuffer )( dp::GLenum, GLExtUInt );
+    dp::GLenum ( GLEXT_APIENTRY * checkFramebufferStatus )( dp::GLenum );
+    void ( GLEXT_APIENTRY * framebufferRenderbuffer )( dp::GLenum, dp::GLenum, dp::GLenum, GLExtUInt );
+
+    void ( GLEXT_APIENTRY * genRenderbuffers )( dp::GLsizei, GLExtUInt * );
+    void ( GLEXT_APIENTRY * bindRenderbuffer )( dp::GLenum, GLExtUInt );
+    void ( GLEXT_APIENTRY * renderbufferStorage )( dp::GLenum, dp::GLenum, dp::GLsizei, dp::GLsizei );
+
+    void ( GLEXT_APIENTRY * readPixels )( dp::GLint, dp::GLint, dp::GLsizei, dp::GLsizei, dp::GLenum, dp::GLenum, void * );
+    void ( GLEXT_APIENTRY * finish )();
+};
+
+// GLコンテキストをカレントにした状態で呼び出す
+// 取得できない関数があった場合はfalseを返す
+dp::Bool loadGLFramebufferProcs(
+    GLFramebufferProcs &
+);
+
+// シェーダーとインスタンス描画
+// 頂点属性のインスタンスごとの更新はGL3.3以降のため、それ未満のドライバではロードに失敗する
+struct GLShaderProcs
+{
+    GLExtUInt ( GLEXT_APIENTRY * createShader )( dp::GLenum );
+    void ( GLEXT_APIENTRY * shaderSource )( GLExtUInt, dp::GLsizei, const char * const *, const dp::GLint * );
+    void ( GLEXT_APIENTRY * compileShader )( GLExtUInt );
+    void ( GLEXT_APIENTRY * getShaderiv )( GLExtUInt, dp::GLenum, dp::GLint * );
+    void ( GLEXT_APIENTRY * getShaderInfoLog )( GLExtUInt, dp::GLsizei, dp::GLsizei *, char * );
+    void ( GLEXT_APIENTRY * deleteShader )( GLExtUInt );
+
+    GLExtUInt ( GLEXT_APIENTRY * createProgram )();
+    void ( GLEXT_APIENTRY * attachShader )( GLExtUInt, GLExtUInt );
+    void ( GLEXT_APIENTRY * bindAttribLocation )( GLExtUInt, GLExtUInt, const char * );
+    void ( GLEXT_APIENTRY * linkProgram )( GLExtUInt );
+    void ( GLEXT_APIENTRY * getProgramiv )( GLExtUInt, dp::GLenum, dp::GLint * );
+    void ( GLEXT_APIENTRY * getProgramInfoLog )( GLExtUInt, dp::GLsizei, dp::GLsizei *, char * );
+    void ( GLEXT_APIENTRY * deleteProgram )( GLExtUInt );
+    void ( GLEXT_APIENTRY * useProgram )( GLExtUInt );
+
+    void ( GLEXT_APIENTRY * vertexAttribPointer )( GLExtUInt, dp::GLint, dp::GLenum, GLExtBoolean, dp::GLsizei, const void * );
+    void ( GLEXT_APIENTRY * enableVertexAttribArray )( GLExtUInt );
+    void ( GLEXT_APIENTRY * vertexAttribDivisor )( GLExtUInt, GLExtUInt );
+    void ( GLEXT_APIENTRY * drawArraysInstanced )( dp::GLenum, dp::GLint, dp::GLsizei, dp::GLsizei );
+};
+
+// GLコンテキストをカレントにした状態で呼び出す
+// 取得できない関数があった場合はfalseを返す
+dp::Bool loadGLShaderProcs(
+    GLShaderProcs &
+);
+
+// GPUの処理時間を計測するクエリ
+// GL_TIME_ELAPSEDはGL3.3以降のため、それ未満のドライバではロードに失敗する
+struct GLQueryProcs
+{
+    void ( GLEXT_APIENTRY * genQueries )( dp::GLsizei, GLExtUInt * );
+    void ( GLEXT_APIENTRY * beginQuery )( dp::GLenum, GLExtUInt );
+    void ( GLEXT_APIENTRY * endQuery )( dp::GLenum );
+    void ( GLEXT_APIENTRY * getQueryObjectiv )( GLExtUInt, dp::GLenum, dp::GLint * );
+    void ( GLEXT_APIENTRY * getQueryObjectui64v )( GLExtUInt, dp::GLenum, GLExtUInt64 * );
+};
+
+// GLコンテキストをカレントにした状態で呼び出す
+// 取得できない関数があった場合はfalseを返す
+dp::Bool loadGLQueryProcs(
+    GLQueryProcs &
+);
+
+// リンク済みのプログラムのバイナリの取得と読み込み
+// GL4.1以降のため、それ未満のドライバではロードに失敗する
+// ロードできても、ドライバがバイナリの形式を1つも持たない場合は使用できない
+struct GLProgramBinaryProcs
+{
+    const dp::Byte * ( GLEXT_APIENTRY * getString )( dp::GLenum );
+    void ( GLEXT_APIENTRY * getIntegerv )( dp::GLenum, dp::GLint * );
+
+    void ( GLEXT_APIENTRY * programParameteri )( GLExtUInt, dp::GLenum, dp::GLint );
+    void ( GLEXT_APIENTRY * getProgramBinary )( GLExtUInt, dp::GLsizei, dp::GLsizei *, dp::GLenum *, void * );
+    void ( GLEXT_APIENTRY * programBinary )( GLExtUInt, dp::GLenum, const void *, dp::GLsizei );
+};
+
+// GLコンテキストをカレントにした状態で呼び出す
+// 取得できない関数があった場合はfalseを返す
+dp::Bool loadGLProgramBinaryProcs(
+    GLProgramBinaryProcs &
+);
+
+#endif  // COMMON_GLEXT_H
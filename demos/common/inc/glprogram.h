@@ -0,0 +1,70 @@
+﻿#ifndef COMMON_GLPROGRAM_H
+#define COMMON_GLPROGRAM_H
+
+#include "glext.h"
+
+#include "dp/common/primitives.h"
+
+#include <vector>
+
+// リンク前にglBindAttribLocation()で割り当てる頂点属性の位置
+struct GLAttributeLocation
+{
+    GLExtUInt       location;
+    const char *    NAME;
+};
+
+typedef std::vector< GLAttributeLocation > GLAttributeLocations;
+
+// 頂点シェーダーとフラグメントシェーダーをコンパイルし、リンクしたプログラムを返す
+// 失敗した場合はログを表示し、0を返す
+GLExtUInt newGLProgram(
+    const GLShaderProcs &
+    , const char *
+    , const char *
+    , const GLAttributeLocations &
+);
+
+// リンク済みのプログラムのバイナリをファイルへ保存し、次回以降はコンパイルせずに読み込む
+// ファイルはソースと頂点属性の位置、ドライバを識別する文字列から求めたハッシュ値ごとに作成する
+// ドライバが変わった場合や読み込みに失敗した場合は、コンパイルしてファイルを作り直す
+struct GLProgramCache
+{
+    dp::Bool                available;  // ドライバがバイナリの取得に対応している場合のみtrue
+    GLProgramBinaryProcs    procs;
+    dp::String              driver;     // ベンダー、レンダラー、バージョン
+    dp::String              filePrefix;
+};
+
+// newCachedGLProgram()がプログラムを用意した方法
+enum class GLProgramOrigin
+{
+    LOADED,     // キャッシュから読み込んだ
+    COMPILED,   // コンパイルし、キャッシュへ保存した
+    UNCACHED,   // キャッシュが使えないため、コンパイルのみ行った
+};
+
+// GLコンテキストをカレントにした状態で呼び出す
+// キャッシュのファイル名は、第2引数にハッシュ値と拡張子を付けたものとなる
+void initGLProgramCache(
+    GLProgramCache &
+    , const dp::String &
+);
+
+// newGLProgram()と同様にプログラムを返す
+// 第6引数がtrueの場合はキャッシュを読み込まず、コンパイルしてファイルを作り直す
+GLExtUInt newCachedGLProgram(
+    const GLProgramCache &
+    , const GLShaderProcs &
+    , const char *
+    , const char *
+    , const GLAttributeLocations &
+    , dp::Bool
+    , GLProgramOrigin &
+);
+
+const char * toString(
+    GLProgramOrigin
+);
+
+#endif  // COMMON_GLPROGRAM_H
@@ -0,0 +1,82 @@
+﻿#ifndef COMMON_GLSTATECACHE_H
+#define COMMON_GLSTATECACHE_H
+
+#include "glext.h"
+#include "vecmath.h"
+
+#include "dp/opengl/gl.h"
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <utility>
+
+// dp::gl*による状態の設定のうち、現在の状態を変えない呼び出しを省略する
+// 現在の状態はこのキャッシュを通した呼び出しからのみ推定するため、対象の状態をdp::gl*で直接変更しないこと
+// コンテキストごとに用意し、そのコンテキストをカレントにしたスレッドからのみ呼び出すこと
+struct GLStateCache
+{
+    std::vector< std::pair< dp::GLenum, dp::Bool > >    capabilities;   // glEnable()した機能と有効かどうか
+
+    dp::Bool    depthFuncValid;
+    dp::GLenum  depthFunc;
+
+    dp::Bool    clearColorValid;
+    dp::GLfloat clearColor[ 4 ];
+
+    dp::Bool    matrixModeValid;
+    dp::GLenum  matrixMode;
+
+    dp::Bool    projectionValid;
+    Mat4        projection;
+
+    dp::ULong   issuedCalls;
+    dp::ULong   droppedCalls;
+
+    GLStateCache(
+    );
+};
+
+// 状態を不明とし、以降の設定は一度ずつ必ず発行する
+// コンテキストを作り直した場合や、キャッシュを通さずに状態を変更した場合に呼び出す
+void invalidateGLStateCache(
+    GLStateCache &
+);
+
+void enableGLState(
+    GLStateCache &
+    , dp::GLenum
+);
+
+void setGLDepthFunc(
+    GLStateCache &
+    , dp::GLenum
+);
+
+void setGLClearColor(
+    GLStateCache &
+    , dp::GLfloat
+    , dp::GLfloat
+    , dp::GLfloat
+    , dp::GLfloat
+);
+
+void setGLMatrixMode(
+    GLStateCache &
+    , dp::GLenum
+);
+
+// 射影行列をglLoadMatrixf()で設定する
+// 前回と同じ射影行列であれば、行列モードの切り替えも含めて省略する
+// 設定した場合は行列モードがGL_PROJECTIONとなるため、続けてsetGLMatrixMode()で戻すこと
+void setGLProjection(
+    GLStateCache &
+    , const GLMatrixProcs &
+    , const Mat4 &
+);
+
+// 発行した呼び出しと、省略した呼び出しの数を表示する
+void printGLStateCache(
+    const GLStateCache &
+);
+
+#endif  // COMMON_GLSTATECACHE_H
@@ -0,0 +1,116 @@
+﻿#ifndef COMMON_MIXER_H
+#define COMMON_MIXER_H
+
+#include "audiostream.h"
+
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+const dp::UInt  MIXER_DEFAULT_VOICES = 64;
+const auto  MIXER_GAIN_MAX = 2.0f;
+
+// 各ボイスのソースはS16LEステレオのAudioStreamとする
+// ボイスの追加・停止・回収とゲイン、パンの変更は制御スレッドから行い、
+// mix()は再生コールバックから呼び出す
+struct MixerVoice
+{
+    enum State
+    {
+        FREE,
+        PLAYING,
+        STOP_REQUESTED,
+        FINISHED,
+    };
+
+    std::atomic< dp::Int >          state;
+    std::atomic< AudioStream * >    stream;
+    std::atomic< dp::Float >        gain;
+    std::atomic< dp::Float >        pan;
+
+    MixerVoice(
+    )
+        : state( FREE )
+        , stream( nullptr )
+        , gain( 1 )
+        , pan( 0 )
+    {
+    }
+};
+
+// ボイス数は生成時に決め、再生コールバックでの確保を避けるため以降は変えない
+struct Mixer
+{
+    std::vector< MixerVoice >   voices;
+
+    dp::UInt    maxFrames;
+    dp::Bool    realtime;
+
+    std::vector< std::int32_t > accumulator;
+    std::vector< std::int16_t > voiceBuffer;
+
+    // _realtimeがfalseの場合、ソースのデータ不足時に無音で埋めず書き込みを待つ
+    Mixer(
+        dp::UInt    _voices
+        , dp::UInt  _maxFrames
+        , dp::Bool  _realtime
+    )
+        : voices( _voices )
+        , maxFrames( _maxFrames )
+        , realtime( _realtime )
+        , accumulator( _maxFrames * 2 )
+        , voiceBuffer( _maxFrames * 2 )
+    {
+    }
+};
+
+// 空いているボイスにソースを割り当て、ボイス番号を返す
+// 空きがない場合は-1を返す
+dp::Int addVoice(
+    Mixer &
+    , AudioStream &
+    , dp::Float
+    , dp::Float
+);
+
+void setVoiceGain(
+    Mixer &
+    , dp::Int
+    , dp::Float
+);
+
+// -1で左、0で中央、1で右
+void setVoicePan(
+    Mixer &
+    , dp::Int
+    , dp::Float
+);
+
+void stopVoice(
+    Mixer &
+    , dp::Int
+);
+
+// 再生を終えたボイスを解放する
+// 解放した場合はtrueを返し、以降ソースを破棄してよい
+dp::Bool reclaimVoice(
+    Mixer &
+    , dp::Int
+);
+
+dp::UInt getPlayingVoices(
+    const Mixer &
+);
+
+// 再生中の全ボイスを合成して、S16LEステレオで_bufferへ書き込む
+// 常に_bufferSizeをフレーム単位に切り捨てたバイト数を返す
+dp::ULong mix(
+    Mixer &
+    , void *
+    , dp::ULong
+);
+
+#endif  // COMMON_MIXER_H
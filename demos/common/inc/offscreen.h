@@ -0,0 +1,56 @@
+﻿#ifndef COMMON_OFFSCREEN_H
+#define COMMON_OFFSCREEN_H
+
+#include "glext.h"
+
+#include "dp/common/primitives.h"
+
+#include <vector>
+
+// ウィンドウを持たないGLコンテキスト
+// EGLのsurfacelessプラットフォームでコンテキストを生成し、フレームバッファオブジェクトへ描画する
+// GPUやXサーバーのない環境でも、Mesaのllvmpipeで描画できる
+// Linuxのみ対応する
+struct OffscreenGLContext
+{
+    dp::Int width;
+    dp::Int height;
+
+    // EGLのヘッダはdp::Boolなどと衝突するマクロを定義する場合があるため、ハンドルはvoid *で持つ
+    void *  display;
+    void *  context;
+
+    GLFramebufferProcs  procs;
+    GLExtUInt           framebuffer;
+    GLExtUInt           colorRenderbuffer;
+    GLExtUInt           depthRenderbuffer;
+
+    std::vector< dp::Byte > pixels;     // 画像の書き出し用
+
+    OffscreenGLContext(
+    );
+
+    ~OffscreenGLContext(
+    );
+};
+
+// 生成したスレッドでコンテキストをカレントにし、フレームバッファオブジェクトを描画先とする
+// 生成できない場合はnullptrを返す
+OffscreenGLContext * newOffscreenGLContext(
+    dp::Int
+    , dp::Int
+);
+
+// 描画の完了を待つ
+// glSwapBuffers()の代わりに、フレームの終わりで呼び出す
+void finishOffscreenGLFrame(
+    OffscreenGLContext &
+);
+
+// 描画結果をPPM形式(バイナリ)で書き出す
+dp::Bool writeOffscreenGLImage(
+    OffscreenGLContext &
+    , const dp::Utf32 &
+);
+
+#endif  // COMMON_OFFSCREEN_H
@@ -0,0 +1,27 @@
+﻿#ifndef COMMON_OPTION_H
+#define COMMON_OPTION_H
+
+#include "dp/common/primitives.h"
+
+// --名前=値の形式のオプションを分解する
+// "="を含まない場合はfalseを返す
+dp::Bool parseValueOption(
+    const dp::String &
+    , dp::String &      // 名前
+    , dp::String &      // 値
+);
+
+// 値を符号なし整数として読む
+dp::Bool parseValueOption(
+    const dp::String &
+    , dp::String &      // 名前
+    , dp::UInt &        // 値
+);
+
+dp::Bool parseValueOption(
+    const dp::Utf32 &
+    , dp::String &      // 名前
+    , dp::UInt &        // 値
+);
+
+#endif  // COMMON_OPTION_H
@@ -0,0 +1,191 @@
+﻿#ifndef COMMON_PLAYEVENTRECORDER_H
+#define COMMON_PLAYEVENTRECORDER_H
+
+#include "ringbuffer.h"
+#include "audiostream.h"
+#include "playlist.h"
+#include "audiooutput.h"
+
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+const std::size_t   PLAY_EVENT_RECORDS = 65536;
+
+struct PlayEventRecord
+{
+    dp::Long    beginNanoseconds;
+    dp::Long    elapsedNanoseconds;
+    dp::ULong   requestedSize;
+    dp::ULong   returnedSize;
+    dp::Bool    underrun;
+};
+
+// 再生コールバックの呼び出し記録
+// 記録は再生コールバックからロックフリーのリングバッファへ書き込まれ、
+// collectPlayEventRecords()で別スレッドから回収する
+struct PlayEventRecorder
+{
+    typedef std::chrono::steady_clock   Clock;
+
+    RingBuffer< PlayEventRecord >   ringBuffer;
+    Clock::time_point               origin;
+    dp::ULong                       bytesPerSecond;
+
+    std::atomic< dp::ULong >        droppedRecords;
+
+    std::vector< PlayEventRecord >  records;
+
+    explicit PlayEventRecorder(
+        dp::ULong   _bytesPerSecond
+    )
+        : ringBuffer( PLAY_EVENT_RECORDS )
+        , origin( Clock::now() )
+        , bytesPerSecond( _bytesPerSecond )
+        , droppedRecords( 0 )
+    {
+        this->records.reserve( PLAY_EVENT_RECORDS );
+    }
+};
+
+// _PLAYを呼び出し、その所要時間と要求・返却サイズを記録する
+// _UNDERRUNSはソース側のアンダーラン回数で、呼び出し前後で増えていればアンダーランとして記録する
+template< typename PLAY >
+dp::ULong recordPlayEvent(
+    PlayEventRecorder &                 _recorder
+    , const std::atomic< dp::ULong > &  _UNDERRUNS
+    , dp::ULong                         _bufferSize
+    , const PLAY &                      _PLAY
+)
+{
+    typedef PlayEventRecorder::Clock    Clock;
+
+    const auto  UNDERRUNS = _UNDERRUNS.load( std::memory_order_relaxed );
+    const auto  BEGIN = Clock::now();
+
+    const auto  RETURNED_SIZE = _PLAY();
+
+    const auto  END = Clock::now();
+
+    PlayEventRecord record;
+    record.beginNanoseconds = std::chrono::duration_cast< std::chrono::nanoseconds >( BEGIN - _recorder.origin ).count();
+    record.elapsedNanoseconds = std::chrono::duration_cast< std::chrono::nanoseconds >( END - BEGIN ).count();
+    record.requestedSize = _bufferSize;
+    record.returnedSize = RETURNED_SIZE;
+    record.underrun = _UNDERRUNS.load( std::memory_order_relaxed ) != UNDERRUNS;
+
+    if( _recorder.ringBuffer.write(
+        &record
+        , 1
+    ) <= 0 ) {
+        _recorder.droppedRecords.fetch_add(
+            1
+            , std::memory_order_relaxed
+        );
+    }
+
+    return RETURNED_SIZE;
+}
+
+inline void setRecordingAudioStreamPlayEventHandler(
+    AudioOutputInfo &       _info
+    , AudioStream &         _stream
+    , PlayEventRecorder &   _recorder
+)
+{
+    setPlayEventHandler(
+        _info
+        , [
+            &_stream
+            , &_recorder
+        ]
+        (
+            AudioOutput &       _output
+            , void *            _buffer
+            , dp::ULong         _bufferSize
+        ) -> dp::ULong
+        {
+            RealtimeScope   realtimeScope;
+
+            return recordPlayEvent(
+                _recorder
+                , _stream.underruns
+                , _bufferSize
+                , [
+                    &_stream
+                    , &_output
+                    , _buffer
+                    , _bufferSize
+                ]
+                {
+                    return readAudioStream(
+                        _stream
+                        , _output
+                        , _buffer
+                        , _bufferSize
+                    );
+                }
+            );
+        }
+    );
+}
+
+inline void setRecordingPlaylistPlayEventHandler(
+    AudioOutputInfo &       _info
+    , Playlist &            _playlist
+    , PlayEventRecorder &   _recorder
+)
+{
+    setPlayEventHandler(
+        _info
+        , [
+            &_playlist
+            , &_recorder
+        ]
+        (
+            AudioOutput &       _output
+            , void *            _buffer
+            , dp::ULong         _bufferSize
+        ) -> dp::ULong
+        {
+            RealtimeScope   realtimeScope;
+
+            return recordPlayEvent(
+                _recorder
+                , _playlist.underruns
+                , _bufferSize
+                , [
+                    &_playlist
+                    , &_output
+                    , _buffer
+                    , _bufferSize
+                ]
+                {
+                    return readPlaylist(
+                        _playlist
+                        , _output
+                        , _buffer
+                        , _bufferSize
+                    );
+                }
+            );
+        }
+    );
+}
+
+// リングバッファに溜まった記録を回収する
+// 再生中は記録が溢れないよう定期的に呼び出すこと
+void collectPlayEventRecords(
+    PlayEventRecorder &
+);
+
+// 呼び出し間隔、要求・返却サイズ、実行時間のパーセンタイルと、
+// アンダーラン、デッドライン超過の回数を表示する
+void printPlayEventSummary(
+    PlayEventRecorder &
+);
+
+#endif  // COMMON_PLAYEVENTRECORDER_H
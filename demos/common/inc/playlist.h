@@ -0,0 +1,128 @@
+﻿#ifndef COMMON_PLAYLIST_H
+#define COMMON_PLAYLIST_H
+
+#include "ringbuffer.h"
+#include "audiostream.h"
+#include "audiooutput.h"
+#include "gain.h"
+
+#include "dp/audio/audioformat.h"
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <atomic>
+
+// 1トラックに1つのAudioStreamを割り当て、再生コールバック内でフレーム単位で次のトラックへ切り替える
+// トラックは全て同じフォーマットに揃えておくこと
+// 生産者スレッドがqueuePlaylistStream()で次のトラックを積み、
+// 再生を終えたトラックはcollectPlaylistStreams()で生産者スレッドへ返却される
+// クロスフェードの長さが設定されている場合、終端が確定したトラックの末尾と次のトラックの先頭を重ねる
+// 重ねる長さはgetPlaylistCrossfadeFrames()で決まり、生産者の速さによらない
+// そのため終端が確定するまで各トラックの末尾を読まずに残し、次のトラックの長さが判断できるまで待つ
+// (実時間の制約がある出力先では、待つ間はアンダーランとなる)
+// AudioStreamの容量は、クロスフェードの長さの2倍より大きくすること
+struct Playlist
+{
+    // 再生中のトラック、待機中のトラック、返却待ちのトラックの数には上限があり、
+    // 返却を待つリングバッファはそれらを全て収容できる大きさとする
+    RingBuffer< AudioStream * > queuedStreams;
+    RingBuffer< AudioStream * > retiredStreams;
+
+    dp::AudioFormat audioFormat;
+    dp::UInt        channels;
+    dp::UInt        frameSize;
+    dp::Byte        silence;
+
+    std::atomic< dp::Bool >     ended;
+    std::atomic< dp::ULong >    underruns;
+    std::atomic< dp::ULong >    finishedTracks;     // 再生を終えたトラックの数
+    std::atomic< dp::UInt >     crossfadeFrames;
+
+    // nullptrでなければ、トラックから読み出す際に同じ走査でゲインをかける
+    GainStage *     gainStage;
+
+    // 再生コールバック側の変数
+    AudioStream *           currentStream;
+    AudioStream *           nextStream;         // クロスフェード中に先読みしているトラック
+    dp::UInt                crossfadingFrames;  // 実行中のクロスフェードの長さ。0の場合はクロスフェード中でない
+    std::vector< dp::Byte > crossfadeBuffer;
+
+    Playlist(
+        dp::AudioFormat
+        , dp::UInt
+    );
+
+    ~Playlist(
+    );
+
+private:
+    Playlist(
+        const Playlist &
+    );
+
+    Playlist & operator=(
+        const Playlist &
+    );
+};
+
+// 生産者スレッドから呼び出す
+// 待機中のトラックが一杯の場合はfalseを返す
+// 積んだAudioStreamの所有権はPlaylistへ移る
+dp::Bool queuePlaylistStream(
+    Playlist &
+    , AudioStream *
+);
+
+// 生産者スレッドから呼び出す
+// 再生を終えたAudioStreamを破棄する
+void collectPlaylistStreams(
+    Playlist &
+);
+
+// 生産者スレッドから、これ以上トラックを積まないことを通知する
+void endPlaylist(
+    Playlist &
+);
+
+// 再生コールバックから呼び出す
+// 再生中のトラックが終端に達した場合、同じバッファの続きへ次のトラックを書き込む
+// データが不足した場合、実時間の制約がある出力先では無音で埋めてアンダーランとして数え、
+// それ以外の出力先では生産者の書き込みを待つ
+dp::ULong readPlaylist(
+    Playlist &
+    , const AudioOutput &
+    , void *
+    , dp::ULong
+);
+
+// 前のトラックの残り(前のクロスフェードで重なった分を除く)と次のトラックを重ねるフレーム数を求める
+// 設定の長さ、前のトラックの残り、次のトラックの長さの半分のうち最も短い長さとする
+// 次のトラックが重なる区間の中で終わって、その次のトラックが途切れて始まることはない
+// 出力する長さを前もって求める場合も、この関数で重なる分を差し引く
+dp::ULong getPlaylistCrossfadeFrames(
+    dp::UInt
+    , dp::ULong
+    , dp::ULong
+);
+
+// 再生中でも変更できる
+// 変更は次にトラックの終端へ達した時点から反映される
+void setPlaylistCrossfade(
+    Playlist &
+    , dp::UInt
+);
+
+// 再生開始前に呼び出す
+// リングバッファからのコピーとゲインの処理を1回の走査で行う
+// GainStageはPlaylistの破棄まで有効であること
+void setPlaylistGainStage(
+    Playlist &
+    , GainStage *
+);
+
+void setPlaylistPlayEventHandler(
+    AudioOutputInfo &
+    , Playlist &
+);
+
+#endif  // COMMON_PLAYLIST_H
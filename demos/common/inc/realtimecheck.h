@@ -0,0 +1,377 @@
+﻿#ifndef COMMON_REALTIMECHECK_H
+#define COMMON_REALTIMECHECK_H
+
+#include "dp/common/primitives.h"
+
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <cstddef>
+
+#if defined( REALTIME_CHECK ) && defined( LINUX ) && defined( __x86_64__ )
+#   define USE_REALTIME_SYSCALL_CHECK
+#   include <signal.h>
+#   include <ucontext.h>
+#   include <sys/prctl.h>
+#endif
+
+// RealtimeScopeの有効範囲内で行われたメモリの確保・解放と、システムコールを数える
+// REALTIME_CHECKを定義してビルドした場合(wafのconfigureで--realtime-checkを指定)のみ有効
+// 定義しない場合は確保・解放の関数を差し替えず、シグナルハンドラも設定しない
+// 計数するには、いずれか1つの翻訳単位でDEFINE_REALTIME_ALLOCATION_CHECKを展開すること
+//
+// メモリの確保・解放
+//   Linuxではmalloc()系の関数を差し替えるため、operator newを経由しない確保も数える
+//   それ以外ではoperator new、operator deleteのみ数える
+// システムコール
+//   Linux(x86-64)のSyscall User Dispatch(5.11以降)で、有効範囲内のシステムコールをSIGSYSとして捕捉する
+//   捕捉したシステムコールは数えた後にそのまま実行させるため、動作は変わらない
+//   捕捉後はその有効範囲を抜けるまで検査を止めるため、有効範囲ごとに最初の1回のみ数える
+//   スレッドごとの検査の準備(prctl())は、そのスレッドで最初に有効範囲に入る時に行う
+
+#if defined( _MSC_VER )
+#   define REALTIME_CHECK_THREAD_LOCAL __declspec( thread )
+#else
+#   define REALTIME_CHECK_THREAD_LOCAL __thread
+#endif
+
+#if defined( USE_REALTIME_SYSCALL_CHECK )
+#   if !defined( PR_SET_SYSCALL_USER_DISPATCH )
+#       define PR_SET_SYSCALL_USER_DISPATCH 59
+#       define PR_SYS_DISPATCH_OFF          0
+#       define PR_SYS_DISPATCH_ON           1
+#   endif
+#   if !defined( SYSCALL_DISPATCH_FILTER_ALLOW )
+#       define SYSCALL_DISPATCH_FILTER_ALLOW    0
+#       define SYSCALL_DISPATCH_FILTER_BLOCK    1
+#   endif
+#endif
+
+inline dp::Bool & getRealtimeFlag(
+)
+{
+    static REALTIME_CHECK_THREAD_LOCAL dp::Bool flag = false;
+
+    return flag;
+}
+
+inline std::atomic< dp::ULong > & getRealtimeAllocationCount(
+)
+{
+    static std::atomic< dp::ULong > count( 0 );
+
+    return count;
+}
+
+inline std::atomic< dp::ULong > & getRealtimeSyscallCount(
+)
+{
+    static std::atomic< dp::ULong > count( 0 );
+
+    return count;
+}
+
+// システムコールの検査を準備できたスレッドの数と、準備に失敗したスレッドの数
+inline std::atomic< dp::UInt > & getRealtimeSyscallCheckedThreads(
+)
+{
+    static std::atomic< dp::UInt > count( 0 );
+
+    return count;
+}
+
+inline std::atomic< dp::UInt > & getRealtimeSyscallUncheckedThreads(
+)
+{
+    static std::atomic< dp::UInt > count( 0 );
+
+    return count;
+}
+
+inline void countRealtimeAllocation(
+)
+{
+    if( getRealtimeFlag() == false ) {
+        return;
+    }
+
+    getRealtimeAllocationCount().fetch_add(
+        1
+        , std::memory_order_relaxed
+    );
+}
+
+#if defined( USE_REALTIME_SYSCALL_CHECK )
+// カーネルが参照する、スレッドごとのシステムコールの許可・捕捉の切り替え
+inline char & getRealtimeSyscallSelector(
+)
+{
+    static REALTIME_CHECK_THREAD_LOCAL char selector = SYSCALL_DISPATCH_FILTER_ALLOW;
+
+    return selector;
+}
+
+inline void handleRealtimeSyscall(
+    int
+    , siginfo_t *
+    , void *        _context
+)
+{
+    getRealtimeSyscallCount().fetch_add(
+        1
+        , std::memory_order_relaxed
+    );
+
+    // シグナルハンドラからの復帰もシステムコールのため、先に許可する
+    getRealtimeSyscallSelector() = SYSCALL_DISPATCH_FILTER_ALLOW;
+
+    // 捕捉されたシステムコールは実行されず、命令ポインタはsyscall命令(2バイト)の次を指している
+    // raxはカーネルがシステムコール番号へ戻しているため、syscall命令から再実行させる
+    auto &  registers = static_cast< ucontext_t * >( _context )->uc_mcontext.gregs;
+    registers[ REG_RIP ] -= 2;
+}
+
+// 0: 未準備、1: 準備済み、2: 準備できない
+inline int & getRealtimeSyscallCheckState(
+)
+{
+    static REALTIME_CHECK_THREAD_LOCAL int state = 0;
+
+    return state;
+}
+
+inline dp::Bool initRealtimeSyscallCheck(
+)
+{
+    auto &  state = getRealtimeSyscallCheckState();
+    if( state != 0 ) {
+        return state == 1;
+    }
+
+    static const auto   HANDLER_INSTALLED = [
+    ]
+    {
+        struct sigaction    action = {};
+        action.sa_sigaction = handleRealtimeSyscall;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset( &( action.sa_mask ) );
+
+        return sigaction(
+            SIGSYS
+            , &action
+            , nullptr
+        ) == 0;
+    }();
+
+    // 常に許可する命令の範囲は持たない
+    if( HANDLER_INSTALLED && prctl(
+        PR_SET_SYSCALL_USER_DISPATCH
+        , PR_SYS_DISPATCH_ON
+        , 0
+        , 0
+        , &( getRealtimeSyscallSelector() )
+    ) == 0 ) {
+        state = 1;
+
+        getRealtimeSyscallCheckedThreads().fetch_add( 1 );
+    } else {
+        state = 2;
+
+        getRealtimeSyscallUncheckedThreads().fetch_add( 1 );
+    }
+
+    return state == 1;
+}
+#endif
+
+inline void setRealtimeFlag(
+    dp::Bool    _flag
+)
+{
+    getRealtimeFlag() = _flag;
+
+#if defined( USE_REALTIME_SYSCALL_CHECK )
+    // 有効範囲に入ったことのないスレッドは準備しない
+    const auto  CHECKED = _flag ? initRealtimeSyscallCheck() : getRealtimeSyscallCheckState() == 1;
+    if( CHECKED ) {
+        // 切り替えの前後の処理が入れ替わらないようにする
+        std::atomic_signal_fence( std::memory_order_seq_cst );
+        getRealtimeSyscallSelector() = _flag ? SYSCALL_DISPATCH_FILTER_BLOCK : SYSCALL_DISPATCH_FILTER_ALLOW;
+        std::atomic_signal_fence( std::memory_order_seq_cst );
+    }
+#endif
+}
+
+struct RealtimeScope
+{
+private:
+    dp::Bool    prevFlag;
+
+public:
+    RealtimeScope(
+    )
+        : prevFlag( getRealtimeFlag() )
+    {
+        setRealtimeFlag( true );
+    }
+
+    ~RealtimeScope(
+    )
+    {
+        setRealtimeFlag( this->prevFlag );
+    }
+};
+
+// RealtimeScopeの中で、意図して待機する区間を検査から除く
+// 実時間の制約がない出力先で、生産者を待つ場合などに使用する
+struct NonRealtimeScope
+{
+private:
+    dp::Bool    prevFlag;
+
+public:
+    NonRealtimeScope(
+    )
+        : prevFlag( getRealtimeFlag() )
+    {
+        setRealtimeFlag( false );
+    }
+
+    ~NonRealtimeScope(
+    )
+    {
+        setRealtimeFlag( this->prevFlag );
+    }
+};
+
+inline void printRealtimeCheck(
+)
+{
+#if !defined( REALTIME_CHECK )
+    std::printf( "再生コールバック内のメモリ確保・解放とシステムコールの検査: 無効(REALTIME_CHECKを定義してビルドすると有効)\n" );
+#else
+    std::printf( "再生コールバック内のメモリ確保・解放回数: %llu\n", getRealtimeAllocationCount().load() );
+
+    const auto  CHECKED_THREADS = getRealtimeSyscallCheckedThreads().load();
+    const auto  UNCHECKED_THREADS = getRealtimeSyscallUncheckedThreads().load();
+    if( CHECKED_THREADS <= 0 ) {
+        std::printf( "再生コールバック内のシステムコール回数: 検査なし\n" );
+    } else {
+        std::printf( "再生コールバック内のシステムコール回数: %llu\n", getRealtimeSyscallCount().load() );
+    }
+    if( UNCHECKED_THREADS > 0 ) {
+        std::printf( "システムコールを検査できなかったスレッド数: %u\n", UNCHECKED_THREADS );
+    }
+#endif
+}
+
+#if !defined( REALTIME_CHECK )
+#   define DEFINE_REALTIME_ALLOCATION_CHECK
+#elif defined( LINUX )
+extern "C" {
+    void * __libc_malloc(
+        std::size_t
+    );
+
+    void * __libc_calloc(
+        std::size_t
+        , std::size_t
+    );
+
+    void * __libc_realloc(
+        void *
+        , std::size_t
+    );
+
+    void * __libc_memalign(
+        std::size_t
+        , std::size_t
+    );
+
+    void __libc_free(
+        void *
+    );
+}
+
+// operator newもmalloc()を経由するため、差し替えない
+#   define DEFINE_REALTIME_ALLOCATION_CHECK \
+    extern "C" void * malloc( \
+        std::size_t _size \
+    ) throw() \
+    { \
+        countRealtimeAllocation(); \
+        return __libc_malloc( _size ); \
+    } \
+    extern "C" void * calloc( \
+        std::size_t     _count \
+        , std::size_t   _size \
+    ) throw() \
+    { \
+        countRealtimeAllocation(); \
+        return __libc_calloc( _count, _size ); \
+    } \
+    extern "C" void * realloc( \
+        void *          _ptr \
+        , std::size_t   _size \
+    ) throw() \
+    { \
+        countRealtimeAllocation(); \
+        return __libc_realloc( _ptr, _size ); \
+    } \
+    extern "C" int posix_memalign( \
+        void **         _ptr \
+        , std::size_t   _alignment \
+        , std::size_t   _size \
+    ) throw() \
+    { \
+        countRealtimeAllocation(); \
+        if( _alignment == 0 || ( _alignment & ( _alignment - 1 ) ) != 0 || _alignment % sizeof( void * ) != 0 ) { \
+            return EINVAL; \
+        } \
+        auto    ptr = __libc_memalign( _alignment, _size ); \
+        if( ptr == nullptr ) { \
+            return ENOMEM; \
+        } \
+        *_ptr = ptr; \
+        return 0; \
+    } \
+    extern "C" void * aligned_alloc( \
+        std::size_t     _alignment \
+        , std::size_t   _size \
+    ) throw() \
+    { \
+        countRealtimeAllocation(); \
+        return __libc_memalign( _alignment, _size ); \
+    } \
+    extern "C" void free( \
+        void *  _ptr \
+    ) throw() \
+    { \
+        countRealtimeAllocation(); \
+        __libc_free( _ptr ); \
+    }
+#else
+#   define DEFINE_REALTIME_ALLOCATION_CHECK \
+    void * operator new( \
+        std::size_t _size \
+    ) \
+    { \
+        countRealtimeAllocation(); \
+        auto    ptr = std::malloc( _size > 0 ? _size : 1 ); \
+        if( ptr == nullptr ) { \
+            throw std::bad_alloc(); \
+        } \
+        return ptr; \
+    } \
+    void operator delete( \
+        void *  _ptr \
+    ) throw() \
+    { \
+        countRealtimeAllocation(); \
+        std::free( _ptr ); \
+    }
+#endif
+
+#endif  // COMMON_REALTIMECHECK_H
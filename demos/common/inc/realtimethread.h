@@ -0,0 +1,11 @@
+﻿#ifndef COMMON_REALTIMETHREAD_H
+#define COMMON_REALTIMETHREAD_H
+
+#include "dp/common/primitives.h"
+
+// 呼び出し元のスレッドを実時間優先度でスケジューリングするよう要求する
+// 権限不足などで変更できなかった場合はfalseを返す
+dp::Bool setCurrentThreadRealtime(
+);
+
+#endif  // COMMON_REALTIMETHREAD_H
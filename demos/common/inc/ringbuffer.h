@@ -0,0 +1,251 @@
+﻿#ifndef COMMON_RINGBUFFER_H
+#define COMMON_RINGBUFFER_H
+
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+const std::size_t   CACHE_LINE_SIZE = 64;
+
+// 単一生産者・単一消費者用のロックフリーリングバッファ
+// write系は生産者スレッドのみ、read系は消費者スレッドのみから呼び出すこと
+// 要素はmemcpyでコピーされるため、Tはトリビアルにコピー可能な型に限る
+template< typename T >
+struct RingBuffer
+{
+private:
+    typedef std::atomic< std::size_t >  Index;
+
+    dp::Byte    paddingForHead[ CACHE_LINE_SIZE ];
+
+    // 生産者側の変数
+    Index       writeIndex;
+    std::size_t cachedReadIndex;
+    dp::Byte    paddingForWriteIndex[ CACHE_LINE_SIZE - sizeof( Index ) - sizeof( std::size_t ) ];
+
+    // 消費者側の変数
+    Index       readIndex;
+    std::size_t cachedWriteIndex;
+    dp::Byte    paddingForReadIndex[ CACHE_LINE_SIZE - sizeof( Index ) - sizeof( std::size_t ) ];
+
+    std::size_t     mask;
+    std::vector< T >    buffer;
+
+    RingBuffer(
+        const RingBuffer &
+    );
+
+    RingBuffer & operator=(
+        const RingBuffer &
+    );
+
+    static std::size_t toPowerOfTwo(
+        std::size_t _size
+    )
+    {
+        std::size_t result = 1;
+        while( result < _size ) {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+public:
+    explicit RingBuffer(
+        std::size_t _capacity
+    )
+        : writeIndex( 0 )
+        , cachedReadIndex( 0 )
+        , readIndex( 0 )
+        , cachedWriteIndex( 0 )
+        , mask( toPowerOfTwo( _capacity ) - 1 )
+        , buffer( this->mask + 1 )
+    {
+    }
+
+    std::size_t getCapacity(
+    ) const
+    {
+        return this->buffer.size();
+    }
+
+    // 生産者スレッドから呼び出す
+    std::size_t getWritableSize(
+    )
+    {
+        const auto  WRITE_INDEX = this->writeIndex.load( std::memory_order_relaxed );
+
+        this->cachedReadIndex = this->readIndex.load( std::memory_order_acquire );
+
+        return this->getCapacity() - ( WRITE_INDEX - this->cachedReadIndex );
+    }
+
+    // 消費者スレッドから呼び出す
+    std::size_t getReadableSize(
+    )
+    {
+        const auto  READ_INDEX = this->readIndex.load( std::memory_order_relaxed );
+
+        this->cachedWriteIndex = this->writeIndex.load( std::memory_order_acquire );
+
+        return this->cachedWriteIndex - READ_INDEX;
+    }
+
+    // 最大_count個の要素を書き込み、書き込んだ要素数を返す
+    std::size_t write(
+        const T *       _DATA
+        , std::size_t   _count
+    )
+    {
+        const auto  WRITE_INDEX = this->writeIndex.load( std::memory_order_relaxed );
+        const auto  CAPACITY = this->getCapacity();
+
+        // 消費者側のインデックスは、キャッシュ値で足りない場合のみ読み直す
+        if( CAPACITY - ( WRITE_INDEX - this->cachedReadIndex ) < _count ) {
+            this->cachedReadIndex = this->readIndex.load( std::memory_order_acquire );
+        }
+
+        const auto  COUNT = std::min(
+            _count
+            , CAPACITY - ( WRITE_INDEX - this->cachedReadIndex )
+        );
+        if( COUNT <= 0 ) {
+            return 0;
+        }
+
+        const auto  OFFSET = WRITE_INDEX & this->mask;
+        const auto  FIRST_COUNT = std::min(
+            COUNT
+            , CAPACITY - OFFSET
+        );
+
+        std::memcpy(
+            this->buffer.data() + OFFSET
+            , _DATA
+            , FIRST_COUNT * sizeof( T )
+        );
+        std::memcpy(
+            this->buffer.data()
+            , _DATA + FIRST_COUNT
+            , ( COUNT - FIRST_COUNT ) * sizeof( T )
+        );
+
+        this->writeIndex.store(
+            WRITE_INDEX + COUNT
+            , std::memory_order_release
+        );
+
+        return COUNT;
+    }
+
+    // 最大_count個の要素を読み込み、読み込んだ要素数を返す
+    std::size_t read(
+        T *             _data
+        , std::size_t   _count
+    )
+    {
+        return this->read(
+            _data
+            , _count
+            , [](
+                T *             _destination
+                , const T *     _SOURCE
+                , std::size_t   _count
+            )
+            {
+                std::memcpy(
+                    _destination
+                    , _SOURCE
+                    , _count * sizeof( T )
+                );
+            }
+        );
+    }
+
+    // 最大_count個の要素を読み込み、読み込んだ要素数を返す
+    // 連続した領域ごとに_copy( 出力先, 読み込み元, 要素数 )で書き出すため、コピーと同時に変換できる
+    // _copyは先頭から順に呼び出され、要素数が0の場合は呼び出されない
+    template< typename COPY_T >
+    std::size_t read(
+        T *             _data
+        , std::size_t   _count
+        , COPY_T        _copy
+    )
+    {
+        const auto  READ_INDEX = this->readIndex.load( std::memory_order_relaxed );
+
+        // 生産者側のインデックスは、キャッシュ値で足りない場合のみ読み直す
+        if( this->cachedWriteIndex - READ_INDEX < _count ) {
+            this->cachedWriteIndex = this->writeIndex.load( std::memory_order_acquire );
+        }
+
+        const auto  COUNT = std::min(
+            _count
+            , this->cachedWriteIndex - READ_INDEX
+        );
+        if( COUNT <= 0 ) {
+            return 0;
+        }
+
+        const auto  CAPACITY = this->getCapacity();
+        const auto  OFFSET = READ_INDEX & this->mask;
+        const auto  FIRST_COUNT = std::min(
+            COUNT
+            , CAPACITY - OFFSET
+        );
+
+        _copy(
+            _data
+            , this->buffer.data() + OFFSET
+            , FIRST_COUNT
+        );
+        if( COUNT > FIRST_COUNT ) {
+            _copy(
+                _data + FIRST_COUNT
+                , this->buffer.data()
+                , COUNT - FIRST_COUNT
+            );
+        }
+
+        this->readIndex.store(
+            READ_INDEX + COUNT
+            , std::memory_order_release
+        );
+
+        return COUNT;
+    }
+
+    // 最大_count個の要素をコピーせずに読み捨て、読み捨てた要素数を返す
+    std::size_t skip(
+        std::size_t _count
+    )
+    {
+        const auto  READ_INDEX = this->readIndex.load( std::memory_order_relaxed );
+
+        if( this->cachedWriteIndex - READ_INDEX < _count ) {
+            this->cachedWriteIndex = this->writeIndex.load( std::memory_order_acquire );
+        }
+
+        const auto  COUNT = std::min(
+            _count
+            , this->cachedWriteIndex - READ_INDEX
+        );
+        if( COUNT <= 0 ) {
+            return 0;
+        }
+
+        this->readIndex.store(
+            READ_INDEX + COUNT
+            , std::memory_order_release
+        );
+
+        return COUNT;
+    }
+};
+
+#endif  // COMMON_RINGBUFFER_H
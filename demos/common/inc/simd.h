@@ -0,0 +1,18 @@
+﻿#ifndef COMMON_SIMD_H
+#define COMMON_SIMD_H
+
+// SSE2が利用可能な場合はUSE_SSE2を定義する
+// x86(32bit)のgccでは-msse2指定時のみ有効となり、それ以外はスカラー実装を使用する
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#   define USE_SSE2
+#   include <emmintrin.h>
+#endif
+
+// AVXが利用可能な場合(gccの-mavx、MSVCの/arch:AVX指定時)はUSE_AVXも定義する
+// 既定のビルドでは指定しないため、SSE2の実装を使用する
+#if defined( __AVX__ )
+#   define USE_AVX
+#   include <immintrin.h>
+#endif
+
+#endif  // COMMON_SIMD_H
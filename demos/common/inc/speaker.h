@@ -0,0 +1,44 @@
+﻿#ifndef COMMON_SPEAKER_H
+#define COMMON_SPEAKER_H
+
+#include "audiooutput.h"
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// 出力先の検索を裏で進め、最初に接続された出力先を保持する
+// 仮想スピーカーが指定されている場合は、その先頭が選ばれる
+struct SpeakerFinder
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    AudioOutputKeyUnique    keyUnique;
+
+    std::chrono::steady_clock::time_point   startTime;
+    std::chrono::steady_clock::time_point   foundTime;
+
+    // 接続イベントがメンバを参照するため、最初に破棄されるよう最後に宣言する
+    std::unique_ptr< AudioOutputManager >   managerUnique;
+};
+
+// 検索を開始してすぐに戻る
+SpeakerFinder * newSpeakerFinder(
+    const VirtualSpeakers &
+);
+
+// 出力先が見つかるまで待つ
+// 一度見つかった出力先は保持され、以降は待たずに返る
+// 5秒以内に見つからない場合はnullptrを返す
+const AudioOutputKey * waitAudioOutputKey(
+    SpeakerFinder &
+);
+
+// 最初に接続された出力先のキーを返す
+// 5秒以内に見つからない場合はnullptrを返す
+AudioOutputKey * getAudioOutputKey(
+    const VirtualSpeakers &
+);
+
+#endif  // COMMON_SPEAKER_H
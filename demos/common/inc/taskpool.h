@@ -0,0 +1,87 @@
+﻿#ifndef COMMON_TASKPOOL_H
+#define COMMON_TASKPOOL_H
+
+#include "dp/common/primitives.h"
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+struct TaskPool;
+
+// 引数は実行中のワーカーの番号
+// タスク内から追加するタスクは、この番号のワーカーのキューへ積む
+typedef std::function<
+    void (
+        TaskPool &
+        , dp::UInt
+    )
+> Task;
+
+// ワーカーごとにタスクのキューを持つ
+// 自分のキューは末尾から取り出し、空になれば他のワーカーのキューの先頭から奪う
+struct TaskWorker
+{
+    std::mutex          mutex;
+    std::deque< Task >  tasks;
+
+    std::atomic< dp::ULong >    executedTasks;
+    std::atomic< dp::ULong >    stolenTasks;    // 他のワーカーから奪って実行したタスクの数
+
+    TaskWorker(
+    )
+        : executedTasks( 0 )
+        , stolenTasks( 0 )
+    {
+    }
+};
+
+struct TaskPool
+{
+    std::vector< std::unique_ptr< TaskWorker > >    workers;
+    std::vector< std::thread >                      threads;
+
+    // 積まれてから実行を終えていないタスクの数
+    std::atomic< dp::ULong >    pendingTasks;
+
+    // キューに積まれ、まだ取り出されていないタスクの数
+    // 待機中のワーカーはmutexを取ってこの値を確認するため、積む側は増やした後にmutexを取って通知する
+    std::atomic< dp::ULong >    queuedTasks;
+
+    std::mutex              mutex;
+    std::condition_variable taskCond;
+    std::condition_variable idleCond;
+    dp::Bool                stopped;
+
+    ~TaskPool(
+    );
+};
+
+// _threadsが0の場合はハードウェアスレッド数とする
+TaskPool * newTaskPool(
+    dp::UInt
+);
+
+dp::UInt getWorkerCount(
+    const TaskPool &
+);
+
+// _workerIndexのワーカーのキューへ積む
+// ワーカー外のスレッドからは任意の番号を指定してよい
+void pushTask(
+    TaskPool &
+    , dp::UInt
+    , const Task &
+);
+
+// 実行中のタスクから積まれたものも含め、全てのタスクの実行が終わるまで待つ
+void waitTaskPool(
+    TaskPool &
+);
+
+#endif  // COMMON_TASKPOOL_H
@@ -0,0 +1,103 @@
+﻿#ifndef COMMON_TRIPLEBUFFER_H
+#define COMMON_TRIPLEBUFFER_H
+
+#include "ringbuffer.h"
+
+#include "dp/common/primitives.h"
+
+#include <atomic>
+#include <cstddef>
+
+// 単一の書き込みスレッドから読み込みスレッドへ、最新の状態を受け渡すロックフリーのトリプルバッファ
+// 書き込み側と読み込み側はそれぞれ専用のスロットを持ち、3つ目のスロットとの交換のみをアトミックに行う
+// どちらも相手を待たず、読み込み側は常に書き込みの完了した最新の状態を得る(途中の状態は読み飛ばされる)
+// writeは書き込みスレッドのみ、readは読み込みスレッドのみから呼び出すこと
+// 複数のスレッドから書き込む場合は、書き込み側で排他すること
+template< typename T >
+struct TripleBuffer
+{
+private:
+    // 中間のスロットの番号と、読み込み側がまだ取得していない状態かどうか
+    typedef std::atomic< dp::UInt > Middle;
+
+    static const dp::UInt   INDEX_MASK = 0x3;
+    static const dp::UInt   UPDATED_BIT = 0x4;
+
+    struct Slot
+    {
+        T           value;
+        dp::Byte    padding[ CACHE_LINE_SIZE - sizeof( T ) % CACHE_LINE_SIZE ];
+    };
+
+    dp::Byte    paddingForHead[ CACHE_LINE_SIZE ];
+
+    Middle      middle;
+    dp::Byte    paddingForMiddle[ CACHE_LINE_SIZE - sizeof( Middle ) ];
+
+    // 書き込み側の変数
+    dp::UInt    back;
+    dp::Byte    paddingForBack[ CACHE_LINE_SIZE - sizeof( dp::UInt ) ];
+
+    // 読み込み側の変数
+    dp::UInt    front;
+    dp::Byte    paddingForFront[ CACHE_LINE_SIZE - sizeof( dp::UInt ) ];
+
+    Slot    slots[ 3 ];
+
+    TripleBuffer(
+        const TripleBuffer &
+    );
+
+    TripleBuffer & operator=(
+        const TripleBuffer &
+    );
+
+public:
+    explicit TripleBuffer(
+        const T &   _INITIAL
+    )
+        : middle( 1 )
+        , back( 2 )
+        , front( 0 )
+    {
+        for( auto & slot : this->slots ) {
+            slot.value = _INITIAL;
+        }
+    }
+
+    // 書き込みスレッドから呼び出す
+    void write(
+        const T &   _VALUE
+    )
+    {
+        this->slots[ this->back ].value = _VALUE;
+
+        // 書き込んだスロットを中間に置き、それまでの中間のスロットを次の書き込み先とする
+        const auto  PREVIOUS = this->middle.exchange(
+            this->back | UPDATED_BIT
+            , std::memory_order_acq_rel
+        );
+
+        this->back = PREVIOUS & INDEX_MASK;
+    }
+
+    // 読み込みスレッドから呼び出す
+    // 前回の呼び出しから書き込みがなければ、前回と同じ状態を返す
+    // 返した参照は、次にread()を呼び出すまで有効
+    const T & read(
+    )
+    {
+        if( ( this->middle.load( std::memory_order_relaxed ) & UPDATED_BIT ) != 0 ) {
+            const auto  PREVIOUS = this->middle.exchange(
+                this->front
+                , std::memory_order_acq_rel
+            );
+
+            this->front = PREVIOUS & INDEX_MASK;
+        }
+
+        return this->slots[ this->front ].value;
+    }
+};
+
+#endif  // COMMON_TRIPLEBUFFER_H
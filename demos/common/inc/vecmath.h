@@ -0,0 +1,132 @@
+﻿#ifndef COMMON_VECMATH_H
+#define COMMON_VECMATH_H
+
+#include "dp/common/primitives.h"
+
+#include <cstddef>
+
+// GLへそのまま渡せるよう、行列は列優先で並べる
+// 境界の揃っていない配列(std::vectorなど)にも置けるよう、整列は要求しない
+struct Vec4
+{
+    dp::Float   elements[ 4 ];
+};
+
+struct Mat4
+{
+    dp::Float   elements[ 16 ];
+};
+
+// 回転を表す単位四元数
+struct Quat
+{
+    dp::Float   x;
+    dp::Float   y;
+    dp::Float   z;
+    dp::Float   w;
+};
+
+void setMat4Identity(
+    Mat4 &
+);
+
+// glFrustum()と同じ透視投影
+void setMat4Frustum(
+    Mat4 &
+    , dp::Float
+    , dp::Float
+    , dp::Float
+    , dp::Float
+    , dp::Float
+    , dp::Float
+);
+
+// 縦の視野角(ラジアン)と縦横比による透視投影
+void setMat4Perspective(
+    Mat4 &
+    , dp::Float
+    , dp::Float
+    , dp::Float
+    , dp::Float
+);
+
+void setMat4Translation(
+    Mat4 &
+    , dp::Float
+    , dp::Float
+    , dp::Float
+);
+
+void setMat4Scale(
+    Mat4 &
+    , dp::Float
+    , dp::Float
+    , dp::Float
+);
+
+void setMat4Rotation(
+    Mat4 &
+    , const Quat &
+);
+
+// 単位ベクトルの軸まわりに、角度(ラジアン)だけ回転する
+void setQuatAxisAngle(
+    Quat &
+    , dp::Float
+    , dp::Float
+    , dp::Float
+    , dp::Float
+);
+
+// 第3引数の回転の後に第2引数の回転を行う四元数を求める
+// 出力は入力と同じでもよい
+void multiplyQuat(
+    Quat &
+    , const Quat &
+    , const Quat &
+);
+
+// 長さが0の場合は回転なしとする
+void normalizeQuat(
+    Quat &
+);
+
+// 第2引数と第3引数の積を求める
+// 行列の場合と同様に、第3引数の変換が先に適用される
+// 出力は入力と同じでもよい
+void multiplyMat4(
+    Mat4 &
+    , const Mat4 &
+    , const Mat4 &
+);
+
+// 出力は入力と同じでもよい
+void transformVec4(
+    Vec4 &
+    , const Mat4 &
+    , const Vec4 &
+);
+
+// 第4引数の個数分、第3引数の各行列に左から第2引数をかける
+// 出力は第3引数と同じ配列でもよい
+void multiplyMat4Array(
+    Mat4 *
+    , const Mat4 &
+    , const Mat4 *
+    , std::size_t
+);
+
+// 第4引数の個数分、第3引数の各ベクトルを第2引数で変換する
+// 出力は第3引数と同じ配列でもよい
+void transformVec4Array(
+    Vec4 *
+    , const Mat4 &
+    , const Vec4 *
+    , std::size_t
+);
+
+// ビルド時に選択された実装の名前("AVX"、"SSE2"、"スカラー")
+const char * getVecMathImplementation(
+);
+
+#endif  // COMMON_VECMATH_H
@@ -0,0 +1,135 @@
+﻿#ifndef COMMON_WAV_H
+#define COMMON_WAV_H
+
+#include "adpcm.h"
+
+#include "dp/audio/audioformat.h"
+#include "dp/file/filer.h"
+#include "dp/file/filerw.h"
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+typedef std::vector< dp::Byte > WaveData;
+
+typedef decltype( dp::unique( static_cast< dp::FileR * >( nullptr ) ) ) FileRUnique;
+typedef decltype( dp::unique( static_cast< dp::FileRW * >( nullptr ) ) ) FileRWUnique;
+
+// RF64形式のファイルも読み込める
+// IMA-ADPCM、MS-ADPCMのファイルは、readWavData()で読み込みながらS16LEへ展開する
+// audioFormat、frameSize、dataSize、restSizeは展開後の値となる
+// factチャンクがあれば、展開後のフレーム数をその値までに切り詰める
+struct WavReader
+{
+    FileRUnique     fileUnique;
+
+    dp::AudioFormat audioFormat;
+    dp::UInt        sampleRate;
+    dp::UInt        channels;
+    dp::UInt        frameSize;
+
+    dp::ULong       dataSize;
+    dp::ULong       restSize;
+
+    dp::ULong       encodedDataSize;    // ファイル上の波形データのバイト数
+    dp::ULong       dataOffset;         // ファイル上の波形データの先頭位置
+
+    // ADPCMの場合のみ使用する
+    dp::Bool                    compressed;
+    AdpcmDecoder                decoder;
+    dp::ULong                   encodedRestSize;
+    WaveData                    encodedBuffer;
+    std::vector< std::int16_t > decodedBuffer;
+    std::size_t                 decodedOffset;
+    std::size_t                 decodedSize;
+};
+
+dp::Bool openWav(
+    const dp::Utf32 &
+    , WavReader &
+);
+
+// 最大_sizeバイトの波形データを読み込み、_sizeに読み込んだバイト数を格納する
+// 波形データの終端では_sizeに0を格納する
+dp::Bool readWavData(
+    WavReader &
+    , void *
+    , dp::ULong &
+);
+
+// 波形データの_frameフレーム目から読み込むよう位置を変更する
+// 終端を超える場合は終端へ移動する
+// ADPCMの場合は_frameを含むブロックの先頭から展開し直し、ブロック内の手前のフレームを読み捨てる
+dp::Bool seekWav(
+    WavReader &
+    , dp::ULong
+);
+
+struct WavChunkInfo
+{
+    dp::Byte    tag[ 4 ];
+    dp::ULong   offset;     // チャンクヘッダの先頭位置
+    dp::ULong   size;       // チャンクヘッダを除いたサイズ
+};
+
+typedef std::vector< WavChunkInfo > WavChunkInfos;
+
+// 再生できない形式も扱えるよう、fmtチャンクの値は変換せずに格納する
+struct WavScanInfo
+{
+    dp::UShort      formatId;
+    dp::UInt        channels;
+    dp::UInt        sampleRate;
+    dp::UInt        bitsPerSample;
+    dp::UInt        blockSize;
+    dp::ULong       frames;     // 圧縮形式はfactチャンク、それ以外はdataチャンクのサイズとブロックサイズから求める
+    WavChunkInfos   chunks;
+};
+
+// ヘッダを解析し、全チャンクの位置とサイズを列挙する
+// openWav()と異なり、24bit、32bit、浮動小数点、WAVE_FORMAT_EXTENSIBLEのファイルも解析できる
+// 波形データは読み込まない
+dp::Bool scanWav(
+    const dp::Utf32 &
+    , WavScanInfo &
+);
+
+// 波形データはまとめてから書き込み、closeWav()でヘッダのサイズ情報を書き直す
+// 波形データが4GBを超えた場合はRF64形式となる
+struct WavWriter
+{
+    FileRWUnique    fileUnique;
+
+    dp::AudioFormat audioFormat;
+    dp::UInt        sampleRate;
+    dp::UInt        channels;
+    dp::UInt        frameSize;
+
+    dp::ULong       dataSize;
+
+    WaveData        writeBuffer;
+    std::size_t     bufferedSize;
+};
+
+dp::Bool createWav(
+    const dp::Utf32 &
+    , dp::AudioFormat
+    , dp::UInt
+    , dp::UInt
+    , WavWriter &
+);
+
+dp::Bool writeWavData(
+    WavWriter &
+    , const void *
+    , dp::ULong
+);
+
+// ヘッダのサイズ情報を確定させてファイルを閉じる
+dp::Bool closeWav(
+    WavWriter &
+);
+
+#endif  // COMMON_WAV_H
@@ -0,0 +1,323 @@
+﻿#include "adpcm.h"
+
+#include "dp/common/primitives.h"
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace {
+    const dp::Int   IMA_INDEX_TABLE[] = {
+        -1, -1, -1, -1, 2, 4, 6, 8,
+        -1, -1, -1, -1, 2, 4, 6, 8,
+    };
+
+    const dp::Int   IMA_STEP_TABLE[] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+        19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+        130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+        337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+        876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+        2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+        5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+    };
+
+    const dp::Int   IMA_STEP_INDEX_MAX = sizeof( IMA_STEP_TABLE ) / sizeof( IMA_STEP_TABLE[ 0 ] ) - 1;
+
+    const dp::Int   MS_ADAPTATION_TABLE[] = {
+        230, 230, 230, 230, 307, 409, 512, 614,
+        768, 614, 512, 409, 307, 230, 230, 230,
+    };
+
+    const std::int16_t  MS_DEFAULT_COEFFICIENTS[] = {
+        256, 0,
+        512, -256,
+        0, 0,
+        192, 64,
+        240, 0,
+        460, -208,
+        392, -232,
+    };
+
+    // ブロックヘッダのチャンネルあたりのバイト数
+    const std::size_t   IMA_HEADER_SIZE = 4;
+    const std::size_t   MS_HEADER_SIZE = 7;
+
+    std::int16_t toS16(
+        const dp::Byte *    _DATA
+    )
+    {
+        return static_cast< std::int16_t >( _DATA[ 0 ] | ( _DATA[ 1 ] << 8 ) );
+    }
+
+    std::int16_t clampS16(
+        dp::Int _sample
+    )
+    {
+        return static_cast< std::int16_t >(
+            std::max(
+                -32768
+                , std::min(
+                    _sample
+                    , 32767
+                )
+            )
+        );
+    }
+
+    struct ImaChannel
+    {
+        dp::Int predictor;
+        dp::Int stepIndex;
+    };
+
+    std::int16_t decodeImaNibble(
+        ImaChannel &    _channel
+        , dp::Int       _nibble
+    )
+    {
+        const auto  STEP = IMA_STEP_TABLE[ _channel.stepIndex ];
+
+        auto    diff = STEP >> 3;
+        if( _nibble & 1 ) {
+            diff += STEP >> 2;
+        }
+        if( _nibble & 2 ) {
+            diff += STEP >> 1;
+        }
+        if( _nibble & 4 ) {
+            diff += STEP;
+        }
+        if( _nibble & 8 ) {
+            diff = -diff;
+        }
+
+        _channel.predictor = clampS16( _channel.predictor + diff );
+        _channel.stepIndex = std::max(
+            0
+            , std::min(
+                _channel.stepIndex + IMA_INDEX_TABLE[ _nibble ]
+                , IMA_STEP_INDEX_MAX
+            )
+        );
+
+        return static_cast< std::int16_t >( _channel.predictor );
+    }
+
+    // ヘッダの後、チャンネルごとに4バイト(8サンプル)ずつ交互に並び、各バイトは下位ニブルが先
+    std::size_t decodeImaBlock(
+        const AdpcmDecoder &    _DECODER
+        , const dp::Byte *      _BLOCK
+        , std::size_t           _blockSize
+        , std::int16_t *        _destination
+    )
+    {
+        const auto  CHANNELS = _DECODER.channels;
+        const auto  FRAMES = getAdpcmBlockFrames(
+            _DECODER
+            , _blockSize
+        );
+
+        ImaChannel  channels[ ADPCM_CHANNELS_MAX ];
+        for( dp::UInt i = 0 ; i < CHANNELS ; i++ ) {
+            const auto  HEADER = _BLOCK + i * IMA_HEADER_SIZE;
+
+            channels[ i ].predictor = toS16( HEADER );
+            channels[ i ].stepIndex = HEADER[ 2 ];
+            if( channels[ i ].stepIndex > IMA_STEP_INDEX_MAX ) {
+                return 0;
+            }
+
+            _destination[ i ] = static_cast< std::int16_t >( channels[ i ].predictor );
+        }
+
+        auto    data = _BLOCK + CHANNELS * IMA_HEADER_SIZE;
+        for( std::size_t frame = 1 ; frame < FRAMES ; frame += 8 ) {
+            for( dp::UInt i = 0 ; i < CHANNELS ; i++ ) {
+                auto &  channel = channels[ i ];
+
+                for( std::size_t j = 0 ; j < 8 ; j++ ) {
+                    const auto  NIBBLE = j % 2 == 0 ? data[ j / 2 ] & 0xf : data[ j / 2 ] >> 4;
+                    const auto  SAMPLE = decodeImaNibble(
+                        channel
+                        , NIBBLE
+                    );
+
+                    if( frame + j < FRAMES ) {
+                        _destination[ ( frame + j ) * CHANNELS + i ] = SAMPLE;
+                    }
+                }
+
+                data += 4;
+            }
+        }
+
+        return FRAMES;
+    }
+
+    struct MsChannel
+    {
+        dp::Int coefficient1;
+        dp::Int coefficient2;
+        dp::Int delta;
+        dp::Int sample1;
+        dp::Int sample2;
+    };
+
+    std::int16_t decodeMsNibble(
+        MsChannel & _channel
+        , dp::Int   _nibble
+    )
+    {
+        const auto  SIGNED_NIBBLE = _nibble >= 8 ? _nibble - 16 : _nibble;
+
+        const auto  PREDICTOR = ( _channel.sample1 * _channel.coefficient1 + _channel.sample2 * _channel.coefficient2 ) >> 8;
+        const auto  SAMPLE = clampS16( PREDICTOR + SIGNED_NIBBLE * _channel.delta );
+
+        _channel.sample2 = _channel.sample1;
+        _channel.sample1 = SAMPLE;
+        _channel.delta = std::max(
+            16
+            , ( MS_ADAPTATION_TABLE[ _nibble ] * _channel.delta ) >> 8
+        );
+
+        return SAMPLE;
+    }
+
+    // ヘッダは予測係数番号、量子化幅、1つ前のサンプル、2つ前のサンプルの順にチャンネル分並ぶ
+    // 2つ前、1つ前のサンプルを出力した後、各バイトの上位ニブルから順にチャンネルを交互に展開する
+    std::size_t decodeMsBlock(
+        const AdpcmDecoder &    _DECODER
+        , const dp::Byte *      _BLOCK
+        , std::size_t           _blockSize
+        , std::int16_t *        _destination
+    )
+    {
+        const auto  CHANNELS = _DECODER.channels;
+        const auto  FRAMES = getAdpcmBlockFrames(
+            _DECODER
+            , _blockSize
+        );
+        const auto  COEFFICIENTS = _DECODER.coefficients.size() / 2;
+
+        MsChannel   channels[ ADPCM_CHANNELS_MAX ];
+        for( dp::UInt i = 0 ; i < CHANNELS ; i++ ) {
+            auto &  channel = channels[ i ];
+
+            const auto  INDEX = _BLOCK[ i ];
+            if( INDEX >= COEFFICIENTS ) {
+                return 0;
+            }
+
+            channel.coefficient1 = _DECODER.coefficients[ INDEX * 2 ];
+            channel.coefficient2 = _DECODER.coefficients[ INDEX * 2 + 1 ];
+            channel.delta = toS16( _BLOCK + CHANNELS + i * 2 );
+            channel.sample1 = toS16( _BLOCK + CHANNELS * 3 + i * 2 );
+            channel.sample2 = toS16( _BLOCK + CHANNELS * 5 + i * 2 );
+
+            _destination[ i ] = static_cast< std::int16_t >( channel.sample2 );
+            _destination[ CHANNELS + i ] = static_cast< std::int16_t >( channel.sample1 );
+        }
+
+        auto        data = _BLOCK + CHANNELS * MS_HEADER_SIZE;
+        std::size_t sampleIndex = CHANNELS * 2;
+        const auto  SAMPLES = FRAMES * CHANNELS;
+        for( ; sampleIndex + 1 < SAMPLES ; data++ ) {
+            _destination[ sampleIndex ] = decodeMsNibble(
+                channels[ sampleIndex % CHANNELS ]
+                , *data >> 4
+            );
+            sampleIndex++;
+
+            _destination[ sampleIndex ] = decodeMsNibble(
+                channels[ sampleIndex % CHANNELS ]
+                , *data & 0xf
+            );
+            sampleIndex++;
+        }
+        if( sampleIndex < SAMPLES ) {
+            _destination[ sampleIndex ] = decodeMsNibble(
+                channels[ sampleIndex % CHANNELS ]
+                , *data >> 4
+            );
+        }
+
+        return FRAMES;
+    }
+}
+
+std::size_t getAdpcmBlockFrames(
+    const AdpcmDecoder &    _DECODER
+    , std::size_t           _blockSize
+)
+{
+    const auto  CHANNELS = _DECODER.channels;
+
+    std::size_t frames = 0;
+    switch( _DECODER.format ) {
+    case AdpcmFormat::IMA:
+        if( _blockSize < CHANNELS * IMA_HEADER_SIZE ) {
+            return 0;
+        }
+        // 4バイト単位に満たない端数は展開しない
+        frames = 1 + ( _blockSize - CHANNELS * IMA_HEADER_SIZE ) / ( CHANNELS * 4 ) * 8;
+        break;
+
+    case AdpcmFormat::MS:
+        if( _blockSize < CHANNELS * MS_HEADER_SIZE ) {
+            return 0;
+        }
+        frames = 2 + ( _blockSize - CHANNELS * MS_HEADER_SIZE ) * 2 / CHANNELS;
+        break;
+
+    default:
+        return 0;
+    }
+
+    return std::min(
+        frames
+        , static_cast< std::size_t >( _DECODER.samplesPerBlock )
+    );
+}
+
+void setDefaultMsAdpcmCoefficients(
+    AdpcmDecoder &  _decoder
+)
+{
+    _decoder.coefficients.assign(
+        MS_DEFAULT_COEFFICIENTS
+        , MS_DEFAULT_COEFFICIENTS + sizeof( MS_DEFAULT_COEFFICIENTS ) / sizeof( MS_DEFAULT_COEFFICIENTS[ 0 ] )
+    );
+}
+
+std::size_t decodeAdpcmBlock(
+    const AdpcmDecoder &    _DECODER
+    , const dp::Byte *      _BLOCK
+    , std::size_t           _blockSize
+    , std::int16_t *        _destination
+)
+{
+    switch( _DECODER.format ) {
+    case AdpcmFormat::IMA:
+        return decodeImaBlock(
+            _DECODER
+            , _BLOCK
+            , _blockSize
+            , _destination
+        );
+
+    case AdpcmFormat::MS:
+        return decodeMsBlock(
+            _DECODER
+            , _BLOCK
+            , _blockSize
+            , _destination
+        );
+
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,363 @@
+﻿#include "analyzer.h"
+#include "fft.h"
+
+#include "dp/audio/audioformat.h"
+#include "dp/common/primitives.h"
+
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace {
+    const auto  PI = 3.14159265358979323846;
+
+    // 0.5秒分の波形データを溜められるようにする
+    const auto  BUFFER_MILLISECONDS = 500;
+    const auto  IDLE_MILLISECONDS = 5;
+
+    // 中心周波数31.5Hz～16kHzのオクターブ帯域
+    // 帯域の下端は中心周波数の1/√2倍、最初の帯域は直流成分を除き、最後の帯域はナイキスト周波数までとする
+    const auto  BAND_CENTER_FREQUENCY = 1000.0;
+    const auto  BAND_CENTER_INDEX = 5;
+
+    dp::UInt toFrameSize(
+        dp::AudioFormat _audioFormat
+        , dp::UInt      _channels
+    )
+    {
+        switch( _audioFormat ) {
+        case dp::AudioFormat::U8:
+            return _channels;
+
+        case dp::AudioFormat::S16LE:
+            return _channels * sizeof( std::int16_t );
+
+        default:
+            return 0;
+        }
+    }
+
+    // インターリーブされた波形データから1チャンネル分を取り出し、フルスケールを1とした値にする
+    void extractChannel(
+        const AudioAnalyzer &   _ANALYZER
+        , dp::UInt              _channel
+        , dp::Float *           _samples
+    )
+    {
+        const auto  BLOCK = _ANALYZER.block.data();
+        const auto  CHANNELS = _ANALYZER.channels;
+
+        if( _ANALYZER.audioFormat == dp::AudioFormat::U8 ) {
+            for( std::size_t i = 0 ; i < ANALYZER_FFT_SIZE ; i++ ) {
+                _samples[ i ] = ( static_cast< dp::Int >( BLOCK[ i * CHANNELS + _channel ] ) - 0x80 ) / 128.0f;
+            }
+        } else {
+            for( std::size_t i = 0 ; i < ANALYZER_FFT_SIZE ; i++ ) {
+                std::int16_t    sample;
+                std::memcpy(
+                    &sample
+                    , BLOCK + ( i * CHANNELS + _channel ) * sizeof( sample )
+                    , sizeof( sample )
+                );
+
+                _samples[ i ] = sample / 32768.0f;
+            }
+        }
+    }
+
+    void analyzeChannel(
+        AudioAnalyzer &     _analyzer
+        , dp::UInt          _channel
+        , AnalyzerResult &  _result
+    )
+    {
+        auto    real = _analyzer.real.data();
+        auto    imaginary = _analyzer.imaginary.data();
+
+        extractChannel(
+            _analyzer
+            , _channel
+            , real
+        );
+
+        dp::Float   peak = 0;
+        dp::Float   power = 0;
+        for( std::size_t i = 0 ; i < ANALYZER_FFT_SIZE ; i++ ) {
+            const auto  SAMPLE = real[ i ];
+
+            peak = std::max(
+                peak
+                , std::abs( SAMPLE )
+            );
+            power += SAMPLE * SAMPLE;
+
+            real[ i ] = SAMPLE * _analyzer.window[ i ];
+            imaginary[ i ] = 0;
+        }
+
+        _result.peak = peak;
+        _result.rms = std::sqrt( power / ANALYZER_FFT_SIZE );
+
+        runFft(
+            _analyzer.fft
+            , real
+            , imaginary
+        );
+
+        for( std::size_t i = 0 ; i < ANALYZER_BANDS ; i++ ) {
+            dp::Float   bandPower = 0;
+            for( auto j = _analyzer.bandBins[ i ] ; j < _analyzer.bandBins[ i + 1 ] ; j++ ) {
+                bandPower += real[ j ] * real[ j ] + imaginary[ j ] * imaginary[ j ];
+            }
+
+            // 片側スペクトルのエネルギーを、窓関数をかける前の平均電力へ換算する
+            _result.bands[ i ] = std::sqrt( bandPower * 2 / ( ANALYZER_FFT_SIZE * _analyzer.windowPower ) );
+        }
+    }
+
+    void publishResults(
+        AudioAnalyzer &             _analyzer
+        , const AnalyzerResult *    _RESULTS
+    )
+    {
+        const auto  SEQUENCE = _analyzer.sequence.load( std::memory_order_relaxed );
+
+        _analyzer.sequence.store(
+            SEQUENCE + 1
+            , std::memory_order_relaxed
+        );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        for( dp::UInt i = 0 ; i < _analyzer.channels ; i++ ) {
+            const auto &    RESULT = _RESULTS[ i ];
+            auto &          channel = _analyzer.results[ i ];
+
+            channel.peak.store(
+                RESULT.peak
+                , std::memory_order_relaxed
+            );
+            channel.rms.store(
+                RESULT.rms
+                , std::memory_order_relaxed
+            );
+            for( std::size_t j = 0 ; j < ANALYZER_BANDS ; j++ ) {
+                channel.bands[ j ].store(
+                    RESULT.bands[ j ]
+                    , std::memory_order_relaxed
+                );
+            }
+        }
+
+        _analyzer.sequence.store(
+            SEQUENCE + 2
+            , std::memory_order_release
+        );
+    }
+
+    void runAnalyzer(
+        AudioAnalyzer & _analyzer
+    )
+    {
+        const auto  BLOCK_SIZE = ANALYZER_FFT_SIZE * _analyzer.frameSize;
+
+        AnalyzerResult  results[ ANALYZER_CHANNELS_MAX ];
+
+        while( _analyzer.stopped == false ) {
+            if( _analyzer.samples.getReadableSize() < BLOCK_SIZE ) {
+                std::this_thread::sleep_for( std::chrono::milliseconds( IDLE_MILLISECONDS ) );
+
+                continue;
+            }
+
+            _analyzer.samples.read(
+                _analyzer.block.data()
+                , BLOCK_SIZE
+            );
+
+            const auto  BEGIN = std::chrono::steady_clock::now();
+
+            for( dp::UInt i = 0 ; i < _analyzer.channels ; i++ ) {
+                analyzeChannel(
+                    _analyzer
+                    , i
+                    , results[ i ]
+                );
+            }
+
+            publishResults(
+                _analyzer
+                , results
+            );
+
+            _analyzer.analysisNanoseconds.fetch_add(
+                std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - BEGIN ).count()
+                , std::memory_order_relaxed
+            );
+            _analyzer.analyzedFrames.fetch_add(
+                ANALYZER_FFT_SIZE
+                , std::memory_order_relaxed
+            );
+        }
+    }
+}
+
+AudioAnalyzer::AudioAnalyzer(
+    dp::AudioFormat _audioFormat
+    , dp::UInt      _sampleRate
+    , dp::UInt      _channels
+)
+    : audioFormat( _audioFormat )
+    , sampleRate( _sampleRate )
+    , channels( _channels )
+    , frameSize(
+        toFrameSize(
+            _audioFormat
+            , _channels
+        )
+    )
+    , samples( static_cast< std::size_t >( _sampleRate ) * this->frameSize * BUFFER_MILLISECONDS / 1000 )
+    , droppedFrames( 0 )
+    , sequence( 0 )
+    , analyzedFrames( 0 )
+    , analysisNanoseconds( 0 )
+    , window( ANALYZER_FFT_SIZE )
+    , windowPower( 0 )
+    , bandBins( ANALYZER_BANDS + 1 )
+    , block( ANALYZER_FFT_SIZE * this->frameSize )
+    , real( ANALYZER_FFT_SIZE )
+    , imaginary( ANALYZER_FFT_SIZE )
+    , stopped( false )
+{
+    initFft(
+        this->fft
+        , ANALYZER_FFT_SIZE
+    );
+
+    // ハン窓
+    for( std::size_t i = 0 ; i < ANALYZER_FFT_SIZE ; i++ ) {
+        const auto  VALUE = static_cast< dp::Float >( 0.5 - 0.5 * std::cos( 2 * PI * i / ANALYZER_FFT_SIZE ) );
+
+        this->window[ i ] = VALUE;
+        this->windowPower += VALUE * VALUE;
+    }
+
+    const std::size_t   NYQUIST_BIN = ANALYZER_FFT_SIZE / 2;
+
+    // ビンは中心周波数を含む帯域へ割り当てる
+    // ビンの幅より狭い低域の帯域は空になり、値は0となる
+    this->bandBins[ 0 ] = 1;
+    for( std::size_t i = 1 ; i < ANALYZER_BANDS ; i++ ) {
+        const auto  LOWER_FREQUENCY = BAND_CENTER_FREQUENCY * std::pow( 2.0, static_cast< double >( i ) - BAND_CENTER_INDEX ) / std::sqrt( 2.0 );
+        const auto  BIN = static_cast< std::size_t >( std::ceil( LOWER_FREQUENCY * ANALYZER_FFT_SIZE / _sampleRate ) );
+
+        this->bandBins[ i ] = std::min(
+            std::max(
+                BIN
+                , this->bandBins[ i - 1 ]
+            )
+            , NYQUIST_BIN
+        );
+    }
+    this->bandBins[ ANALYZER_BANDS ] = NYQUIST_BIN;
+
+    for( auto & channel : this->results ) {
+        channel.peak = 0;
+        channel.rms = 0;
+        for( auto & band : channel.bands ) {
+            band = 0;
+        }
+    }
+}
+
+AudioAnalyzer::~AudioAnalyzer(
+)
+{
+    this->stopped = true;
+
+    if( this->thread.joinable() ) {
+        this->thread.join();
+    }
+}
+
+AudioAnalyzer * newAudioAnalyzer(
+    dp::AudioFormat _audioFormat
+    , dp::UInt      _sampleRate
+    , dp::UInt      _channels
+)
+{
+    if( _channels <= 0 || _channels > ANALYZER_CHANNELS_MAX ) {
+        return nullptr;
+    }
+
+    if( toFrameSize(
+        _audioFormat
+        , _channels
+    ) <= 0 ) {
+        return nullptr;
+    }
+
+    std::unique_ptr< AudioAnalyzer >    analyzerUnique(
+        new AudioAnalyzer(
+            _audioFormat
+            , _sampleRate
+            , _channels
+        )
+    );
+    auto &  analyzer = *analyzerUnique;
+
+    analyzer.thread = std::thread(
+        [
+            &analyzer
+        ]
+        {
+            runAnalyzer( analyzer );
+        }
+    );
+
+    return analyzerUnique.release();
+}
+
+dp::Bool getAnalyzerResult(
+    const AudioAnalyzer &   _ANALYZER
+    , dp::UInt              _channel
+    , AnalyzerResult &      _result
+)
+{
+    if( _channel >= _ANALYZER.channels ) {
+        return false;
+    }
+
+    const auto &    CHANNEL = _ANALYZER.results[ _channel ];
+
+    while( 1 ) {
+        const auto  SEQUENCE = _ANALYZER.sequence.load( std::memory_order_acquire );
+        if( SEQUENCE <= 0 ) {
+            return false;
+        }
+        if( SEQUENCE % 2 != 0 ) {
+            std::this_thread::yield();
+
+            continue;
+        }
+
+        _result.peak = CHANNEL.peak.load( std::memory_order_relaxed );
+        _result.rms = CHANNEL.rms.load( std::memory_order_relaxed );
+        for( std::size_t i = 0 ; i < ANALYZER_BANDS ; i++ ) {
+            _result.bands[ i ] = CHANNEL.bands[ i ].load( std::memory_order_relaxed );
+        }
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if( _ANALYZER.sequence.load( std::memory_order_relaxed ) == SEQUENCE ) {
+            break;
+        }
+    }
+
+    return true;
+}
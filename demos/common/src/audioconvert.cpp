@@ -0,0 +1,267 @@
+﻿#include "audioconvert.h"
+
+#include "dp/audio/audioformat.h"
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace {
+    std::int16_t toS16(
+        dp::Byte    _sample
+    )
+    {
+        return static_cast< std::int16_t >( ( static_cast< dp::Int >( _sample ) - 0x80 ) << 8 );
+    }
+
+    std::int16_t toS16(
+        const dp::Byte *    _SAMPLE
+    )
+    {
+        return static_cast< std::int16_t >( _SAMPLE[ 0 ] | ( _SAMPLE[ 1 ] << 8 ) );
+    }
+
+    dp::UInt toSampleSize(
+        dp::AudioFormat _audioFormat
+    )
+    {
+        return _audioFormat == dp::AudioFormat::U8 ? 1 : 2;
+    }
+
+    float toFloat(
+        dp::AudioFormat     _audioFormat
+        , const dp::Byte *  _SAMPLE
+    )
+    {
+        if( _audioFormat == dp::AudioFormat::U8 ) {
+            return ( static_cast< dp::Int >( _SAMPLE[ 0 ] ) - 0x80 ) / 128.0f;
+        }
+
+        return toS16( _SAMPLE ) / 32768.0f;
+    }
+
+    void fromFloat(
+        dp::AudioFormat _audioFormat
+        , float         _sample
+        , dp::Byte *    _destination
+    )
+    {
+        if( _audioFormat == dp::AudioFormat::U8 ) {
+            const auto  SAMPLE = static_cast< dp::Int >( std::floor( _sample * 128 + 0.5f ) ) + 0x80;
+
+            _destination[ 0 ] = static_cast< dp::Byte >( std::max( 0, std::min( SAMPLE, 0xff ) ) );
+
+            return;
+        }
+
+        const auto  SAMPLE = std::max( -32768, std::min( static_cast< dp::Int >( std::floor( _sample * 32768 + 0.5f ) ), 32767 ) );
+
+        _destination[ 0 ] = static_cast< dp::Byte >( SAMPLE & 0xff );
+        _destination[ 1 ] = static_cast< dp::Byte >( ( SAMPLE >> 8 ) & 0xff );
+    }
+
+    // 変換元のフレームを、変換先のチャンネル数の浮動小数点数に変換する
+    void mapChannels(
+        const AudioConverter &  _CONVERTER
+        , const dp::Byte *      _SOURCE
+        , float *               _destination
+    )
+    {
+        const auto  SAMPLE_SIZE = toSampleSize( _CONVERTER.sourceFormat );
+        const auto  SOURCE_CHANNELS = _CONVERTER.sourceChannels;
+        const auto  DESTINATION_CHANNELS = _CONVERTER.destinationChannels;
+
+        if( DESTINATION_CHANNELS == 1 ) {
+            float   sum = 0;
+            for( dp::UInt i = 0 ; i < SOURCE_CHANNELS ; i++ ) {
+                sum += toFloat(
+                    _CONVERTER.sourceFormat
+                    , _SOURCE + i * SAMPLE_SIZE
+                );
+            }
+            _destination[ 0 ] = sum / SOURCE_CHANNELS;
+
+            return;
+        }
+
+        for( dp::UInt i = 0 ; i < DESTINATION_CHANNELS ; i++ ) {
+            if( SOURCE_CHANNELS == 1 ) {
+                _destination[ i ] = toFloat(
+                    _CONVERTER.sourceFormat
+                    , _SOURCE
+                );
+            } else if( i < SOURCE_CHANNELS ) {
+                _destination[ i ] = toFloat(
+                    _CONVERTER.sourceFormat
+                    , _SOURCE + i * SAMPLE_SIZE
+                );
+            } else {
+                _destination[ i ] = 0;
+            }
+        }
+    }
+}
+
+void convertToS16Stereo(
+    dp::AudioFormat     _audioFormat
+    , dp::UInt          _channels
+    , const void *      _SOURCE
+    , std::size_t       _frames
+    , std::int16_t *    _destination
+)
+{
+    const auto  SOURCE = static_cast< const dp::Byte * >( _SOURCE );
+    const auto  RIGHT_CHANNEL = _channels >= 2 ? 1 : 0;
+
+    switch( _audioFormat ) {
+    case dp::AudioFormat::U8:
+        for( std::size_t i = 0 ; i < _frames ; i++ ) {
+            const auto  FRAME = SOURCE + i * _channels;
+
+            _destination[ i * 2 ] = toS16( FRAME[ 0 ] );
+            _destination[ i * 2 + 1 ] = toS16( FRAME[ RIGHT_CHANNEL ] );
+        }
+        break;
+
+    case dp::AudioFormat::S16LE:
+        if( _channels == 2 ) {
+            std::memcpy(
+                _destination
+                , SOURCE
+                , _frames * 2 * sizeof( std::int16_t )
+            );
+            break;
+        }
+
+        for( std::size_t i = 0 ; i < _frames ; i++ ) {
+            const auto  FRAME = SOURCE + i * _channels * 2;
+
+            _destination[ i * 2 ] = toS16( FRAME );
+            _destination[ i * 2 + 1 ] = toS16( FRAME + RIGHT_CHANNEL * 2 );
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void initAudioConverter(
+    AudioConverter &    _converter
+    , dp::AudioFormat   _sourceFormat
+    , dp::UInt          _sourceSampleRate
+    , dp::UInt          _sourceChannels
+    , dp::AudioFormat   _destinationFormat
+    , dp::UInt          _destinationSampleRate
+    , dp::UInt          _destinationChannels
+)
+{
+    _converter.sourceFormat = _sourceFormat;
+    _converter.sourceSampleRate = _sourceSampleRate;
+    _converter.sourceChannels = _sourceChannels;
+
+    _converter.destinationFormat = _destinationFormat;
+    _converter.destinationSampleRate = _destinationSampleRate;
+    _converter.destinationChannels = _destinationChannels;
+
+    _converter.passthrough =
+        _sourceFormat == _destinationFormat &&
+        _sourceSampleRate == _destinationSampleRate &&
+        _sourceChannels == _destinationChannels
+    ;
+
+    _converter.step = static_cast< double >( _sourceSampleRate ) / _destinationSampleRate;
+    _converter.position = 0;
+
+    // 先頭のフレームの前は無音として補間する
+    _converter.previousFrame.assign(
+        _destinationChannels
+        , 0.0f
+    );
+    _converter.sourceBuffer.clear();
+}
+
+std::size_t convertAudio(
+    AudioConverter &            _converter
+    , const void *              _SOURCE
+    , std::size_t               _frames
+    , std::vector< dp::Byte > & _destination
+)
+{
+    const auto  SOURCE = static_cast< const dp::Byte * >( _SOURCE );
+
+    if( _converter.passthrough ) {
+        const auto  SIZE = _frames * _converter.sourceChannels * toSampleSize( _converter.sourceFormat );
+
+        if( _destination.size() < SIZE ) {
+            _destination.resize( SIZE );
+        }
+        std::memcpy(
+            _destination.data()
+            , SOURCE
+            , SIZE
+        );
+
+        return _frames;
+    }
+
+    if( _frames <= 0 ) {
+        return 0;
+    }
+
+    const auto  CHANNELS = _converter.destinationChannels;
+    const auto  SOURCE_FRAME_SIZE = _converter.sourceChannels * toSampleSize( _converter.sourceFormat );
+    const auto  DESTINATION_SAMPLE_SIZE = toSampleSize( _converter.destinationFormat );
+
+    auto &  sourceBuffer = _converter.sourceBuffer;
+    if( sourceBuffer.size() < _frames * CHANNELS ) {
+        sourceBuffer.resize( _frames * CHANNELS );
+    }
+    for( std::size_t i = 0 ; i < _frames ; i++ ) {
+        mapChannels(
+            _converter
+            , SOURCE + i * SOURCE_FRAME_SIZE
+            , sourceBuffer.data() + i * CHANNELS
+        );
+    }
+
+    // positionは直前のフレームを0としたときの、次に出力するフレームの位置
+    const auto  MAX_FRAMES = static_cast< std::size_t >( std::ceil( ( _frames + 1 ) / _converter.step ) ) + 1;
+    if( _destination.size() < MAX_FRAMES * CHANNELS * DESTINATION_SAMPLE_SIZE ) {
+        _destination.resize( MAX_FRAMES * CHANNELS * DESTINATION_SAMPLE_SIZE );
+    }
+
+    std::size_t frames = 0;
+    auto &      position = _converter.position;
+    for( ; position < _frames ; position += _converter.step ) {
+        const auto  INDEX = static_cast< std::size_t >( position );
+        const auto  FRACTION = static_cast< float >( position - INDEX );
+
+        const auto  FROM = INDEX == 0 ? _converter.previousFrame.data() : sourceBuffer.data() + ( INDEX - 1 ) * CHANNELS;
+        const auto  TO = sourceBuffer.data() + INDEX * CHANNELS;
+
+        auto    destination = _destination.data() + frames * CHANNELS * DESTINATION_SAMPLE_SIZE;
+        for( dp::UInt i = 0 ; i < CHANNELS ; i++ ) {
+            fromFloat(
+                _converter.destinationFormat
+                , FROM[ i ] + ( TO[ i ] - FROM[ i ] ) * FRACTION
+                , destination + i * DESTINATION_SAMPLE_SIZE
+            );
+        }
+
+        frames++;
+    }
+    position -= _frames;
+
+    std::copy(
+        sourceBuffer.data() + ( _frames - 1 ) * CHANNELS
+        , sourceBuffer.data() + _frames * CHANNELS
+        , _converter.previousFrame.begin()
+    );
+
+    return frames;
+}
@@ -0,0 +1,1006 @@
+﻿#include "audiooutput.h"
+#include "wav.h"
+#include "realtimethread.h"
+#include "analyzer.h"
+
+#include "dp/audio/speakermanager.h"
+#include "dp/audio/speakerkey.h"
+#include "dp/audio/audioplayer.h"
+#include "dp/audio/audioformat.h"
+#include "dp/common/stringconverter.h"
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+
+namespace {
+    const auto  PERIOD_MILLISECONDS = 10;
+    const auto  BUFFER_COUNT = 2;
+
+    // 実時間の制約がない出力先の周期
+    // 再生コールバックとファイル書き込みの呼び出し回数を減らすため長くとる
+    const auto  OFFLINE_PERIOD_FRAMES = 8192;
+
+    dp::UInt toFrameSize(
+        dp::AudioFormat _audioFormat
+        , dp::UInt      _channels
+    )
+    {
+        switch( _audioFormat ) {
+        case dp::AudioFormat::U8:
+            return _channels;
+
+        case dp::AudioFormat::S16LE:
+            return _channels * 2;
+
+        default:
+            return 0;
+        }
+    }
+
+    dp::Long toNanoseconds(
+        const std::chrono::steady_clock::time_point &   _TIME
+    )
+    {
+        return std::chrono::duration_cast< std::chrono::nanoseconds >( _TIME.time_since_epoch() ).count();
+    }
+
+    // 出力側のスレッドから再生位置の基準点を更新する
+    void updatePlaybackClock(
+        AudioOutput &                                   _output
+        , dp::ULong                                     _frames
+        , dp::ULong                                     _limitFrames
+        , const std::chrono::steady_clock::time_point & _TIME
+    )
+    {
+        const auto  SEQUENCE = _output.clockSequence.load( std::memory_order_relaxed );
+
+        _output.clockSequence.store(
+            SEQUENCE + 1
+            , std::memory_order_relaxed
+        );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        _output.clockFrames.store(
+            _frames
+            , std::memory_order_relaxed
+        );
+        _output.clockLimitFrames.store(
+            _limitFrames
+            , std::memory_order_relaxed
+        );
+        _output.clockNanoseconds.store(
+            toNanoseconds( _TIME )
+            , std::memory_order_relaxed
+        );
+
+        _output.clockSequence.store(
+            SEQUENCE + 2
+            , std::memory_order_release
+        );
+    }
+
+    // 出力開始の指定フレームまでを無音で埋め、埋めたバイト数を返す
+    dp::ULong fillSilenceBeforeStart(
+        AudioOutput &   _output
+        , void *        _buffer
+        , dp::ULong     _bufferSize
+    )
+    {
+        if( _output.started.load( std::memory_order_relaxed ) ) {
+            return 0;
+        }
+
+        const auto  START_FRAME = _output.startFrame.load( std::memory_order_acquire );
+
+        dp::ULong   size = 0;
+        if( START_FRAME > _output.renderedFrames ) {
+            size = std::min(
+                ( START_FRAME - _output.renderedFrames ) * _output.frameSize
+                , _bufferSize - _bufferSize % _output.frameSize
+            );
+
+            std::memset(
+                _buffer
+                , _output.audioFormat == dp::AudioFormat::U8 ? 0x80 : 0x00
+                , size
+            );
+        }
+
+        if( size < _bufferSize ) {
+            _output.started.store(
+                true
+                , std::memory_order_release
+            );
+        }
+
+        return size;
+    }
+
+    // 初回の呼び出しで、再生コールバックを呼び出すスレッドと要求サイズが確定する
+    // 実スピーカーのスレッドはdp::AudioPlayerが生成するため、ここで優先度を変更する
+    void beginPlayEvent(
+        AudioOutput &   _output
+        , dp::ULong     _bufferSize
+    )
+    {
+        if( _output.callbackFrames.load( std::memory_order_relaxed ) == 0 ) {
+            if( _output.type == AudioOutputType::SPEAKER && _output.info.realtimeScheduling ) {
+                _output.realtimeScheduled = setCurrentThreadRealtime();
+            }
+
+            _output.callbackFrames.store(
+                static_cast< dp::UInt >( _bufferSize / _output.frameSize )
+                , std::memory_order_release
+            );
+        }
+    }
+
+    // 無音と再生コールバックの波形データを合わせたバイト数を返す
+    dp::ULong endPlayEvent(
+        AudioOutput &   _output
+        , dp::ULong     _silenceSize
+        , dp::ULong     _playSize
+    )
+    {
+        const auto  NOW = std::chrono::steady_clock::now();
+
+        if( _playSize > 0 && _output.firstPlayNanoseconds.load( std::memory_order_relaxed ) == 0 ) {
+            _output.firstPlayNanoseconds.store( toNanoseconds( NOW ) );
+        }
+
+        const auto  SIZE = _silenceSize + _playSize;
+        const auto  FRAMES = SIZE / _output.frameSize;
+
+        // 実スピーカーでは、この呼び出しの時点で直前のバッファの出力が始まったものとみなす
+        if( _output.type == AudioOutputType::SPEAKER ) {
+            updatePlaybackClock(
+                _output
+                , _output.renderedFrames - _output.lastRenderedFrames
+                , _output.renderedFrames
+                , NOW
+            );
+        }
+
+        _output.renderedFrames += FRAMES;
+        _output.lastRenderedFrames = FRAMES;
+
+        return SIZE;
+    }
+
+    dp::ULong callPlayEventHandler(
+        AudioOutput &   _output
+        , void *        _buffer
+        , dp::ULong     _bufferSize
+    )
+    {
+        beginPlayEvent(
+            _output
+            , _bufferSize
+        );
+
+        const auto  SILENCE_SIZE = fillSilenceBeforeStart(
+            _output
+            , _buffer
+            , _bufferSize
+        );
+
+        dp::ULong   playSize = 0;
+        if( SILENCE_SIZE < _bufferSize ) {
+            auto    buffer = static_cast< dp::Byte * >( _buffer ) + SILENCE_SIZE;
+
+            playSize = _output.info.playEventHandler(
+                _output
+                , buffer
+                , _bufferSize - SILENCE_SIZE
+            );
+
+            if( _output.info.analyzer != nullptr ) {
+                tapAudioAnalyzer(
+                    *( _output.info.analyzer )
+                    , buffer
+                    , playSize / _output.frameSize
+                );
+            }
+        }
+
+        return endPlayEvent(
+            _output
+            , SILENCE_SIZE
+            , playSize
+        );
+    }
+
+    // 再生コールバックが用意した波形データを、コピーせずにそのまま出力できる状態ならtrueを返す
+    // 出力開始前の無音を埋める場合は、バッファへコピーして処理する
+    dp::Bool canHandOffPlayData(
+        const AudioOutput & _OUTPUT
+    )
+    {
+        return _OUTPUT.info.playDataEventHandler
+            && _OUTPUT.started.load( std::memory_order_relaxed )
+        ;
+    }
+
+    // 仮想スピーカーの1周期分の波形データを用意し、_dataに出力する波形データの先頭を格納する
+    // コピーせずに受け渡せる場合、_dataは再生コールバックが用意した領域を指す
+    dp::ULong renderPlayData(
+        AudioOutput &       _output
+        , void *            _buffer
+        , dp::ULong         _bufferSize
+        , const void * &    _data
+    )
+    {
+        if( canHandOffPlayData( _output ) == false ) {
+            _data = _buffer;
+
+            return callPlayEventHandler(
+                _output
+                , _buffer
+                , _bufferSize
+            );
+        }
+
+        beginPlayEvent(
+            _output
+            , _bufferSize
+        );
+
+        const void *    data = nullptr;
+        auto            playSize = _output.info.playDataEventHandler(
+            _output
+            , data
+            , _bufferSize
+        );
+        playSize -= playSize % _output.frameSize;
+
+        if( _output.info.analyzer != nullptr ) {
+            tapAudioAnalyzer(
+                *( _output.info.analyzer )
+                , data
+                , playSize / _output.frameSize
+            );
+        }
+
+        _data = data;
+
+        return endPlayEvent(
+            _output
+            , 0
+            , playSize
+        );
+    }
+
+    dp::Bool startSpeaker(
+        AudioOutput &               _output
+        , const dp::SpeakerKey &    _KEY
+    )
+    {
+        auto    infoUnique = dp::unique( dp::newAudioPlayerInfo() );
+        if( infoUnique.get() == nullptr ) {
+            std::printf( "dp::AudioPlayerInfoの生成に失敗\n" );
+
+            return false;
+        }
+        auto &  info = *infoUnique;
+
+        dp::setStartEventHandler(
+            info
+            , [
+            ]
+            (
+                dp::AudioPlayer &   _audioPlayer
+            )
+            {
+                dp::pause(
+                    _audioPlayer
+                    , false
+                );
+            }
+        );
+        dp::setEndEventHandler(
+            info
+            , [
+                &_output
+            ]
+            (
+                dp::AudioPlayer &
+            )
+            {
+                _output.info.endEventHandler( _output );
+            }
+        );
+        dp::setPlayEventHandler(
+            info
+            , [
+                &_output
+            ]
+            (
+                dp::AudioPlayer &
+                , void *            _buffer
+                , dp::ULong         _bufferSize
+            ) -> dp::ULong
+            {
+                return callPlayEventHandler(
+                    _output
+                    , _buffer
+                    , _bufferSize
+                );
+            }
+        );
+
+        _output.audioPlayerUnique = dp::unique(
+            dp::newAudioPlayer(
+                _KEY
+                , info
+                , _output.audioFormat
+                , _output.sampleRate
+                , _output.channels
+            )
+        );
+        if( _output.audioPlayerUnique.get() == nullptr ) {
+            std::printf( "dp::AudioPlayerの生成に失敗\n" );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // _TIMEはバッファの先頭が出力される時刻
+    void callPresentEventHandler(
+        AudioOutput &                                   _output
+        , const void *                                  _BUFFER
+        , dp::ULong                                     _bufferSize
+        , const std::chrono::steady_clock::time_point & _TIME
+    )
+    {
+        const auto  FRAMES = _bufferSize / _output.frameSize;
+
+        // 実時間の制約がない出力先では、バッファ全体が一度に出力されたものとする
+        if( isRealtimeAudioOutput( _output.type ) ) {
+            updatePlaybackClock(
+                _output
+                , _output.presentedFrames
+                , _output.presentedFrames + FRAMES
+                , _TIME
+            );
+        } else {
+            updatePlaybackClock(
+                _output
+                , _output.presentedFrames + FRAMES
+                , _output.presentedFrames + FRAMES
+                , _TIME
+            );
+        }
+        _output.presentedFrames += FRAMES;
+
+        if( _output.info.presentEventHandler ) {
+            _output.info.presentEventHandler(
+                _output
+                , _BUFFER
+                , _bufferSize
+            );
+        }
+    }
+
+    // 実時間の制約がない仮想スピーカーの再生スレッド
+    // 1周期分ずつ再生コールバックを呼び出し、書き込まれた波形データを直ちに出力する
+    void runVirtualSpeaker(
+        AudioOutput &   _output
+    )
+    {
+        std::vector< dp::Byte > buffer( _output.periodFrames * _output.frameSize );
+
+        while( _output.stopped == false ) {
+            const void *    data;
+            const auto      SIZE = renderPlayData(
+                _output
+                , buffer.data()
+                , buffer.size()
+                , data
+            );
+            if( SIZE <= 0 ) {
+                break;
+            }
+
+            if( _output.type == AudioOutputType::WAV_FILE ) {
+                if( writeWavData(
+                    _output.wavWriter
+                    , data
+                    , SIZE
+                ) == false ) {
+                    break;
+                }
+            }
+
+            callPresentEventHandler(
+                _output
+                , data
+                , SIZE
+                , std::chrono::steady_clock::now()
+            );
+        }
+
+        if( _output.type == AudioOutputType::WAV_FILE ) {
+            closeWav( _output.wavWriter );
+        }
+
+        if( _output.stopped == false ) {
+            _output.info.endEventHandler( _output );
+        }
+    }
+
+    // NULL_REALTIMEの再生スレッド
+    // bufferCount周期分のバッファを持つ出力先を模し、周期nのバッファは時刻n * 周期で出力されたものとする
+    // 周期nのバッファは、周期n - bufferCountのバッファの出力が終わった時点で再生コールバックに書き込ませる
+    void runRealtimeVirtualSpeaker(
+        AudioOutput &   _output
+    )
+    {
+        typedef std::chrono::steady_clock   Clock;
+
+        const auto  PERIOD_SIZE = _output.periodFrames * _output.frameSize;
+        const auto  BUFFERS = _output.bufferCount;
+
+        std::vector< dp::Byte >         buffers( PERIOD_SIZE * BUFFERS );
+        std::vector< dp::ULong >        sizes( BUFFERS );
+        std::vector< const void * >     data( BUFFERS );
+
+        const auto  START = Clock::now();
+
+        dp::ULong   rendered = 0;
+        dp::Bool    ended = false;
+        for( dp::ULong played = 0 ; _output.stopped == false ; played++ ) {
+            const auto  PRESENT_TIME = START + std::chrono::microseconds( played * _output.periodFrames * 1000000 / _output.sampleRate );
+
+            std::this_thread::sleep_until( PRESENT_TIME );
+
+            while( ended == false && rendered < played + BUFFERS ) {
+                const auto  INDEX = rendered % BUFFERS;
+
+                sizes[ INDEX ] = renderPlayData(
+                    _output
+                    , buffers.data() + INDEX * PERIOD_SIZE
+                    , PERIOD_SIZE
+                    , data[ INDEX ]
+                );
+                if( sizes[ INDEX ] <= 0 ) {
+                    ended = true;
+
+                    break;
+                }
+
+                rendered++;
+            }
+
+            if( played >= rendered ) {
+                break;
+            }
+
+            const auto  INDEX = played % BUFFERS;
+
+            callPresentEventHandler(
+                _output
+                , data[ INDEX ]
+                , sizes[ INDEX ]
+                , PRESENT_TIME
+            );
+        }
+
+        if( _output.stopped == false ) {
+            _output.info.endEventHandler( _output );
+        }
+    }
+
+    dp::Bool startVirtualSpeaker(
+        AudioOutput &               _output
+        , const AudioOutputKey &    _KEY
+    )
+    {
+        if( _output.type == AudioOutputType::WAV_FILE ) {
+            if( createWav(
+                _KEY.filePath
+                , _output.audioFormat
+                , _output.sampleRate
+                , _output.channels
+                , _output.wavWriter
+            ) == false ) {
+                return false;
+            }
+        }
+
+        _output.thread = std::thread(
+            [
+                &_output
+            ]
+            {
+                if( _output.info.realtimeScheduling ) {
+                    _output.realtimeScheduled = setCurrentThreadRealtime();
+                }
+
+                if( _output.type == AudioOutputType::NULL_REALTIME ) {
+                    runRealtimeVirtualSpeaker( _output );
+                } else {
+                    runVirtualSpeaker( _output );
+                }
+            }
+        );
+
+        return true;
+    }
+
+    dp::Bool startSpeakerManager(
+        AudioOutputManager &    _manager
+    )
+    {
+        auto    infoUnique = dp::unique( dp::newSpeakerManagerInfo() );
+        if( infoUnique.get() == nullptr ) {
+            std::printf( "dp::SpeakerManagerInfoの生成に失敗\n" );
+
+            return false;
+        }
+        auto &  info = *infoUnique;
+
+        dp::setConnectEventHandler(
+            info
+            , [
+                &_manager
+            ]
+            (
+                dp::SpeakerManager &
+                , dp::SpeakerKeyUnique &&   _keyUnique
+                , dp::Bool                  _connected
+            )
+            {
+                AudioOutputKeyUnique    keyUnique( new AudioOutputKey );
+                keyUnique->type = AudioOutputType::SPEAKER;
+                keyUnique->speakerKeyUnique = std::move( _keyUnique );
+
+                _manager.info.connectEventHandler(
+                    _manager
+                    , std::move( keyUnique )
+                    , _connected
+                );
+            }
+        );
+
+        _manager.speakerManagerUnique = dp::unique(
+            dp::newSpeakerManager(
+                info
+            )
+        );
+        if( _manager.speakerManagerUnique.get() == nullptr ) {
+            std::printf( "dp::SpeakerManagerの生成に失敗\n" );
+
+            return false;
+        }
+
+        return true;
+    }
+}
+
+dp::Bool parseVirtualSpeakerOption(
+    VirtualSpeakers &   _speakers
+    , const dp::Utf32 & _OPTION
+)
+{
+    const auto  SEPARATOR_INDEX = _OPTION.find( static_cast< dp::Utf32::value_type >( '=' ) );
+
+    dp::String  name;
+    if( dp::toString(
+        name
+        , _OPTION.substr(
+            0
+            , SEPARATOR_INDEX
+        )
+    ) == false ) {
+        return false;
+    }
+
+    VirtualSpeaker  speaker;
+    if( name == "--null" && SEPARATOR_INDEX == dp::Utf32::npos ) {
+        speaker.type = AudioOutputType::NULL_REALTIME;
+    } else if( name == "--null-fast" && SEPARATOR_INDEX == dp::Utf32::npos ) {
+        speaker.type = AudioOutputType::NULL_FAST;
+    } else if( name == "--wavout" && SEPARATOR_INDEX != dp::Utf32::npos ) {
+        speaker.type = AudioOutputType::WAV_FILE;
+        speaker.filePath = _OPTION.substr( SEPARATOR_INDEX + 1 );
+    } else {
+        return false;
+    }
+
+    _speakers.push_back( speaker );
+
+    return true;
+}
+
+void setConnectEventHandler(
+    AudioOutputManagerInfo &                    _info
+    , const AudioOutputConnectEventHandler &    _HANDLER
+)
+{
+    _info.connectEventHandler = _HANDLER;
+}
+
+void addVirtualSpeaker(
+    AudioOutputManagerInfo &    _info
+    , const VirtualSpeaker &    _SPEAKER
+)
+{
+    _info.virtualSpeakers.push_back( _SPEAKER );
+}
+
+AudioOutputManager * newAudioOutputManager(
+    const AudioOutputManagerInfo &  _INFO
+)
+{
+    std::unique_ptr< AudioOutputManager >   managerUnique( new AudioOutputManager );
+    auto &                                  manager = *managerUnique;
+
+    manager.info = _INFO;
+
+    for( const auto & SPEAKER : manager.info.virtualSpeakers ) {
+        AudioOutputKeyUnique    keyUnique( new AudioOutputKey );
+        keyUnique->type = SPEAKER.type;
+        keyUnique->filePath = SPEAKER.filePath;
+
+        manager.info.connectEventHandler(
+            manager
+            , std::move( keyUnique )
+            , true
+        );
+    }
+
+    if( startSpeakerManager( manager ) == false ) {
+        if( manager.info.virtualSpeakers.empty() ) {
+            return nullptr;
+        }
+
+        std::printf( "実スピーカーの検索を開始できないため、仮想スピーカーのみを使用\n" );
+    }
+
+    return managerUnique.release();
+}
+
+AudioOutputInfo::AudioOutputInfo(
+)
+    : latencyMilliseconds( 0 )
+    , periodFrames( 0 )
+    , bufferCount( 0 )
+    , realtimeScheduling( false )
+    , analyzer( nullptr )
+    , startFrame( 0 )
+{
+}
+
+AudioOutput::AudioOutput(
+)
+    : callbackFrames( 0 )
+    , realtimeScheduled( false )
+    , firstPlayNanoseconds( 0 )
+    , clockSequence( 0 )
+    , clockFrames( 0 )
+    , clockLimitFrames( 0 )
+    , clockNanoseconds( 0 )
+    , startFrame( 0 )
+    , started( false )
+    , renderedFrames( 0 )
+    , presentedFrames( 0 )
+    , lastRenderedFrames( 0 )
+    , stopped( false )
+{
+}
+
+AudioOutput::~AudioOutput(
+)
+{
+    // 実スピーカーのコールバックは以降のメンバを参照するため、メンバの破棄より先に再生を止める
+    this->audioPlayerUnique.reset();
+
+    this->stopped = true;
+
+    if( this->thread.joinable() ) {
+        this->thread.join();
+    }
+}
+
+void setEndEventHandler(
+    AudioOutputInfo &                       _info
+    , const AudioOutputEndEventHandler &    _HANDLER
+)
+{
+    _info.endEventHandler = _HANDLER;
+}
+
+void setPlayEventHandler(
+    AudioOutputInfo &                       _info
+    , const AudioOutputPlayEventHandler &   _HANDLER
+)
+{
+    _info.playEventHandler = _HANDLER;
+}
+
+void setPlayDataEventHandler(
+    AudioOutputInfo &                           _info
+    , const AudioOutputPlayDataEventHandler &   _HANDLER
+)
+{
+    _info.playDataEventHandler = _HANDLER;
+
+    // コピーせずに受け渡せない出力先と状況のため、バッファへコピーする再生コールバックも設定する
+    _info.playEventHandler = [
+        _HANDLER
+    ]
+    (
+        AudioOutput &       _output
+        , void *            _buffer
+        , dp::ULong         _bufferSize
+    ) -> dp::ULong
+    {
+        const void *    data = nullptr;
+        auto            size = _HANDLER(
+            _output
+            , data
+            , _bufferSize
+        );
+        size -= size % _output.frameSize;
+
+        if( size > 0 ) {
+            std::memcpy(
+                _buffer
+                , data
+                , size
+            );
+        }
+
+        return size;
+    };
+}
+
+void setPresentEventHandler(
+    AudioOutputInfo &                           _info
+    , const AudioOutputPresentEventHandler &    _HANDLER
+)
+{
+    _info.presentEventHandler = _HANDLER;
+}
+
+void setLatency(
+    AudioOutputInfo &   _info
+    , dp::UInt          _milliseconds
+)
+{
+    _info.latencyMilliseconds = _milliseconds;
+}
+
+void setPeriodFrames(
+    AudioOutputInfo &   _info
+    , dp::UInt          _frames
+)
+{
+    _info.periodFrames = _frames;
+}
+
+void setBufferCount(
+    AudioOutputInfo &   _info
+    , dp::UInt          _count
+)
+{
+    _info.bufferCount = _count;
+}
+
+void setRealtimeScheduling(
+    AudioOutputInfo &   _info
+    , dp::Bool          _realtimeScheduling
+)
+{
+    _info.realtimeScheduling = _realtimeScheduling;
+}
+
+void setAnalyzer(
+    AudioOutputInfo &   _info
+    , AudioAnalyzer *   _analyzer
+)
+{
+    _info.analyzer = _analyzer;
+}
+
+void setStartFrame(
+    AudioOutputInfo &   _info
+    , dp::ULong         _frame
+)
+{
+    _info.startFrame = _frame;
+}
+
+dp::Bool scheduleAudioOutputStart(
+    AudioOutput &   _output
+    , dp::ULong     _frame
+)
+{
+    if( _output.started.load( std::memory_order_acquire ) ) {
+        return false;
+    }
+
+    _output.startFrame.store(
+        _frame
+        , std::memory_order_release
+    );
+
+    return true;
+}
+
+dp::Bool getPlaybackPosition(
+    const AudioOutput &     _OUTPUT
+    , AudioOutputPosition & _position
+)
+{
+    dp::ULong   frames;
+    dp::ULong   limitFrames;
+    dp::Long    nanoseconds;
+    while( 1 ) {
+        const auto  SEQUENCE = _OUTPUT.clockSequence.load( std::memory_order_acquire );
+        if( SEQUENCE <= 0 ) {
+            return false;
+        }
+        if( SEQUENCE % 2 != 0 ) {
+            std::this_thread::yield();
+
+            continue;
+        }
+
+        frames = _OUTPUT.clockFrames.load( std::memory_order_relaxed );
+        limitFrames = _OUTPUT.clockLimitFrames.load( std::memory_order_relaxed );
+        nanoseconds = _OUTPUT.clockNanoseconds.load( std::memory_order_relaxed );
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if( _OUTPUT.clockSequence.load( std::memory_order_relaxed ) == SEQUENCE ) {
+            break;
+        }
+    }
+
+    const auto  NOW = std::chrono::steady_clock::now();
+    const auto  ELAPSED_NANOSECONDS = toNanoseconds( NOW ) - nanoseconds;
+
+    if( ELAPSED_NANOSECONDS > 0 ) {
+        frames = std::min(
+            frames + static_cast< dp::ULong >( ELAPSED_NANOSECONDS ) * _OUTPUT.sampleRate / 1000000000
+            , limitFrames
+        );
+    }
+
+    _position.frame = frames;
+    _position.time = NOW;
+
+    return true;
+}
+
+dp::Bool getAudioOutputParameters(
+    const AudioOutput &         _OUTPUT
+    , AudioOutputParameters &   _parameters
+)
+{
+    const auto  CALLBACK_FRAMES = _OUTPUT.callbackFrames.load( std::memory_order_acquire );
+    if( CALLBACK_FRAMES <= 0 ) {
+        return false;
+    }
+
+    _parameters.periodFrames = CALLBACK_FRAMES;
+    _parameters.realtimeScheduling = _OUTPUT.realtimeScheduled;
+
+    switch( _OUTPUT.type ) {
+    case AudioOutputType::NULL_REALTIME:
+        _parameters.bufferingKnown = true;
+        _parameters.bufferCount = _OUTPUT.bufferCount;
+        _parameters.latencyFrames = _OUTPUT.periodFrames * _OUTPUT.bufferCount;
+        break;
+
+    default:
+        // 実スピーカーの内部バッファはdp::AudioPlayerから取得できない
+        _parameters.bufferingKnown = false;
+        _parameters.bufferCount = 0;
+        _parameters.latencyFrames = 0;
+        break;
+    }
+
+    return true;
+}
+
+dp::Bool getFirstPlayTime(
+    const AudioOutput &                         _OUTPUT
+    , std::chrono::steady_clock::time_point &   _time
+)
+{
+    const auto  NANOSECONDS = _OUTPUT.firstPlayNanoseconds.load();
+    if( NANOSECONDS == 0 ) {
+        return false;
+    }
+
+    _time = std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast< std::chrono::steady_clock::duration >( std::chrono::nanoseconds( NANOSECONDS ) )
+    );
+
+    return true;
+}
+
+AudioOutput * newAudioOutput(
+    const AudioOutputKey &      _KEY
+    , const AudioOutputInfo &   _INFO
+    , dp::AudioFormat           _audioFormat
+    , dp::UInt                  _sampleRate
+    , dp::UInt                  _channels
+)
+{
+    std::unique_ptr< AudioOutput >  outputUnique( new AudioOutput );
+    auto &                          output = *outputUnique;
+
+    output.info = _INFO;
+    output.startFrame = _INFO.startFrame;
+    output.type = _KEY.type;
+    output.audioFormat = _audioFormat;
+    output.sampleRate = _sampleRate;
+    output.channels = _channels;
+    output.frameSize = toFrameSize(
+        _audioFormat
+        , _channels
+    );
+
+    // 周期とバッファ数のうち指定のない方を、遅延の上限から決める
+    const auto  LATENCY_FRAMES = _sampleRate * _INFO.latencyMilliseconds / 1000;
+
+    output.periodFrames = _INFO.periodFrames;
+    output.bufferCount = _INFO.bufferCount;
+    if( output.periodFrames <= 0 ) {
+        if( LATENCY_FRAMES > 0 ) {
+            output.periodFrames = LATENCY_FRAMES / ( output.bufferCount > 0 ? output.bufferCount : BUFFER_COUNT );
+        } else if( isRealtimeAudioOutput( _KEY.type ) == false ) {
+            output.periodFrames = OFFLINE_PERIOD_FRAMES;
+        } else {
+            output.periodFrames = _sampleRate * PERIOD_MILLISECONDS / 1000;
+        }
+    }
+    if( output.bufferCount <= 0 ) {
+        if( LATENCY_FRAMES > 0 && output.periodFrames > 0 ) {
+            output.bufferCount = std::max(
+                static_cast< dp::UInt >( 1 )
+                , LATENCY_FRAMES / output.periodFrames
+            );
+        } else {
+            output.bufferCount = BUFFER_COUNT;
+        }
+    }
+
+    if( output.frameSize <= 0 || output.periodFrames <= 0 ) {
+        std::printf( "非対応のフォーマット\n" );
+
+        return nullptr;
+    }
+
+    if( _KEY.type == AudioOutputType::SPEAKER ) {
+        if( _INFO.latencyMilliseconds > 0 || _INFO.periodFrames > 0 || _INFO.bufferCount > 0 ) {
+            std::printf( "警告: 実スピーカーでは遅延・周期・バッファ数の指定は反映されない\n" );
+        }
+
+        if( startSpeaker(
+            output
+            , *( _KEY.speakerKeyUnique )
+        ) == false ) {
+            return nullptr;
+        }
+    } else {
+        if( startVirtualSpeaker(
+            output
+            , _KEY
+        ) == false ) {
+            return nullptr;
+        }
+    }
+
+    return outputUnique.release();
+}
@@ -0,0 +1,116 @@
+﻿#include "directory.h"
+
+#include "dp/common/primitives.h"
+
+#if defined( _MSC_VER )
+#   include <windows.h>
+#else
+#   include <dirent.h>
+#endif
+
+#include <cstring>
+
+namespace {
+    dp::Bool isDotEntry(
+        const char *    _NAME
+    )
+    {
+        return std::strcmp( _NAME, "." ) == 0 || std::strcmp( _NAME, ".." ) == 0;
+    }
+}
+
+dp::Bool readDirectory(
+    const dp::String &      _PATH
+    , DirectoryEntries &    _entries
+)
+{
+#if defined( _MSC_VER )
+    WIN32_FIND_DATAA    data;
+
+    const auto  FIND_HANDLE = FindFirstFileA(
+        joinPath(
+            _PATH
+            , "*"
+        ).c_str()
+        , &data
+    );
+    if( FIND_HANDLE == INVALID_HANDLE_VALUE ) {
+        return false;
+    }
+
+    do {
+        if( isDotEntry( data.cFileName ) ) {
+            continue;
+        }
+
+        DirectoryEntry  entry;
+        entry.name = data.cFileName;
+        entry.directory = ( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) != 0;
+
+        _entries.push_back( entry );
+    } while( FindNextFileA(
+        FIND_HANDLE
+        , &data
+    ) != 0 );
+
+    FindClose( FIND_HANDLE );
+#else
+    const auto  DIRECTORY = opendir( _PATH.c_str() );
+    if( DIRECTORY == nullptr ) {
+        return false;
+    }
+
+    while( 1 ) {
+        const auto  DATA = readdir( DIRECTORY );
+        if( DATA == nullptr ) {
+            break;
+        }
+
+        if( isDotEntry( DATA->d_name ) ) {
+            continue;
+        }
+
+        DirectoryEntry  entry;
+        entry.name = DATA->d_name;
+
+        // d_typeを返さないファイルシステムでは、開けるかどうかで判別する
+        if( DATA->d_type == DT_UNKNOWN ) {
+            const auto  CHILD = opendir(
+                joinPath(
+                    _PATH
+                    , entry.name
+                ).c_str()
+            );
+            entry.directory = CHILD != nullptr;
+            if( CHILD != nullptr ) {
+                closedir( CHILD );
+            }
+        } else {
+            entry.directory = DATA->d_type == DT_DIR;
+        }
+
+        _entries.push_back( entry );
+    }
+
+    closedir( DIRECTORY );
+#endif
+
+    return true;
+}
+
+dp::String joinPath(
+    const dp::String &      _PATH
+    , const dp::String &    _NAME
+)
+{
+    if( _PATH.empty() ) {
+        return _NAME;
+    }
+
+    const auto  LAST = _PATH[ _PATH.size() - 1 ];
+    if( LAST == '/' || LAST == '\\' ) {
+        return _PATH + _NAME;
+    }
+
+    return _PATH + "/" + _NAME;
+}
@@ -0,0 +1,10 @@
+﻿#include "elapsed.h"
+
+#include <chrono>
+
+double toSeconds(
+    std::chrono::steady_clock::duration _duration
+)
+{
+    return std::chrono::duration_cast< std::chrono::duration< double > >( _duration ).count();
+}
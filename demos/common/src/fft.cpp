@@ -0,0 +1,210 @@
+﻿#include "fft.h"
+#include "simd.h"
+
+#include "dp/common/primitives.h"
+
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+    const auto  PI = 3.14159265358979323846;
+
+    // 長さ4のDFTを、ビット反転済みの並びに対して行う
+    // 回転因子は1と-jのみのため乗算は不要
+    void runRadix4Stage(
+        std::size_t     _size
+        , dp::Float *   _real
+        , dp::Float *   _imaginary
+    )
+    {
+        for( std::size_t i = 0 ; i < _size ; i += 4 ) {
+            auto    real = _real + i;
+            auto    imaginary = _imaginary + i;
+
+            const auto  REAL0 = real[ 0 ] + real[ 1 ];
+            const auto  IMAGINARY0 = imaginary[ 0 ] + imaginary[ 1 ];
+            const auto  REAL1 = real[ 0 ] - real[ 1 ];
+            const auto  IMAGINARY1 = imaginary[ 0 ] - imaginary[ 1 ];
+            const auto  REAL2 = real[ 2 ] + real[ 3 ];
+            const auto  IMAGINARY2 = imaginary[ 2 ] + imaginary[ 3 ];
+            const auto  REAL3 = real[ 2 ] - real[ 3 ];
+            const auto  IMAGINARY3 = imaginary[ 2 ] - imaginary[ 3 ];
+
+            real[ 0 ] = REAL0 + REAL2;
+            imaginary[ 0 ] = IMAGINARY0 + IMAGINARY2;
+            real[ 2 ] = REAL0 - REAL2;
+            imaginary[ 2 ] = IMAGINARY0 - IMAGINARY2;
+
+            // -j * ( REAL3 + j * IMAGINARY3 ) = IMAGINARY3 - j * REAL3
+            real[ 1 ] = REAL1 + IMAGINARY3;
+            imaginary[ 1 ] = IMAGINARY1 - REAL3;
+            real[ 3 ] = REAL1 - IMAGINARY3;
+            imaginary[ 3 ] = IMAGINARY1 + REAL3;
+        }
+    }
+
+    void runRadix2Stage(
+        std::size_t         _size
+        , std::size_t       _half
+        , const dp::Float * _TWIDDLE_REAL
+        , const dp::Float * _TWIDDLE_IMAGINARY
+        , dp::Float *       _real
+        , dp::Float *       _imaginary
+    )
+    {
+        for( std::size_t block = 0 ; block < _size ; block += _half * 2 ) {
+            auto    realA = _real + block;
+            auto    imaginaryA = _imaginary + block;
+            auto    realB = realA + _half;
+            auto    imaginaryB = imaginaryA + _half;
+
+#if defined( USE_SSE2 )
+            // _halfは4の倍数のため端数は出ない
+            for( std::size_t i = 0 ; i < _half ; i += 4 ) {
+                const auto  W_REAL = _mm_loadu_ps( _TWIDDLE_REAL + i );
+                const auto  W_IMAGINARY = _mm_loadu_ps( _TWIDDLE_IMAGINARY + i );
+                const auto  A_REAL = _mm_loadu_ps( realA + i );
+                const auto  A_IMAGINARY = _mm_loadu_ps( imaginaryA + i );
+                const auto  B_REAL = _mm_loadu_ps( realB + i );
+                const auto  B_IMAGINARY = _mm_loadu_ps( imaginaryB + i );
+
+                const auto  T_REAL = _mm_sub_ps(
+                    _mm_mul_ps(
+                        B_REAL
+                        , W_REAL
+                    )
+                    , _mm_mul_ps(
+                        B_IMAGINARY
+                        , W_IMAGINARY
+                    )
+                );
+                const auto  T_IMAGINARY = _mm_add_ps(
+                    _mm_mul_ps(
+                        B_REAL
+                        , W_IMAGINARY
+                    )
+                    , _mm_mul_ps(
+                        B_IMAGINARY
+                        , W_REAL
+                    )
+                );
+
+                _mm_storeu_ps(
+                    realA + i
+                    , _mm_add_ps(
+                        A_REAL
+                        , T_REAL
+                    )
+                );
+                _mm_storeu_ps(
+                    imaginaryA + i
+                    , _mm_add_ps(
+                        A_IMAGINARY
+                        , T_IMAGINARY
+                    )
+                );
+                _mm_storeu_ps(
+                    realB + i
+                    , _mm_sub_ps(
+                        A_REAL
+                        , T_REAL
+                    )
+                );
+                _mm_storeu_ps(
+                    imaginaryB + i
+                    , _mm_sub_ps(
+                        A_IMAGINARY
+                        , T_IMAGINARY
+                    )
+                );
+            }
+#else
+            for( std::size_t i = 0 ; i < _half ; i++ ) {
+                const auto  T_REAL = realB[ i ] * _TWIDDLE_REAL[ i ] - imaginaryB[ i ] * _TWIDDLE_IMAGINARY[ i ];
+                const auto  T_IMAGINARY = realB[ i ] * _TWIDDLE_IMAGINARY[ i ] + imaginaryB[ i ] * _TWIDDLE_REAL[ i ];
+
+                realB[ i ] = realA[ i ] - T_REAL;
+                imaginaryB[ i ] = imaginaryA[ i ] - T_IMAGINARY;
+                realA[ i ] += T_REAL;
+                imaginaryA[ i ] += T_IMAGINARY;
+            }
+#endif
+        }
+    }
+}
+
+void initFft(
+    Fft &           _fft
+    , std::size_t   _size
+)
+{
+    _fft.size = _size;
+
+    std::size_t bits = 0;
+    while( ( static_cast< std::size_t >( 1 ) << bits ) < _size ) {
+        bits++;
+    }
+
+    _fft.bitReversed.resize( _size );
+    for( std::size_t i = 0 ; i < _size ; i++ ) {
+        std::size_t reversed = 0;
+        for( std::size_t j = 0 ; j < bits ; j++ ) {
+            reversed |= ( ( i >> j ) & 1 ) << ( bits - 1 - j );
+        }
+
+        _fft.bitReversed[ i ] = reversed;
+    }
+
+    _fft.twiddleReal.resize( _size - 4 );
+    _fft.twiddleImaginary.resize( _size - 4 );
+    for( std::size_t half = 4 ; half < _size ; half *= 2 ) {
+        for( std::size_t i = 0 ; i < half ; i++ ) {
+            const auto  ANGLE = -PI * i / half;
+
+            _fft.twiddleReal[ half - 4 + i ] = static_cast< dp::Float >( std::cos( ANGLE ) );
+            _fft.twiddleImaginary[ half - 4 + i ] = static_cast< dp::Float >( std::sin( ANGLE ) );
+        }
+    }
+}
+
+void runFft(
+    const Fft &     _FFT
+    , dp::Float *   _real
+    , dp::Float *   _imaginary
+)
+{
+    const auto  SIZE = _FFT.size;
+
+    for( std::size_t i = 0 ; i < SIZE ; i++ ) {
+        const auto  REVERSED = _FFT.bitReversed[ i ];
+        if( REVERSED > i ) {
+            std::swap(
+                _real[ i ]
+                , _real[ REVERSED ]
+            );
+            std::swap(
+                _imaginary[ i ]
+                , _imaginary[ REVERSED ]
+            );
+        }
+    }
+
+    runRadix4Stage(
+        SIZE
+        , _real
+        , _imaginary
+    );
+
+    for( std::size_t half = 4 ; half < SIZE ; half *= 2 ) {
+        runRadix2Stage(
+            SIZE
+            , half
+            , _FFT.twiddleReal.data() + half - 4
+            , _FFT.twiddleImaginary.data() + half - 4
+            , _real
+            , _imaginary
+        );
+    }
+}
@@ -0,0 +1,44 @@
+﻿#include "frameclock.h"
+
+#include "dp/common/primitives.h"
+
+#include <thread>
+#include <chrono>
+
+FrameClock::FrameClock(
+    dp::UInt    _framesPerSecond
+)
+    : interval(
+        std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+            std::chrono::duration< double >( 1.0 / _framesPerSecond )
+        )
+    )
+    , start( std::chrono::steady_clock::now() )
+    , frames( 0 )
+    , skippedFrames( 0 )
+{
+}
+
+double waitNextFrame(
+    FrameClock &    _clock
+)
+{
+    _clock.frames++;
+
+    auto    next = _clock.start + _clock.interval * static_cast< std::chrono::steady_clock::rep >( _clock.frames );
+
+    // 遅れを取り戻すために描画要求をまとめて送らないよう、過ぎた予定時刻は捨てる
+    const auto  NOW = std::chrono::steady_clock::now();
+    if( NOW > next ) {
+        const auto  BEHIND = static_cast< dp::ULong >( ( NOW - next ) / _clock.interval );
+
+        _clock.frames += BEHIND;
+        _clock.skippedFrames += BEHIND;
+
+        next += _clock.interval * static_cast< std::chrono::steady_clock::rep >( BEHIND );
+    } else {
+        std::this_thread::sleep_until( next );
+    }
+
+    return std::chrono::duration_cast< std::chrono::duration< double > >( next - _clock.start ).count();
+}
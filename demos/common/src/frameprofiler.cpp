@@ -0,0 +1,281 @@
+﻿#include "frameprofiler.h"
+#include "glext.h"
+
+#include "dp/common/primitives.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+
+namespace {
+    const auto  HISTOGRAM_WIDTH = 40;
+
+    void initFrameTimeHistory(
+        FrameTimeHistory &  _history
+    )
+    {
+        _history.nanoseconds.resize( FRAME_PROFILER_HISTORY );
+        _history.next = 0;
+        _history.count = 0;
+        std::fill(
+            std::begin( _history.buckets )
+            , std::end( _history.buckets )
+            , 0
+        );
+    }
+
+    std::size_t toBucket(
+        dp::Long    _nanoseconds
+    )
+    {
+        std::size_t bucket = 0;
+        for( auto microseconds = _nanoseconds / 1000 ; microseconds > 1 && bucket + 1 < FRAME_PROFILER_BUCKETS ; microseconds /= 2 ) {
+            bucket++;
+        }
+
+        return bucket;
+    }
+
+    // 一杯になった後は最も古い記録を分布から除いて上書きする
+    void addFrameTime(
+        FrameTimeHistory &  _history
+        , dp::Long          _nanoseconds
+    )
+    {
+        auto &  slot = _history.nanoseconds[ _history.next ];
+
+        if( _history.count >= FRAME_PROFILER_HISTORY ) {
+            _history.buckets[ toBucket( slot ) ]--;
+        } else {
+            _history.count++;
+        }
+
+        slot = _nanoseconds;
+        _history.buckets[ toBucket( _nanoseconds ) ]++;
+
+        _history.next = ( _history.next + 1 ) % FRAME_PROFILER_HISTORY;
+    }
+
+    void initQueries(
+        FrameProfiler & _profiler
+    )
+    {
+        _profiler.gpuTimerAvailable = loadGLQueryProcs( _profiler.procs );
+        if( _profiler.gpuTimerAvailable == false ) {
+            std::printf( "GL_TIME_ELAPSEDが利用できないため、GPU時間は計測しない\n" );
+
+            return;
+        }
+
+        _profiler.procs.genQueries(
+            FRAME_PROFILER_QUERIES
+            , _profiler.queries
+        );
+    }
+
+    // 結果が得られるまで待たない
+    void collectQuery(
+        FrameProfiler & _profiler
+        , std::size_t   _index
+    )
+    {
+        if( _profiler.queryPending[ _index ] == false ) {
+            return;
+        }
+
+        const auto &    PROCS = _profiler.procs;
+        const auto      QUERY = _profiler.queries[ _index ];
+
+        dp::GLint   available = 0;
+        PROCS.getQueryObjectiv(
+            QUERY
+            , GLEXT_QUERY_RESULT_AVAILABLE
+            , &available
+        );
+        if( available == 0 ) {
+            return;
+        }
+
+        GLExtUInt64 nanoseconds = 0;
+        PROCS.getQueryObjectui64v(
+            QUERY
+            , GLEXT_QUERY_RESULT
+            , &nanoseconds
+        );
+
+        addFrameTime(
+            _profiler.gpu
+            , static_cast< dp::Long >( nanoseconds )
+        );
+
+        _profiler.queryPending[ _index ] = false;
+    }
+
+    void printFrameTimes(
+        const char *                _NAME
+        , const FrameTimeHistory &  _HISTORY
+    )
+    {
+        FrameTimeSummary    summary;
+        if( summarizeFrameTimes(
+            _HISTORY
+            , summary
+        ) == false ) {
+            std::printf( "%s: 記録なし\n", _NAME );
+
+            return;
+        }
+
+        std::printf(
+            "%s: 直近%uフレーム 平均 %.1fus p50 %.1fus p99 %.1fus 最大 %.1fus\n"
+            , _NAME
+            , static_cast< dp::UInt >( summary.count )
+            , summary.mean / 1000.0
+            , summary.p50 / 1000.0
+            , summary.p99 / 1000.0
+            , summary.max / 1000.0
+        );
+
+        const auto  MAX_COUNT = *std::max_element(
+            std::begin( _HISTORY.buckets )
+            , std::end( _HISTORY.buckets )
+        );
+        for( std::size_t i = 0 ; i < FRAME_PROFILER_BUCKETS ; i++ ) {
+            const auto  COUNT = _HISTORY.buckets[ i ];
+            if( COUNT <= 0 ) {
+                continue;
+            }
+
+            const auto  LOWER = i > 0 ? 1ull << i : 0ull;
+            const auto  BAR = static_cast< dp::Int >( ( COUNT * HISTOGRAM_WIDTH + MAX_COUNT - 1 ) / MAX_COUNT );
+
+            std::printf( "  %8lluus～ |%-*.*s %llu\n", LOWER, HISTOGRAM_WIDTH, BAR, "########################################", COUNT );
+        }
+    }
+}
+
+FrameProfiler::FrameProfiler(
+)
+    : initialized( false )
+    , gpuTimerAvailable( false )
+    , currentQuery( 0 )
+    , droppedGpuFrames( 0 )
+{
+    std::fill(
+        std::begin( this->queryPending )
+        , std::end( this->queryPending )
+        , false
+    );
+
+    initFrameTimeHistory( this->cpu );
+    initFrameTimeHistory( this->gpu );
+}
+
+void beginProfiledFrame(
+    FrameProfiler & _profiler
+)
+{
+    // 最初のフレームは初期化を含み、実装によってはクエリの結果も不正となるため、GPU時間を計測しない
+    // (Mesaのllvmpipeでは、最初のクエリが経過時間ではなく時刻を返す)
+    if( _profiler.initialized == false ) {
+        _profiler.initialized = true;
+
+        initQueries( _profiler );
+    } else if( _profiler.gpuTimerAvailable ) {
+        const auto  INDEX = _profiler.currentQuery;
+
+        // 2フレーム前の結果がまだ得られない場合は、そのフレームの記録を諦めてクエリを再利用する
+        collectQuery(
+            _profiler
+            , INDEX
+        );
+        if( _profiler.queryPending[ INDEX ] ) {
+            _profiler.droppedGpuFrames++;
+        }
+
+        _profiler.procs.beginQuery(
+            GLEXT_TIME_ELAPSED
+            , _profiler.queries[ INDEX ]
+        );
+        _profiler.queryPending[ INDEX ] = true;
+    }
+
+    _profiler.frameBegin = std::chrono::steady_clock::now();
+}
+
+void endProfiledFrame(
+    FrameProfiler & _profiler
+)
+{
+    addFrameTime(
+        _profiler.cpu
+        , std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - _profiler.frameBegin ).count()
+    );
+
+    if( _profiler.gpuTimerAvailable && _profiler.queryPending[ _profiler.currentQuery ] ) {
+        _profiler.procs.endQuery( GLEXT_TIME_ELAPSED );
+
+        // 前のフレームのクエリを確認する
+        _profiler.currentQuery = ( _profiler.currentQuery + 1 ) % FRAME_PROFILER_QUERIES;
+        collectQuery(
+            _profiler
+            , _profiler.currentQuery
+        );
+    }
+}
+
+dp::Bool summarizeFrameTimes(
+    const FrameTimeHistory &    _HISTORY
+    , FrameTimeSummary &        _summary
+)
+{
+    const auto  COUNT = _HISTORY.count;
+    if( COUNT <= 0 ) {
+        return false;
+    }
+
+    std::vector< dp::Long > sorted(
+        _HISTORY.nanoseconds.begin()
+        , _HISTORY.nanoseconds.begin() + COUNT
+    );
+    std::sort(
+        sorted.begin()
+        , sorted.end()
+    );
+
+    dp::Long    total = 0;
+    for( const auto & NANOSECONDS : sorted ) {
+        total += NANOSECONDS;
+    }
+
+    // 記録のうち、その割合以下に収まる最小の値とする
+    _summary.count = COUNT;
+    _summary.mean = total / static_cast< dp::Long >( COUNT );
+    _summary.p50 = sorted[ ( COUNT * 50 + 99 ) / 100 - 1 ];
+    _summary.p99 = sorted[ ( COUNT * 99 + 99 ) / 100 - 1 ];
+    _summary.max = sorted.back();
+
+    return true;
+}
+
+void printFrameProfiler(
+    const FrameProfiler &   _PROFILER
+)
+{
+    printFrameTimes(
+        "CPU時間"
+        , _PROFILER.cpu
+    );
+
+    if( _PROFILER.gpuTimerAvailable ) {
+        printFrameTimes(
+            "GPU時間"
+            , _PROFILER.gpu
+        );
+
+        std::printf( "結果を待たずに破棄したGPU時間: %lluフレーム\n", _PROFILER.droppedGpuFrames );
+    }
+}
@@ -0,0 +1,867 @@
+﻿#include "gain.h"
+#include "simd.h"
+
+#include "dp/audio/audioformat.h"
+#include "dp/common/primitives.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace {
+    const auto  COMMANDS = 16;
+
+    // 一定のゲインはQ14の固定小数点で扱う
+    const auto  GAIN_SHIFT = 14;
+    const auto  GAIN_ONE = 1 << GAIN_SHIFT;
+    const auto  GAIN_FIXED_MAX = 0x7fff;
+
+    std::int16_t toFixedGain(
+        dp::Float   _gain
+    )
+    {
+        const auto  GAIN = static_cast< dp::Int >( _gain * GAIN_ONE + 0.5f );
+
+        return static_cast< std::int16_t >(
+            std::max(
+                0
+                , std::min(
+                    GAIN
+                    , GAIN_FIXED_MAX
+                )
+            )
+        );
+    }
+
+    std::int16_t clampS16(
+        dp::Int _sample
+    )
+    {
+        return static_cast< std::int16_t >(
+            std::max(
+                -0x8000
+                , std::min(
+                    _sample
+                    , 0x7fff
+                )
+            )
+        );
+    }
+
+    dp::Byte clampU8(
+        dp::Int _sample
+    )
+    {
+        return static_cast< dp::Byte >(
+            std::max(
+                0
+                , std::min(
+                    _sample
+                    , 0xff
+                )
+            )
+        );
+    }
+
+    dp::Int roundToInt(
+        dp::Float   _value
+    )
+    {
+        return static_cast< dp::Int >( _value < 0 ? _value - 0.5f : _value + 0.5f );
+    }
+
+#if defined( USE_SSE2 )
+    // 8サンプル分の16bit値にQ14のゲインをかけ、32bitのまま返す
+    void multiplyFixed(
+        __m128i         _samples
+        , __m128i       _gains
+        , __m128i &     _products0
+        , __m128i &     _products1
+    )
+    {
+        const auto  LOW = _mm_mullo_epi16(
+            _samples
+            , _gains
+        );
+        const auto  HIGH = _mm_mulhi_epi16(
+            _samples
+            , _gains
+        );
+
+        _products0 = _mm_srai_epi32(
+            _mm_unpacklo_epi16(
+                LOW
+                , HIGH
+            )
+            , GAIN_SHIFT
+        );
+        _products1 = _mm_srai_epi32(
+            _mm_unpackhi_epi16(
+                LOW
+                , HIGH
+            )
+            , GAIN_SHIFT
+        );
+    }
+
+    // 8サンプル分の16bit値に、前半4サンプルは_gains0、後半4サンプルは_gains1をかける
+    __m128i multiplyFloat(
+        __m128i     _samples
+        , __m128    _gains0
+        , __m128    _gains1
+    )
+    {
+        const auto  SAMPLES0 = _mm_cvtepi32_ps(
+            _mm_srai_epi32(
+                _mm_unpacklo_epi16(
+                    _samples
+                    , _samples
+                )
+                , 16
+            )
+        );
+        const auto  SAMPLES1 = _mm_cvtepi32_ps(
+            _mm_srai_epi32(
+                _mm_unpackhi_epi16(
+                    _samples
+                    , _samples
+                )
+                , 16
+            )
+        );
+
+        return _mm_packs_epi32(
+            _mm_cvtps_epi32(
+                _mm_mul_ps(
+                    SAMPLES0
+                    , _gains0
+                )
+            )
+            , _mm_cvtps_epi32(
+                _mm_mul_ps(
+                    SAMPLES1
+                    , _gains1
+                )
+            )
+        );
+    }
+#endif
+
+    // 以降のカーネルは_SOURCEにゲインをかけて_destinationへ書き出す
+    // 読み込みと書き出しを同じ走査で行うため、_destinationと_SOURCEは同じでもよい
+    void scaleS16(
+        std::int16_t *          _destination
+        , const std::int16_t *  _SOURCE
+        , std::size_t           _count
+        , std::int16_t          _gain
+    )
+    {
+        std::size_t i = 0;
+
+#if defined( USE_SSE2 )
+        const auto  GAINS = _mm_set1_epi16( _gain );
+
+        for( ; i + 8 <= _count ; i += 8 ) {
+            __m128i products0;
+            __m128i products1;
+            multiplyFixed(
+                _mm_loadu_si128( reinterpret_cast< const __m128i * >( _SOURCE + i ) )
+                , GAINS
+                , products0
+                , products1
+            );
+
+            _mm_storeu_si128(
+                reinterpret_cast< __m128i * >( _destination + i )
+                , _mm_packs_epi32(
+                    products0
+                    , products1
+                )
+            );
+        }
+#endif
+
+        for( ; i < _count ; i++ ) {
+            _destination[ i ] = clampS16( ( _SOURCE[ i ] * _gain ) >> GAIN_SHIFT );
+        }
+    }
+
+    // U8は0x80を中心とした符号付きの値として16bitへ広げて処理する
+    void scaleU8(
+        dp::Byte *          _destination
+        , const dp::Byte *  _SOURCE
+        , std::size_t       _count
+        , std::int16_t      _gain
+    )
+    {
+        std::size_t i = 0;
+
+#if defined( USE_SSE2 )
+        const auto  GAINS = _mm_set1_epi16( _gain );
+        const auto  ZERO = _mm_setzero_si128();
+        const auto  CENTER = _mm_set1_epi16( 0x80 );
+
+        for( ; i + 16 <= _count ; i += 16 ) {
+            const auto  SAMPLES = _mm_loadu_si128( reinterpret_cast< const __m128i * >( _SOURCE + i ) );
+
+            __m128i products0;
+            __m128i products1;
+
+            multiplyFixed(
+                _mm_sub_epi16(
+                    _mm_unpacklo_epi8(
+                        SAMPLES
+                        , ZERO
+                    )
+                    , CENTER
+                )
+                , GAINS
+                , products0
+                , products1
+            );
+            const auto  LOW = _mm_add_epi16(
+                _mm_packs_epi32(
+                    products0
+                    , products1
+                )
+                , CENTER
+            );
+
+            multiplyFixed(
+                _mm_sub_epi16(
+                    _mm_unpackhi_epi8(
+                        SAMPLES
+                        , ZERO
+                    )
+                    , CENTER
+                )
+                , GAINS
+                , products0
+                , products1
+            );
+            const auto  HIGH = _mm_add_epi16(
+                _mm_packs_epi32(
+                    products0
+                    , products1
+                )
+                , CENTER
+            );
+
+            _mm_storeu_si128(
+                reinterpret_cast< __m128i * >( _destination + i )
+                , _mm_packus_epi16(
+                    LOW
+                    , HIGH
+                )
+            );
+        }
+#endif
+
+        for( ; i < _count ; i++ ) {
+            _destination[ i ] = clampU8( ( ( ( _SOURCE[ i ] - 0x80 ) * _gain ) >> GAIN_SHIFT ) + 0x80 );
+        }
+    }
+
+    void rampS16(
+        std::int16_t *          _destination
+        , const std::int16_t *  _SOURCE
+        , dp::UInt              _channels
+        , std::size_t           _frames
+        , dp::Float             _gain
+        , dp::Float             _step
+    )
+    {
+        std::size_t frame = 0;
+
+#if defined( USE_SSE2 )
+        // 4サンプルが整数フレームとなるチャンネル数のみベクトル化する
+        if( 4 % _channels == 0 ) {
+            const auto  FRAMES_PER_VECTOR = 4 / _channels;
+
+            auto        gains = _mm_setr_ps(
+                _gain
+                , _gain + _step * ( 1 / _channels )
+                , _gain + _step * ( 2 / _channels )
+                , _gain + _step * ( 3 / _channels )
+            );
+            const auto  INCREMENT = _mm_set1_ps( _step * FRAMES_PER_VECTOR );
+
+            for( ; frame + FRAMES_PER_VECTOR * 2 <= _frames ; frame += FRAMES_PER_VECTOR * 2 ) {
+                const auto  GAINS1 = _mm_add_ps(
+                    gains
+                    , INCREMENT
+                );
+
+                _mm_storeu_si128(
+                    reinterpret_cast< __m128i * >( _destination + frame * _channels )
+                    , multiplyFloat(
+                        _mm_loadu_si128( reinterpret_cast< const __m128i * >( _SOURCE + frame * _channels ) )
+                        , gains
+                        , GAINS1
+                    )
+                );
+
+                gains = _mm_add_ps(
+                    GAINS1
+                    , INCREMENT
+                );
+            }
+        }
+#endif
+
+        for( ; frame < _frames ; frame++ ) {
+            const auto  GAIN = _gain + _step * frame;
+
+            for( dp::UInt i = 0 ; i < _channels ; i++ ) {
+                const auto  INDEX = frame * _channels + i;
+
+                _destination[ INDEX ] = clampS16( roundToInt( _SOURCE[ INDEX ] * GAIN ) );
+            }
+        }
+    }
+
+    void rampU8(
+        dp::Byte *          _destination
+        , const dp::Byte *  _SOURCE
+        , dp::UInt          _channels
+        , std::size_t       _frames
+        , dp::Float         _gain
+        , dp::Float         _step
+    )
+    {
+        std::size_t frame = 0;
+
+#if defined( USE_SSE2 )
+        if( 4 % _channels == 0 ) {
+            const auto  FRAMES_PER_VECTOR = 4 / _channels;
+
+            auto        gains = _mm_setr_ps(
+                _gain
+                , _gain + _step * ( 1 / _channels )
+                , _gain + _step * ( 2 / _channels )
+                , _gain + _step * ( 3 / _channels )
+            );
+            const auto  INCREMENT = _mm_set1_ps( _step * FRAMES_PER_VECTOR );
+            const auto  ZERO = _mm_setzero_si128();
+            const auto  CENTER = _mm_set1_epi16( 0x80 );
+
+            for( ; frame + FRAMES_PER_VECTOR * 2 <= _frames ; frame += FRAMES_PER_VECTOR * 2 ) {
+                const auto  GAINS1 = _mm_add_ps(
+                    gains
+                    , INCREMENT
+                );
+
+                const auto  RESULT = _mm_add_epi16(
+                    multiplyFloat(
+                        _mm_sub_epi16(
+                            _mm_unpacklo_epi8(
+                                _mm_loadl_epi64( reinterpret_cast< const __m128i * >( _SOURCE + frame * _channels ) )
+                                , ZERO
+                            )
+                            , CENTER
+                        )
+                        , gains
+                        , GAINS1
+                    )
+                    , CENTER
+                );
+
+                _mm_storel_epi64(
+                    reinterpret_cast< __m128i * >( _destination + frame * _channels )
+                    , _mm_packus_epi16(
+                        RESULT
+                        , RESULT
+                    )
+                );
+
+                gains = _mm_add_ps(
+                    GAINS1
+                    , INCREMENT
+                );
+            }
+        }
+#endif
+
+        for( ; frame < _frames ; frame++ ) {
+            const auto  GAIN = _gain + _step * frame;
+
+            for( dp::UInt i = 0 ; i < _channels ; i++ ) {
+                const auto  INDEX = frame * _channels + i;
+
+                _destination[ INDEX ] = clampU8( roundToInt( ( _SOURCE[ INDEX ] - 0x80 ) * GAIN ) + 0x80 );
+            }
+        }
+    }
+
+    void addS16(
+        std::int16_t *          _destination
+        , const std::int16_t *  _SOURCE
+        , std::size_t           _count
+    )
+    {
+        std::size_t i = 0;
+
+#if defined( USE_SSE2 )
+        for( ; i + 8 <= _count ; i += 8 ) {
+            auto    destination = reinterpret_cast< __m128i * >( _destination + i );
+
+            _mm_storeu_si128(
+                destination
+                , _mm_adds_epi16(
+                    _mm_loadu_si128( destination )
+                    , _mm_loadu_si128( reinterpret_cast< const __m128i * >( _SOURCE + i ) )
+                )
+            );
+        }
+#endif
+
+        for( ; i < _count ; i++ ) {
+            _destination[ i ] = clampS16( _destination[ i ] + _SOURCE[ i ] );
+        }
+    }
+
+    void addU8(
+        dp::Byte *          _destination
+        , const dp::Byte *  _SOURCE
+        , std::size_t       _count
+    )
+    {
+        std::size_t i = 0;
+
+#if defined( USE_SSE2 )
+        const auto  ZERO = _mm_setzero_si128();
+        const auto  CENTER = _mm_set1_epi16( 0x80 );
+
+        for( ; i + 16 <= _count ; i += 16 ) {
+            auto        destination = reinterpret_cast< __m128i * >( _destination + i );
+            const auto  DESTINATION = _mm_loadu_si128( destination );
+            const auto  SOURCE = _mm_loadu_si128( reinterpret_cast< const __m128i * >( _SOURCE + i ) );
+
+            const auto  LOW = _mm_sub_epi16(
+                _mm_add_epi16(
+                    _mm_unpacklo_epi8(
+                        DESTINATION
+                        , ZERO
+                    )
+                    , _mm_unpacklo_epi8(
+                        SOURCE
+                        , ZERO
+                    )
+                )
+                , CENTER
+            );
+            const auto  HIGH = _mm_sub_epi16(
+                _mm_add_epi16(
+                    _mm_unpackhi_epi8(
+                        DESTINATION
+                        , ZERO
+                    )
+                    , _mm_unpackhi_epi8(
+                        SOURCE
+                        , ZERO
+                    )
+                )
+                , CENTER
+            );
+
+            _mm_storeu_si128(
+                destination
+                , _mm_packus_epi16(
+                    LOW
+                    , HIGH
+                )
+            );
+        }
+#endif
+
+        for( ; i < _count ; i++ ) {
+            _destination[ i ] = clampU8( _destination[ i ] + _SOURCE[ i ] - 0x80 );
+        }
+    }
+
+    void scale(
+        dp::AudioFormat _audioFormat
+        , void *        _destination
+        , const void *  _SOURCE
+        , std::size_t   _count
+        , dp::Float     _gain
+    )
+    {
+        switch( _audioFormat ) {
+        case dp::AudioFormat::U8:
+            scaleU8(
+                static_cast< dp::Byte * >( _destination )
+                , static_cast< const dp::Byte * >( _SOURCE )
+                , _count
+                , toFixedGain( _gain )
+            );
+            break;
+
+        case dp::AudioFormat::S16LE:
+            scaleS16(
+                static_cast< std::int16_t * >( _destination )
+                , static_cast< const std::int16_t * >( _SOURCE )
+                , _count
+                , toFixedGain( _gain )
+            );
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    dp::UInt toSampleSize(
+        dp::AudioFormat _audioFormat
+    )
+    {
+        return _audioFormat == dp::AudioFormat::U8 ? 1 : 2;
+    }
+
+    dp::Float clampGain(
+        dp::Float   _gain
+    )
+    {
+        return std::max(
+            0.0f
+            , std::min(
+                _gain
+                , GAIN_MAX
+            )
+        );
+    }
+
+    dp::Bool writeCommand(
+        GainStage &             _stage
+        , const GainCommand &   _COMMAND
+    )
+    {
+        auto &  commands = _COMMAND.immediate ? _stage.immediateCommands : _stage.commands;
+
+        return commands.write(
+            &_COMMAND
+            , 1
+        ) > 0;
+    }
+
+    void ramp(
+        dp::AudioFormat _audioFormat
+        , dp::UInt      _channels
+        , void *        _destination
+        , const void *  _SOURCE
+        , std::size_t   _frames
+        , dp::Float     _gain
+        , dp::Float     _step
+    )
+    {
+        switch( _audioFormat ) {
+        case dp::AudioFormat::U8:
+            rampU8(
+                static_cast< dp::Byte * >( _destination )
+                , static_cast< const dp::Byte * >( _SOURCE )
+                , _channels
+                , _frames
+                , _gain
+                , _step
+            );
+            break;
+
+        case dp::AudioFormat::S16LE:
+            rampS16(
+                static_cast< std::int16_t * >( _destination )
+                , static_cast< const std::int16_t * >( _SOURCE )
+                , _channels
+                , _frames
+                , _gain
+                , _step
+            );
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // 開始フレームに達したコマンドを反映する
+    void startCommand(
+        GainStage &             _stage
+        , const GainCommand &   _COMMAND
+    )
+    {
+        // 開始フレームを過ぎてから反映された場合も、予定どおりのフレームで変化し終わるようにする
+        // 開始値の指定があれば遅れた分だけ進めた値から、なければ現在のゲインから残りのフレームで変化させる
+        dp::ULong   lateFrames = 0;
+        if( _COMMAND.immediate == false && _stage.frames > _COMMAND.startFrame ) {
+            lateFrames = _stage.frames - _COMMAND.startFrame;
+        }
+
+        _stage.targetGain = _COMMAND.gain;
+
+        if( lateFrames >= _COMMAND.rampFrames ) {
+            _stage.gain = _COMMAND.gain;
+            _stage.step = 0;
+            _stage.rampRestFrames = 0;
+
+            return;
+        }
+
+        const auto  RAMP_FRAMES = static_cast< dp::UInt >( _COMMAND.rampFrames - lateFrames );
+        if( _COMMAND.hasStartGain ) {
+            _stage.gain = _COMMAND.startGain + ( _COMMAND.gain - _COMMAND.startGain ) * lateFrames / _COMMAND.rampFrames;
+        }
+        _stage.step = ( _COMMAND.gain - _stage.gain ) / RAMP_FRAMES;
+        _stage.rampRestFrames = RAMP_FRAMES;
+    }
+}
+
+GainStage::GainStage(
+)
+    : commands( COMMANDS )
+    , immediateCommands( COMMANDS )
+    , frames( 0 )
+    , gain( 1 )
+    , targetGain( 1 )
+    , step( 0 )
+    , rampRestFrames( 0 )
+    , pending( false )
+{
+}
+
+dp::Bool setGain(
+    GainStage &     _stage
+    , dp::Float     _gain
+    , dp::UInt      _rampFrames
+    , dp::ULong     _startFrame
+)
+{
+    GainCommand command;
+    command.startGain = 0;
+    command.gain = clampGain( _gain );
+    command.startFrame = _startFrame;
+    command.rampFrames = _rampFrames;
+    command.hasStartGain = false;
+    command.immediate = false;
+
+    return writeCommand(
+        _stage
+        , command
+    );
+}
+
+dp::Bool setGain(
+    GainStage &     _stage
+    , dp::Float     _gain
+    , dp::UInt      _rampFrames
+)
+{
+    GainCommand command;
+    command.startGain = 0;
+    command.gain = clampGain( _gain );
+    command.startFrame = 0;
+    command.rampFrames = _rampFrames;
+    command.hasStartGain = false;
+    command.immediate = true;
+
+    return writeCommand(
+        _stage
+        , command
+    );
+}
+
+dp::Bool setGain(
+    GainStage &     _stage
+    , dp::Float     _startGain
+    , dp::Float     _gain
+    , dp::UInt      _rampFrames
+    , dp::ULong     _startFrame
+)
+{
+    GainCommand command;
+    command.startGain = clampGain( _startGain );
+    command.gain = clampGain( _gain );
+    command.startFrame = _startFrame;
+    command.rampFrames = _rampFrames;
+    command.hasStartGain = true;
+    command.immediate = false;
+
+    return writeCommand(
+        _stage
+        , command
+    );
+}
+
+dp::Bool fadeOut(
+    GainStage &     _stage
+    , dp::UInt      _frames
+    , dp::ULong     _startFrame
+)
+{
+    return setGain(
+        _stage
+        , 0
+        , _frames
+        , _startFrame
+    );
+}
+
+void applyGain(
+    GainStage &         _stage
+    , dp::AudioFormat   _audioFormat
+    , dp::UInt          _channels
+    , void *            _buffer
+    , std::size_t       _frames
+)
+{
+    applyGain(
+        _stage
+        , _audioFormat
+        , _channels
+        , _buffer
+        , _buffer
+        , _frames
+    );
+}
+
+void applyGain(
+    GainStage &         _stage
+    , dp::AudioFormat   _audioFormat
+    , dp::UInt          _channels
+    , void *            _destination
+    , const void *      _SOURCE
+    , std::size_t       _frames
+)
+{
+    const auto  FRAME_SIZE = toSampleSize( _audioFormat ) * _channels;
+
+    auto    destination = static_cast< dp::Byte * >( _destination );
+    auto    source = static_cast< const dp::Byte * >( _SOURCE );
+
+    GainCommand command;
+    while( _stage.immediateCommands.read(
+        &command
+        , 1
+    ) > 0 ) {
+        startCommand(
+            _stage
+            , command
+        );
+    }
+
+    while( _frames > 0 ) {
+        if( _stage.pending == false ) {
+            _stage.pending = _stage.commands.read(
+                &( _stage.pendingCommand )
+                , 1
+            ) > 0;
+        }
+
+        if( _stage.pending && _stage.pendingCommand.startFrame <= _stage.frames ) {
+            startCommand(
+                _stage
+                , _stage.pendingCommand
+            );
+            _stage.pending = false;
+
+            continue;
+        }
+
+        // 次のコマンドの開始フレーム、またはゲインの変化が終わるフレームで区切る
+        auto    frames = _frames;
+        if( _stage.pending ) {
+            frames = std::min(
+                frames
+                , static_cast< std::size_t >( _stage.pendingCommand.startFrame - _stage.frames )
+            );
+        }
+        if( _stage.rampRestFrames > 0 ) {
+            frames = std::min(
+                frames
+                , static_cast< std::size_t >( _stage.rampRestFrames )
+            );
+        }
+
+        if( _stage.rampRestFrames > 0 ) {
+            ramp(
+                _audioFormat
+                , _channels
+                , destination
+                , source
+                , frames
+                , _stage.gain
+                , _stage.step
+            );
+
+            _stage.rampRestFrames -= static_cast< dp::UInt >( frames );
+            _stage.gain = _stage.rampRestFrames > 0 ? _stage.gain + _stage.step * frames : _stage.targetGain;
+        } else if( _stage.gain != 1 ) {
+            scale(
+                _audioFormat
+                , destination
+                , source
+                , frames * _channels
+                , _stage.gain
+            );
+        } else if( destination != source ) {
+            std::memcpy(
+                destination
+                , source
+                , frames * FRAME_SIZE
+            );
+        }
+
+        destination += frames * FRAME_SIZE;
+        source += frames * FRAME_SIZE;
+        _frames -= frames;
+        _stage.frames += frames;
+    }
+}
+
+void applyGainRamp(
+    dp::AudioFormat _audioFormat
+    , dp::UInt      _channels
+    , void *        _buffer
+    , std::size_t   _frames
+    , dp::Float     _gain
+    , dp::Float     _step
+)
+{
+    ramp(
+        _audioFormat
+        , _channels
+        , _buffer
+        , _buffer
+        , _frames
+        , _gain
+        , _step
+    );
+}
+
+void addAudio(
+    dp::AudioFormat _audioFormat
+    , void *        _destination
+    , const void *  _SOURCE
+    , std::size_t   _samples
+)
+{
+    switch( _audioFormat ) {
+    case dp::AudioFormat::U8:
+        addU8(
+            static_cast< dp::Byte * >( _destination )
+            , static_cast< const dp::Byte * >( _SOURCE )
+            , _samples
+        );
+        break;
+
+    case dp::AudioFormat::S16LE:
+        addS16(
+            static_cast< std::int16_t * >( _destination )
+            , static_cast< const std::int16_t * >( _SOURCE )
+            , _samples
+        );
+        break;
+
+    default:
+        break;
+    }
+}
@@ -0,0 +1,336 @@
+﻿#include "glext.h"
+
+#include "dp/opengl/gl.h"
+#include "dp/common/primitives.h"
+
+#if defined( _MSC_VER )
+#   include <windows.h>
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined( _MSC_VER )
+// GLのヘッダはdp::gl*の定数と衝突するため、必要な宣言のみ行う
+extern "C" void ( * glXGetProcAddressARB( const unsigned char * ) )();
+#endif
+
+namespace {
+    // 頂点配列オブジェクトとフレームバッファオブジェクトはGL3.0以降
+    const auto  OBJECTS_MAJOR_VERSION = 3;
+    const auto  OBJECTS_MINOR_VERSION = 0;
+
+    // 頂点属性のインスタンスごとの更新とGL_TIME_ELAPSEDはGL3.3以降
+    const auto  INSTANCING_MAJOR_VERSION = 3;
+    const auto  INSTANCING_MINOR_VERSION = 3;
+    const auto  TIMER_QUERY_MAJOR_VERSION = 3;
+    const auto  TIMER_QUERY_MINOR_VERSION = 3;
+
+    // プログラムのバイナリはGL4.1以降
+    const auto  PROGRAM_BINARY_MAJOR_VERSION = 4;
+    const auto  PROGRAM_BINARY_MINOR_VERSION = 1;
+
+    typedef void ( GLEXT_APIENTRY * ProcAddress )();
+
+    ProcAddress getProcAddress(
+        const char *    _NAME
+    )
+    {
+#if defined( _MSC_VER )
+        // GL1.1の関数はwglGetProcAddress()で取得できず、opengl32.dllから直接取得する
+        const auto  PROC = wglGetProcAddress( _NAME );
+        switch( reinterpret_cast< std::intptr_t >( PROC ) ) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+        case -1:
+            return reinterpret_cast< ProcAddress >(
+                GetProcAddress(
+                    GetModuleHandleA( "opengl32.dll" )
+                    , _NAME
+                )
+            );
+
+        default:
+            return reinterpret_cast< ProcAddress >( PROC );
+        }
+#else
+        return glXGetProcAddressARB( reinterpret_cast< const unsigned char * >( _NAME ) );
+#endif
+    }
+
+    template< typename PROC >
+    dp::Bool loadProc(
+        PROC &          _proc
+        , const char *  _NAME
+    )
+    {
+        _proc = reinterpret_cast< PROC >( getProcAddress( _NAME ) );
+
+        return _proc != nullptr;
+    }
+
+    // glXGetProcAddressARB()は未対応の関数でもnullptrを返さないため、先にバージョンを確認する
+    dp::Bool isRequiredVersion(
+        dp::Int     _major
+        , dp::Int   _minor
+    )
+    {
+        const dp::Byte * ( GLEXT_APIENTRY * getString )( dp::GLenum );
+        if( loadProc(
+            getString
+            , "glGetString"
+        ) == false ) {
+            return false;
+        }
+
+        const auto  VERSION = reinterpret_cast< const char * >( getString( GLEXT_VERSION ) );
+        if( VERSION == nullptr ) {
+            return false;
+        }
+
+        const auto  MAJOR = std::atoi( VERSION );
+        const auto  DOT = std::strchr(
+            VERSION
+            , '.'
+        );
+        const auto  MINOR = DOT != nullptr ? std::atoi( DOT + 1 ) : 0;
+
+        return MAJOR > _major || ( MAJOR == _major && MINOR >= _minor );
+    }
+}
+
+dp::Bool loadGLExtProcs(
+    GLExtProcs &    _procs
+)
+{
+    if( isRequiredVersion(
+        OBJECTS_MAJOR_VERSION
+        , OBJECTS_MINOR_VERSION
+    ) == false ) {
+        return false;
+    }
+
+    return loadProc(
+        _procs.getString
+        , "glGetString"
+    ) && loadProc(
+        _procs.genBuffers
+        , "glGenBuffers"
+    ) && loadProc(
+        _procs.bindBuffer
+        , "glBindBuffer"
+    ) && loadProc(
+        _procs.bufferData
+        , "glBufferData"
+    ) && loadProc(
+        _procs.genVertexArrays
+        , "glGenVertexArrays"
+    ) && loadProc(
+        _procs.bindVertexArray
+        , "glBindVertexArray"
+    ) && loadProc(
+        _procs.enableClientState
+        , "glEnableClientState"
+    ) && loadProc(
+        _procs.vertexPointer
+        , "glVertexPointer"
+    ) && loadProc(
+        _procs.colorPointer
+        , "glColorPointer"
+    ) && loadProc(
+        _procs.drawArrays
+        , "glDrawArrays"
+    ) && loadProc(
+        _procs.pushMatrix
+        , "glPushMatrix"
+    ) && loadProc(
+        _procs.popMatrix
+        , "glPopMatrix"
+    ) && loadProc(
+        _procs.multMatrixf
+        , "glMultMatrixf"
+    );
+}
+
+dp::Bool loadGLMatrixProcs(
+    GLMatrixProcs & _procs
+)
+{
+    return loadProc(
+        _procs.loadMatrixf
+        , "glLoadMatrixf"
+    ) && loadProc(
+        _procs.multMatrixf
+        , "glMultMatrixf"
+    );
+}
+
+dp::Bool loadGLFramebufferProcs(
+    GLFramebufferProcs &    _procs
+)
+{
+    if( isRequiredVersion(
+        OBJECTS_MAJOR_VERSION
+        , OBJECTS_MINOR_VERSION
+    ) == false ) {
+        return false;
+    }
+
+    return loadProc(
+        _procs.genFramebuffers
+        , "glGenFramebuffers"
+    ) && loadProc(
+        _procs.bindFramebuffer
+        , "glBindFramebuffer"
+    ) && loadProc(
+        _procs.checkFramebufferStatus
+        , "glCheckFramebufferStatus"
+    ) && loadProc(
+        _procs.framebufferRenderbuffer
+        , "glFramebufferRenderbuffer"
+    ) && loadProc(
+        _procs.genRenderbuffers
+        , "glGenRenderbuffers"
+    ) && loadProc(
+        _procs.bindRenderbuffer
+        , "glBindRenderbuffer"
+    ) && loadProc(
+        _procs.renderbufferStorage
+        , "glRenderbufferStorage"
+    ) && loadProc(
+        _procs.readPixels
+        , "glReadPixels"
+    ) && loadProc(
+        _procs.finish
+        , "glFinish"
+    );
+}
+
+dp::Bool loadGLShaderProcs(
+    GLShaderProcs & _procs
+)
+{
+    if( isRequiredVersion(
+        INSTANCING_MAJOR_VERSION
+        , INSTANCING_MINOR_VERSION
+    ) == false ) {
+        return false;
+    }
+
+    return loadProc(
+        _procs.createShader
+        , "glCreateShader"
+    ) && loadProc(
+        _procs.shaderSource
+        , "glShaderSource"
+    ) && loadProc(
+        _procs.compileShader
+        , "glCompileShader"
+    ) && loadProc(
+        _procs.getShaderiv
+        , "glGetShaderiv"
+    ) && loadProc(
+        _procs.getShaderInfoLog
+        , "glGetShaderInfoLog"
+    ) && loadProc(
+        _procs.deleteShader
+        , "glDeleteShader"
+    ) && loadProc(
+        _procs.createProgram
+        , "glCreateProgram"
+    ) && loadProc(
+        _procs.attachShader
+        , "glAttachShader"
+    ) && loadProc(
+        _procs.bindAttribLocation
+        , "glBindAttribLocation"
+    ) && loadProc(
+        _procs.linkProgram
+        , "glLinkProgram"
+    ) && loadProc(
+        _procs.getProgramiv
+        , "glGetProgramiv"
+    ) && loadProc(
+        _procs.getProgramInfoLog
+        , "glGetProgramInfoLog"
+    ) && loadProc(
+        _procs.deleteProgram
+        , "glDeleteProgram"
+    ) && loadProc(
+        _procs.useProgram
+        , "glUseProgram"
+    ) && loadProc(
+        _procs.vertexAttribPointer
+        , "glVertexAttribPointer"
+    ) && loadProc(
+        _procs.enableVertexAttribArray
+        , "glEnableVertexAttribArray"
+    ) && loadProc(
+        _procs.vertexAttribDivisor
+        , "glVertexAttribDivisor"
+    ) && loadProc(
+        _procs.drawArraysInstanced
+        , "glDrawArraysInstanced"
+    );
+}
+
+dp::Bool loadGLQueryProcs(
+    GLQueryProcs &  _procs
+)
+{
+    if( isRequiredVersion(
+        TIMER_QUERY_MAJOR_VERSION
+        , TIMER_QUERY_MINOR_VERSION
+    ) == false ) {
+        return false;
+    }
+
+    return loadProc(
+        _procs.genQueries
+        , "glGenQueries"
+    ) && loadProc(
+        _procs.beginQuery
+        , "glBeginQuery"
+    ) && loadProc(
+        _procs.endQuery
+        , "glEndQuery"
+    ) && loadProc(
+        _procs.getQueryObjectiv
+        , "glGetQueryObjectiv"
+    ) && loadProc(
+        _procs.getQueryObjectui64v
+        , "glGetQueryObjectui64v"
+    );
+}
+
+dp::Bool loadGLProgramBinaryProcs(
+    GLProgramBinaryProcs &  _procs
+)
+{
+    if( isRequiredVersion(
+        PROGRAM_BINARY_MAJOR_VERSION
+        , PROGRAM_BINARY_MINOR_VERSION
+    ) == false ) {
+        return false;
+    }
+
+    return loadProc(
+        _procs.getString
+        , "glGetString"
+    ) && loadProc(
+        _procs.getIntegerv
+        , "glGetIntegerv"
+    ) && loadProc(
+        _procs.programParameteri
+        , "glProgramParameteri"
+    ) && loadProc(
+        _procs.getProgramBinary
+        , "glGetProgramBinary"
+    ) && loadProc(
+        _procs.programBinary
+        , "glProgramBinary"
+    );
+}
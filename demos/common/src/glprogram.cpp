@@ -0,0 +1,669 @@
+﻿#include "glprogram.h"
+#include "glext.h"
+
+#include "dp/file/filer.h"
+#include "dp/file/filew.h"
+#include "dp/common/stringconverter.h"
+#include "dp/common/primitives.h"
+
+#if defined( _MSC_VER )
+#   include <windows.h>
+#endif
+
+#include <vector>
+#include <cstring>
+#include <cstdio>
+
+namespace {
+    const char  CACHE_MAGIC[] = { 'G', 'L', 'P', 'B' };
+    const auto  CACHE_VERSION = 1u;
+
+    const auto  CACHE_FILE_EXTENSION = ".glprogram";
+
+    // 書き込み中のファイルを読み込まないよう、この拡張子を付けた名前で書き込んでから置き換える
+    const auto  TEMPORARY_FILE_EXTENSION = ".tmp";
+
+    // キャッシュファイルの先頭
+    // 続けてドライバを識別する文字列、プログラムのバイナリを置く
+    struct CacheHeader
+    {
+        char        magic[ sizeof( CACHE_MAGIC ) ];
+        dp::UInt    version;
+        dp::UInt    driverLength;
+        dp::UInt    binaryFormat;
+        dp::UInt    binaryLength;
+    };
+
+    // FNV-1a
+    const auto  HASH_OFFSET_BASIS = 0xcbf29ce484222325ull;
+    const auto  HASH_PRIME = 0x100000001b3ull;
+
+    void hash(
+        dp::ULong &     _hash
+        , const void *  _DATA
+        , std::size_t   _size
+    )
+    {
+        const auto  DATA = static_cast< const dp::Byte * >( _DATA );
+
+        for( std::size_t i = 0 ; i < _size ; i++ ) {
+            _hash ^= DATA[ i ];
+            _hash *= HASH_PRIME;
+        }
+    }
+
+    // 文字列の区切りが変わっても同じ値にならないよう、終端の0も含める
+    void hashString(
+        dp::ULong &     _hash
+        , const char *  _STRING
+    )
+    {
+        hash(
+            _hash
+            , _STRING
+            , std::strlen( _STRING ) + 1
+        );
+    }
+
+    dp::Bool toCacheFilePath(
+        dp::String &                    _filePath
+        , const GLProgramCache &        _CACHE
+        , const char *                  _VERTEX_SOURCE
+        , const char *                  _FRAGMENT_SOURCE
+        , const GLAttributeLocations &  _ATTRIBUTE_LOCATIONS
+    )
+    {
+        auto    key = HASH_OFFSET_BASIS;
+
+        hashString(
+            key
+            , _CACHE.driver.c_str()
+        );
+        hashString(
+            key
+            , _VERTEX_SOURCE
+        );
+        hashString(
+            key
+            , _FRAGMENT_SOURCE
+        );
+        for( const auto & ATTRIBUTE_LOCATION : _ATTRIBUTE_LOCATIONS ) {
+            hash(
+                key
+                , &( ATTRIBUTE_LOCATION.location )
+                , sizeof( ATTRIBUTE_LOCATION.location )
+            );
+            hashString(
+                key
+                , ATTRIBUTE_LOCATION.NAME
+            );
+        }
+
+        char    keyString[ 17 ];
+        std::snprintf(
+            keyString
+            , sizeof( keyString )
+            , "%016llx"
+            , key
+        );
+
+        _filePath = _CACHE.filePrefix + keyString + CACHE_FILE_EXTENSION;
+
+        return true;
+    }
+
+    // 残りのバイト数を求め、ファイルポインタは元の位置へ戻す
+    dp::Bool getRestSize(
+        dp::FileR &     _file
+        , dp::ULong &   _restSize
+    )
+    {
+        dp::Long    position;
+        dp::Long    endPosition;
+        if( dp::getPosition(
+            _file
+            , position
+        ) == false || dp::setPositionFromEnd(
+            _file
+            , 0
+        ) == false || dp::getPosition(
+            _file
+            , endPosition
+        ) == false || dp::setPosition(
+            _file
+            , position
+        ) == false ) {
+            return false;
+        }
+
+        _restSize = endPosition > position ? endPosition - position : 0;
+
+        return true;
+    }
+
+    // 置き換え先が既にあれば置き換える
+    dp::Bool replaceFile(
+        const dp::String &      _FROM
+        , const dp::String &    _TO
+    )
+    {
+#if defined( _MSC_VER )
+        // std::rename()は置き換え先があると失敗する
+        return MoveFileExA(
+            _FROM.c_str()
+            , _TO.c_str()
+            , MOVEFILE_REPLACE_EXISTING
+        ) != 0;
+#else
+        return std::rename(
+            _FROM.c_str()
+            , _TO.c_str()
+        ) == 0;
+#endif
+    }
+
+    template< typename FILE >
+    dp::Bool readAll(
+        FILE &          _file
+        , void *        _data
+        , dp::ULong     _size
+    )
+    {
+        auto    size = _size;
+
+        return dp::read(
+            _file
+            , _data
+            , size
+        ) && size == _size;
+    }
+
+    dp::Bool writeAll(
+        dp::FileW &     _file
+        , const void *  _DATA
+        , dp::ULong     _size
+    )
+    {
+        auto    size = _size;
+
+        return dp::write(
+            _file
+            , _DATA
+            , size
+        ) && size == _size;
+    }
+
+    dp::Bool isLinked(
+        const GLShaderProcs &   _PROCS
+        , GLExtUInt             _program
+    )
+    {
+        dp::GLint   linked = 0;
+        _PROCS.getProgramiv(
+            _program
+            , GLEXT_LINK_STATUS
+            , &linked
+        );
+
+        return linked != 0;
+    }
+
+    // ファイルがない、ドライバが異なる、読み込んだバイナリをドライバが受け付けないといった場合は0を返す
+    GLExtUInt loadCachedProgram(
+        const GLProgramCache &  _CACHE
+        , const GLShaderProcs & _PROCS
+        , const dp::String &    _FILE_PATH
+    )
+    {
+        dp::Utf32   filePath;
+        if( dp::toUtf32(
+            filePath
+            , _FILE_PATH
+        ) == false ) {
+            return 0;
+        }
+
+        auto    fileUnique = dp::unique( dp::newFileR( filePath ) );
+        if( fileUnique.get() == nullptr ) {
+            return 0;
+        }
+        auto &  file = *fileUnique;
+
+        CacheHeader header;
+        if( readAll(
+            file
+            , &header
+            , sizeof( header )
+        ) == false ) {
+            return 0;
+        }
+
+        if( std::memcmp(
+            header.magic
+            , CACHE_MAGIC
+            , sizeof( CACHE_MAGIC )
+        ) != 0 || header.version != CACHE_VERSION || header.driverLength != _CACHE.driver.size() ) {
+            return 0;
+        }
+
+        // ハッシュ値が衝突した場合に、異なるドライバのバイナリを渡さないよう確認する
+        dp::String  driver( header.driverLength, '\0' );
+        if( readAll(
+            file
+            , &( driver[ 0 ] )
+            , header.driverLength
+        ) == false || driver != _CACHE.driver ) {
+            return 0;
+        }
+
+        // 壊れたファイルの長さで確保しないよう、バイナリがファイルの残りと一致する場合のみ読み込む
+        dp::ULong   restSize;
+        if( getRestSize(
+            file
+            , restSize
+        ) == false || header.binaryLength == 0 || header.binaryLength != restSize ) {
+            return 0;
+        }
+
+        std::vector< dp::Byte > binary( header.binaryLength );
+        if( readAll(
+            file
+            , binary.data()
+            , binary.size()
+        ) == false ) {
+            return 0;
+        }
+
+        const auto  PROGRAM = _PROCS.createProgram();
+
+        _CACHE.procs.programBinary(
+            PROGRAM
+            , header.binaryFormat
+            , binary.data()
+            , static_cast< dp::GLsizei >( binary.size() )
+        );
+        if( isLinked(
+            _PROCS
+            , PROGRAM
+        ) == false ) {
+            _PROCS.deleteProgram( PROGRAM );
+
+            return 0;
+        }
+
+        return PROGRAM;
+    }
+
+    // 一時ファイルへ書き込んでから置き換え、読み込み側が書きかけのファイルを見ないようにする
+    dp::Bool saveCachedProgram(
+        const GLProgramCache &  _CACHE
+        , const GLShaderProcs & _PROCS
+        , GLExtUInt             _program
+        , const dp::String &    _FILE_PATH
+    )
+    {
+        dp::GLint   length = 0;
+        _PROCS.getProgramiv(
+            _program
+            , GLEXT_PROGRAM_BINARY_LENGTH
+            , &length
+        );
+        if( length <= 0 ) {
+            return false;
+        }
+
+        std::vector< dp::Byte > binary( length );
+        dp::GLsizei             binaryLength = 0;
+        dp::GLenum              binaryFormat = 0;
+        _CACHE.procs.getProgramBinary(
+            _program
+            , length
+            , &binaryLength
+            , &binaryFormat
+            , binary.data()
+        );
+        if( binaryLength <= 0 ) {
+            return false;
+        }
+
+        CacheHeader header;
+        std::memcpy(
+            header.magic
+            , CACHE_MAGIC
+            , sizeof( CACHE_MAGIC )
+        );
+        header.version = CACHE_VERSION;
+        header.driverLength = static_cast< dp::UInt >( _CACHE.driver.size() );
+        header.binaryFormat = binaryFormat;
+        header.binaryLength = static_cast< dp::UInt >( binaryLength );
+
+        const auto  TEMPORARY_PATH = _FILE_PATH + TEMPORARY_FILE_EXTENSION;
+
+        dp::Utf32   temporaryPath;
+        if( dp::toUtf32(
+            temporaryPath
+            , TEMPORARY_PATH
+        ) == false ) {
+            return false;
+        }
+
+        auto    fileUnique = dp::unique( dp::newFileW( temporaryPath ) );
+        if( fileUnique.get() == nullptr ) {
+            return false;
+        }
+
+        const auto  WRITTEN = writeAll(
+            *fileUnique
+            , &header
+            , sizeof( header )
+        ) && writeAll(
+            *fileUnique
+            , _CACHE.driver.data()
+            , _CACHE.driver.size()
+        ) && writeAll(
+            *fileUnique
+            , binary.data()
+            , header.binaryLength
+        );
+
+        // 置き換える前に閉じる
+        fileUnique.reset();
+
+        if( WRITTEN == false || replaceFile(
+            TEMPORARY_PATH
+            , _FILE_PATH
+        ) == false ) {
+            std::remove( TEMPORARY_PATH.c_str() );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    GLExtUInt compileShader(
+        const GLShaderProcs &   _PROCS
+        , dp::GLenum            _type
+        , const char *          _SOURCE
+    )
+    {
+        const auto  SHADER = _PROCS.createShader( _type );
+        if( SHADER == 0 ) {
+            std::printf( "シェーダーの生成に失敗\n" );
+
+            return 0;
+        }
+
+        _PROCS.shaderSource(
+            SHADER
+            , 1
+            , &_SOURCE
+            , nullptr
+        );
+        _PROCS.compileShader( SHADER );
+
+        dp::GLint   compiled = 0;
+        _PROCS.getShaderiv(
+            SHADER
+            , GLEXT_COMPILE_STATUS
+            , &compiled
+        );
+        if( compiled == 0 ) {
+            dp::GLint   length = 0;
+            _PROCS.getShaderiv(
+                SHADER
+                , GLEXT_INFO_LOG_LENGTH
+                , &length
+            );
+
+            std::vector< char > log( length + 1 );
+            _PROCS.getShaderInfoLog(
+                SHADER
+                , static_cast< dp::GLsizei >( log.size() )
+                , nullptr
+                , log.data()
+            );
+
+            std::printf( "シェーダーのコンパイルに失敗\n%s\n", log.data() );
+
+            _PROCS.deleteShader( SHADER );
+
+            return 0;
+        }
+
+        return SHADER;
+    }
+
+    // _BINARY_PROCSがnullptrでなければ、リンク後にバイナリを取得できるよう指定する
+    GLExtUInt linkProgram(
+        const GLShaderProcs &           _PROCS
+        , const GLProgramBinaryProcs *  _BINARY_PROCS
+        , const char *                  _VERTEX_SOURCE
+        , const char *                  _FRAGMENT_SOURCE
+        , const GLAttributeLocations &  _ATTRIBUTE_LOCATIONS
+    )
+    {
+        const auto  VERTEX_SHADER = compileShader(
+            _PROCS
+            , GLEXT_VERTEX_SHADER
+            , _VERTEX_SOURCE
+        );
+        if( VERTEX_SHADER == 0 ) {
+            return 0;
+        }
+
+        const auto  FRAGMENT_SHADER = compileShader(
+            _PROCS
+            , GLEXT_FRAGMENT_SHADER
+            , _FRAGMENT_SOURCE
+        );
+        if( FRAGMENT_SHADER == 0 ) {
+            _PROCS.deleteShader( VERTEX_SHADER );
+
+            return 0;
+        }
+
+        const auto  PROGRAM = _PROCS.createProgram();
+
+        _PROCS.attachShader(
+            PROGRAM
+            , VERTEX_SHADER
+        );
+        _PROCS.attachShader(
+            PROGRAM
+            , FRAGMENT_SHADER
+        );
+
+        for( const auto & ATTRIBUTE_LOCATION : _ATTRIBUTE_LOCATIONS ) {
+            _PROCS.bindAttribLocation(
+                PROGRAM
+                , ATTRIBUTE_LOCATION.location
+                , ATTRIBUTE_LOCATION.NAME
+            );
+        }
+
+        if( _BINARY_PROCS != nullptr ) {
+            _BINARY_PROCS->programParameteri(
+                PROGRAM
+                , GLEXT_PROGRAM_BINARY_RETRIEVABLE_HINT
+                , 1
+            );
+        }
+
+        _PROCS.linkProgram( PROGRAM );
+
+        // リンク後はプログラムが参照を持つため、シェーダーは削除してよい
+        _PROCS.deleteShader( VERTEX_SHADER );
+        _PROCS.deleteShader( FRAGMENT_SHADER );
+
+        if( isLinked(
+            _PROCS
+            , PROGRAM
+        ) == false ) {
+            dp::GLint   length = 0;
+            _PROCS.getProgramiv(
+                PROGRAM
+                , GLEXT_INFO_LOG_LENGTH
+                , &length
+            );
+
+            std::vector< char > log( length + 1 );
+            _PROCS.getProgramInfoLog(
+                PROGRAM
+                , static_cast< dp::GLsizei >( log.size() )
+                , nullptr
+                , log.data()
+            );
+
+            std::printf( "プログラムのリンクに失敗\n%s\n", log.data() );
+
+            _PROCS.deleteProgram( PROGRAM );
+
+            return 0;
+        }
+
+        return PROGRAM;
+    }
+}
+
+GLExtUInt newGLProgram(
+    const GLShaderProcs &           _PROCS
+    , const char *                  _VERTEX_SOURCE
+    , const char *                  _FRAGMENT_SOURCE
+    , const GLAttributeLocations &  _ATTRIBUTE_LOCATIONS
+)
+{
+    return linkProgram(
+        _PROCS
+        , nullptr
+        , _VERTEX_SOURCE
+        , _FRAGMENT_SOURCE
+        , _ATTRIBUTE_LOCATIONS
+    );
+}
+
+void initGLProgramCache(
+    GLProgramCache &        _cache
+    , const dp::String &    _FILE_PREFIX
+)
+{
+    _cache.available = false;
+    _cache.filePrefix = _FILE_PREFIX;
+
+    if( loadGLProgramBinaryProcs( _cache.procs ) == false ) {
+        return;
+    }
+
+    dp::GLint   formats = 0;
+    _cache.procs.getIntegerv(
+        GLEXT_NUM_PROGRAM_BINARY_FORMATS
+        , &formats
+    );
+    if( formats <= 0 ) {
+        return;
+    }
+
+    // 同じドライバの更新前後ではバイナリの互換性がないため、バージョンまで含める
+    for( const auto & NAME : {
+        GLEXT_VENDOR,
+        GLEXT_RENDERER,
+        GLEXT_VERSION,
+    } ) {
+        const auto  STRING = reinterpret_cast< const char * >( _cache.procs.getString( NAME ) );
+        if( STRING == nullptr ) {
+            return;
+        }
+
+        _cache.driver.append( STRING );
+        _cache.driver.push_back( '\n' );
+    }
+
+    _cache.available = true;
+}
+
+GLExtUInt newCachedGLProgram(
+    const GLProgramCache &          _CACHE
+    , const GLShaderProcs &         _PROCS
+    , const char *                  _VERTEX_SOURCE
+    , const char *                  _FRAGMENT_SOURCE
+    , const GLAttributeLocations &  _ATTRIBUTE_LOCATIONS
+    , dp::Bool                      _recompile
+    , GLProgramOrigin &             _origin
+)
+{
+    dp::String  filePath;
+    if( _CACHE.available == false || toCacheFilePath(
+        filePath
+        , _CACHE
+        , _VERTEX_SOURCE
+        , _FRAGMENT_SOURCE
+        , _ATTRIBUTE_LOCATIONS
+    ) == false ) {
+        _origin = GLProgramOrigin::UNCACHED;
+
+        return newGLProgram(
+            _PROCS
+            , _VERTEX_SOURCE
+            , _FRAGMENT_SOURCE
+            , _ATTRIBUTE_LOCATIONS
+        );
+    }
+
+    if( _recompile == false ) {
+        const auto  CACHED_PROGRAM = loadCachedProgram(
+            _CACHE
+            , _PROCS
+            , filePath
+        );
+        if( CACHED_PROGRAM != 0 ) {
+            _origin = GLProgramOrigin::LOADED;
+
+            return CACHED_PROGRAM;
+        }
+    }
+
+    const auto  PROGRAM = linkProgram(
+        _PROCS
+        , &( _CACHE.procs )
+        , _VERTEX_SOURCE
+        , _FRAGMENT_SOURCE
+        , _ATTRIBUTE_LOCATIONS
+    );
+    if( PROGRAM == 0 ) {
+        return 0;
+    }
+
+    // 保存できなくてもプログラムは使用できるため、次回もコンパイルすることになるのみ
+    if( saveCachedProgram(
+        _CACHE
+        , _PROCS
+        , PROGRAM
+        , filePath
+    ) == false ) {
+        std::printf( "プログラムのキャッシュの保存に失敗\n" );
+
+        _origin = GLProgramOrigin::UNCACHED;
+
+        return PROGRAM;
+    }
+
+    _origin = GLProgramOrigin::COMPILED;
+
+    return PROGRAM;
+}
+
+const char * toString(
+    GLProgramOrigin _origin
+)
+{
+    switch( _origin ) {
+    case GLProgramOrigin::LOADED:
+        return "キャッシュから読み込み";
+
+    case GLProgramOrigin::COMPILED:
+        return "コンパイルしてキャッシュへ保存";
+
+    default:
+        return "コンパイル(キャッシュなし)";
+    }
+}
@@ -0,0 +1,218 @@
+﻿#include "glstatecache.h"
+#include "glext.h"
+#include "vecmath.h"
+
+#include "dp/opengl/gl.h"
+#include "dp/common/primitives.h"
+
+#include <algorithm>
+#include <iterator>
+#include <cstdio>
+
+namespace {
+    // 射影行列の設定はglMatrixMode()、glLoadMatrixf()
+    const auto  PROJECTION_CALLS = 2;
+
+    dp::Bool isSameProjection(
+        const Mat4 &    _PROJECTION1
+        , const Mat4 &  _PROJECTION2
+    )
+    {
+        return std::equal(
+            std::begin( _PROJECTION1.elements )
+            , std::end( _PROJECTION1.elements )
+            , std::begin( _PROJECTION2.elements )
+        );
+    }
+
+    // 機能の状態が変わる場合のみtrueを返し、キャッシュを更新する
+    dp::Bool updateCapability(
+        GLStateCache &  _cache
+        , dp::GLenum    _capability
+        , dp::Bool      _enabled
+    )
+    {
+        auto &  capabilities = _cache.capabilities;
+
+        const auto  IT = std::find_if(
+            capabilities.begin()
+            , capabilities.end()
+            , [
+                _capability
+            ]
+            (
+                const std::pair< dp::GLenum, dp::Bool > &   _CAPABILITY
+            )
+            {
+                return _CAPABILITY.first == _capability;
+            }
+        );
+        if( IT == capabilities.end() ) {
+            capabilities.push_back(
+                std::make_pair(
+                    _capability
+                    , _enabled
+                )
+            );
+
+            return true;
+        }
+
+        if( IT->second == _enabled ) {
+            return false;
+        }
+
+        IT->second = _enabled;
+
+        return true;
+    }
+}
+
+GLStateCache::GLStateCache(
+)
+    : issuedCalls( 0 )
+    , droppedCalls( 0 )
+{
+    invalidateGLStateCache( *this );
+}
+
+void invalidateGLStateCache(
+    GLStateCache &  _cache
+)
+{
+    _cache.capabilities.clear();
+    _cache.depthFuncValid = false;
+    _cache.clearColorValid = false;
+    _cache.matrixModeValid = false;
+    _cache.projectionValid = false;
+}
+
+void enableGLState(
+    GLStateCache &  _cache
+    , dp::GLenum    _capability
+)
+{
+    if( updateCapability(
+        _cache
+        , _capability
+        , true
+    ) == false ) {
+        _cache.droppedCalls++;
+
+        return;
+    }
+
+    dp::glEnable( _capability );
+    _cache.issuedCalls++;
+}
+
+void setGLDepthFunc(
+    GLStateCache &  _cache
+    , dp::GLenum    _func
+)
+{
+    if( _cache.depthFuncValid && _cache.depthFunc == _func ) {
+        _cache.droppedCalls++;
+
+        return;
+    }
+
+    dp::glDepthFunc( _func );
+    _cache.issuedCalls++;
+
+    _cache.depthFuncValid = true;
+    _cache.depthFunc = _func;
+}
+
+void setGLClearColor(
+    GLStateCache &  _cache
+    , dp::GLfloat   _red
+    , dp::GLfloat   _green
+    , dp::GLfloat   _blue
+    , dp::GLfloat   _alpha
+)
+{
+    auto &  clearColor = _cache.clearColor;
+
+    if( _cache.clearColorValid &&
+        clearColor[ 0 ] == _red &&
+        clearColor[ 1 ] == _green &&
+        clearColor[ 2 ] == _blue &&
+        clearColor[ 3 ] == _alpha
+    ) {
+        _cache.droppedCalls++;
+
+        return;
+    }
+
+    dp::glClearColor(
+        _red
+        , _green
+        , _blue
+        , _alpha
+    );
+    _cache.issuedCalls++;
+
+    _cache.clearColorValid = true;
+    clearColor[ 0 ] = _red;
+    clearColor[ 1 ] = _green;
+    clearColor[ 2 ] = _blue;
+    clearColor[ 3 ] = _alpha;
+}
+
+void setGLMatrixMode(
+    GLStateCache &  _cache
+    , dp::GLenum    _mode
+)
+{
+    if( _cache.matrixModeValid && _cache.matrixMode == _mode ) {
+        _cache.droppedCalls++;
+
+        return;
+    }
+
+    dp::glMatrixMode( _mode );
+    _cache.issuedCalls++;
+
+    _cache.matrixModeValid = true;
+    _cache.matrixMode = _mode;
+}
+
+void setGLProjection(
+    GLStateCache &          _cache
+    , const GLMatrixProcs & _PROCS
+    , const Mat4 &          _PROJECTION
+)
+{
+    if( _cache.projectionValid && isSameProjection(
+        _cache.projection
+        , _PROJECTION
+    ) ) {
+        _cache.droppedCalls += PROJECTION_CALLS;
+
+        return;
+    }
+
+    setGLMatrixMode(
+        _cache
+        , dp::GL_PROJECTION
+    );
+
+    _PROCS.loadMatrixf( _PROJECTION.elements );
+    _cache.issuedCalls += PROJECTION_CALLS - 1;
+
+    _cache.projectionValid = true;
+    _cache.projection = _PROJECTION;
+}
+
+void printGLStateCache(
+    const GLStateCache &    _CACHE
+)
+{
+    const auto  TOTAL = _CACHE.issuedCalls + _CACHE.droppedCalls;
+    if( TOTAL <= 0 ) {
+        return;
+    }
+
+    std::printf( "状態設定のGL呼び出し: 発行 %llu回 省略 %llu回 (%.1f%%)\n", _CACHE.issuedCalls, _CACHE.droppedCalls, _CACHE.droppedCalls * 100.0 / TOTAL );
+}
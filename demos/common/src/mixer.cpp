@@ -0,0 +1,382 @@
+﻿#include "mixer.h"
+#include "audiostream.h"
+#include "simd.h"
+
+#include "dp/common/primitives.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace {
+    const auto  FRAME_SIZE = sizeof( std::int16_t ) * 2;
+
+    // ゲインはQ14の固定小数点で扱う
+    const auto  GAIN_SHIFT = 14;
+    const auto  GAIN_ONE = 1 << GAIN_SHIFT;
+    const auto  GAIN_FIXED_MAX = 0x7fff;
+
+    std::int16_t toFixedGain(
+        dp::Float   _gain
+    )
+    {
+        const auto  GAIN = static_cast< dp::Int >( _gain * GAIN_ONE + 0.5f );
+
+        return static_cast< std::int16_t >(
+            std::max(
+                0
+                , std::min(
+                    GAIN
+                    , GAIN_FIXED_MAX
+                )
+            )
+        );
+    }
+
+    void accumulate(
+        std::int32_t *          _accumulator
+        , const std::int16_t *  _SOURCE
+        , std::size_t           _samples
+        , std::int16_t          _gainLeft
+        , std::int16_t          _gainRight
+    )
+    {
+        std::size_t i = 0;
+
+#if defined( USE_SSE2 )
+        const auto  GAINS = _mm_setr_epi16(
+            _gainLeft
+            , _gainRight
+            , _gainLeft
+            , _gainRight
+            , _gainLeft
+            , _gainRight
+            , _gainLeft
+            , _gainRight
+        );
+
+        for( ; i + 8 <= _samples ; i += 8 ) {
+            const auto  SOURCE = _mm_loadu_si128( reinterpret_cast< const __m128i * >( _SOURCE + i ) );
+
+            const auto  LOW = _mm_mullo_epi16(
+                SOURCE
+                , GAINS
+            );
+            const auto  HIGH = _mm_mulhi_epi16(
+                SOURCE
+                , GAINS
+            );
+
+            const auto  PRODUCTS0 = _mm_srai_epi32(
+                _mm_unpacklo_epi16(
+                    LOW
+                    , HIGH
+                )
+                , GAIN_SHIFT
+            );
+            const auto  PRODUCTS1 = _mm_srai_epi32(
+                _mm_unpackhi_epi16(
+                    LOW
+                    , HIGH
+                )
+                , GAIN_SHIFT
+            );
+
+            auto    accumulator0 = reinterpret_cast< __m128i * >( _accumulator + i );
+            auto    accumulator1 = reinterpret_cast< __m128i * >( _accumulator + i + 4 );
+
+            _mm_storeu_si128(
+                accumulator0
+                , _mm_add_epi32(
+                    _mm_loadu_si128( accumulator0 )
+                    , PRODUCTS0
+                )
+            );
+            _mm_storeu_si128(
+                accumulator1
+                , _mm_add_epi32(
+                    _mm_loadu_si128( accumulator1 )
+                    , PRODUCTS1
+                )
+            );
+        }
+#endif
+
+        for( ; i < _samples ; i += 2 ) {
+            _accumulator[ i ] += ( _SOURCE[ i ] * _gainLeft ) >> GAIN_SHIFT;
+            _accumulator[ i + 1 ] += ( _SOURCE[ i + 1 ] * _gainRight ) >> GAIN_SHIFT;
+        }
+    }
+
+    // 飽和させながら16bitへ詰める
+    void store(
+        std::int16_t *          _destination
+        , const std::int32_t *  _ACCUMULATOR
+        , std::size_t           _samples
+    )
+    {
+        std::size_t i = 0;
+
+#if defined( USE_SSE2 )
+        for( ; i + 8 <= _samples ; i += 8 ) {
+            _mm_storeu_si128(
+                reinterpret_cast< __m128i * >( _destination + i )
+                , _mm_packs_epi32(
+                    _mm_loadu_si128( reinterpret_cast< const __m128i * >( _ACCUMULATOR + i ) )
+                    , _mm_loadu_si128( reinterpret_cast< const __m128i * >( _ACCUMULATOR + i + 4 ) )
+                )
+            );
+        }
+#endif
+
+        for( ; i < _samples ; i++ ) {
+            _destination[ i ] = static_cast< std::int16_t >(
+                std::max(
+                    -0x8000
+                    , std::min(
+                        _ACCUMULATOR[ i ]
+                        , 0x7fff
+                    )
+                )
+            );
+        }
+    }
+
+    void mixVoice(
+        Mixer &         _mixer
+        , MixerVoice &  _voice
+        , dp::UInt      _frames
+    )
+    {
+        const auto  STATE = _voice.state.load( std::memory_order_acquire );
+        if( STATE == MixerVoice::STOP_REQUESTED ) {
+            _voice.state.store(
+                MixerVoice::FINISHED
+                , std::memory_order_release
+            );
+
+            return;
+        }
+
+        if( STATE != MixerVoice::PLAYING ) {
+            return;
+        }
+
+        auto &  stream = *( _voice.stream.load( std::memory_order_relaxed ) );
+
+        const auto  SIZE = _mixer.realtime ? readAudioStream(
+            stream
+            , _mixer.voiceBuffer.data()
+            , _frames * FRAME_SIZE
+        ) : waitReadAudioStream(
+            stream
+            , _mixer.voiceBuffer.data()
+            , _frames * FRAME_SIZE
+        );
+        if( SIZE < _frames * FRAME_SIZE ) {
+            _voice.state.store(
+                MixerVoice::FINISHED
+                , std::memory_order_release
+            );
+        }
+
+        // パンはセンターで左右とも等倍となるバランス方式とする
+        const auto  GAIN = _voice.gain.load( std::memory_order_relaxed );
+        const auto  PAN = _voice.pan.load( std::memory_order_relaxed );
+
+        accumulate(
+            _mixer.accumulator.data()
+            , _mixer.voiceBuffer.data()
+            , SIZE / sizeof( std::int16_t )
+            , toFixedGain( GAIN * std::min( 1.0f, 1 - PAN ) )
+            , toFixedGain( GAIN * std::min( 1.0f, 1 + PAN ) )
+        );
+    }
+
+    void mixChunk(
+        Mixer &             _mixer
+        , std::int16_t *    _destination
+        , dp::UInt          _frames
+    )
+    {
+        const auto  SAMPLES = _frames * 2;
+
+        std::fill(
+            _mixer.accumulator.begin()
+            , _mixer.accumulator.begin() + SAMPLES
+            , 0
+        );
+
+        for( auto & voice : _mixer.voices ) {
+            mixVoice(
+                _mixer
+                , voice
+                , _frames
+            );
+        }
+
+        store(
+            _destination
+            , _mixer.accumulator.data()
+            , SAMPLES
+        );
+    }
+}
+
+dp::Int addVoice(
+    Mixer &         _mixer
+    , AudioStream & _stream
+    , dp::Float     _gain
+    , dp::Float     _pan
+)
+{
+    const auto  VOICES = static_cast< dp::Int >( _mixer.voices.size() );
+    for( dp::Int i = 0 ; i < VOICES ; i++ ) {
+        auto &  voice = _mixer.voices[ i ];
+
+        if( voice.state.load( std::memory_order_acquire ) != MixerVoice::FREE ) {
+            continue;
+        }
+
+        voice.stream.store(
+            &_stream
+            , std::memory_order_relaxed
+        );
+        voice.gain.store(
+            _gain
+            , std::memory_order_relaxed
+        );
+        voice.pan.store(
+            _pan
+            , std::memory_order_relaxed
+        );
+
+        voice.state.store(
+            MixerVoice::PLAYING
+            , std::memory_order_release
+        );
+
+        return i;
+    }
+
+    return -1;
+}
+
+void setVoiceGain(
+    Mixer &     _mixer
+    , dp::Int   _index
+    , dp::Float _gain
+)
+{
+    _mixer.voices[ _index ].gain.store(
+        std::max(
+            0.0f
+            , std::min(
+                _gain
+                , MIXER_GAIN_MAX
+            )
+        )
+        , std::memory_order_relaxed
+    );
+}
+
+void setVoicePan(
+    Mixer &     _mixer
+    , dp::Int   _index
+    , dp::Float _pan
+)
+{
+    _mixer.voices[ _index ].pan.store(
+        std::max(
+            -1.0f
+            , std::min(
+                _pan
+                , 1.0f
+            )
+        )
+        , std::memory_order_relaxed
+    );
+}
+
+void stopVoice(
+    Mixer &     _mixer
+    , dp::Int   _index
+)
+{
+    dp::Int state = MixerVoice::PLAYING;
+
+    _mixer.voices[ _index ].state.compare_exchange_strong(
+        state
+        , MixerVoice::STOP_REQUESTED
+        , std::memory_order_acq_rel
+    );
+}
+
+dp::Bool reclaimVoice(
+    Mixer &     _mixer
+    , dp::Int   _index
+)
+{
+    auto &  voice = _mixer.voices[ _index ];
+
+    if( voice.state.load( std::memory_order_acquire ) != MixerVoice::FINISHED ) {
+        return false;
+    }
+
+    voice.stream.store(
+        nullptr
+        , std::memory_order_relaxed
+    );
+
+    voice.state.store(
+        MixerVoice::FREE
+        , std::memory_order_release
+    );
+
+    return true;
+}
+
+dp::UInt getPlayingVoices(
+    const Mixer &   _MIXER
+)
+{
+    dp::UInt    count = 0;
+
+    for( const auto & VOICE : _MIXER.voices ) {
+        const auto  STATE = VOICE.state.load( std::memory_order_acquire );
+        if( STATE == MixerVoice::PLAYING || STATE == MixerVoice::STOP_REQUESTED ) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+dp::ULong mix(
+    Mixer &     _mixer
+    , void *    _buffer
+    , dp::ULong _bufferSize
+)
+{
+    auto    destination = static_cast< std::int16_t * >( _buffer );
+
+    const auto  FRAMES = static_cast< dp::UInt >( _bufferSize / FRAME_SIZE );
+
+    for( dp::UInt offset = 0 ; offset < FRAMES ; ) {
+        const auto  CHUNK_FRAMES = std::min(
+            FRAMES - offset
+            , _mixer.maxFrames
+        );
+
+        mixChunk(
+            _mixer
+            , destination + offset * 2
+            , CHUNK_FRAMES
+        );
+
+        offset += CHUNK_FRAMES;
+    }
+
+    return FRAMES * FRAME_SIZE;
+}
@@ -0,0 +1,342 @@
+﻿#include "offscreen.h"
+#include "glext.h"
+
+#include "dp/file/filew.h"
+#include "dp/common/primitives.h"
+
+#if !defined( _MSC_VER )
+// X11のヘッダを読み込まないようにする
+#   define EGL_NO_X11
+#   define MESA_EGL_NO_X11_HEADERS
+#   include <EGL/egl.h>
+#   include <EGL/eglext.h>
+#endif
+
+#include <memory>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+
+namespace {
+    const auto  BYTES_PER_PIXEL = 4;    // RGBA
+    const auto  PPM_BYTES_PER_PIXEL = 3;    // RGB
+
+#if !defined( _MSC_VER )
+    EGLDisplay getSurfacelessDisplay(
+    )
+    {
+        const auto  GET_PLATFORM_DISPLAY = reinterpret_cast< PFNEGLGETPLATFORMDISPLAYEXTPROC >( eglGetProcAddress( "eglGetPlatformDisplayEXT" ) );
+        if( GET_PLATFORM_DISPLAY == nullptr ) {
+            return EGL_NO_DISPLAY;
+        }
+
+        return GET_PLATFORM_DISPLAY(
+            EGL_PLATFORM_SURFACELESS_MESA
+            , EGL_DEFAULT_DISPLAY
+            , nullptr
+        );
+    }
+
+    dp::Bool initEGLContext(
+        OffscreenGLContext &    _context
+    )
+    {
+        const auto  DISPLAY = getSurfacelessDisplay();
+        if( DISPLAY == EGL_NO_DISPLAY ) {
+            std::printf( "EGLのsurfacelessプラットフォームが利用できない\n" );
+
+            return false;
+        }
+
+        if( eglInitialize(
+            DISPLAY
+            , nullptr
+            , nullptr
+        ) == EGL_FALSE ) {
+            std::printf( "EGLの初期化に失敗\n" );
+
+            return false;
+        }
+        _context.display = DISPLAY;
+
+        if( eglBindAPI( EGL_OPENGL_API ) == EGL_FALSE ) {
+            std::printf( "EGLでOpenGLが利用できない\n" );
+
+            return false;
+        }
+
+        // 描画先はフレームバッファオブジェクトのため、サーフェスの種類は問わない
+        const EGLint    CONFIG_ATTRIBUTES[] = {
+            EGL_SURFACE_TYPE, 0,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE,
+        };
+
+        EGLConfig   config;
+        EGLint      configs = 0;
+        if( eglChooseConfig(
+            DISPLAY
+            , CONFIG_ATTRIBUTES
+            , &config
+            , 1
+            , &configs
+        ) == EGL_FALSE || configs <= 0 ) {
+            std::printf( "EGLの設定が見つからない\n" );
+
+            return false;
+        }
+
+        const EGLint    CONTEXT_ATTRIBUTES[] = {
+            EGL_NONE,
+        };
+
+        const auto  CONTEXT = eglCreateContext(
+            DISPLAY
+            , config
+            , EGL_NO_CONTEXT
+            , CONTEXT_ATTRIBUTES
+        );
+        if( CONTEXT == EGL_NO_CONTEXT ) {
+            std::printf( "EGLコンテキストの生成に失敗\n" );
+
+            return false;
+        }
+        _context.context = CONTEXT;
+
+        if( eglMakeCurrent(
+            DISPLAY
+            , EGL_NO_SURFACE
+            , EGL_NO_SURFACE
+            , CONTEXT
+        ) == EGL_FALSE ) {
+            std::printf( "EGLコンテキストをカレントにできない\n" );
+
+            return false;
+        }
+
+        return true;
+    }
+#endif
+
+    dp::Bool initFramebuffer(
+        OffscreenGLContext &    _context
+    )
+    {
+        auto &  procs = _context.procs;
+
+        if( loadGLFramebufferProcs( procs ) == false ) {
+            std::printf( "フレームバッファオブジェクトの関数のロードに失敗\n" );
+
+            return false;
+        }
+
+        procs.genRenderbuffers(
+            1
+            , &( _context.colorRenderbuffer )
+        );
+        procs.bindRenderbuffer(
+            GLEXT_RENDERBUFFER
+            , _context.colorRenderbuffer
+        );
+        procs.renderbufferStorage(
+            GLEXT_RENDERBUFFER
+            , GLEXT_RGBA8
+            , _context.width
+            , _context.height
+        );
+
+        procs.genRenderbuffers(
+            1
+            , &( _context.depthRenderbuffer )
+        );
+        procs.bindRenderbuffer(
+            GLEXT_RENDERBUFFER
+            , _context.depthRenderbuffer
+        );
+        procs.renderbufferStorage(
+            GLEXT_RENDERBUFFER
+            , GLEXT_DEPTH_COMPONENT24
+            , _context.width
+            , _context.height
+        );
+
+        procs.genFramebuffers(
+            1
+            , &( _context.framebuffer )
+        );
+        procs.bindFramebuffer(
+            GLEXT_FRAMEBUFFER
+            , _context.framebuffer
+        );
+        procs.framebufferRenderbuffer(
+            GLEXT_FRAMEBUFFER
+            , GLEXT_COLOR_ATTACHMENT0
+            , GLEXT_RENDERBUFFER
+            , _context.colorRenderbuffer
+        );
+        procs.framebufferRenderbuffer(
+            GLEXT_FRAMEBUFFER
+            , GLEXT_DEPTH_ATTACHMENT
+            , GLEXT_RENDERBUFFER
+            , _context.depthRenderbuffer
+        );
+
+        if( procs.checkFramebufferStatus( GLEXT_FRAMEBUFFER ) != GLEXT_FRAMEBUFFER_COMPLETE ) {
+            std::printf( "フレームバッファオブジェクトが不完全\n" );
+
+            return false;
+        }
+
+        return true;
+    }
+}
+
+OffscreenGLContext::OffscreenGLContext(
+)
+    : width( 0 )
+    , height( 0 )
+    , display( nullptr )
+    , context( nullptr )
+    , framebuffer( 0 )
+    , colorRenderbuffer( 0 )
+    , depthRenderbuffer( 0 )
+{
+}
+
+OffscreenGLContext::~OffscreenGLContext(
+)
+{
+#if !defined( _MSC_VER )
+    // フレームバッファオブジェクトはコンテキストとともに破棄される
+    if( this->display == nullptr ) {
+        return;
+    }
+
+    eglMakeCurrent(
+        this->display
+        , EGL_NO_SURFACE
+        , EGL_NO_SURFACE
+        , EGL_NO_CONTEXT
+    );
+
+    if( this->context != nullptr ) {
+        eglDestroyContext(
+            this->display
+            , this->context
+        );
+    }
+
+    eglTerminate( this->display );
+#endif
+}
+
+OffscreenGLContext * newOffscreenGLContext(
+    dp::Int     _width
+    , dp::Int   _height
+)
+{
+#if defined( _MSC_VER )
+    std::printf( "オフスクリーン描画はLinuxのみ対応\n" );
+
+    return nullptr;
+#else
+    std::unique_ptr< OffscreenGLContext >   contextUnique( new OffscreenGLContext );
+    auto &  context = *contextUnique;
+
+    context.width = _width;
+    context.height = _height;
+    context.pixels.resize( static_cast< std::size_t >( _width ) * _height * BYTES_PER_PIXEL );
+
+    if( initEGLContext( context ) == false ) {
+        return nullptr;
+    }
+
+    if( initFramebuffer( context ) == false ) {
+        return nullptr;
+    }
+
+    return contextUnique.release();
+#endif
+}
+
+void finishOffscreenGLFrame(
+    OffscreenGLContext &    _context
+)
+{
+    _context.procs.finish();
+}
+
+dp::Bool writeOffscreenGLImage(
+    OffscreenGLContext &    _context
+    , const dp::Utf32 &     _FILE_PATH
+)
+{
+    const auto  WIDTH = static_cast< std::size_t >( _context.width );
+    const auto  HEIGHT = static_cast< std::size_t >( _context.height );
+
+    auto &  pixels = _context.pixels;
+
+    _context.procs.readPixels(
+        0
+        , 0
+        , _context.width
+        , _context.height
+        , GLEXT_RGBA
+        , GLEXT_UNSIGNED_BYTE
+        , pixels.data()
+    );
+
+    // GLの画像は下の行から並ぶため、上下を反転しながらRGBへ詰める
+    std::vector< dp::Byte > image( WIDTH * HEIGHT * PPM_BYTES_PER_PIXEL );
+    for( std::size_t y = 0 ; y < HEIGHT ; y++ ) {
+        const auto  SOURCE = pixels.data() + ( HEIGHT - 1 - y ) * WIDTH * BYTES_PER_PIXEL;
+        auto        destination = image.data() + y * WIDTH * PPM_BYTES_PER_PIXEL;
+
+        for( std::size_t x = 0 ; x < WIDTH ; x++ ) {
+            destination[ x * PPM_BYTES_PER_PIXEL ] = SOURCE[ x * BYTES_PER_PIXEL ];
+            destination[ x * PPM_BYTES_PER_PIXEL + 1 ] = SOURCE[ x * BYTES_PER_PIXEL + 1 ];
+            destination[ x * PPM_BYTES_PER_PIXEL + 2 ] = SOURCE[ x * BYTES_PER_PIXEL + 2 ];
+        }
+    }
+
+    char    header[ 32 ];
+    const auto  HEADER_SIZE = std::snprintf(
+        header
+        , sizeof( header )
+        , "P6\n%d %d\n255\n"
+        , _context.width
+        , _context.height
+    );
+
+    auto    fileUnique = dp::unique( dp::newFileW( _FILE_PATH ) );
+    if( fileUnique.get() == nullptr ) {
+        std::printf( "画像ファイルの作成に失敗\n" );
+
+        return false;
+    }
+    auto &  file = *fileUnique;
+
+    dp::ULong   size = HEADER_SIZE;
+    if( dp::write(
+        file
+        , header
+        , size
+    ) == false || size != static_cast< dp::ULong >( HEADER_SIZE ) ) {
+        std::printf( "画像ファイルの書き込みに失敗\n" );
+
+        return false;
+    }
+
+    size = image.size();
+    if( dp::write(
+        file
+        , image.data()
+        , size
+    ) == false || size != image.size() ) {
+        std::printf( "画像ファイルの書き込みに失敗\n" );
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,67 @@
+﻿#include "option.h"
+
+#include "dp/common/stringconverter.h"
+#include "dp/common/primitives.h"
+
+#include <cstdlib>
+
+dp::Bool parseValueOption(
+    const dp::String &  _OPTION
+    , dp::String &      _name
+    , dp::String &      _value
+)
+{
+    const auto  SEPARATOR_INDEX = _OPTION.find( '=' );
+    if( SEPARATOR_INDEX == dp::String::npos ) {
+        return false;
+    }
+
+    _name = _OPTION.substr(
+        0
+        , SEPARATOR_INDEX
+    );
+    _value = _OPTION.substr( SEPARATOR_INDEX + 1 );
+
+    return true;
+}
+
+dp::Bool parseValueOption(
+    const dp::String &  _OPTION
+    , dp::String &      _name
+    , dp::UInt &        _value
+)
+{
+    dp::String  value;
+    if( parseValueOption(
+        _OPTION
+        , _name
+        , value
+    ) == false ) {
+        return false;
+    }
+
+    _value = static_cast< dp::UInt >( std::atoi( value.c_str() ) );
+
+    return true;
+}
+
+dp::Bool parseValueOption(
+    const dp::Utf32 &   _OPTION
+    , dp::String &      _name
+    , dp::UInt &        _value
+)
+{
+    dp::String  option;
+    if( dp::toString(
+        option
+        , _OPTION
+    ) == false ) {
+        return false;
+    }
+
+    return parseValueOption(
+        option
+        , _name
+        , _value
+    );
+}
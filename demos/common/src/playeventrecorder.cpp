@@ -0,0 +1,169 @@
+﻿#include "playeventrecorder.h"
+
+#include "dp/common/primitives.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+
+namespace {
+    const std::size_t   COLLECT_RECORDS = 256;
+
+    const dp::Int   PERCENTILES[] = {
+        50,
+        90,
+        99,
+        100,
+    };
+
+    template< typename T >
+    void printPercentiles(
+        const char *            _NAME
+        , const char *          _UNIT
+        , std::vector< T > &    _values
+        , dp::Float             _scale
+    )
+    {
+        if( _values.empty() ) {
+            return;
+        }
+
+        std::sort(
+            _values.begin()
+            , _values.end()
+        );
+
+        std::printf( "%s", _NAME );
+        for( const auto & PERCENTILE : PERCENTILES ) {
+            const auto  INDEX = ( _values.size() - 1 ) * PERCENTILE / 100;
+
+            std::printf(
+                " p%d=%.3f%s"
+                , PERCENTILE
+                , _values[ INDEX ] * _scale
+                , _UNIT
+            );
+        }
+        std::printf( "\n" );
+    }
+
+    dp::Long toPeriodNanoseconds(
+        const PlayEventRecorder &   _RECORDER
+        , dp::ULong                 _size
+    )
+    {
+        if( _RECORDER.bytesPerSecond <= 0 ) {
+            return 0;
+        }
+
+        return static_cast< dp::Long >( _size * 1000000000ULL / _RECORDER.bytesPerSecond );
+    }
+}
+
+void collectPlayEventRecords(
+    PlayEventRecorder & _recorder
+)
+{
+    PlayEventRecord records[ COLLECT_RECORDS ];
+
+    while( 1 ) {
+        const auto  COUNT = _recorder.ringBuffer.read(
+            records
+            , COLLECT_RECORDS
+        );
+        if( COUNT <= 0 ) {
+            break;
+        }
+
+        _recorder.records.insert(
+            _recorder.records.end()
+            , records
+            , records + COUNT
+        );
+    }
+}
+
+void printPlayEventSummary(
+    PlayEventRecorder & _recorder
+)
+{
+    collectPlayEventRecords( _recorder );
+
+    const auto &    RECORDS = _recorder.records;
+
+    std::printf( "再生コールバック呼び出し回数: %u\n", static_cast< dp::UInt >( RECORDS.size() ) );
+    std::printf( "記録の取りこぼし: %llu\n", _recorder.droppedRecords.load() );
+    if( RECORDS.empty() ) {
+        return;
+    }
+
+    std::vector< dp::Long >     intervals;
+    std::vector< dp::Long >     elapsedTimes;
+    std::vector< dp::ULong >    requestedSizes;
+    std::vector< dp::ULong >    returnedSizes;
+
+    dp::UInt    underruns = 0;
+    dp::UInt    overruns = 0;
+    dp::UInt    lateCalls = 0;
+
+    for( std::size_t i = 0 ; i < RECORDS.size() ; i++ ) {
+        const auto &    RECORD = RECORDS[ i ];
+
+        elapsedTimes.push_back( RECORD.elapsedNanoseconds );
+        requestedSizes.push_back( RECORD.requestedSize );
+        returnedSizes.push_back( RECORD.returnedSize );
+
+        if( RECORD.underrun ) {
+            underruns++;
+        }
+
+        // 要求されたバッファ分の再生時間内に処理を終えられなければデッドライン超過とみなす
+        if( RECORD.elapsedNanoseconds > toPeriodNanoseconds( _recorder, RECORD.requestedSize ) ) {
+            overruns++;
+        }
+
+        if( i <= 0 ) {
+            continue;
+        }
+
+        const auto &    PREV_RECORD = RECORDS[ i - 1 ];
+
+        const auto  INTERVAL = RECORD.beginNanoseconds - PREV_RECORD.beginNanoseconds;
+        intervals.push_back( INTERVAL );
+
+        // 前回返したデータの再生時間の1.5倍を超えて呼び出されなかった場合は遅延とみなす
+        if( INTERVAL * 2 > toPeriodNanoseconds( _recorder, PREV_RECORD.returnedSize ) * 3 ) {
+            lateCalls++;
+        }
+    }
+
+    printPercentiles(
+        "呼び出し間隔:"
+        , "ms"
+        , intervals
+        , 1e-6f
+    );
+    printPercentiles(
+        "実行時間:    "
+        , "us"
+        , elapsedTimes
+        , 1e-3f
+    );
+    printPercentiles(
+        "要求サイズ:  "
+        , "B"
+        , requestedSizes
+        , 1
+    );
+    printPercentiles(
+        "返却サイズ:  "
+        , "B"
+        , returnedSizes
+        , 1
+    );
+
+    std::printf( "アンダーラン: %u\n", underruns );
+    std::printf( "デッドライン超過: %u\n", overruns );
+    std::printf( "呼び出し遅延: %u\n", lateCalls );
+}
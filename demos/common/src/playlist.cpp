@@ -0,0 +1,631 @@
+﻿#include "playlist.h"
+#include "ringbuffer.h"
+#include "audiostream.h"
+#include "audiooutput.h"
+#include "realtimecheck.h"
+#include "gain.h"
+
+#include "dp/audio/audioformat.h"
+#include "dp/common/primitives.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // 待機中のトラックの上限
+    const auto  QUEUED_STREAMS = 2;
+
+    // 再生中1、クロスフェード中の次のトラック1、待機中QUEUED_STREAMS、返却前に生産者が新たに生成する1の合計
+    const auto  RETIRED_STREAMS = QUEUED_STREAMS + 3;
+
+    // 1回に重ねる波形データの上限
+    const auto  CROSSFADE_BUFFER_SIZE = 16384;
+
+    // ゲインが設定されていれば、バッファに書き込み済みの_sizeバイトにかける
+    void applyPlaylistGain(
+        Playlist &  _playlist
+        , void *    _buffer
+        , dp::ULong _size
+    )
+    {
+        if( _playlist.gainStage == nullptr ) {
+            return;
+        }
+
+        applyGain(
+            *( _playlist.gainStage )
+            , _playlist.audioFormat
+            , _playlist.channels
+            , _buffer
+            , _size / _playlist.frameSize
+        );
+    }
+
+    // トラックから最大_sizeバイトを読み出し、ゲインが設定されていれば同じ走査でかける
+    // リングバッファの折り返しがフレームの途中にある場合、そのフレームのみ組み立ててからかける
+    dp::ULong readStream(
+        Playlist &      _playlist
+        , AudioStream & _stream
+        , dp::Byte *    _buffer
+        , dp::ULong     _size
+    )
+    {
+        if( _playlist.gainStage == nullptr ) {
+            return _stream.ringBuffer.read(
+                _buffer
+                , _size
+            );
+        }
+
+        const auto  FRAME_SIZE = _playlist.frameSize;
+
+        std::size_t carrySize = 0;
+        return _stream.ringBuffer.read(
+            _buffer
+            , _size
+            , [
+                &_playlist
+                , FRAME_SIZE
+                , &carrySize
+            ]
+            (
+                dp::Byte *          _destination
+                , const dp::Byte *  _SOURCE
+                , std::size_t       _count
+            )
+            {
+                if( carrySize > 0 ) {
+                    const auto  REST_SIZE = std::min(
+                        FRAME_SIZE - carrySize
+                        , _count
+                    );
+                    std::memcpy(
+                        _destination
+                        , _SOURCE
+                        , REST_SIZE
+                    );
+                    _destination += REST_SIZE;
+                    _SOURCE += REST_SIZE;
+                    _count -= REST_SIZE;
+
+                    carrySize += REST_SIZE;
+                    if( carrySize >= FRAME_SIZE ) {
+                        applyPlaylistGain(
+                            _playlist
+                            , _destination - FRAME_SIZE
+                            , FRAME_SIZE
+                        );
+                        carrySize = 0;
+                    }
+                }
+
+                const auto  FRAMES = _count / FRAME_SIZE;
+                applyGain(
+                    *( _playlist.gainStage )
+                    , _playlist.audioFormat
+                    , _playlist.channels
+                    , _destination
+                    , _SOURCE
+                    , FRAMES
+                );
+
+                carrySize = _count - FRAMES * FRAME_SIZE;
+                std::memcpy(
+                    _destination + FRAMES * FRAME_SIZE
+                    , _SOURCE + FRAMES * FRAME_SIZE
+                    , carrySize
+                );
+            }
+        );
+    }
+
+    void retireStream(
+        Playlist &  _playlist
+    )
+    {
+        _playlist.retiredStreams.write(
+            &( _playlist.currentStream )
+            , 1
+        );
+        _playlist.currentStream = nullptr;
+        _playlist.crossfadingFrames = 0;
+    }
+
+    dp::Bool prepareNextStream(
+        Playlist &  _playlist
+    )
+    {
+        if( _playlist.nextStream == nullptr ) {
+            _playlist.queuedStreams.read(
+                &( _playlist.nextStream )
+                , 1
+            );
+        }
+
+        return _playlist.nextStream != nullptr;
+    }
+
+    // AudioStreamに読まずに残しておける最大のバイト数
+    // 生産者が書き込めなくならないよう、容量より1フレーム少ない分までとする
+    std::size_t getMaxHoldSize(
+        const Playlist &    _PLAYLIST
+        , AudioStream &     _stream
+    )
+    {
+        const auto  CAPACITY = _stream.ringBuffer.getCapacity();
+
+        return CAPACITY - CAPACITY % _PLAYLIST.frameSize - _PLAYLIST.frameSize;
+    }
+
+    // 生産者の書き込みが間に合っていない場合に呼び出す
+    // 実時間の制約がある出力先では残りを無音で埋めてアンダーランとして数え、trueを返す
+    // それ以外の出力先では生産者を待ち、falseを返す
+    dp::Bool waitProducer(
+        Playlist &      _playlist
+        , dp::Bool      _realtime
+        , dp::Byte *    _buffer
+        , dp::ULong     _size
+    )
+    {
+        if( _realtime == false ) {
+            waitAudioStreamProducer();
+
+            return false;
+        }
+
+        std::memset(
+            _buffer
+            , _playlist.silence
+            , _size
+        );
+        applyPlaylistGain(
+            _playlist
+            , _buffer
+            , _size
+        );
+
+        _playlist.underruns.fetch_add(
+            1
+            , std::memory_order_relaxed
+        );
+
+        return true;
+    }
+
+    // 再生中のトラックの残り_restSizeバイトと次のトラックを重ねる長さを決め、crossfadingFramesに設定する
+    // 次のトラックがない場合は重ねず、0のままとする
+    // 次のトラックの長さを判断できるだけのデータが届いていない場合はfalseを返す
+    dp::Bool decideCrossfade(
+        Playlist &      _playlist
+        , std::size_t   _restSize
+        , dp::UInt      _crossfadeFrames
+    )
+    {
+        const auto  PLAYLIST_ENDED = _playlist.ended.load( std::memory_order_acquire );
+        if( prepareNextStream( _playlist ) == false ) {
+            // 最後のトラックはそのまま読み込む
+            return PLAYLIST_ENDED;
+        }
+
+        auto &  nextStream = *( _playlist.nextStream );
+
+        // 重ねる長さは次のトラックの半分までのため、設定の2倍が届くか終端が確定すれば決められる
+        const auto  NEXT_ENDED = nextStream.ended.load( std::memory_order_acquire );
+        const auto  NEXT_SIZE = nextStream.ringBuffer.getReadableSize();
+        const auto  REQUIRED_SIZE = std::min(
+            static_cast< std::size_t >( _crossfadeFrames ) * _playlist.frameSize * 2
+            , getMaxHoldSize(
+                _playlist
+                , nextStream
+            )
+        );
+        if( NEXT_ENDED == false && NEXT_SIZE < REQUIRED_SIZE ) {
+            return false;
+        }
+
+        _playlist.crossfadingFrames = static_cast< dp::UInt >(
+            getPlaylistCrossfadeFrames(
+                _crossfadeFrames
+                , _restSize / _playlist.frameSize
+                , NEXT_SIZE / _playlist.frameSize
+            )
+        );
+
+        return true;
+    }
+
+    // 再生中のトラックの残り_restSizeバイトと次のトラックの先頭を重ね、書き込んだバイト数を返す
+    // 各トラックのゲインは残りフレーム数から求めるため、何回に分けて呼び出しても連続して変化する
+    // _crossfadeFramesはクロスフェードを始めた時点の残りフレーム数以上であること
+    dp::ULong crossfade(
+        Playlist &      _playlist
+        , std::size_t   _restSize
+        , dp::UInt      _crossfadeFrames
+        , dp::Byte *    _buffer
+        , dp::ULong     _bufferSize
+    )
+    {
+        auto &  currentStream = *( _playlist.currentStream );
+        auto &  nextStream = *( _playlist.nextStream );
+
+        const auto  NEXT_ENDED = nextStream.ended.load( std::memory_order_acquire );
+
+        std::size_t size = std::min(
+            static_cast< std::size_t >( _bufferSize )
+            , std::min(
+                _restSize
+                , _playlist.crossfadeBuffer.size()
+            )
+        );
+        if( NEXT_ENDED == false ) {
+            size = std::min(
+                size
+                , nextStream.ringBuffer.getReadableSize()
+            );
+        }
+        size -= size % _playlist.frameSize;
+        if( size <= 0 ) {
+            return 0;
+        }
+
+        currentStream.ringBuffer.read(
+            _buffer
+            , size
+        );
+
+        auto        crossfadeBuffer = _playlist.crossfadeBuffer.data();
+        const auto  NEXT_SIZE = nextStream.ringBuffer.read(
+            crossfadeBuffer
+            , size
+        );
+        std::memset(
+            crossfadeBuffer + NEXT_SIZE
+            , _playlist.silence
+            , size - NEXT_SIZE
+        );
+
+        const auto  FRAMES = size / _playlist.frameSize;
+        const auto  FADE_OUT_GAIN = static_cast< dp::Float >( _restSize / _playlist.frameSize ) / _crossfadeFrames;
+        const auto  STEP = 1.0f / _crossfadeFrames;
+
+        applyGainRamp(
+            _playlist.audioFormat
+            , _playlist.channels
+            , _buffer
+            , FRAMES
+            , FADE_OUT_GAIN
+            , -STEP
+        );
+        applyGainRamp(
+            _playlist.audioFormat
+            , _playlist.channels
+            , crossfadeBuffer
+            , FRAMES
+            , 1 - FADE_OUT_GAIN
+            , STEP
+        );
+        addAudio(
+            _playlist.audioFormat
+            , _buffer
+            , crossfadeBuffer
+            , FRAMES * _playlist.channels
+        );
+
+        return size;
+    }
+}
+
+Playlist::Playlist(
+    dp::AudioFormat _audioFormat
+    , dp::UInt      _frameSize
+)
+    : queuedStreams( QUEUED_STREAMS )
+    , retiredStreams( RETIRED_STREAMS )
+    , audioFormat( _audioFormat )
+    , channels( _frameSize / ( _audioFormat == dp::AudioFormat::U8 ? 1 : 2 ) )
+    , frameSize( _frameSize )
+    , silence( _audioFormat == dp::AudioFormat::U8 ? 0x80 : 0x00 )
+    , ended( false )
+    , underruns( 0 )
+    , finishedTracks( 0 )
+    , crossfadeFrames( 0 )
+    , gainStage( nullptr )
+    , currentStream( nullptr )
+    , nextStream( nullptr )
+    , crossfadingFrames( 0 )
+    , crossfadeBuffer( CROSSFADE_BUFFER_SIZE - CROSSFADE_BUFFER_SIZE % _frameSize )
+{
+}
+
+Playlist::~Playlist(
+)
+{
+    collectPlaylistStreams( *this );
+
+    AudioStream *   stream;
+    while( this->queuedStreams.read(
+        &stream
+        , 1
+    ) > 0 ) {
+        delete stream;
+    }
+
+    delete this->currentStream;
+    delete this->nextStream;
+}
+
+dp::Bool queuePlaylistStream(
+    Playlist &      _playlist
+    , AudioStream * _stream
+)
+{
+    return _playlist.queuedStreams.write(
+        &_stream
+        , 1
+    ) > 0;
+}
+
+void collectPlaylistStreams(
+    Playlist &  _playlist
+)
+{
+    AudioStream *   stream;
+    while( _playlist.retiredStreams.read(
+        &stream
+        , 1
+    ) > 0 ) {
+        delete stream;
+    }
+}
+
+void endPlaylist(
+    Playlist &  _playlist
+)
+{
+    _playlist.ended.store(
+        true
+        , std::memory_order_release
+    );
+}
+
+dp::ULong getPlaylistCrossfadeFrames(
+    dp::UInt    _crossfadeFrames
+    , dp::ULong _restFrames
+    , dp::ULong _nextFrames
+)
+{
+    return std::min(
+        static_cast< dp::ULong >( _crossfadeFrames )
+        , std::min(
+            _restFrames
+            , _nextFrames / 2
+        )
+    );
+}
+
+dp::ULong readPlaylist(
+    Playlist &              _playlist
+    , const AudioOutput &   _OUTPUT
+    , void *                _buffer
+    , dp::ULong             _bufferSize
+)
+{
+    auto    buffer = static_cast< dp::Byte * >( _buffer );
+
+    _bufferSize -= _bufferSize % _playlist.frameSize;
+
+    const auto  REALTIME = isRealtimeAudioOutput( _OUTPUT.type );
+
+    dp::ULong   size = 0;
+    while( size < _bufferSize ) {
+        if( _playlist.currentStream == nullptr && _playlist.nextStream != nullptr ) {
+            _playlist.currentStream = _playlist.nextStream;
+            _playlist.nextStream = nullptr;
+        }
+
+        if( _playlist.currentStream == nullptr ) {
+            const auto  ENDED = _playlist.ended.load( std::memory_order_acquire );
+
+            if( _playlist.queuedStreams.read(
+                &( _playlist.currentStream )
+                , 1
+            ) <= 0 ) {
+                if( ENDED ) {
+                    break;
+                }
+
+                // 次のトラックの準備が間に合っていない
+                if( waitProducer(
+                    _playlist
+                    , REALTIME
+                    , buffer + size
+                    , _bufferSize - size
+                ) ) {
+                    return _bufferSize;
+                }
+
+                continue;
+            }
+        }
+
+        auto &  stream = *( _playlist.currentStream );
+
+        const auto  ENDED = stream.ended.load( std::memory_order_acquire );
+
+        auto    readSize = _bufferSize - size;
+
+        // 終端が確定したトラックは、末尾の設定の長さを残して読み込んでから重ねる長さを決め、
+        // 残りがその長さに達した時点から次のトラックの先頭と重ねる
+        // 始まったクロスフェードは、途中で設定が変更されても同じ長さで続ける
+        const auto  CROSSFADE_FRAMES = _playlist.crossfadeFrames.load( std::memory_order_relaxed );
+        if( ENDED && ( CROSSFADE_FRAMES > 0 || _playlist.crossfadingFrames > 0 ) ) {
+            const auto  CROSSFADE_SIZE = static_cast< std::size_t >( CROSSFADE_FRAMES ) * _playlist.frameSize;
+            const auto  REST_SIZE = stream.ringBuffer.getReadableSize();
+
+            if( _playlist.crossfadingFrames <= 0 && REST_SIZE > CROSSFADE_SIZE ) {
+                readSize = std::min(
+                    readSize
+                    , static_cast< dp::ULong >( REST_SIZE - CROSSFADE_SIZE )
+                );
+            } else if( _playlist.crossfadingFrames <= 0 && REST_SIZE > 0 ) {
+                // 次のトラックの長さが判断できるまで届いていない
+                if( decideCrossfade(
+                    _playlist
+                    , REST_SIZE
+                    , CROSSFADE_FRAMES
+                ) == false ) {
+                    if( waitProducer(
+                        _playlist
+                        , REALTIME
+                        , buffer + size
+                        , _bufferSize - size
+                    ) ) {
+                        return _bufferSize;
+                    }
+
+                    continue;
+                }
+            }
+
+            const auto  CROSSFADING_SIZE = static_cast< std::size_t >( _playlist.crossfadingFrames ) * _playlist.frameSize;
+            if( REST_SIZE > CROSSFADING_SIZE ) {
+                readSize = std::min(
+                    readSize
+                    , static_cast< dp::ULong >( REST_SIZE - CROSSFADING_SIZE )
+                );
+            } else if( REST_SIZE > 0 ) {
+                const auto  CROSSFADED_SIZE = crossfade(
+                    _playlist
+                    , REST_SIZE
+                    , _playlist.crossfadingFrames
+                    , buffer + size
+                    , _bufferSize - size
+                );
+                if( CROSSFADED_SIZE > 0 ) {
+                    applyPlaylistGain(
+                        _playlist
+                        , buffer + size
+                        , CROSSFADED_SIZE
+                    );
+                    size += CROSSFADED_SIZE;
+
+                    continue;
+                }
+
+                // 次のトラックの先頭の準備が間に合っていない
+                if( waitProducer(
+                    _playlist
+                    , REALTIME
+                    , buffer + size
+                    , _bufferSize - size
+                ) ) {
+                    return _bufferSize;
+                }
+
+                continue;
+            }
+        }
+
+        // 終端が確定するまでは設定の長さを読まずに残し、生産者の速さによらず同じ長さで重ねる
+        // 生産者が書き込めなくならないよう、残すのはAudioStreamの容量より1フレーム少ない分までとする
+        if( ENDED == false && CROSSFADE_FRAMES > 0 ) {
+            const auto  HOLD_SIZE = std::min(
+                static_cast< std::size_t >( CROSSFADE_FRAMES ) * _playlist.frameSize
+                , getMaxHoldSize(
+                    _playlist
+                    , stream
+                )
+            );
+            const auto  READABLE_SIZE = stream.ringBuffer.getReadableSize();
+
+            readSize = READABLE_SIZE > HOLD_SIZE ? std::min(
+                readSize
+                , static_cast< dp::ULong >( READABLE_SIZE - HOLD_SIZE )
+            ) : 0;
+        }
+
+        size += readStream(
+            _playlist
+            , stream
+            , buffer + size
+            , readSize
+        );
+        if( size >= _bufferSize ) {
+            break;
+        }
+
+        if( ENDED ) {
+            if( stream.ringBuffer.getReadableSize() > 0 ) {
+                continue;
+            }
+
+            retireStream( _playlist );
+
+            _playlist.finishedTracks.fetch_add(
+                1
+                , std::memory_order_relaxed
+            );
+
+            continue;
+        }
+
+        if( waitProducer(
+            _playlist
+            , REALTIME
+            , buffer + size
+            , _bufferSize - size
+        ) ) {
+            return _bufferSize;
+        }
+    }
+
+    return size;
+}
+
+void setPlaylistCrossfade(
+    Playlist &  _playlist
+    , dp::UInt  _frames
+)
+{
+    _playlist.crossfadeFrames.store(
+        _frames
+        , std::memory_order_relaxed
+    );
+}
+
+void setPlaylistGainStage(
+    Playlist &      _playlist
+    , GainStage *   _gainStage
+)
+{
+    _playlist.gainStage = _gainStage;
+}
+
+void setPlaylistPlayEventHandler(
+    AudioOutputInfo &   _info
+    , Playlist &        _playlist
+)
+{
+    setPlayEventHandler(
+        _info
+        , [
+            &_playlist
+        ]
+        (
+            AudioOutput &       _output
+            , void *            _buffer
+            , dp::ULong         _bufferSize
+        ) -> dp::ULong
+        {
+            RealtimeScope   realtimeScope;
+
+            return readPlaylist(
+                _playlist
+                , _output
+                , _buffer
+                , _bufferSize
+            );
+        }
+    );
+}
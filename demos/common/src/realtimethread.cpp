@@ -0,0 +1,34 @@
+﻿#include "realtimethread.h"
+
+#include "dp/common/primitives.h"
+
+#if defined( _MSC_VER )
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+dp::Bool setCurrentThreadRealtime(
+)
+{
+#if defined( _MSC_VER )
+    return SetThreadPriority(
+        GetCurrentThread()
+        , THREAD_PRIORITY_TIME_CRITICAL
+    ) != 0;
+#else
+    // 他の実時間スレッドを妨げないよう、SCHED_FIFOの中位の優先度とする
+    const auto  MIN = sched_get_priority_min( SCHED_FIFO );
+    const auto  MAX = sched_get_priority_max( SCHED_FIFO );
+
+    sched_param param;
+    param.sched_priority = ( MIN + MAX ) / 2;
+
+    return pthread_setschedparam(
+        pthread_self()
+        , SCHED_FIFO
+        , &param
+    ) == 0;
+#endif
+}
@@ -0,0 +1,124 @@
+﻿#include "speaker.h"
+#include "audiooutput.h"
+
+#include "dp/common/primitives.h"
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+    void foundSpeakerKey(
+        SpeakerFinder &             _finder
+        , AudioOutputKeyUnique &    _foundKeyUnique
+    )
+    {
+        std::unique_lock< std::mutex >  lock( _finder.mutex );
+
+        if( _finder.keyUnique.get() != nullptr ) {
+            return;
+        }
+
+        _finder.keyUnique = std::move( _foundKeyUnique );
+        _finder.foundTime = std::chrono::steady_clock::now();
+
+        _finder.cond.notify_one();
+    }
+}
+
+SpeakerFinder * newSpeakerFinder(
+    const VirtualSpeakers & _VIRTUAL_SPEAKERS
+)
+{
+    std::unique_ptr< SpeakerFinder >    finderUnique( new SpeakerFinder );
+    auto &                              finder = *finderUnique;
+
+    finder.startTime = std::chrono::steady_clock::now();
+
+    AudioOutputManagerInfo  info;
+
+    for( const auto & SPEAKER : _VIRTUAL_SPEAKERS ) {
+        addVirtualSpeaker(
+            info
+            , SPEAKER
+        );
+    }
+
+    setConnectEventHandler(
+        info
+        , [
+            &finder
+        ]
+        (
+            AudioOutputManager &
+            , AudioOutputKeyUnique &&   _keyUnique
+            , dp::Bool                  _connected
+        )
+        {
+            if( _connected == false ) {
+                return;
+            }
+
+            foundSpeakerKey(
+                finder
+                , _keyUnique
+            );
+        }
+    );
+
+    finder.managerUnique.reset(
+        newAudioOutputManager(
+            info
+        )
+    );
+    if( finder.managerUnique.get() == nullptr ) {
+        return nullptr;
+    }
+
+    return finderUnique.release();
+}
+
+const AudioOutputKey * waitAudioOutputKey(
+    SpeakerFinder & _finder
+)
+{
+    std::unique_lock< std::mutex >  lock( _finder.mutex );
+
+    if( _finder.keyUnique.get() == nullptr ) {
+        std::printf( "スピーカーを検索中…\n" );
+    }
+
+    _finder.cond.wait_until(
+        lock
+        , _finder.startTime + std::chrono::seconds( 5 )
+        , [
+            &_finder
+        ]
+        {
+            return _finder.keyUnique.get() != nullptr;
+        }
+    );
+
+    return _finder.keyUnique.get();
+}
+
+AudioOutputKey * getAudioOutputKey(
+    const VirtualSpeakers & _VIRTUAL_SPEAKERS
+)
+{
+    std::unique_ptr< SpeakerFinder >    finderUnique( newSpeakerFinder( _VIRTUAL_SPEAKERS ) );
+    if( finderUnique.get() == nullptr ) {
+        return nullptr;
+    }
+    auto &  finder = *finderUnique;
+
+    if( waitAudioOutputKey( finder ) == nullptr ) {
+        return nullptr;
+    }
+
+    std::unique_lock< std::mutex >  lock( finder.mutex );
+
+    return finder.keyUnique.release();
+}
@@ -0,0 +1,239 @@
+﻿#include "taskpool.h"
+
+#include "dp/common/primitives.h"
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace {
+    dp::Bool popTask(
+        TaskWorker &    _worker
+        , Task &        _task
+    )
+    {
+        std::unique_lock< std::mutex >  lock( _worker.mutex );
+
+        if( _worker.tasks.empty() ) {
+            return false;
+        }
+
+        _task = std::move( _worker.tasks.back() );
+        _worker.tasks.pop_back();
+
+        return true;
+    }
+
+    dp::Bool stealTask(
+        TaskWorker &    _worker
+        , Task &        _task
+    )
+    {
+        std::unique_lock< std::mutex >  lock( _worker.mutex );
+
+        if( _worker.tasks.empty() ) {
+            return false;
+        }
+
+        _task = std::move( _worker.tasks.front() );
+        _worker.tasks.pop_front();
+
+        return true;
+    }
+
+    // 自分のキュー、他のワーカーのキューの順にタスクを探す
+    dp::Bool findTask(
+        TaskPool &  _pool
+        , dp::UInt  _workerIndex
+        , Task &    _task
+    )
+    {
+        auto &  worker = *( _pool.workers[ _workerIndex ] );
+
+        if( popTask(
+            worker
+            , _task
+        ) ) {
+            _pool.queuedTasks.fetch_sub( 1 );
+
+            return true;
+        }
+
+        const auto  WORKERS = static_cast< dp::UInt >( _pool.workers.size() );
+        for( dp::UInt i = 1 ; i < WORKERS ; i++ ) {
+            if( stealTask(
+                *( _pool.workers[ ( _workerIndex + i ) % WORKERS ] )
+                , _task
+            ) ) {
+                _pool.queuedTasks.fetch_sub( 1 );
+
+                worker.stolenTasks.fetch_add(
+                    1
+                    , std::memory_order_relaxed
+                );
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void runWorker(
+        TaskPool &  _pool
+        , dp::UInt  _workerIndex
+    )
+    {
+        auto &  worker = *( _pool.workers[ _workerIndex ] );
+
+        Task    task;
+        while( 1 ) {
+            if( findTask(
+                _pool
+                , _workerIndex
+                , task
+            ) ) {
+                task(
+                    _pool
+                    , _workerIndex
+                );
+                task = nullptr;
+
+                worker.executedTasks.fetch_add(
+                    1
+                    , std::memory_order_relaxed
+                );
+
+                if( _pool.pendingTasks.fetch_sub( 1 ) == 1 ) {
+                    std::unique_lock< std::mutex >  lock( _pool.mutex );
+
+                    _pool.idleCond.notify_all();
+                }
+
+                continue;
+            }
+
+            std::unique_lock< std::mutex >  lock( _pool.mutex );
+
+            // 他のワーカーが先に取り出した場合は、見つからずに再び待機する
+            _pool.taskCond.wait(
+                lock
+                , [
+                    &_pool
+                ]
+                {
+                    return _pool.stopped || _pool.queuedTasks.load() > 0;
+                }
+            );
+
+            if( _pool.stopped ) {
+                break;
+            }
+        }
+    }
+}
+
+TaskPool::~TaskPool(
+)
+{
+    {
+        std::unique_lock< std::mutex >  lock( this->mutex );
+
+        this->stopped = true;
+
+        this->taskCond.notify_all();
+    }
+
+    for( auto & thread : this->threads ) {
+        thread.join();
+    }
+}
+
+TaskPool * newTaskPool(
+    dp::UInt    _threads
+)
+{
+    if( _threads <= 0 ) {
+        _threads = std::thread::hardware_concurrency();
+    }
+    if( _threads <= 0 ) {
+        _threads = 1;
+    }
+
+    std::unique_ptr< TaskPool > poolUnique( new TaskPool );
+    auto &                      pool = *poolUnique;
+
+    pool.pendingTasks = 0;
+    pool.queuedTasks = 0;
+    pool.stopped = false;
+
+    for( dp::UInt i = 0 ; i < _threads ; i++ ) {
+        pool.workers.push_back( std::unique_ptr< TaskWorker >( new TaskWorker ) );
+    }
+
+    for( dp::UInt i = 0 ; i < _threads ; i++ ) {
+        pool.threads.push_back(
+            std::thread(
+                [
+                    &pool
+                    , i
+                ]
+                {
+                    runWorker(
+                        pool
+                        , i
+                    );
+                }
+            )
+        );
+    }
+
+    return poolUnique.release();
+}
+
+dp::UInt getWorkerCount(
+    const TaskPool &    _POOL
+)
+{
+    return static_cast< dp::UInt >( _POOL.workers.size() );
+}
+
+void pushTask(
+    TaskPool &      _pool
+    , dp::UInt      _workerIndex
+    , const Task &  _TASK
+)
+{
+    _pool.pendingTasks.fetch_add( 1 );
+
+    auto &  worker = *( _pool.workers[ _workerIndex % _pool.workers.size() ] );
+    {
+        std::unique_lock< std::mutex >  lock( worker.mutex );
+
+        worker.tasks.push_back( _TASK );
+    }
+    _pool.queuedTasks.fetch_add( 1 );
+
+    // 待機に入る直前のワーカーが通知を取りこぼさないよう、mutexを取って通知する
+    std::unique_lock< std::mutex >  lock( _pool.mutex );
+
+    _pool.taskCond.notify_one();
+}
+
+void waitTaskPool(
+    TaskPool &  _pool
+)
+{
+    std::unique_lock< std::mutex >  lock( _pool.mutex );
+
+    _pool.idleCond.wait(
+        lock
+        , [
+            &_pool
+        ]
+        {
+            return _pool.pendingTasks.load() <= 0;
+        }
+    );
+}
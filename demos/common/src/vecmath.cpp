@@ -0,0 +1,521 @@
+﻿#include "vecmath.h"
+#include "simd.h"
+
+#include "dp/common/primitives.h"
+
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+#if defined( USE_SSE2 )
+    void loadColumns(
+        __m128 ( & _columns )[ 4 ]
+        , const Mat4 &  _MATRIX
+    )
+    {
+        for( std::size_t i = 0 ; i < 4 ; i++ ) {
+            _columns[ i ] = _mm_loadu_ps( _MATRIX.elements + i * 4 );
+        }
+    }
+
+    // 左の行列の各列に、右の列の対応する要素を全レーンへ広げてかけ合わせる
+    __m128 multiplyColumn(
+        const __m128 ( & _LEFT )[ 4 ]
+        , __m128    _column
+    )
+    {
+        const auto  PRODUCT01 = _mm_add_ps(
+            _mm_mul_ps(
+                _LEFT[ 0 ]
+                , _mm_shuffle_ps( _column, _column, _MM_SHUFFLE( 0, 0, 0, 0 ) )
+            )
+            , _mm_mul_ps(
+                _LEFT[ 1 ]
+                , _mm_shuffle_ps( _column, _column, _MM_SHUFFLE( 1, 1, 1, 1 ) )
+            )
+        );
+        const auto  PRODUCT23 = _mm_add_ps(
+            _mm_mul_ps(
+                _LEFT[ 2 ]
+                , _mm_shuffle_ps( _column, _column, _MM_SHUFFLE( 2, 2, 2, 2 ) )
+            )
+            , _mm_mul_ps(
+                _LEFT[ 3 ]
+                , _mm_shuffle_ps( _column, _column, _MM_SHUFFLE( 3, 3, 3, 3 ) )
+            )
+        );
+
+        return _mm_add_ps(
+            PRODUCT01
+            , PRODUCT23
+        );
+    }
+#endif
+
+#if defined( USE_AVX )
+    // 左の行列の各列を、上下128bitの両方へ置く
+    void broadcastColumns(
+        __m256 ( & _columns )[ 4 ]
+        , const Mat4 &  _MATRIX
+    )
+    {
+        for( std::size_t i = 0 ; i < 4 ; i++ ) {
+            _columns[ i ] = _mm256_broadcast_ps( reinterpret_cast< const __m128 * >( _MATRIX.elements + i * 4 ) );
+        }
+    }
+
+    // 2列を同時に処理する
+    // _mm256_permute_ps()は128bitごとに並べ替えるため、上下の列それぞれの要素が広がる
+    __m256 multiplyColumns(
+        const __m256 ( & _LEFT )[ 4 ]
+        , __m256    _columns
+    )
+    {
+        const auto  PRODUCT01 = _mm256_add_ps(
+            _mm256_mul_ps(
+                _LEFT[ 0 ]
+                , _mm256_permute_ps( _columns, _MM_SHUFFLE( 0, 0, 0, 0 ) )
+            )
+            , _mm256_mul_ps(
+                _LEFT[ 1 ]
+                , _mm256_permute_ps( _columns, _MM_SHUFFLE( 1, 1, 1, 1 ) )
+            )
+        );
+        const auto  PRODUCT23 = _mm256_add_ps(
+            _mm256_mul_ps(
+                _LEFT[ 2 ]
+                , _mm256_permute_ps( _columns, _MM_SHUFFLE( 2, 2, 2, 2 ) )
+            )
+            , _mm256_mul_ps(
+                _LEFT[ 3 ]
+                , _mm256_permute_ps( _columns, _MM_SHUFFLE( 3, 3, 3, 3 ) )
+            )
+        );
+
+        return _mm256_add_ps(
+            PRODUCT01
+            , PRODUCT23
+        );
+    }
+#endif
+
+#if !defined( USE_SSE2 )
+    void multiplyColumn(
+        dp::Float *         _destination
+        , const Mat4 &      _LEFT
+        , const dp::Float * _COLUMN
+    )
+    {
+        for( std::size_t row = 0 ; row < 4 ; row++ ) {
+            const auto &    LEFT = _LEFT.elements;
+
+            _destination[ row ] =
+                LEFT[ row ] * _COLUMN[ 0 ] +
+                LEFT[ 4 + row ] * _COLUMN[ 1 ] +
+                LEFT[ 8 + row ] * _COLUMN[ 2 ] +
+                LEFT[ 12 + row ] * _COLUMN[ 3 ]
+            ;
+        }
+    }
+#endif
+}
+
+void setMat4Identity(
+    Mat4 &  _matrix
+)
+{
+    auto &  m = _matrix.elements;
+
+    std::fill(
+        std::begin( m )
+        , std::end( m )
+        , 0.0f
+    );
+
+    m[ 0 ] = 1;
+    m[ 5 ] = 1;
+    m[ 10 ] = 1;
+    m[ 15 ] = 1;
+}
+
+void setMat4Frustum(
+    Mat4 &          _matrix
+    , dp::Float     _left
+    , dp::Float     _right
+    , dp::Float     _bottom
+    , dp::Float     _top
+    , dp::Float     _near
+    , dp::Float     _far
+)
+{
+    auto &  m = _matrix.elements;
+
+    std::fill(
+        std::begin( m )
+        , std::end( m )
+        , 0.0f
+    );
+
+    m[ 0 ] = 2 * _near / ( _right - _left );
+    m[ 5 ] = 2 * _near / ( _top - _bottom );
+    m[ 8 ] = ( _right + _left ) / ( _right - _left );
+    m[ 9 ] = ( _top + _bottom ) / ( _top - _bottom );
+    m[ 10 ] = -( _far + _near ) / ( _far - _near );
+    m[ 11 ] = -1;
+    m[ 14 ] = -2 * _far * _near / ( _far - _near );
+}
+
+void setMat4Perspective(
+    Mat4 &          _matrix
+    , dp::Float     _fovY
+    , dp::Float     _aspect
+    , dp::Float     _near
+    , dp::Float     _far
+)
+{
+    const auto  TOP = _near * std::tan( _fovY / 2 );
+    const auto  RIGHT = TOP * _aspect;
+
+    setMat4Frustum(
+        _matrix
+        , -RIGHT
+        , RIGHT
+        , -TOP
+        , TOP
+        , _near
+        , _far
+    );
+}
+
+void setMat4Translation(
+    Mat4 &          _matrix
+    , dp::Float     _x
+    , dp::Float     _y
+    , dp::Float     _z
+)
+{
+    setMat4Identity( _matrix );
+
+    auto &  m = _matrix.elements;
+    m[ 12 ] = _x;
+    m[ 13 ] = _y;
+    m[ 14 ] = _z;
+}
+
+void setMat4Scale(
+    Mat4 &          _matrix
+    , dp::Float     _x
+    , dp::Float     _y
+    , dp::Float     _z
+)
+{
+    setMat4Identity( _matrix );
+
+    auto &  m = _matrix.elements;
+    m[ 0 ] = _x;
+    m[ 5 ] = _y;
+    m[ 10 ] = _z;
+}
+
+void setMat4Rotation(
+    Mat4 &          _matrix
+    , const Quat &  _QUAT
+)
+{
+    const auto  XX = _QUAT.x * _QUAT.x;
+    const auto  YY = _QUAT.y * _QUAT.y;
+    const auto  ZZ = _QUAT.z * _QUAT.z;
+    const auto  XY = _QUAT.x * _QUAT.y;
+    const auto  XZ = _QUAT.x * _QUAT.z;
+    const auto  YZ = _QUAT.y * _QUAT.z;
+    const auto  WX = _QUAT.w * _QUAT.x;
+    const auto  WY = _QUAT.w * _QUAT.y;
+    const auto  WZ = _QUAT.w * _QUAT.z;
+
+    auto &  m = _matrix.elements;
+
+    m[ 0 ] = 1 - 2 * ( YY + ZZ );
+    m[ 1 ] = 2 * ( XY + WZ );
+    m[ 2 ] = 2 * ( XZ - WY );
+    m[ 3 ] = 0;
+
+    m[ 4 ] = 2 * ( XY - WZ );
+    m[ 5 ] = 1 - 2 * ( XX + ZZ );
+    m[ 6 ] = 2 * ( YZ + WX );
+    m[ 7 ] = 0;
+
+    m[ 8 ] = 2 * ( XZ + WY );
+    m[ 9 ] = 2 * ( YZ - WX );
+    m[ 10 ] = 1 - 2 * ( XX + YY );
+    m[ 11 ] = 0;
+
+    m[ 12 ] = 0;
+    m[ 13 ] = 0;
+    m[ 14 ] = 0;
+    m[ 15 ] = 1;
+}
+
+void setQuatAxisAngle(
+    Quat &          _quat
+    , dp::Float     _axisX
+    , dp::Float     _axisY
+    , dp::Float     _axisZ
+    , dp::Float     _angle
+)
+{
+    const auto  SIN = std::sin( _angle / 2 );
+
+    _quat.x = _axisX * SIN;
+    _quat.y = _axisY * SIN;
+    _quat.z = _axisZ * SIN;
+    _quat.w = std::cos( _angle / 2 );
+}
+
+void multiplyQuat(
+    Quat &          _quat
+    , const Quat &  _LEFT
+    , const Quat &  _RIGHT
+)
+{
+    Quat    quat;
+    quat.x = _LEFT.w * _RIGHT.x + _LEFT.x * _RIGHT.w + _LEFT.y * _RIGHT.z - _LEFT.z * _RIGHT.y;
+    quat.y = _LEFT.w * _RIGHT.y - _LEFT.x * _RIGHT.z + _LEFT.y * _RIGHT.w + _LEFT.z * _RIGHT.x;
+    quat.z = _LEFT.w * _RIGHT.z + _LEFT.x * _RIGHT.y - _LEFT.y * _RIGHT.x + _LEFT.z * _RIGHT.w;
+    quat.w = _LEFT.w * _RIGHT.w - _LEFT.x * _RIGHT.x - _LEFT.y * _RIGHT.y - _LEFT.z * _RIGHT.z;
+
+    _quat = quat;
+}
+
+void normalizeQuat(
+    Quat &  _quat
+)
+{
+    const auto  LENGTH = std::sqrt( _quat.x * _quat.x + _quat.y * _quat.y + _quat.z * _quat.z + _quat.w * _quat.w );
+    if( LENGTH <= 0 ) {
+        _quat.x = 0;
+        _quat.y = 0;
+        _quat.z = 0;
+        _quat.w = 1;
+
+        return;
+    }
+
+    _quat.x /= LENGTH;
+    _quat.y /= LENGTH;
+    _quat.z /= LENGTH;
+    _quat.w /= LENGTH;
+}
+
+void multiplyMat4(
+    Mat4 &          _matrix
+    , const Mat4 &  _LEFT
+    , const Mat4 &  _RIGHT
+)
+{
+#if defined( USE_SSE2 )
+    // 書き込む前に両方を読み込むため、出力が入力と同じでもよい
+    __m128  left[ 4 ];
+    loadColumns(
+        left
+        , _LEFT
+    );
+
+    __m128  right[ 4 ];
+    loadColumns(
+        right
+        , _RIGHT
+    );
+
+    for( std::size_t i = 0 ; i < 4 ; i++ ) {
+        _mm_storeu_ps(
+            _matrix.elements + i * 4
+            , multiplyColumn(
+                left
+                , right[ i ]
+            )
+        );
+    }
+#else
+    Mat4    matrix;
+    for( std::size_t i = 0 ; i < 4 ; i++ ) {
+        multiplyColumn(
+            matrix.elements + i * 4
+            , _LEFT
+            , _RIGHT.elements + i * 4
+        );
+    }
+
+    _matrix = matrix;
+#endif
+}
+
+void transformVec4(
+    Vec4 &          _vector
+    , const Mat4 &  _MATRIX
+    , const Vec4 &  _VECTOR
+)
+{
+#if defined( USE_SSE2 )
+    __m128  columns[ 4 ];
+    loadColumns(
+        columns
+        , _MATRIX
+    );
+
+    _mm_storeu_ps(
+        _vector.elements
+        , multiplyColumn(
+            columns
+            , _mm_loadu_ps( _VECTOR.elements )
+        )
+    );
+#else
+    Vec4    vector;
+    multiplyColumn(
+        vector.elements
+        , _MATRIX
+        , _VECTOR.elements
+    );
+
+    _vector = vector;
+#endif
+}
+
+void multiplyMat4Array(
+    Mat4 *          _matrices
+    , const Mat4 &  _LEFT
+    , const Mat4 *  _RIGHTS
+    , std::size_t   _count
+)
+{
+#if defined( USE_AVX )
+    __m256  left[ 4 ];
+    broadcastColumns(
+        left
+        , _LEFT
+    );
+
+    for( std::size_t i = 0 ; i < _count ; i++ ) {
+        const auto  RIGHT = _RIGHTS[ i ].elements;
+        const auto  COLUMNS01 = _mm256_loadu_ps( RIGHT );
+        const auto  COLUMNS23 = _mm256_loadu_ps( RIGHT + 8 );
+
+        auto    matrix = _matrices[ i ].elements;
+        _mm256_storeu_ps(
+            matrix
+            , multiplyColumns(
+                left
+                , COLUMNS01
+            )
+        );
+        _mm256_storeu_ps(
+            matrix + 8
+            , multiplyColumns(
+                left
+                , COLUMNS23
+            )
+        );
+    }
+#elif defined( USE_SSE2 )
+    // 左の行列は全体で共通のため、一度だけ読み込む
+    __m128  left[ 4 ];
+    loadColumns(
+        left
+        , _LEFT
+    );
+
+    for( std::size_t i = 0 ; i < _count ; i++ ) {
+        __m128  right[ 4 ];
+        loadColumns(
+            right
+            , _RIGHTS[ i ]
+        );
+
+        auto    matrix = _matrices[ i ].elements;
+        for( std::size_t j = 0 ; j < 4 ; j++ ) {
+            _mm_storeu_ps(
+                matrix + j * 4
+                , multiplyColumn(
+                    left
+                    , right[ j ]
+                )
+            );
+        }
+    }
+#else
+    for( std::size_t i = 0 ; i < _count ; i++ ) {
+        multiplyMat4(
+            _matrices[ i ]
+            , _LEFT
+            , _RIGHTS[ i ]
+        );
+    }
+#endif
+}
+
+void transformVec4Array(
+    Vec4 *          _vectors
+    , const Mat4 &  _MATRIX
+    , const Vec4 *  _VECTORS
+    , std::size_t   _count
+)
+{
+    std::size_t i = 0;
+
+#if defined( USE_AVX )
+    // 2ベクトルを1列ずつとして同時に処理する
+    __m256  columns[ 4 ];
+    broadcastColumns(
+        columns
+        , _MATRIX
+    );
+
+    for( ; i + 2 <= _count ; i += 2 ) {
+        _mm256_storeu_ps(
+            _vectors[ i ].elements
+            , multiplyColumns(
+                columns
+                , _mm256_loadu_ps( _VECTORS[ i ].elements )
+            )
+        );
+    }
+#elif defined( USE_SSE2 )
+    __m128  columns[ 4 ];
+    loadColumns(
+        columns
+        , _MATRIX
+    );
+
+    for( ; i < _count ; i++ ) {
+        _mm_storeu_ps(
+            _vectors[ i ].elements
+            , multiplyColumn(
+                columns
+                , _mm_loadu_ps( _VECTORS[ i ].elements )
+            )
+        );
+    }
+#endif
+
+    for( ; i < _count ; i++ ) {
+        transformVec4(
+            _vectors[ i ]
+            , _MATRIX
+            , _VECTORS[ i ]
+        );
+    }
+}
+
+const char * getVecMathImplementation(
+)
+{
+#if defined( USE_AVX )
+    return "AVX";
+#elif defined( USE_SSE2 )
+    return "SSE2";
+#else
+    return "スカラー";
+#endif
+}
@@ -0,0 +1,1382 @@
+﻿#include "wav.h"
+#include "adpcm.h"
+
+#include "dp/audio/audioformat.h"
+#include "dp/file/filer.h"
+#include "dp/file/filerw.h"
+#include "dp/common/stringconverter.h"
+#include "dp/common/primitives.h"
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    struct RiffHeader
+    {
+        dp::Byte    magic[ 4 ];
+        dp::UInt    fileSize;
+    };
+
+    struct WavHeader
+    {
+        dp::Byte    magic[ 4 ];
+    };
+
+    struct RiffChunkHeader
+    {
+        dp::Byte    tag[ 4 ];
+        dp::UInt    size;
+    };
+
+    struct FmtChunk
+    {
+        dp::UShort  formatId;
+        dp::UShort  channels;
+        dp::UInt    sampleRate;
+        dp::UInt    bytesPerSec;
+        dp::UShort  blockSize;
+        dp::UShort  bitsPerSample;
+    };
+
+    // RF64のds64チャンクの内容
+    // 8バイト境界への詰め物が入らないよう、バイト列として読み書きする
+    const std::size_t   DS64_RIFF_SIZE_OFFSET = 0;
+    const std::size_t   DS64_DATA_SIZE_OFFSET = 8;
+    const std::size_t   DS64_SAMPLE_COUNT_OFFSET = 16;
+    const std::size_t   DS64_CHUNK_SIZE = 28;
+
+    const dp::Byte  MAGIC_RIFF[] = { 'R', 'I', 'F', 'F' };
+    const dp::Byte  MAGIC_RF64[] = { 'R', 'F', '6', '4' };
+    const dp::Byte  MAGIC_WAVE[] = { 'W', 'A', 'V', 'E' };
+
+    const dp::Byte  TAG_FMT[] = { 'f', 'm', 't', ' ' };
+    const dp::Byte  TAG_DATA[] = { 'd', 'a', 't', 'a' };
+    const dp::Byte  TAG_FACT[] = { 'f', 'a', 'c', 't' };
+    const dp::Byte  TAG_DS64[] = { 'd', 's', '6', '4' };
+    const dp::Byte  TAG_JUNK[] = { 'J', 'U', 'N', 'K' };
+
+    // RIFFのサイズ欄に収まらない場合はRF64として書き出す
+    const dp::ULong RIFF_SIZE_MAX = 0xffffffff;
+
+    // 書き込みはこのサイズ単位でまとめる
+    const std::size_t   WRITE_BUFFER_SIZE = 256 * 1024;
+
+    const dp::UShort    FORMAT_ID_LINEAR_PCM = 0x1;
+    const dp::UShort    FORMAT_ID_MS_ADPCM = 0x2;
+    const dp::UShort    FORMAT_ID_IMA_ADPCM = 0x11;
+
+    // ADPCMのfmtチャンクの拡張部分
+    const std::size_t   FMT_EXTENSION_OFFSET = 18;
+    const std::size_t   IMA_FMT_SIZE = FMT_EXTENSION_OFFSET + 2;
+    const std::size_t   MS_FMT_SIZE = FMT_EXTENSION_OFFSET + 4;
+
+    // fmtチャンクの拡張部分のサイズは2バイトのため、これより大きいfmtチャンクは不正とする
+    const std::size_t   FMT_CHUNK_SIZE_MAX = FMT_EXTENSION_OFFSET + 0xffff;
+
+    // ADPCMはこのブロック数ずつ読み込んで展開する
+    const std::size_t   ADPCM_READ_BLOCKS = 16;
+
+    // RF64の場合は_rf64にtrueを格納する
+    dp::Bool checkRiffHeader(
+        dp::FileR &     _file
+        , dp::Bool &    _rf64
+    )
+    {
+        RiffHeader  header;
+
+        const auto  HEADER_SIZE = sizeof( header );
+
+        dp::ULong   size = HEADER_SIZE;
+        if( dp::read(
+            _file
+            , &header
+            , size
+        ) == false ) {
+            std::printf( "RIFFヘッダ読み込み処理が失敗\n" );
+
+            return false;
+        }
+
+        if( size != HEADER_SIZE ) {
+            std::printf( "RIFFヘッダの読み込みに失敗\n" );
+
+            return false;
+        }
+
+        if( std::memcmp(
+            header.magic
+            , MAGIC_RIFF
+            , sizeof( header.magic )
+        ) == 0 ) {
+            _rf64 = false;
+        } else if( std::memcmp(
+            header.magic
+            , MAGIC_RF64
+            , sizeof( header.magic )
+        ) == 0 ) {
+            _rf64 = true;
+        } else {
+            std::printf( "RIFFヘッダの識別子が不一致\n" );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    dp::Bool checkWavHeader(
+        dp::FileR & _file
+    )
+    {
+        WavHeader   header;
+
+        const auto  HEADER_SIZE = sizeof( header );
+
+        dp::ULong   size = HEADER_SIZE;
+        if( dp::read(
+            _file
+            , &header
+            , size
+        ) == false ) {
+            std::printf( "WAVEヘッダ読み込み処理が失敗\n" );
+
+            return false;
+        }
+
+        if( size != HEADER_SIZE ) {
+            std::printf( "WAVEヘッダの読み込みに失敗\n" );
+
+            return false;
+        }
+
+        if( std::memcmp(
+            header.magic
+            , MAGIC_WAVE
+            , sizeof( header.magic )
+        ) != 0 ) {
+            std::printf( "WAVEヘッダの識別子が不一致\n" );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    dp::UInt findChunk(
+        dp::FileR &         _file
+        , const dp::Byte *  _TAG
+    )
+    {
+        RiffChunkHeader header;
+
+        const auto  HEADER_SIZE = sizeof( header );
+
+        dp::ULong   size = HEADER_SIZE;
+        while( 1 ) {
+            if( dp::read(
+                _file
+                , &header
+                , size
+            ) == false ) {
+                std::printf(
+                    "RIFFチャンクヘッダ[%.*s]読み込み処理が失敗\n"
+                    , static_cast< dp::Int >( sizeof( header.tag ) )
+                    , _TAG
+                );
+
+                return 0;
+            }
+
+            if( size != HEADER_SIZE ) {
+                std::printf(
+                    "RIFFチャンクヘッダ[%.*s]の読み込みに失敗\n"
+                    , static_cast< dp::Int >( sizeof( header.tag ) )
+                    , _TAG
+                );
+
+                return 0;
+            }
+
+            if( std::memcmp(
+                header.tag
+                , _TAG
+                , sizeof( header.tag )
+            ) == 0 ) {
+                break;
+            }
+
+            if( dp::movePosition(
+                _file
+                , header.size
+            ) == false ) {
+                std::printf( "次のRIFFチャンクヘッダへの移動に失敗\n" );
+
+                return 0;
+            }
+        }
+
+        return header.size;
+    }
+
+    dp::UShort toUShort(
+        const dp::Byte *    _DATA
+    )
+    {
+        return static_cast< dp::UShort >( _DATA[ 0 ] | ( _DATA[ 1 ] << 8 ) );
+    }
+
+    dp::ULong toULong(
+        const dp::Byte *    _DATA
+    )
+    {
+        dp::ULong   value = 0;
+        for( auto i = 0 ; i < 8 ; i++ ) {
+            value |= static_cast< dp::ULong >( _DATA[ i ] ) << ( i * 8 );
+        }
+
+        return value;
+    }
+
+    void fromULong(
+        dp::Byte *  _data
+        , dp::ULong _value
+    )
+    {
+        for( auto i = 0 ; i < 8 ; i++ ) {
+            _data[ i ] = static_cast< dp::Byte >( _value >> ( i * 8 ) );
+        }
+    }
+
+    // RF64のWAVEヘッダ直後にあるds64チャンクから、64bitの波形データサイズとフレーム数を取得する
+    dp::Bool readDs64Chunk(
+        dp::FileR &     _file
+        , dp::ULong &   _dataSize
+        , dp::ULong &   _sampleCount
+    )
+    {
+        RiffChunkHeader header;
+
+        dp::ULong   size = sizeof( header );
+        if( dp::read(
+            _file
+            , &header
+            , size
+        ) == false || size != sizeof( header ) ) {
+            std::printf( "ds64チャンクヘッダの読み込みに失敗\n" );
+
+            return false;
+        }
+
+        if( std::memcmp(
+            header.tag
+            , TAG_DS64
+            , sizeof( header.tag )
+        ) != 0 || header.size < DS64_CHUNK_SIZE ) {
+            std::printf( "ds64チャンクが不正\n" );
+
+            return false;
+        }
+
+        dp::Byte    chunk[ DS64_CHUNK_SIZE ];
+
+        size = sizeof( chunk );
+        if( dp::read(
+            _file
+            , chunk
+            , size
+        ) == false || size != sizeof( chunk ) ) {
+            std::printf( "ds64チャンクの読み込みに失敗\n" );
+
+            return false;
+        }
+
+        _dataSize = toULong( chunk + DS64_DATA_SIZE_OFFSET );
+        _sampleCount = toULong( chunk + DS64_SAMPLE_COUNT_OFFSET );
+
+        if( dp::movePosition(
+            _file
+            , header.size - DS64_CHUNK_SIZE
+        ) == false ) {
+            std::printf( "次のRIFFチャンクヘッダへの移動に失敗\n" );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // factチャンクのヘッダ直後から、展開後のフレーム数を読み込む
+    dp::Bool readFactSampleCount(
+        dp::FileR &     _file
+        , dp::ULong     _chunkSize
+        , dp::ULong     _ds64SampleCount
+        , dp::ULong &   _sampleCount
+    )
+    {
+        dp::UInt    sampleCount;
+
+        dp::ULong   size = sizeof( sampleCount );
+        if( _chunkSize < size || dp::read(
+            _file
+            , &sampleCount
+            , size
+        ) == false || size != sizeof( sampleCount ) ) {
+            std::printf( "factチャンクの読み込みに失敗\n" );
+
+            return false;
+        }
+
+        // RF64でサイズ欄に収まらない場合は、ds64チャンクの値を使う
+        _sampleCount = sampleCount == RIFF_SIZE_MAX && _ds64SampleCount > 0 ? _ds64SampleCount : sampleCount;
+
+        return true;
+    }
+
+    // dataチャンクより前にあるfactチャンクから、展開後のフレーム数を取得する
+    // factチャンクがない場合は_foundにfalseを格納する
+    dp::Bool readFactChunk(
+        dp::FileR &     _file
+        , dp::ULong     _ds64SampleCount
+        , dp::ULong &   _sampleCount
+        , dp::Bool &    _found
+    )
+    {
+        _found = false;
+
+        RiffChunkHeader header;
+        while( 1 ) {
+            dp::ULong   size = sizeof( header );
+            if( dp::read(
+                _file
+                , &header
+                , size
+            ) == false ) {
+                std::printf( "RIFFチャンクヘッダ読み込み処理が失敗\n" );
+
+                return false;
+            }
+
+            // dataチャンクがない場合は、この後のdataチャンクの検索で失敗させる
+            if( size != sizeof( header ) || std::memcmp(
+                header.tag
+                , TAG_DATA
+                , sizeof( header.tag )
+            ) == 0 ) {
+                return true;
+            }
+
+            if( std::memcmp(
+                header.tag
+                , TAG_FACT
+                , sizeof( header.tag )
+            ) == 0 ) {
+                break;
+            }
+
+            if( dp::movePosition(
+                _file
+                , header.size + header.size % 2
+            ) == false ) {
+                std::printf( "次のRIFFチャンクヘッダへの移動に失敗\n" );
+
+                return false;
+            }
+        }
+
+        if( readFactSampleCount(
+            _file
+            , header.size
+            , _ds64SampleCount
+            , _sampleCount
+        ) == false ) {
+            return false;
+        }
+        _found = true;
+
+        return true;
+    }
+
+    dp::Bool readAdpcmFmtChunk(
+        const FmtChunk &                    _FMT_CHUNK
+        , const std::vector< dp::Byte > &   _BUFFER
+        , AdpcmDecoder &                    _decoder
+    )
+    {
+        if( _FMT_CHUNK.bitsPerSample != 4 ) {
+            std::printf( "非対応のADPCMのビット数\n" );
+
+            return false;
+        }
+
+        if( _FMT_CHUNK.channels <= 0 || _FMT_CHUNK.channels > ADPCM_CHANNELS_MAX ) {
+            std::printf( "非対応のチャンネル数\n" );
+
+            return false;
+        }
+
+        _decoder.channels = _FMT_CHUNK.channels;
+        _decoder.blockSize = _FMT_CHUNK.blockSize;
+
+        if( _FMT_CHUNK.formatId == FORMAT_ID_IMA_ADPCM ) {
+            if( _BUFFER.size() < IMA_FMT_SIZE ) {
+                std::printf( "fmtチャンクのサイズが不足\n" );
+
+                return false;
+            }
+
+            _decoder.format = AdpcmFormat::IMA;
+            _decoder.samplesPerBlock = toUShort( _BUFFER.data() + FMT_EXTENSION_OFFSET );
+        } else {
+            if( _BUFFER.size() < MS_FMT_SIZE ) {
+                std::printf( "fmtチャンクのサイズが不足\n" );
+
+                return false;
+            }
+
+            _decoder.format = AdpcmFormat::MS;
+            _decoder.samplesPerBlock = toUShort( _BUFFER.data() + FMT_EXTENSION_OFFSET );
+
+            const std::size_t   COEFFICIENTS = toUShort( _BUFFER.data() + FMT_EXTENSION_OFFSET + 2 );
+            if( COEFFICIENTS <= 0 ) {
+                setDefaultMsAdpcmCoefficients( _decoder );
+            } else {
+                if( _BUFFER.size() < MS_FMT_SIZE + COEFFICIENTS * 4 ) {
+                    std::printf( "fmtチャンクのサイズが不足\n" );
+
+                    return false;
+                }
+
+                _decoder.coefficients.resize( COEFFICIENTS * 2 );
+                for( std::size_t i = 0 ; i < COEFFICIENTS * 2 ; i++ ) {
+                    _decoder.coefficients[ i ] = static_cast< std::int16_t >( toUShort( _BUFFER.data() + MS_FMT_SIZE + i * 2 ) );
+                }
+            }
+        }
+
+        // 1ブロックに収まらないフレーム数は不正とする
+        if( _decoder.samplesPerBlock <= 0 || getAdpcmBlockFrames(
+            _decoder
+            , _decoder.blockSize
+        ) != _decoder.samplesPerBlock ) {
+            std::printf( "ADPCMのブロックサイズが不正\n" );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    dp::Bool readFmtChunk(
+        dp::FileR &     _file
+        , WavReader &   _reader
+    )
+    {
+        const auto  CHUNK_SIZE = findChunk(
+            _file
+            , TAG_FMT
+        );
+        if( CHUNK_SIZE <= 0 ) {
+            return false;
+        }
+
+        if( CHUNK_SIZE < sizeof( FmtChunk ) ) {
+            std::printf( "fmtチャンクのサイズが不足\n" );
+
+            return false;
+        }
+
+        dp::ULong   size = CHUNK_SIZE;
+        std::vector< dp::Byte > buffer( CHUNK_SIZE );
+        if( dp::read(
+            _file
+            , buffer.data()
+            , size
+        ) == false ) {
+            std::printf( "fmtチャンク読み込み処理が失敗\n" );
+
+            return false;
+        }
+
+        if( size != CHUNK_SIZE ) {
+            std::printf( "fmtチャンクの読み込みに失敗\n" );
+
+            return false;
+        }
+
+        const auto &    FMT_CHUNK = *reinterpret_cast< FmtChunk * >( buffer.data() );
+
+        _reader.compressed = false;
+
+        switch( FMT_CHUNK.formatId ) {
+        case FORMAT_ID_LINEAR_PCM:
+            switch( FMT_CHUNK.bitsPerSample ) {
+            case 8:
+                _reader.audioFormat = dp::AudioFormat::U8;
+                break;
+
+            case 16:
+                _reader.audioFormat = dp::AudioFormat::S16LE;
+                break;
+
+            default:
+                std::printf( "非対応のフォーマット\n" );
+                return false;
+                break;
+            }
+            break;
+
+        case FORMAT_ID_IMA_ADPCM:
+        case FORMAT_ID_MS_ADPCM:
+            if( readAdpcmFmtChunk(
+                FMT_CHUNK
+                , buffer
+                , _reader.decoder
+            ) == false ) {
+                return false;
+            }
+
+            _reader.compressed = true;
+            _reader.audioFormat = dp::AudioFormat::S16LE;
+            break;
+
+        default:
+            std::printf( "非対応のフォーマットID\n" );
+
+            return false;
+        }
+
+        _reader.sampleRate = FMT_CHUNK.sampleRate;
+        _reader.channels = FMT_CHUNK.channels;
+
+        return true;
+    }
+
+    // _encodedDataSizeバイトのADPCMを展開した後のフレーム数を求める
+    dp::ULong toDecodedFrames(
+        const AdpcmDecoder &    _DECODER
+        , dp::ULong             _encodedDataSize
+    )
+    {
+        const auto  BLOCKS = _encodedDataSize / _DECODER.blockSize;
+        const auto  REST_SIZE = _encodedDataSize % _DECODER.blockSize;
+
+        return BLOCKS * _DECODER.samplesPerBlock + getAdpcmBlockFrames(
+            _DECODER
+            , REST_SIZE
+        );
+    }
+
+    // ADPCM_READ_BLOCKSブロック分を読み込んで展開する
+    dp::Bool decodeWavData(
+        WavReader & _reader
+    )
+    {
+        const auto  BLOCK_SIZE = _reader.decoder.blockSize;
+
+        dp::ULong   size = std::min(
+            static_cast< dp::ULong >( BLOCK_SIZE * ADPCM_READ_BLOCKS )
+            , _reader.encodedRestSize
+        );
+        const auto  SIZE = size;
+        if( dp::read(
+            *( _reader.fileUnique )
+            , _reader.encodedBuffer.data()
+            , size
+        ) == false ) {
+            std::printf( "波形データ読み込み処理が失敗\n" );
+
+            return false;
+        }
+
+        if( size != SIZE ) {
+            std::printf( "波形データの読み込みに失敗\n" );
+
+            return false;
+        }
+
+        _reader.encodedRestSize -= size;
+
+        std::size_t frames = 0;
+        for( std::size_t offset = 0 ; offset < size ; offset += BLOCK_SIZE ) {
+            const auto  BLOCK_FRAMES = decodeAdpcmBlock(
+                _reader.decoder
+                , _reader.encodedBuffer.data() + offset
+                , std::min(
+                    static_cast< std::size_t >( size - offset )
+                    , static_cast< std::size_t >( BLOCK_SIZE )
+                )
+                , _reader.decodedBuffer.data() + frames * _reader.channels
+            );
+            if( BLOCK_FRAMES <= 0 && offset + BLOCK_SIZE <= size ) {
+                std::printf( "ADPCMブロックの展開に失敗\n" );
+
+                return false;
+            }
+
+            frames += BLOCK_FRAMES;
+        }
+
+        _reader.decodedOffset = 0;
+        _reader.decodedSize = frames * _reader.frameSize;
+
+        return true;
+    }
+
+    dp::UInt toFrameSize(
+        dp::AudioFormat _audioFormat
+        , dp::UInt      _channels
+    )
+    {
+        switch( _audioFormat ) {
+        case dp::AudioFormat::U8:
+            return _channels;
+
+        case dp::AudioFormat::S16LE:
+            return _channels * 2;
+
+        default:
+            return 0;
+        }
+    }
+
+    dp::UInt toBitsPerSample(
+        dp::AudioFormat _audioFormat
+    )
+    {
+        switch( _audioFormat ) {
+        case dp::AudioFormat::U8:
+            return 8;
+
+        case dp::AudioFormat::S16LE:
+            return 16;
+
+        default:
+            return 0;
+        }
+    }
+
+    // ds64チャンクの領域をJUNKチャンクとして確保しておき、
+    // 閉じる時点でサイズがRIFFに収まらなければRF64のds64チャンクへ書き換える
+    struct WavFileHeader
+    {
+        RiffHeader      riffHeader;
+        WavHeader       wavHeader;
+        RiffChunkHeader ds64ChunkHeader;
+        dp::Byte        ds64Chunk[ DS64_CHUNK_SIZE ];
+        RiffChunkHeader fmtChunkHeader;
+        FmtChunk        fmtChunk;
+        RiffChunkHeader dataChunkHeader;
+    };
+
+    dp::Bool writeWavHeader(
+        WavWriter & _writer
+    )
+    {
+        WavFileHeader   header;
+
+        const auto  RIFF_SIZE = sizeof( header ) - sizeof( header.riffHeader ) + _writer.dataSize;
+        const auto  RF64 = RIFF_SIZE > RIFF_SIZE_MAX;
+
+        std::memcpy(
+            header.riffHeader.magic
+            , RF64 ? MAGIC_RF64 : MAGIC_RIFF
+            , sizeof( header.riffHeader.magic )
+        );
+        header.riffHeader.fileSize = static_cast< dp::UInt >( RF64 ? RIFF_SIZE_MAX : RIFF_SIZE );
+
+        std::memcpy(
+            header.wavHeader.magic
+            , MAGIC_WAVE
+            , sizeof( header.wavHeader.magic )
+        );
+
+        std::memcpy(
+            header.ds64ChunkHeader.tag
+            , RF64 ? TAG_DS64 : TAG_JUNK
+            , sizeof( header.ds64ChunkHeader.tag )
+        );
+        header.ds64ChunkHeader.size = DS64_CHUNK_SIZE;
+
+        std::memset(
+            header.ds64Chunk
+            , 0
+            , sizeof( header.ds64Chunk )
+        );
+        if( RF64 ) {
+            fromULong(
+                header.ds64Chunk + DS64_RIFF_SIZE_OFFSET
+                , RIFF_SIZE
+            );
+            fromULong(
+                header.ds64Chunk + DS64_DATA_SIZE_OFFSET
+                , _writer.dataSize
+            );
+            fromULong(
+                header.ds64Chunk + DS64_SAMPLE_COUNT_OFFSET
+                , _writer.dataSize / _writer.frameSize
+            );
+        }
+
+        std::memcpy(
+            header.fmtChunkHeader.tag
+            , TAG_FMT
+            , sizeof( header.fmtChunkHeader.tag )
+        );
+        header.fmtChunkHeader.size = sizeof( header.fmtChunk );
+
+        header.fmtChunk.formatId = FORMAT_ID_LINEAR_PCM;
+        header.fmtChunk.channels = static_cast< dp::UShort >( _writer.channels );
+        header.fmtChunk.sampleRate = _writer.sampleRate;
+        header.fmtChunk.bytesPerSec = _writer.sampleRate * _writer.frameSize;
+        header.fmtChunk.blockSize = static_cast< dp::UShort >( _writer.frameSize );
+        header.fmtChunk.bitsPerSample = static_cast< dp::UShort >( toBitsPerSample( _writer.audioFormat ) );
+
+        std::memcpy(
+            header.dataChunkHeader.tag
+            , TAG_DATA
+            , sizeof( header.dataChunkHeader.tag )
+        );
+        header.dataChunkHeader.size = static_cast< dp::UInt >( RF64 ? RIFF_SIZE_MAX : _writer.dataSize );
+
+        auto &  file = *( _writer.fileUnique );
+
+        if( dp::setPosition(
+            file
+            , 0
+        ) == false ) {
+            std::printf( "ファイルポインタの移動に失敗\n" );
+
+            return false;
+        }
+
+        dp::ULong   size = sizeof( header );
+        if( dp::write(
+            file
+            , &header
+            , size
+        ) == false || size != sizeof( header ) ) {
+            std::printf( "WAVヘッダの書き込みに失敗\n" );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    dp::Bool flushWavData(
+        WavWriter & _writer
+    )
+    {
+        if( _writer.bufferedSize <= 0 ) {
+            return true;
+        }
+
+        dp::ULong   size = _writer.bufferedSize;
+        if( dp::write(
+            *( _writer.fileUnique )
+            , _writer.writeBuffer.data()
+            , size
+        ) == false || size != _writer.bufferedSize ) {
+            std::printf( "波形データの書き込みに失敗\n" );
+
+            return false;
+        }
+
+        _writer.bufferedSize = 0;
+
+        return true;
+    }
+}
+
+dp::Bool openWav(
+    const dp::Utf32 &   _FILE_PATH
+    , WavReader &       _reader
+)
+{
+    _reader.fileUnique = dp::unique(
+        dp::newFileR(
+            _FILE_PATH
+        )
+    );
+    if( _reader.fileUnique.get() == nullptr ) {
+        std::printf( "ファイルのオープンに失敗\n" );
+
+        return false;
+    }
+    auto &  file = *( _reader.fileUnique );
+
+    dp::Bool    rf64;
+    if( checkRiffHeader(
+        file
+        , rf64
+    ) == false ) {
+        return false;
+    }
+
+    if( checkWavHeader(
+        file
+    ) == false ) {
+        return false;
+    }
+
+    dp::ULong   ds64DataSize = 0;
+    dp::ULong   ds64SampleCount = 0;
+    if( rf64 && readDs64Chunk(
+        file
+        , ds64DataSize
+        , ds64SampleCount
+    ) == false ) {
+        return false;
+    }
+
+    dp::Long    chunkHead;
+    if( dp::getPosition(
+        file
+        , chunkHead
+    ) == false ) {
+        std::printf( "ファイルポインタの現在位置取得に失敗\n" );
+
+        return false;
+    }
+
+    if( readFmtChunk(
+        file
+        , _reader
+    ) == false ) {
+        return false;
+    }
+
+    _reader.frameSize = toFrameSize(
+        _reader.audioFormat
+        , _reader.channels
+    );
+    if( _reader.frameSize <= 0 ) {
+        std::printf( "非対応のチャンネル数\n" );
+
+        return false;
+    }
+
+    if( dp::setPosition(
+        file
+        , chunkHead
+    ) == false ) {
+        std::printf( "ファイルポインタの移動に失敗\n" );
+
+        return false;
+    }
+
+    // ADPCMの最後のブロックは途中までしか使われないことがあるため、factチャンクのフレーム数で切り詰める
+    dp::ULong   factFrames = 0;
+    dp::Bool    factFound = false;
+    if( _reader.compressed ) {
+        if( readFactChunk(
+            file
+            , ds64SampleCount
+            , factFrames
+            , factFound
+        ) == false ) {
+            return false;
+        }
+
+        if( dp::setPosition(
+            file
+            , chunkHead
+        ) == false ) {
+            std::printf( "ファイルポインタの移動に失敗\n" );
+
+            return false;
+        }
+    }
+
+    dp::ULong   chunkSize = findChunk(
+        file
+        , TAG_DATA
+    );
+    if( chunkSize <= 0 ) {
+        return false;
+    }
+    if( rf64 && chunkSize == RIFF_SIZE_MAX ) {
+        chunkSize = ds64DataSize;
+    }
+    const auto  CHUNK_SIZE = chunkSize;
+
+    dp::Long    dataOffset;
+    if( dp::getPosition(
+        file
+        , dataOffset
+    ) == false ) {
+        std::printf( "ファイルポインタの現在位置取得に失敗\n" );
+
+        return false;
+    }
+    _reader.dataOffset = dataOffset;
+
+    if( _reader.compressed ) {
+        _reader.encodedDataSize = CHUNK_SIZE;
+        _reader.encodedRestSize = CHUNK_SIZE;
+
+        _reader.dataSize = toDecodedFrames(
+            _reader.decoder
+            , _reader.encodedDataSize
+        ) * _reader.frameSize;
+        if( factFound ) {
+            _reader.dataSize = std::min(
+                _reader.dataSize
+                , factFrames * _reader.frameSize
+            );
+        }
+
+        _reader.encodedBuffer.resize( _reader.decoder.blockSize * ADPCM_READ_BLOCKS );
+        _reader.decodedBuffer.resize( _reader.decoder.samplesPerBlock * ADPCM_READ_BLOCKS * _reader.channels );
+        _reader.decodedOffset = 0;
+        _reader.decodedSize = 0;
+    } else {
+        // 末尾の端数フレームは再生対象外とする
+        _reader.dataSize = CHUNK_SIZE - CHUNK_SIZE % _reader.frameSize;
+        _reader.encodedDataSize = _reader.dataSize;
+    }
+    _reader.restSize = _reader.dataSize;
+
+    return true;
+}
+
+dp::Bool seekWav(
+    WavReader &     _reader
+    , dp::ULong     _frame
+)
+{
+    const auto  FRAMES = _reader.dataSize / _reader.frameSize;
+    if( _frame > FRAMES ) {
+        _frame = FRAMES;
+    }
+
+    if( _reader.compressed == false ) {
+        const auto  OFFSET = _frame * _reader.frameSize;
+
+        if( dp::setPosition(
+            *( _reader.fileUnique )
+            , _reader.dataOffset + OFFSET
+        ) == false ) {
+            std::printf( "ファイルポインタの移動に失敗\n" );
+
+            return false;
+        }
+
+        _reader.restSize = _reader.dataSize - OFFSET;
+
+        return true;
+    }
+
+    const auto  BLOCK_SIZE = static_cast< dp::ULong >( _reader.decoder.blockSize );
+    const auto  BLOCK_FRAMES = static_cast< dp::ULong >( _reader.decoder.samplesPerBlock );
+    const auto  BLOCK_INDEX = _frame / BLOCK_FRAMES;
+    const auto  ENCODED_OFFSET = std::min(
+        BLOCK_INDEX * BLOCK_SIZE
+        , _reader.encodedDataSize
+    );
+
+    if( dp::setPosition(
+        *( _reader.fileUnique )
+        , _reader.dataOffset + ENCODED_OFFSET
+    ) == false ) {
+        std::printf( "ファイルポインタの移動に失敗\n" );
+
+        return false;
+    }
+
+    _reader.encodedRestSize = _reader.encodedDataSize - ENCODED_OFFSET;
+    _reader.decodedOffset = 0;
+    _reader.decodedSize = 0;
+    _reader.restSize = _reader.dataSize - std::min(
+        BLOCK_INDEX * BLOCK_FRAMES * _reader.frameSize
+        , _reader.dataSize
+    );
+
+    const auto  SKIP_SIZE = std::min(
+        ( _frame - BLOCK_INDEX * BLOCK_FRAMES ) * _reader.frameSize
+        , _reader.restSize
+    );
+    if( SKIP_SIZE <= 0 ) {
+        return true;
+    }
+
+    if( decodeWavData( _reader ) == false ) {
+        return false;
+    }
+
+    _reader.decodedOffset = std::min(
+        static_cast< std::size_t >( SKIP_SIZE )
+        , _reader.decodedSize
+    );
+    _reader.restSize -= _reader.decodedOffset;
+
+    return true;
+}
+
+dp::Bool scanWav(
+    const dp::Utf32 &   _FILE_PATH
+    , WavScanInfo &     _info
+)
+{
+    auto    fileUnique = dp::unique(
+        dp::newFileR(
+            _FILE_PATH
+        )
+    );
+    if( fileUnique.get() == nullptr ) {
+        std::printf( "ファイルのオープンに失敗\n" );
+
+        return false;
+    }
+    auto &  file = *fileUnique;
+
+    dp::Bool    rf64;
+    if( checkRiffHeader(
+        file
+        , rf64
+    ) == false ) {
+        return false;
+    }
+
+    if( checkWavHeader(
+        file
+    ) == false ) {
+        return false;
+    }
+
+    dp::ULong   ds64DataSize = 0;
+    dp::ULong   ds64SampleCount = 0;
+    if( rf64 && readDs64Chunk(
+        file
+        , ds64DataSize
+        , ds64SampleCount
+    ) == false ) {
+        return false;
+    }
+
+    // ds64チャンクも列挙するため、先頭のチャンクから辿り直す
+    const dp::Long  FIRST_CHUNK_OFFSET = sizeof( RiffHeader ) + sizeof( WavHeader );
+    if( dp::setPosition(
+        file
+        , FIRST_CHUNK_OFFSET
+    ) == false ) {
+        std::printf( "ファイルポインタの移動に失敗\n" );
+
+        return false;
+    }
+
+    std::vector< dp::Byte > fmtBuffer;
+    dp::ULong               dataSize = 0;
+    dp::Bool                dataFound = false;
+    dp::ULong               factFrames = 0;
+    dp::Bool                factFound = false;
+
+    _info.chunks.clear();
+
+    dp::ULong   offset = FIRST_CHUNK_OFFSET;
+    while( 1 ) {
+        RiffChunkHeader header;
+
+        dp::ULong   size = sizeof( header );
+        if( dp::read(
+            file
+            , &header
+            , size
+        ) == false ) {
+            std::printf( "RIFFチャンクヘッダ読み込み処理が失敗\n" );
+
+            return false;
+        }
+
+        // 終端、または末尾の端数
+        if( size != sizeof( header ) ) {
+            break;
+        }
+
+        WavChunkInfo    chunk;
+        std::memcpy(
+            chunk.tag
+            , header.tag
+            , sizeof( chunk.tag )
+        );
+        chunk.offset = offset;
+        chunk.size = header.size;
+
+        if( std::memcmp(
+            header.tag
+            , TAG_FMT
+            , sizeof( header.tag )
+        ) == 0 && fmtBuffer.empty() ) {
+            if( chunk.size < sizeof( FmtChunk ) || chunk.size > FMT_CHUNK_SIZE_MAX ) {
+                std::printf( "fmtチャンクのサイズが不正\n" );
+
+                return false;
+            }
+
+            fmtBuffer.resize( chunk.size );
+
+            size = chunk.size;
+            if( dp::read(
+                file
+                , fmtBuffer.data()
+                , size
+            ) == false || size != chunk.size ) {
+                std::printf( "fmtチャンクの読み込みに失敗\n" );
+
+                return false;
+            }
+        } else if( std::memcmp(
+            header.tag
+            , TAG_FACT
+            , sizeof( header.tag )
+        ) == 0 ) {
+            if( readFactSampleCount(
+                file
+                , chunk.size
+                , ds64SampleCount
+                , factFrames
+            ) == false ) {
+                return false;
+            }
+            factFound = true;
+        } else if( std::memcmp(
+            header.tag
+            , TAG_DATA
+            , sizeof( header.tag )
+        ) == 0 ) {
+            // RF64のdataチャンクのサイズはds64チャンクにある
+            if( rf64 && header.size == RIFF_SIZE_MAX ) {
+                chunk.size = ds64DataSize;
+            }
+
+            dataSize = chunk.size;
+            dataFound = true;
+        }
+
+        _info.chunks.push_back( chunk );
+
+        // チャンクは2バイト境界に揃えられる
+        const auto  NEXT_OFFSET = offset + sizeof( header ) + chunk.size + chunk.size % 2;
+        if( dp::setPosition(
+            file
+            , NEXT_OFFSET
+        ) == false ) {
+            std::printf( "次のRIFFチャンクヘッダへの移動に失敗\n" );
+
+            return false;
+        }
+        offset = NEXT_OFFSET;
+    }
+
+    if( fmtBuffer.empty() ) {
+        std::printf( "fmtチャンクがない\n" );
+
+        return false;
+    }
+
+    if( dataFound == false ) {
+        std::printf( "dataチャンクがない\n" );
+
+        return false;
+    }
+
+    const auto &    FMT_CHUNK = *reinterpret_cast< const FmtChunk * >( fmtBuffer.data() );
+
+    _info.formatId = FMT_CHUNK.formatId;
+    _info.channels = FMT_CHUNK.channels;
+    _info.sampleRate = FMT_CHUNK.sampleRate;
+    _info.bitsPerSample = FMT_CHUNK.bitsPerSample;
+    _info.blockSize = FMT_CHUNK.blockSize;
+
+    // 圧縮形式はブロックサイズからフレーム数が決まらないため、factチャンクの値を優先する
+    // factチャンクのないADPCMは、ブロックごとのフレーム数から求める
+    if( factFound && FMT_CHUNK.formatId != FORMAT_ID_LINEAR_PCM ) {
+        _info.frames = factFrames;
+    } else if( FMT_CHUNK.formatId == FORMAT_ID_IMA_ADPCM || FMT_CHUNK.formatId == FORMAT_ID_MS_ADPCM ) {
+        AdpcmDecoder    decoder;
+        if( readAdpcmFmtChunk(
+            FMT_CHUNK
+            , fmtBuffer
+            , decoder
+        ) == false ) {
+            return false;
+        }
+
+        _info.frames = toDecodedFrames(
+            decoder
+            , dataSize
+        );
+    } else {
+        _info.frames = FMT_CHUNK.blockSize > 0 ? dataSize / FMT_CHUNK.blockSize : 0;
+    }
+
+    return true;
+}
+
+dp::Bool readWavData(
+    WavReader &     _reader
+    , void *        _buffer
+    , dp::ULong &   _size
+)
+{
+    if( _size > _reader.restSize ) {
+        _size = _reader.restSize;
+    }
+
+    if( _size <= 0 ) {
+        return true;
+    }
+
+    if( _reader.compressed ) {
+        auto        buffer = static_cast< dp::Byte * >( _buffer );
+        const auto  DECODED_BUFFER = reinterpret_cast< const dp::Byte * >( _reader.decodedBuffer.data() );
+
+        dp::ULong   size = 0;
+        while( size < _size ) {
+            if( _reader.decodedOffset >= _reader.decodedSize ) {
+                if( decodeWavData( _reader ) == false ) {
+                    return false;
+                }
+
+                if( _reader.decodedSize <= 0 ) {
+                    break;
+                }
+            }
+
+            const auto  COPY_SIZE = std::min(
+                static_cast< dp::ULong >( _reader.decodedSize - _reader.decodedOffset )
+                , _size - size
+            );
+
+            std::memcpy(
+                buffer + size
+                , DECODED_BUFFER + _reader.decodedOffset
+                , COPY_SIZE
+            );
+
+            _reader.decodedOffset += COPY_SIZE;
+            size += COPY_SIZE;
+        }
+
+        _size = size;
+        _reader.restSize -= size;
+
+        return true;
+    }
+
+    const auto  SIZE = _size;
+    if( dp::read(
+        *( _reader.fileUnique )
+        , _buffer
+        , _size
+    ) == false ) {
+        std::printf( "波形データ読み込み処理が失敗\n" );
+
+        return false;
+    }
+
+    if( _size != SIZE ) {
+        std::printf( "波形データの読み込みに失敗\n" );
+
+        return false;
+    }
+
+    _reader.restSize -= _size;
+
+    return true;
+}
+
+dp::Bool createWav(
+    const dp::Utf32 &   _FILE_PATH
+    , dp::AudioFormat   _audioFormat
+    , dp::UInt          _sampleRate
+    , dp::UInt          _channels
+    , WavWriter &       _writer
+)
+{
+    _writer.audioFormat = _audioFormat;
+    _writer.sampleRate = _sampleRate;
+    _writer.channels = _channels;
+    _writer.frameSize = toFrameSize(
+        _audioFormat
+        , _channels
+    );
+    _writer.dataSize = 0;
+    _writer.writeBuffer.resize( WRITE_BUFFER_SIZE );
+    _writer.bufferedSize = 0;
+
+    _writer.fileUnique = dp::unique(
+        dp::newFileWR(
+            _FILE_PATH
+        )
+    );
+    if( _writer.fileUnique.get() == nullptr ) {
+        std::printf( "ファイルの作成に失敗\n" );
+
+        return false;
+    }
+
+    // データサイズは確定していないため、closeWav()でヘッダを書き直す
+    return writeWavHeader( _writer );
+}
+
+dp::Bool writeWavData(
+    WavWriter &     _writer
+    , const void *  _DATA
+    , dp::ULong     _size
+)
+{
+    _writer.dataSize += _size;
+
+    auto    data = static_cast< const dp::Byte * >( _DATA );
+    while( _size > 0 ) {
+        // 溜めている分がなく、バッファ以上の大きさであれば直接書き込む
+        if( _writer.bufferedSize <= 0 && _size >= _writer.writeBuffer.size() ) {
+            const auto  SIZE = _size;
+            if( dp::write(
+                *( _writer.fileUnique )
+                , data
+                , _size
+            ) == false || _size != SIZE ) {
+                std::printf( "波形データの書き込みに失敗\n" );
+
+                return false;
+            }
+
+            break;
+        }
+
+        const auto  SIZE = std::min(
+            static_cast< std::size_t >( _size )
+            , _writer.writeBuffer.size() - _writer.bufferedSize
+        );
+        std::memcpy(
+            _writer.writeBuffer.data() + _writer.bufferedSize
+            , data
+            , SIZE
+        );
+        _writer.bufferedSize += SIZE;
+        data += SIZE;
+        _size -= SIZE;
+
+        if( _writer.bufferedSize >= _writer.writeBuffer.size() && flushWavData( _writer ) == false ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+dp::Bool closeWav(
+    WavWriter & _writer
+)
+{
+    const auto  RESULT = flushWavData( _writer ) && writeWavHeader( _writer );
+
+    _writer.fileUnique.reset();
+
+    return RESULT;
+}
@@ -5,16 +5,76 @@
 #include "dp/opengl/glcontext.h"
 #include "dp/opengl/gl.h"
 
+#include "glext.h"
+#include "offscreen.h"
+#include "frameprofiler.h"
+#include "frameclock.h"
+#include "triplebuffer.h"
+#include "glstatecache.h"
+#include "vecmath.h"
+#include "cube.h"
+#include "option.h"
+
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <functional>
+#include <memory>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdlib>
 #include <cstdio>
+#include <cmath>
 
 const auto  TITLE_STRING = "OpenGL simple";
 const auto  WIDTH = 100;
 const auto  HEIGHT = 100;
 
+const auto  DUMP_FILE_NAME_FORMAT = "opengl_simple_%06u.ppm";
+
+const auto  DEFAULT_FRAMES_PER_SECOND = 60;
+
+// 1秒あたりの回転角度
+const auto  ROTATE_X_SPEED = 30.0;
+const auto  ROTATE_Y_SPEED = 50.0;
+const auto  ROTATE_Z_SPEED = 70.0;
+
+const auto  BENCH_SECONDS = 1.0;
+
+// glFrustum()と同じ透視投影の範囲と、視点を下げる距離
+const auto  FRUSTUM_LEFT = -0.5f;
+const auto  FRUSTUM_RIGHT = 0.5f;
+const auto  FRUSTUM_BOTTOM = -0.5f;
+const auto  FRUSTUM_TOP = 0.5f;
+const auto  FRUSTUM_NEAR = 1.0f;
+const auto  FRUSTUM_FAR = 10.0f;
+const auto  VIEW_Z = -5.0f;
+
+const auto  PI = 3.14159265358979323846f;
+
+// フレームスレッドから描画スレッドへ受け渡す回転角度
+struct Rotation
+{
+    dp::Float   x;
+    dp::Float   y;
+    dp::Float   z;
+};
+
+// 頂点バッファへ格納する頂点
+// 頂点バッファと頂点配列オブジェクトによる描画
+// 最初の描画でGLコンテキストがカレントになってから生成し、以降は1回の呼び出しで描画する
+struct CubeGeometry
+{
+    dp::Bool    enabled;
+    dp::Bool    initialized;
+    dp::Bool    available;
+
+    GLExtProcs  procs;
+    GLExtUInt   buffer;
+    GLExtUInt   vertexArray;
+};
+
 dp::GLContext * newGLContext(
 )
 {
@@ -29,7 +89,9 @@ dp::GLContext * newGLContext(
     return dp::newGLContext( info );
 }
 
+// 行列はvecmathで求め、GLMatrixProcsで設定する
 dp::Bool loadGLProcs(
+    GLMatrixProcs & _matrixProcs
 )
 {
     const auto  GL_PROC_PTRS = {
@@ -38,11 +100,6 @@ dp::Bool loadGLProcs(
         dp::toGLProcPtr( dp::glClearColor ),
         dp::toGLProcPtr( dp::glViewport ),
         dp::toGLProcPtr( dp::glMatrixMode ),
-        dp::toGLProcPtr( dp::glLoadIdentity ),
-        dp::toGLProcPtr( dp::glFrustum ),
-        dp::toGLProcPtr( dp::glTranslatef ),
-        dp::toGLProcPtr( dp::glScalef ),
-        dp::toGLProcPtr( dp::glRotatef ),
         dp::toGLProcPtr( dp::glClear ),
         dp::toGLProcPtr( dp::glBegin ),
         dp::toGLProcPtr( dp::glEnd ),
@@ -50,60 +107,455 @@ dp::Bool loadGLProcs(
         dp::toGLProcPtr( dp::glVertex3f ),
     };
 
-    return dp::loadGLProcs( GL_PROC_PTRS );
+    return dp::loadGLProcs( GL_PROC_PTRS ) && loadGLMatrixProcs( _matrixProcs );
 }
 
-void rotate(
-    std::mutex &        _mutex
-    , const dp::Float & _ROTATE_X
-    , const dp::Float & _ROTATE_Y
-    , const dp::Float & _ROTATE_Z
+Mat4 toProjection(
 )
 {
-    dp::glLoadIdentity();
+    Mat4    frustum;
+    setMat4Frustum(
+        frustum
+        , FRUSTUM_LEFT
+        , FRUSTUM_RIGHT
+        , FRUSTUM_BOTTOM
+        , FRUSTUM_TOP
+        , FRUSTUM_NEAR
+        , FRUSTUM_FAR
+    );
 
-    dp::Float   rotateX;
-    dp::Float   rotateY;
-    dp::Float   rotateZ;
-    {
-        std::unique_lock< std::mutex >  lock( _mutex );
+    Mat4    view;
+    setMat4Translation(
+        view
+        , 0
+        , 0
+        , VIEW_Z
+    );
 
-        rotateX = _ROTATE_X;
-        rotateY = _ROTATE_Y;
-        rotateZ = _ROTATE_Z;
-    }
+    Mat4    projection;
+    multiplyMat4(
+        projection
+        , frustum
+        , view
+    );
+
+    return projection;
+}
 
-    dp::glRotatef(
-        rotateX
+// X軸、Y軸、Z軸の順にかけた回転行列を、モデルビュー行列として設定する
+void rotate(
+    const Rotation &        _ROTATION
+    , const GLMatrixProcs & _PROCS
+)
+{
+    const auto  TO_RADIANS = PI / 180;
+
+    Quat    rotationX;
+    setQuatAxisAngle(
+        rotationX
         , 1
         , 0
         , 0
+        , _ROTATION.x * TO_RADIANS
     );
 
-    dp::glRotatef(
-        rotateY
+    Quat    rotationY;
+    setQuatAxisAngle(
+        rotationY
         , 0
         , 1
         , 0
+        , _ROTATION.y * TO_RADIANS
     );
 
-    dp::glRotatef(
-        rotateZ
+    Quat    rotationZ;
+    setQuatAxisAngle(
+        rotationZ
         , 0
         , 0
         , 1
+        , _ROTATION.z * TO_RADIANS
+    );
+
+    Quat    rotation;
+    multiplyQuat(
+        rotation
+        , rotationY
+        , rotationZ
+    );
+    multiplyQuat(
+        rotation
+        , rotationX
+        , rotation
+    );
+
+    Mat4    matrix;
+    setMat4Rotation(
+        matrix
+        , rotation
+    );
+
+    _PROCS.loadMatrixf( matrix.elements );
+}
+
+// 回転は開始からの経過時間で決め、描画の頻度によらず同じ速さで回す
+Rotation toRotation(
+    double  _seconds
+)
+{
+    Rotation    rotation;
+    rotation.x = static_cast< dp::Float >( std::fmod( _seconds * ROTATE_X_SPEED, 360 ) );
+    rotation.y = static_cast< dp::Float >( std::fmod( _seconds * ROTATE_Y_SPEED, 360 ) );
+    rotation.z = static_cast< dp::Float >( std::fmod( _seconds * ROTATE_Z_SPEED, 360 ) );
+
+    return rotation;
+}
+
+void drawImmediate(
+)
+{
+    dp::glBegin( dp::GL_TRIANGLES );
+
+    for( const auto & VERTEX : CUBE_VERTICES ) {
+        dp::glColor3f(
+            VERTEX[ 0 ] >= 0 ? VERTEX[ 0 ] : 0
+            , VERTEX[ 1 ] >= 0 ? VERTEX[ 1 ] : 0
+            , VERTEX[ 2 ] >= 0 ? VERTEX[ 2 ] : 0
+        );
+
+        dp::glVertex3f(
+            VERTEX[ 0 ]
+            , VERTEX[ 1 ]
+            , VERTEX[ 2 ]
+        );
+    }
+
+    dp::glEnd();
+}
+
+// 頂点バッファを生成し、頂点配列オブジェクトへ頂点と色の配列を記録する
+dp::Bool initCubeGeometry(
+    CubeGeometry &  _geometry
+)
+{
+    auto &  procs = _geometry.procs;
+
+    if( loadGLExtProcs( procs ) == false ) {
+        return false;
+    }
+
+    CubeVertex  vertices[ CUBE_VERTEX_COUNT ];
+    setCubeVertices( vertices );
+
+    procs.genVertexArrays(
+        1
+        , &( _geometry.vertexArray )
+    );
+    procs.bindVertexArray( _geometry.vertexArray );
+
+    procs.genBuffers(
+        1
+        , &( _geometry.buffer )
+    );
+    procs.bindBuffer(
+        GLEXT_ARRAY_BUFFER
+        , _geometry.buffer
+    );
+    procs.bufferData(
+        GLEXT_ARRAY_BUFFER
+        , sizeof( vertices )
+        , vertices
+        , GLEXT_STATIC_DRAW
     );
+
+    // バッファオブジェクトをバインドした状態では、ポインタはバッファの先頭からのオフセットとなる
+    procs.enableClientState( GLEXT_VERTEX_ARRAY );
+    procs.vertexPointer(
+        3
+        , GLEXT_FLOAT
+        , sizeof( CubeVertex )
+        , reinterpret_cast< const void * >( offsetof( CubeVertex, position ) )
+    );
+    procs.enableClientState( GLEXT_COLOR_ARRAY );
+    procs.colorPointer(
+        3
+        , GLEXT_FLOAT
+        , sizeof( CubeVertex )
+        , reinterpret_cast< const void * >( offsetof( CubeVertex, color ) )
+    );
+
+    procs.bindVertexArray( 0 );
+    procs.bindBuffer(
+        GLEXT_ARRAY_BUFFER
+        , 0
+    );
+
+    return true;
 }
 
+void drawRetained(
+    CubeGeometry &  _geometry
+)
+{
+    if( _geometry.initialized == false ) {
+        _geometry.initialized = true;
+
+        _geometry.available = initCubeGeometry( _geometry );
+        if( _geometry.available == false ) {
+            std::printf( "頂点バッファが利用できないため、即時モードで描画する\n" );
+        }
+    }
+
+    if( _geometry.available == false ) {
+        drawImmediate();
+
+        return;
+    }
+
+    const auto &    PROCS = _geometry.procs;
+
+    PROCS.bindVertexArray( _geometry.vertexArray );
+    PROCS.drawArrays(
+        dp::GL_TRIANGLES
+        , 0
+        , static_cast< dp::GLsizei >( CUBE_VERTEX_COUNT )
+    );
+    PROCS.bindVertexArray( 0 );
+}
+
+// 毎フレームの描画に先立って、深度テストと投影行列を設定する
+// 状態はフレーム間で変わらないため、2フレーム目以降の呼び出しはキャッシュで省略される
+void beginPaint(
+    GLStateCache &          _stateCache
+    , const GLMatrixProcs & _MATRIX_PROCS
+)
+{
+    enableGLState(
+        _stateCache
+        , dp::GL_DEPTH_TEST
+    );
+    setGLDepthFunc(
+        _stateCache
+        , dp::GL_LEQUAL
+    );
+
+    setGLClearColor(
+        _stateCache
+        , 0
+        , 0
+        , 0
+        , 0
+    );
+
+    setGLProjection(
+        _stateCache
+        , _MATRIX_PROCS
+        , toProjection()
+    );
+
+    setGLMatrixMode(
+        _stateCache
+        , dp::GL_MODELVIEW
+    );
+}
+
+void paint(
+    const Rotation &        _ROTATION
+    , CubeGeometry &        _geometry
+    , const GLMatrixProcs & _MATRIX_PROCS
+)
+{
+    dp::glClear(
+        dp::GL_COLOR_BUFFER_BIT |
+        dp::GL_DEPTH_BUFFER_BIT
+    );
+
+    rotate(
+        _ROTATION
+        , _MATRIX_PROCS
+    );
+
+    if( _geometry.enabled ) {
+        drawRetained( _geometry );
+    } else {
+        drawImmediate();
+    }
+}
+
+void printFrameStats(
+    const CubeGeometry &    _GEOMETRY
+    , const GLStateCache &  _STATE_CACHE
+    , const FrameProfiler & _PROFILER
+)
+{
+    // 即時モードは頂点ごとのglColor3f()、glVertex3f()とglBegin()、glEnd()
+    // 頂点バッファはglBindVertexArray()2回とglDrawArrays()
+    const auto  CALLS = _GEOMETRY.available ? 3 : CUBE_VERTEX_COUNT * 2 + 2;
+
+    std::printf( "描画方法: %s\n", _GEOMETRY.available ? "頂点バッファ" : "即時モード" );
+    std::printf( "1フレームの描画のGL呼び出し回数: %u\n", static_cast< dp::UInt >( CALLS ) );
+
+    printGLStateCache( _STATE_CACHE );
+
+    printFrameProfiler( _PROFILER );
+}
+
+// 描画スレッドへの要求
+// 未処理の要求はまとめて扱い、描画は1回、サイズは最新のもののみ反映する
+struct RenderRequests
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+
+    dp::Bool    paint;
+    dp::Bool    size;
+    dp::Int     width;
+    dp::Int     height;
+    dp::Bool    ended;
+};
+
+// ウィンドウへの描画の集計
+// 描画するスレッドのみが更新し、ウィンドウと描画スレッドの終了後に参照する
+struct WindowRenderStats
+{
+    dp::ULong   frames;
+    dp::Long    bindNanoseconds;    // コンテキストのカレントへの設定と解除にかかった時間
+};
+
+dp::Long measureNanoseconds(
+    const std::function< void() > &   _PROC
+)
+{
+    const auto  BEGIN = std::chrono::steady_clock::now();
+
+    _PROC();
+
+    return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - BEGIN ).count();
+}
+
+void postRenderRequest(
+    RenderRequests &                                _requests
+    , const std::function< void( RenderRequests & ) > & _UPDATE
+)
+{
+    std::unique_lock< std::mutex >  lock( _requests.mutex );
+
+    _UPDATE( _requests );
+
+    _requests.cond.notify_one();
+}
+
+// コンテキストを生存期間の間カレントにしたまま、要求を受けて描画する
+// ウィンドウのイベントハンドラは要求を送るのみとし、GLの呼び出しはすべてこのスレッドで行う
+void renderThreadMain(
+    dp::Window &                    _window
+    , dp::GLContext &               _glContext
+    , RenderRequests &              _requests
+    , TripleBuffer< Rotation > &    _rotation
+    , CubeGeometry &                _geometry
+    , const GLMatrixProcs &         _MATRIX_PROCS
+    , GLStateCache &                _stateCache
+    , FrameProfiler &               _profiler
+    , WindowRenderStats &           _stats
+)
+{
+    _stats.bindNanoseconds += measureNanoseconds(
+        [
+            &_window
+            , &_glContext
+        ]
+        {
+            dp::glMakeCurrent(
+                _window
+                , _glContext
+                , true
+            );
+        }
+    );
+
+    while( true ) {
+        dp::Bool    paintRequested;
+        dp::Bool    sizeRequested;
+        dp::Int     width;
+        dp::Int     height;
+        {
+            std::unique_lock< std::mutex >  lock( _requests.mutex );
+
+            _requests.cond.wait(
+                lock
+                , [
+                    &_requests
+                ]
+                {
+                    return _requests.paint || _requests.size || _requests.ended;
+                }
+            );
+            if( _requests.ended ) {
+                break;
+            }
+
+            paintRequested = _requests.paint;
+            sizeRequested = _requests.size;
+            width = _requests.width;
+            height = _requests.height;
+
+            _requests.paint = false;
+            _requests.size = false;
+        }
+
+        if( sizeRequested ) {
+            dp::glViewport(
+                0
+                , 0
+                , width
+                , height
+            );
+        }
+
+        if( paintRequested ) {
+            beginProfiledFrame( _profiler );
+
+            beginPaint(
+                _stateCache
+                , _MATRIX_PROCS
+            );
+
+            paint(
+                _rotation.read()
+                , _geometry
+                , _MATRIX_PROCS
+            );
+
+            endProfiledFrame( _profiler );
+
+            dp::glSwapBuffers( _window );
+
+            _stats.frames++;
+        }
+    }
+
+    _stats.bindNanoseconds += measureNanoseconds(
+        []
+        {
+            dp::glMakeCurrent();
+        }
+    );
+}
+
+// _renderRequestsがnullptrの場合は、描画のたびにイベントハンドラでコンテキストをカレントにして描画する
+// nullptrでない場合は、イベントハンドラから描画スレッドへ要求を送る
 dp::Window * newWindow(
-    dp::GLContext &             _glContext
-    , std::mutex &              _mutexForEnded
-    , std::condition_variable & _condForEnded
-    , dp::Bool &                _ended
-    , std::mutex &              _mutexForRotate
-    , const dp::Float &         _ROTATE_X
-    , const dp::Float &         _ROTATE_Y
-    , const dp::Float &         _ROTATE_Z
+    dp::GLContext &                 _glContext
+    , std::mutex &                  _mutexForEnded
+    , std::condition_variable &     _condForEnded
+    , dp::Bool &                    _ended
+    , TripleBuffer< Rotation > &    _rotation
+    , CubeGeometry &                _geometry
+    , const GLMatrixProcs &         _MATRIX_PROCS
+    , GLStateCache &                _stateCache
+    , FrameProfiler &               _profiler
+    , RenderRequests *              _renderRequests
+    , WindowRenderStats &           _stats
 )
 {
     dp::Utf32   title;
@@ -143,190 +595,410 @@ dp::Window * newWindow(
         }
     );
 
-    dp::setBeginPaintEventHandler(
-        info
-        , [
-            &_glContext
-        ]
-        (
-            dp::Window &    _window
-        )
-        {
-            dp::glMakeCurrent(
-                _window
-                , _glContext
-                , true
-            );
+    if( _renderRequests != nullptr ) {
+        auto &  requests = *_renderRequests;
+
+        dp::setSizeEventHandler(
+            info
+            , [
+                &requests
+            ]
+            (
+                dp::Window &
+                , dp::Int       _width
+                , dp::Int       _height
+            )
+            {
+                postRenderRequest(
+                    requests
+                    , [
+                        _width
+                        , _height
+                    ]
+                    (
+                        RenderRequests &    _requests
+                    )
+                    {
+                        _requests.size = true;
+                        _requests.width = _width;
+                        _requests.height = _height;
+                    }
+                );
+            }
+        );
+
+        dp::setPaintEventHandler(
+            info
+            , [
+                &requests
+            ]
+            (
+                dp::Window &
+                , dp::Int
+                , dp::Int
+                , dp::Int
+                , dp::Int
+            )
+            {
+                postRenderRequest(
+                    requests
+                    , [](
+                        RenderRequests &    _requests
+                    )
+                    {
+                        _requests.paint = true;
+                    }
+                );
+            }
+        );
+    } else {
+        dp::setBeginPaintEventHandler(
+            info
+            , [
+                &_glContext
+                , &_stateCache
+                , &_MATRIX_PROCS
+                , &_profiler
+                , &_stats
+            ]
+            (
+                dp::Window &    _window
+            )
+            {
+                _stats.bindNanoseconds += measureNanoseconds(
+                    [
+                        &_window
+                        , &_glContext
+                    ]
+                    {
+                        dp::glMakeCurrent(
+                            _window
+                            , _glContext
+                            , true
+                        );
+                    }
+                );
 
-            dp::glEnable( dp::GL_DEPTH_TEST );
-            dp::glDepthFunc( dp::GL_LEQUAL );
+                // glSwapBuffers()は垂直同期を待つ場合があるため、計測はその手前までとする
+                beginProfiledFrame( _profiler );
 
-            dp::glClearColor(
-                0
-                , 0
-                , 0
-                , 0
-            );
+                beginPaint(
+                    _stateCache
+                    , _MATRIX_PROCS
+                );
+            }
+        );
+
+        dp::setEndPaintEventHandler(
+            info
+            , [
+                &_stats
+            ]
+            (
+                dp::Window &
+            )
+            {
+                _stats.bindNanoseconds += measureNanoseconds(
+                    []
+                    {
+                        dp::glMakeCurrent();
+                    }
+                );
+            }
+        );
+
+        dp::setSizeEventHandler(
+            info
+            , [](
+                dp::Window &
+                , dp::Int       _width
+                , dp::Int       _height
+            )
+            {
+                dp::glViewport(
+                    0
+                    , 0
+                    , _width
+                    , _height
+                );
+            }
+        );
+
+        dp::setPaintEventHandler(
+            info
+            , [
+                &_rotation
+                , &_geometry
+                , &_MATRIX_PROCS
+                , &_profiler
+                , &_stats
+            ]
+            (
+                dp::Window &    _window
+                , dp::Int
+                , dp::Int
+                , dp::Int
+                , dp::Int
+            )
+            {
+                // フレームスレッドの書き込みを待たず、書き込みの完了した最新の回転で描画する
+                paint(
+                    _rotation.read()
+                    , _geometry
+                    , _MATRIX_PROCS
+                );
 
-            dp::glMatrixMode( dp::GL_PROJECTION );
+                endProfiledFrame( _profiler );
 
-            dp::glLoadIdentity();
-            dp::glFrustum(
-                -0.5
-                , 0.5
-                , -0.5
-                , 0.5
-                , 1
-                , 10
-            );
-            dp::glTranslatef(
-                0
-                , 0
-                , -5
-            );
+                dp::glSwapBuffers( _window );
 
-            dp::glMatrixMode( dp::GL_MODELVIEW );
-        }
-    );
+                _stats.frames++;
+            }
+        );
+    }
 
-    dp::setEndPaintEventHandler(
+    return dp::newWindow(
         info
-        , [](
-            dp::Window &
-        )
-        {
-            dp::glMakeCurrent();
-        }
+        , title
+        , WIDTH
+        , HEIGHT
+        , dp::WindowFlags::UNRESIZABLE
     );
+}
 
-    dp::setSizeEventHandler(
-        info
-        , [](
-            dp::Window &
-            , dp::Int       _width
-            , dp::Int       _height
+// ウィンドウを使わず、_framesフレームを可能な限りの速度で描画する
+// 各フレームの時刻は_framesPerSecondのフレームレートで描画した場合の予定時刻とするため、書き出す画像は実行のたびに同じとなる
+// _dumpIntervalが0でなければ、そのフレーム数ごとに画像を書き出す
+dp::Bool renderOffscreen(
+    dp::UInt            _frames
+    , dp::UInt          _framesPerSecond
+    , dp::UInt          _dumpInterval
+    , CubeGeometry &    _geometry
+    , GLStateCache &    _stateCache
+    , FrameProfiler &   _profiler
+)
+{
+    std::unique_ptr< OffscreenGLContext >   contextUnique(
+        newOffscreenGLContext(
+            WIDTH
+            , HEIGHT
         )
-        {
-            dp::glViewport(
-                0
-                , 0
-                , _width
-                , _height
-            );
-        }
     );
+    if( contextUnique.get() == nullptr ) {
+        std::printf( "オフスクリーンのGLコンテキスト生成に失敗\n" );
 
-    dp::setPaintEventHandler(
-        info
-        , [
-            &_mutexForRotate
-            , &_ROTATE_X
-            , &_ROTATE_Y
-            , &_ROTATE_Z
-        ]
-        (
-            dp::Window &    _window
-            , dp::Int
-            , dp::Int
-            , dp::Int
-            , dp::Int
-        )
-        {
-            dp::glClear(
-                dp::GL_COLOR_BUFFER_BIT |
-                dp::GL_DEPTH_BUFFER_BIT
-            );
+        return false;
+    }
+    auto &  context = *contextUnique;
 
-            const dp::Int   VERTICES[][ 3 ] = {
-                { -1,  1,  1 },
-                { -1, -1,  1 },
-                {  1, -1,  1 },
+    // dp::gl*はカレントのコンテキストに対して呼び出されるため、ウィンドウの場合と同じく使用できる
+    GLMatrixProcs   matrixProcs;
+    if( loadGLProcs( matrixProcs ) == false ) {
+        std::printf( "GL関数のロードに失敗\n" );
 
-                { -1,  1,  1 },
-                {  1, -1,  1 },
-                {  1,  1,  1 },
+        return false;
+    }
 
+    dp::glViewport(
+        0
+        , 0
+        , WIDTH
+        , HEIGHT
+    );
 
-                { -1,  1, -1 },
-                { -1,  1,  1 },
-                {  1,  1,  1 },
+    auto    elapsed = std::chrono::steady_clock::duration::zero();
+    for( dp::UInt i = 0 ; i < _frames ; i++ ) {
+        const auto  BEGIN = std::chrono::steady_clock::now();
 
-                { -1,  1, -1 },
-                {  1,  1,  1 },
-                {  1,  1, -1 },
+        const auto  ROTATION = toRotation( static_cast< double >( i + 1 ) / _framesPerSecond );
 
+        beginProfiledFrame( _profiler );
 
-                { -1, -1, -1 },
-                { -1,  1, -1 },
-                {  1,  1, -1 },
+        beginPaint(
+            _stateCache
+            , matrixProcs
+        );
 
-                { -1, -1, -1 },
-                {  1,  1, -1 },
-                {  1, -1, -1 },
+        paint(
+            ROTATION
+            , _geometry
+            , matrixProcs
+        );
 
+        endProfiledFrame( _profiler );
 
-                { -1, -1,  1 },
-                { -1, -1, -1 },
-                {  1, -1, -1 },
+        finishOffscreenGLFrame( context );
 
-                { -1, -1,  1 },
-                {  1, -1, -1 },
-                {  1, -1,  1 },
+        elapsed += std::chrono::steady_clock::now() - BEGIN;
 
+        if( _dumpInterval > 0 && ( i + 1 ) % _dumpInterval == 0 ) {
+            char    fileName[ 32 ];
+            std::snprintf(
+                fileName
+                , sizeof( fileName )
+                , DUMP_FILE_NAME_FORMAT
+                , i + 1
+            );
 
-                {  1,  1,  1 },
-                {  1, -1,  1 },
-                {  1, -1, -1 },
+            dp::Utf32   filePath;
+            if( dp::toUtf32(
+                filePath
+                , fileName
+            ) == false ) {
+                std::printf( "ファイルパスの文字コード変換に失敗\n" );
 
-                {  1,  1,  1 },
-                {  1, -1, -1 },
-                {  1,  1, -1 },
+                return false;
+            }
 
+            if( writeOffscreenGLImage(
+                context
+                , filePath
+            ) == false ) {
+                return false;
+            }
+        }
+    }
 
-                { -1,  1, -1 },
-                { -1, -1, -1 },
-                { -1, -1,  1 },
+    const auto  SECONDS = std::chrono::duration_cast< std::chrono::duration< double > >( elapsed ).count();
 
-                { -1,  1, -1 },
-                { -1, -1,  1 },
-                { -1,  1,  1 },
-            };
+    // 画像の書き出しにかかった時間は含めない
+    std::printf( "オフスクリーン描画: %uフレーム %.3f秒 (%.1ffps)\n", _frames, SECONDS, _frames / SECONDS );
+    std::printf( "1フレームの描画完了までの時間: %.2fus\n", SECONDS * 1000000 / _frames );
 
-            rotate(
-                _mutexForRotate
-                , _ROTATE_X
-                , _ROTATE_Y
-                , _ROTATE_Z
-            );
+    return true;
+}
 
-            dp::glBegin( dp::GL_TRIANGLES );
+// 書き込みスレッドが回転を書き込み続ける間、呼び出し元のスレッドで_SECONDS秒間読み込み続ける
+// 書き込む回転はx、y、zを同じ値とし、読み込んだ回転で値が揃っていなければ不整合として数える
+template< typename WRITE, typename READ >
+void benchSharing(
+    const char *    _NAME
+    , double        _seconds
+    , const WRITE & _WRITE
+    , const READ &  _READ
+)
+{
+    std::atomic< dp::Bool > ended( false );
+    dp::ULong               writes = 0;
 
-            for( const auto & VERTEX : VERTICES ) {
-                dp::glColor3f(
-                    VERTEX[ 0 ] >= 0 ? VERTEX[ 0 ] : 0
-                    , VERTEX[ 1 ] >= 0 ? VERTEX[ 1 ] : 0
-                    , VERTEX[ 2 ] >= 0 ? VERTEX[ 2 ] : 0
-                );
+    std::thread writer(
+        [
+            &ended
+            , &writes
+            , &_WRITE
+        ]
+        {
+            while( ended.load( std::memory_order_relaxed ) == false ) {
+                // 浮動小数点数で正確に表せる範囲で値を巡回させる
+                const auto  VALUE = static_cast< dp::Float >( writes & 0xfffff );
 
-                dp::glVertex3f(
-                    VERTEX[ 0 ]
-                    , VERTEX[ 1 ]
-                    , VERTEX[ 2 ]
-                );
+                Rotation    rotation;
+                rotation.x = VALUE;
+                rotation.y = VALUE;
+                rotation.z = VALUE;
+
+                _WRITE( rotation );
+
+                writes++;
             }
+        }
+    );
 
-            dp::glEnd();
+    dp::ULong   reads = 0;
+    dp::ULong   updates = 0;
+    dp::ULong   tornReads = 0;
+    dp::Float   lastValue = -1;
 
-            dp::glSwapBuffers( _window );
+    const auto  BEGIN = std::chrono::steady_clock::now();
+    const auto  END = BEGIN + std::chrono::duration_cast< std::chrono::steady_clock::duration >( std::chrono::duration< double >( _seconds ) );
+    auto        now = BEGIN;
+    for( ; now < END ; now = std::chrono::steady_clock::now() ) {
+        const Rotation  ROTATION = _READ();
+
+        reads++;
+
+        if( ROTATION.x != ROTATION.y || ROTATION.x != ROTATION.z ) {
+            tornReads++;
+        }
+
+        if( ROTATION.x != lastValue ) {
+            updates++;
+
+            lastValue = ROTATION.x;
+        }
+    }
+
+    ended = true;
+    writer.join();
+
+    const auto  SECONDS = std::chrono::duration_cast< std::chrono::duration< double > >( now - BEGIN ).count();
+
+    std::printf( "%s\n", _NAME );
+    std::printf( "  書き込み: %12.1f回/秒\n", writes / SECONDS );
+    std::printf( "  読み込み: %12.1f回/秒 (新しい値 %.1f回/秒)\n", reads / SECONDS, updates / SECONDS );
+    std::printf( "  不整合: %llu回\n", tornReads );
+}
+
+// フレームスレッドから描画スレッドへの回転の受け渡しを、ミューテックスとトリプルバッファで比較する
+void benchRotationSharing(
+)
+{
+    if( std::thread::hardware_concurrency() < 2 ) {
+        std::printf( "CPUが1つのため、書き込みと読み込みは同時に実行されない\n" );
+    }
+
+    Rotation    initial;
+    initial.x = 0;
+    initial.y = 0;
+    initial.z = 0;
+
+    std::mutex  mutex;
+    Rotation    shared = initial;
+    benchSharing(
+        "std::mutex"
+        , BENCH_SECONDS
+        , [
+            &mutex
+            , &shared
+        ]
+        (
+            const Rotation &    _ROTATION
+        )
+        {
+            std::unique_lock< std::mutex >  lock( mutex );
+
+            shared = _ROTATION;
+        }
+        , [
+            &mutex
+            , &shared
+        ]
+        {
+            std::unique_lock< std::mutex >  lock( mutex );
+
+            return shared;
         }
     );
 
-    return dp::newWindow(
-        info
-        , title
-        , WIDTH
-        , HEIGHT
-        , dp::WindowFlags::UNRESIZABLE
+    TripleBuffer< Rotation >    tripleBuffer( initial );
+    benchSharing(
+        "TripleBuffer"
+        , BENCH_SECONDS
+        , [
+            &tripleBuffer
+        ]
+        (
+            const Rotation &    _ROTATION
+        )
+        {
+            tripleBuffer.write( _ROTATION );
+        }
+        , [
+            &tripleBuffer
+        ]
+        {
+            return tripleBuffer.read();
+        }
     );
 }
 
@@ -350,9 +1022,98 @@ void waitEnd(
 }
 
 dp::Int dpMain(
-    dp::Args &
+    dp::Args &  _args
 )
 {
+    CubeGeometry    geometry;
+    geometry.enabled = false;
+    geometry.initialized = false;
+    geometry.available = false;
+
+    dp::UInt    offscreenFrames = 0;
+    dp::UInt    dumpInterval = 0;
+    dp::UInt    framesPerSecond = DEFAULT_FRAMES_PER_SECOND;
+    dp::Bool    bench = false;
+    dp::Bool    renderThread = false;
+
+    for( std::size_t i = 1 ; i < _args.size() ; i++ ) {
+        dp::String  option;
+        dp::toString(
+            option
+            , _args[ i ]
+        );
+
+        dp::String  name;
+        dp::UInt    value;
+
+        if( option == "--vbo" ) {
+            geometry.enabled = true;
+        } else if( option == "--bench" ) {
+            bench = true;
+        } else if( option == "--render-thread" ) {
+            renderThread = true;
+        } else if( parseValueOption(
+            option
+            , name
+            , value
+        ) && name == "--offscreen" && value > 0 ) {
+            offscreenFrames = value;
+        } else if( parseValueOption(
+            option
+            , name
+            , value
+        ) && name == "--dump" ) {
+            dumpInterval = value;
+        } else if( parseValueOption(
+            option
+            , name
+            , value
+        ) && name == "--fps" && value > 0 ) {
+            framesPerSecond = value;
+        } else {
+            dp::String  command;
+            dp::toString(
+                command
+                , _args[ 0 ]
+            );
+
+            std::printf( "使い方: %s [--vbo] [--fps=フレームレート] [--render-thread] [--offscreen=フレーム数 [--dump=間隔]] [--bench]\n", command.c_str() );
+
+            return 1;
+        }
+    }
+
+    if( bench ) {
+        benchRotationSharing();
+
+        return 0;
+    }
+
+    // オフスクリーン描画とウィンドウのどちらか一方のコンテキストに対して使用する
+    GLStateCache    stateCache;
+    FrameProfiler   profiler;
+
+    if( offscreenFrames > 0 ) {
+        if( renderOffscreen(
+            offscreenFrames
+            , framesPerSecond
+            , dumpInterval
+            , geometry
+            , stateCache
+            , profiler
+        ) == false ) {
+            return 1;
+        }
+
+        printFrameStats(
+            geometry
+            , stateCache
+            , profiler
+        );
+
+        return 0;
+    }
+
     auto    glContextUnique = dp::unique( newGLContext() );
     if( glContextUnique.get() == nullptr ) {
         std::printf( "OpenGLコンテキスト生成に失敗\n" );
@@ -361,7 +1122,8 @@ dp::Int dpMain(
     }
     auto &  glContext = *glContextUnique;
 
-    if( loadGLProcs() == false ) {
+    GLMatrixProcs   matrixProcs;
+    if( loadGLProcs( matrixProcs ) == false ) {
         std::printf( "GL関数のロードに失敗\n" );
 
         return 1;
@@ -371,10 +1133,18 @@ dp::Int dpMain(
     std::condition_variable condForEnded;
     dp::Bool                ended = false;
 
-    std::mutex  mutexForRotate;
-    dp::Float   rotateX = 0;
-    dp::Float   rotateY = 0;
-    dp::Float   rotateZ = 0;
+    TripleBuffer< Rotation >    rotation( toRotation( 0 ) );
+
+    RenderRequests  renderRequests;
+    renderRequests.paint = false;
+    renderRequests.size = false;
+    renderRequests.ended = false;
+
+    WindowRenderStats   stats;
+    stats.frames = 0;
+    stats.bindNanoseconds = 0;
+
+    const auto  BEGIN = std::chrono::steady_clock::now();
 
     auto    windowUnique = dp::unique(
         newWindow(
@@ -382,10 +1152,13 @@ dp::Int dpMain(
             , mutexForEnded
             , condForEnded
             , ended
-            , mutexForRotate
-            , rotateX
-            , rotateY
-            , rotateZ
+            , rotation
+            , geometry
+            , matrixProcs
+            , stateCache
+            , profiler
+            , renderThread ? &renderRequests : nullptr
+            , stats
         )
     );
     if( windowUnique.get() == nullptr ) {
@@ -395,47 +1168,55 @@ dp::Int dpMain(
     }
     auto &  window = *windowUnique;
 
-    std::condition_variable condForRotate;
-    std::thread timerThread(
+    std::thread renderThreadUnique;
+    if( renderThread ) {
+        renderThreadUnique = std::thread(
+            [
+                &window
+                , &glContext
+                , &renderRequests
+                , &rotation
+                , &geometry
+                , &matrixProcs
+                , &stateCache
+                , &profiler
+                , &stats
+            ]
+            {
+                renderThreadMain(
+                    window
+                    , glContext
+                    , renderRequests
+                    , rotation
+                    , geometry
+                    , matrixProcs
+                    , stateCache
+                    , profiler
+                    , stats
+                );
+            }
+        );
+    }
+
+    // 描画要求はフレームの予定時刻ごとに送る
+    FrameClock  frameClock( framesPerSecond );
+    std::thread frameThread(
         [
             &ended
-            , &mutexForRotate
-            , &condForRotate
-            , &rotateX
-            , &rotateY
-            , &rotateZ
+            , &frameClock
+            , &rotation
             , &window
         ]
         {
             while( ended == false ) {
-                std::unique_lock< std::mutex >  lock( mutexForRotate );
-
-                rotateX += 0.03;
-                if( rotateX > 360 ) {
-                    rotateX -= 360;
-                }
-
-                rotateY += 0.05;
-                if( rotateY > 360 ) {
-                    rotateY -= 360;
-                }
-
-                rotateZ += 0.07;
-                if( rotateZ > 360 ) {
-                    rotateZ -= 360;
-                }
+                rotation.write( toRotation( waitNextFrame( frameClock ) ) );
 
                 dp::repaint(
                     window
                     , 0
                     , 0
-                    , 100
-                    , 100
-                );
-
-                condForRotate.wait_for(
-                    lock
-                    , std::chrono::milliseconds( 1 )
+                    , WIDTH
+                    , HEIGHT
                 );
             }
         }
@@ -447,7 +1228,41 @@ dp::Int dpMain(
         , ended
     );
 
-    timerThread.join();
+    frameThread.join();
+
+    if( renderThread ) {
+        postRenderRequest(
+            renderRequests
+            , [](
+                RenderRequests &    _requests
+            )
+            {
+                _requests.ended = true;
+            }
+        );
+
+        renderThreadUnique.join();
+    }
+
+    const auto  SECONDS = std::chrono::duration_cast< std::chrono::duration< double > >( std::chrono::steady_clock::now() - BEGIN ).count();
+
+    // 描画中のフレームがないよう、ウィンドウを破棄してから表示する
+    windowUnique.reset();
+
+    std::printf( "描画要求: %lluフレーム (%ufps) 遅れて飛ばしたフレーム: %llu\n", frameClock.frames - frameClock.skippedFrames, framesPerSecond, frameClock.skippedFrames );
+    std::printf( "描画: %lluフレーム %.3f秒 (%.1ffps)\n", stats.frames, SECONDS, stats.frames / SECONDS );
+    std::printf(
+        "コンテキストの切り替え(%s): 合計 %.1fus 1フレームあたり %.2fus\n"
+        , renderThread ? "描画スレッドで保持" : "描画ごと"
+        , stats.bindNanoseconds / 1000.0
+        , stats.frames > 0 ? stats.bindNanoseconds / 1000.0 / stats.frames : 0.0
+    );
+
+    printFrameStats(
+        geometry
+        , stateCache
+        , profiler
+    );
 
     return 0;
 }
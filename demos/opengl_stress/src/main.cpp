@@ -0,0 +1,1027 @@
+﻿#include "dp/cli.h"
+#include "dp/common/primitives.h"
+#include "dp/common/stringconverter.h"
+#include "dp/opengl/gl.h"
+
+#include "glext.h"
+#include "glprogram.h"
+#include "offscreen.h"
+#include "vecmath.h"
+#include "cube.h"
+#include "option.h"
+
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <iterator>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdio>
+
+const auto  WIDTH = 256;
+const auto  HEIGHT = 256;
+
+const auto  DEFAULT_FRAMES = 5;
+const auto  WARMUP_FRAMES = 1;
+
+const auto  RANDOM_SEED = 1;
+
+const dp::UInt  DEFAULT_CUBES[] = {
+    1000,
+    10000,
+    100000,
+    1000000,
+};
+
+// 立方体を並べる範囲の一辺の長さ
+const auto  FIELD_SIZE = 3.0f;
+
+// 並べる間隔に対する立方体の大きさ(中心から面まで)
+const auto  CUBE_SCALE = 0.35f;
+
+const auto  DUMP_FILE_NAME_FORMAT = "opengl_stress_%s_%u.ppm";
+
+// プログラムのキャッシュは作業ディレクトリへ保存する
+const auto  PROGRAM_CACHE_PREFIX = "opengl_stress_";
+
+// --math-benchで変換する行列とベクトルの個数
+const dp::UInt  MATH_BENCH_COUNT = 1000000;
+const auto      MATH_BENCH_REPEATS = 10;
+
+// インスタンスごとの変換行列は頂点属性1～4へ列ごとに渡す
+// 頂点属性0は固定機能の頂点座標と共有されるため使用しない
+const GLExtUInt     INSTANCE_ATTRIBUTE_LOCATION = 1;
+const std::size_t   INSTANCE_ATTRIBUTE_COUNT = 4;
+
+const auto  INSTANCED_VERTEX_SHADER =
+    "#version 120\n"
+    "attribute vec4 instanceColumn0;\n"
+    "attribute vec4 instanceColumn1;\n"
+    "attribute vec4 instanceColumn2;\n"
+    "attribute vec4 instanceColumn3;\n"
+    "void main()\n"
+    "{\n"
+    "    mat4 model = mat4( instanceColumn0, instanceColumn1, instanceColumn2, instanceColumn3 );\n"
+    "    gl_FrontColor = gl_Color;\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * ( model * gl_Vertex );\n"
+    "}\n"
+;
+
+const auto  INSTANCED_FRAGMENT_SHADER =
+    "#version 120\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = gl_Color;\n"
+    "}\n"
+;
+
+enum class DrawMode
+{
+    IMMEDIATE,      // 立方体ごとにglBegin()～glEnd()で頂点を送る
+    PER_OBJECT,     // 頂点バッファを共有し、立方体ごとに行列を設定してglDrawArrays()を呼び出す
+    INSTANCED,      // 変換行列をバッファへ並べ、1回のglDrawArraysInstanced()で描画する
+};
+
+const DrawMode  DRAW_MODES[] = {
+    DrawMode::IMMEDIATE,
+    DrawMode::PER_OBJECT,
+    DrawMode::INSTANCED,
+};
+
+typedef std::vector< Mat4 > InstanceMatrices;
+
+struct StressScene
+{
+    GLExtProcs      procs;
+    GLShaderProcs   shaderProcs;
+
+    InstanceMatrices    matrices;
+
+    GLExtUInt   vertexBuffer;
+    GLExtUInt   instanceBuffer;
+    GLExtUInt   perObjectVertexArray;
+    GLExtUInt   instancedVertexArray;
+    GLExtUInt   program;
+};
+
+struct DrawResult
+{
+    double      frameSeconds;   // 描画完了までの1フレームの平均時間
+    double      submitSeconds;  // GL呼び出しにかかった1フレームの平均CPU時間
+    dp::ULong   drawCalls;      // 1フレームの描画の呼び出し回数
+};
+
+const char * toString(
+    DrawMode    _mode
+)
+{
+    switch( _mode ) {
+    case DrawMode::IMMEDIATE:
+        return "immediate";
+
+    case DrawMode::PER_OBJECT:
+        return "perobject";
+
+    case DrawMode::INSTANCED:
+        return "instanced";
+
+    default:
+        return "";
+    }
+}
+
+dp::Bool loadGLProcs(
+)
+{
+    const auto  GL_PROC_PTRS = {
+        dp::toGLProcPtr( dp::glEnable ),
+        dp::toGLProcPtr( dp::glDepthFunc ),
+        dp::toGLProcPtr( dp::glClearColor ),
+        dp::toGLProcPtr( dp::glViewport ),
+        dp::toGLProcPtr( dp::glMatrixMode ),
+        dp::toGLProcPtr( dp::glLoadIdentity ),
+        dp::toGLProcPtr( dp::glFrustum ),
+        dp::toGLProcPtr( dp::glTranslatef ),
+        dp::toGLProcPtr( dp::glClear ),
+        dp::toGLProcPtr( dp::glBegin ),
+        dp::toGLProcPtr( dp::glEnd ),
+        dp::toGLProcPtr( dp::glColor3f ),
+        dp::toGLProcPtr( dp::glVertex3f ),
+    };
+
+    return dp::loadGLProcs( GL_PROC_PTRS );
+}
+
+// 立方体を格子状に並べ、それぞれ無作為な軸まわりに回転させる
+// 乱数の種は固定のため、描画結果は実行のたびに同じとなる
+void generateMatrices(
+    InstanceMatrices &  _matrices
+    , dp::UInt          _cubes
+)
+{
+    _matrices.resize( _cubes );
+
+    dp::UInt    side = 1;
+    while( side * side * side < _cubes ) {
+        side++;
+    }
+
+    const auto  SPACING = FIELD_SIZE / side;
+    const auto  SCALE = SPACING * CUBE_SCALE;
+    const auto  ORIGIN = ( SPACING - FIELD_SIZE ) / 2;
+
+    Mat4    scaleMatrix;
+    setMat4Scale(
+        scaleMatrix
+        , SCALE
+        , SCALE
+        , SCALE
+    );
+
+    std::mt19937                                random( RANDOM_SEED );
+    std::uniform_real_distribution< dp::Float > distribution(
+        -1
+        , 1
+    );
+
+    for( dp::UInt i = 0 ; i < _cubes ; i++ ) {
+        // 軸が0に近い場合はz軸とする
+        auto    axisX = distribution( random );
+        auto    axisY = distribution( random );
+        auto    axisZ = distribution( random );
+        const auto  LENGTH = std::sqrt( axisX * axisX + axisY * axisY + axisZ * axisZ );
+        if( LENGTH > 0.001f ) {
+            axisX /= LENGTH;
+            axisY /= LENGTH;
+            axisZ /= LENGTH;
+        } else {
+            axisX = 0;
+            axisY = 0;
+            axisZ = 1;
+        }
+
+        const auto  ANGLE = distribution( random ) * 3.14159265f;
+
+        Quat    rotation;
+        setQuatAxisAngle(
+            rotation
+            , axisX
+            , axisY
+            , axisZ
+            , ANGLE
+        );
+
+        Mat4    rotationMatrix;
+        setMat4Rotation(
+            rotationMatrix
+            , rotation
+        );
+
+        auto &  matrix = _matrices[ i ];
+        multiplyMat4(
+            matrix
+            , rotationMatrix
+            , scaleMatrix
+        );
+
+        // 平行移動
+        matrix.elements[ 12 ] = ORIGIN + SPACING * ( i % side );
+        matrix.elements[ 13 ] = ORIGIN + SPACING * ( i / side % side );
+        matrix.elements[ 14 ] = ORIGIN + SPACING * ( i / side / side );
+    }
+}
+
+// 頂点バッファを、立方体ごとの描画用とインスタンス描画用の頂点配列オブジェクトへ記録する
+// プログラムはキャッシュがあれば読み込み、_recompileがtrueの場合は常にコンパイルする
+dp::Bool initScene(
+    StressScene &   _scene
+    , dp::Bool      _recompile
+)
+{
+    auto &  procs = _scene.procs;
+    auto &  shaderProcs = _scene.shaderProcs;
+
+    if( loadGLExtProcs( procs ) == false ) {
+        std::printf( "頂点バッファの関数のロードに失敗\n" );
+
+        return false;
+    }
+
+    if( loadGLShaderProcs( shaderProcs ) == false ) {
+        std::printf( "シェーダーの関数のロードに失敗\n" );
+
+        return false;
+    }
+
+    GLAttributeLocations    attributeLocations;
+    const char * const      INSTANCE_ATTRIBUTE_NAMES[] = {
+        "instanceColumn0",
+        "instanceColumn1",
+        "instanceColumn2",
+        "instanceColumn3",
+    };
+    for( std::size_t i = 0 ; i < INSTANCE_ATTRIBUTE_COUNT ; i++ ) {
+        const GLAttributeLocation   ATTRIBUTE_LOCATION = {
+            static_cast< GLExtUInt >( INSTANCE_ATTRIBUTE_LOCATION + i ),
+            INSTANCE_ATTRIBUTE_NAMES[ i ],
+        };
+
+        attributeLocations.push_back( ATTRIBUTE_LOCATION );
+    }
+
+    const auto  PROGRAM_BEGIN = std::chrono::steady_clock::now();
+
+    GLProgramCache  programCache;
+    initGLProgramCache(
+        programCache
+        , PROGRAM_CACHE_PREFIX
+    );
+
+    GLProgramOrigin programOrigin;
+    _scene.program = newCachedGLProgram(
+        programCache
+        , shaderProcs
+        , INSTANCED_VERTEX_SHADER
+        , INSTANCED_FRAGMENT_SHADER
+        , attributeLocations
+        , _recompile
+        , programOrigin
+    );
+    if( _scene.program == 0 ) {
+        return false;
+    }
+
+    std::printf(
+        "プログラムの準備: %.3fms(%s)\n"
+        , std::chrono::duration_cast< std::chrono::duration< double, std::milli > >( std::chrono::steady_clock::now() - PROGRAM_BEGIN ).count()
+        , toString( programOrigin )
+    );
+
+    CubeVertex  vertices[ CUBE_VERTEX_COUNT ];
+    setCubeVertices( vertices );
+
+    procs.genBuffers(
+        1
+        , &( _scene.vertexBuffer )
+    );
+    procs.bindBuffer(
+        GLEXT_ARRAY_BUFFER
+        , _scene.vertexBuffer
+    );
+    procs.bufferData(
+        GLEXT_ARRAY_BUFFER
+        , sizeof( vertices )
+        , vertices
+        , GLEXT_STATIC_DRAW
+    );
+
+    procs.genBuffers(
+        1
+        , &( _scene.instanceBuffer )
+    );
+
+    GLExtUInt   vertexArrays[ 2 ];
+    procs.genVertexArrays(
+        2
+        , vertexArrays
+    );
+    _scene.perObjectVertexArray = vertexArrays[ 0 ];
+    _scene.instancedVertexArray = vertexArrays[ 1 ];
+
+    for( const auto & VERTEX_ARRAY : vertexArrays ) {
+        procs.bindVertexArray( VERTEX_ARRAY );
+
+        procs.bindBuffer(
+            GLEXT_ARRAY_BUFFER
+            , _scene.vertexBuffer
+        );
+        procs.enableClientState( GLEXT_VERTEX_ARRAY );
+        procs.vertexPointer(
+            3
+            , GLEXT_FLOAT
+            , sizeof( CubeVertex )
+            , reinterpret_cast< const void * >( offsetof( CubeVertex, position ) )
+        );
+        procs.enableClientState( GLEXT_COLOR_ARRAY );
+        procs.colorPointer(
+            3
+            , GLEXT_FLOAT
+            , sizeof( CubeVertex )
+            , reinterpret_cast< const void * >( offsetof( CubeVertex, color ) )
+        );
+    }
+
+    // インスタンス描画用には、変換行列の列を1インスタンスごとに進む頂点属性として加える
+    procs.bindVertexArray( _scene.instancedVertexArray );
+    procs.bindBuffer(
+        GLEXT_ARRAY_BUFFER
+        , _scene.instanceBuffer
+    );
+    for( std::size_t i = 0 ; i < INSTANCE_ATTRIBUTE_COUNT ; i++ ) {
+        const auto  LOCATION = static_cast< GLExtUInt >( INSTANCE_ATTRIBUTE_LOCATION + i );
+
+        shaderProcs.enableVertexAttribArray( LOCATION );
+        shaderProcs.vertexAttribPointer(
+            LOCATION
+            , 4
+            , GLEXT_FLOAT
+            , 0
+            , sizeof( Mat4 )
+            , reinterpret_cast< const void * >( i * 4 * sizeof( dp::GLfloat ) )
+        );
+        shaderProcs.vertexAttribDivisor(
+            LOCATION
+            , 1
+        );
+    }
+
+    procs.bindVertexArray( 0 );
+    procs.bindBuffer(
+        GLEXT_ARRAY_BUFFER
+        , 0
+    );
+
+    dp::glViewport(
+        0
+        , 0
+        , WIDTH
+        , HEIGHT
+    );
+
+    dp::glEnable( dp::GL_DEPTH_TEST );
+    dp::glDepthFunc( dp::GL_LEQUAL );
+
+    dp::glClearColor(
+        0
+        , 0
+        , 0
+        , 0
+    );
+
+    dp::glMatrixMode( dp::GL_PROJECTION );
+
+    dp::glLoadIdentity();
+    dp::glFrustum(
+        -0.5
+        , 0.5
+        , -0.5
+        , 0.5
+        , 1
+        , 10
+    );
+    dp::glTranslatef(
+        0
+        , 0
+        , -5
+    );
+
+    dp::glMatrixMode( dp::GL_MODELVIEW );
+    dp::glLoadIdentity();
+
+    return true;
+}
+
+void uploadMatrices(
+    StressScene &   _scene
+)
+{
+    const auto &    PROCS = _scene.procs;
+    const auto &    MATRICES = _scene.matrices;
+
+    PROCS.bindBuffer(
+        GLEXT_ARRAY_BUFFER
+        , _scene.instanceBuffer
+    );
+    PROCS.bufferData(
+        GLEXT_ARRAY_BUFFER
+        , MATRICES.size() * sizeof( Mat4 )
+        , MATRICES.data()
+        , GLEXT_STATIC_DRAW
+    );
+    PROCS.bindBuffer(
+        GLEXT_ARRAY_BUFFER
+        , 0
+    );
+}
+
+dp::ULong drawImmediate(
+    const StressScene & _SCENE
+)
+{
+    const auto &    PROCS = _SCENE.procs;
+
+    for( const auto & MATRIX : _SCENE.matrices ) {
+        PROCS.pushMatrix();
+        PROCS.multMatrixf( MATRIX.elements );
+
+        dp::glBegin( dp::GL_TRIANGLES );
+
+        for( const auto & VERTEX : CUBE_VERTICES ) {
+            dp::glColor3f(
+                VERTEX[ 0 ] >= 0 ? VERTEX[ 0 ] : 0
+                , VERTEX[ 1 ] >= 0 ? VERTEX[ 1 ] : 0
+                , VERTEX[ 2 ] >= 0 ? VERTEX[ 2 ] : 0
+            );
+
+            dp::glVertex3f(
+                VERTEX[ 0 ]
+                , VERTEX[ 1 ]
+                , VERTEX[ 2 ]
+            );
+        }
+
+        dp::glEnd();
+
+        PROCS.popMatrix();
+    }
+
+    return _SCENE.matrices.size();
+}
+
+dp::ULong drawPerObject(
+    const StressScene & _SCENE
+)
+{
+    const auto &    PROCS = _SCENE.procs;
+
+    PROCS.bindVertexArray( _SCENE.perObjectVertexArray );
+
+    for( const auto & MATRIX : _SCENE.matrices ) {
+        PROCS.pushMatrix();
+        PROCS.multMatrixf( MATRIX.elements );
+
+        PROCS.drawArrays(
+            dp::GL_TRIANGLES
+            , 0
+            , static_cast< dp::GLsizei >( CUBE_VERTEX_COUNT )
+        );
+
+        PROCS.popMatrix();
+    }
+
+    PROCS.bindVertexArray( 0 );
+
+    return _SCENE.matrices.size();
+}
+
+dp::ULong drawInstanced(
+    const StressScene & _SCENE
+)
+{
+    const auto &    PROCS = _SCENE.procs;
+    const auto &    SHADER_PROCS = _SCENE.shaderProcs;
+
+    SHADER_PROCS.useProgram( _SCENE.program );
+    PROCS.bindVertexArray( _SCENE.instancedVertexArray );
+
+    SHADER_PROCS.drawArraysInstanced(
+        dp::GL_TRIANGLES
+        , 0
+        , static_cast< dp::GLsizei >( CUBE_VERTEX_COUNT )
+        , static_cast< dp::GLsizei >( _SCENE.matrices.size() )
+    );
+
+    PROCS.bindVertexArray( 0 );
+    SHADER_PROCS.useProgram( 0 );
+
+    return 1;
+}
+
+dp::ULong drawScene(
+    const StressScene & _SCENE
+    , DrawMode          _mode
+)
+{
+    switch( _mode ) {
+    case DrawMode::IMMEDIATE:
+        return drawImmediate( _SCENE );
+
+    case DrawMode::PER_OBJECT:
+        return drawPerObject( _SCENE );
+
+    case DrawMode::INSTANCED:
+        return drawInstanced( _SCENE );
+
+    default:
+        return 0;
+    }
+}
+
+dp::Bool dumpImage(
+    OffscreenGLContext &    _context
+    , DrawMode              _mode
+    , dp::UInt              _cubes
+)
+{
+    char    fileName[ 64 ];
+    std::snprintf(
+        fileName
+        , sizeof( fileName )
+        , DUMP_FILE_NAME_FORMAT
+        , toString( _mode )
+        , _cubes
+    );
+
+    dp::Utf32   filePath;
+    if( dp::toUtf32(
+        filePath
+        , fileName
+    ) == false ) {
+        std::printf( "ファイルパスの文字コード変換に失敗\n" );
+
+        return false;
+    }
+
+    return writeOffscreenGLImage(
+        _context
+        , filePath
+    );
+}
+
+// 最初のWARMUP_FRAMESフレームはドライバ内部の準備を含むため、計測から除く
+DrawResult measure(
+    OffscreenGLContext &    _context
+    , const StressScene &   _SCENE
+    , DrawMode              _mode
+    , dp::UInt              _frames
+)
+{
+    DrawResult  result;
+    result.drawCalls = 0;
+
+    auto    frameElapsed = std::chrono::steady_clock::duration::zero();
+    auto    submitElapsed = std::chrono::steady_clock::duration::zero();
+    for( dp::UInt i = 0 ; i < WARMUP_FRAMES + _frames ; i++ ) {
+        const auto  BEGIN = std::chrono::steady_clock::now();
+
+        dp::glClear(
+            dp::GL_COLOR_BUFFER_BIT |
+            dp::GL_DEPTH_BUFFER_BIT
+        );
+
+        result.drawCalls = drawScene(
+            _SCENE
+            , _mode
+        );
+
+        const auto  SUBMITTED = std::chrono::steady_clock::now();
+
+        finishOffscreenGLFrame( _context );
+
+        if( i >= WARMUP_FRAMES ) {
+            frameElapsed += std::chrono::steady_clock::now() - BEGIN;
+            submitElapsed += SUBMITTED - BEGIN;
+        }
+    }
+
+    result.frameSeconds = std::chrono::duration_cast< std::chrono::duration< double > >( frameElapsed ).count() / _frames;
+    result.submitSeconds = std::chrono::duration_cast< std::chrono::duration< double > >( submitElapsed ).count() / _frames;
+
+    return result;
+}
+
+dp::Bool benchmark(
+    OffscreenGLContext &    _context
+    , StressScene &         _scene
+    , dp::UInt              _cubes
+    , dp::UInt              _frames
+    , dp::Bool              _dump
+)
+{
+    generateMatrices(
+        _scene.matrices
+        , _cubes
+    );
+    uploadMatrices( _scene );
+
+    std::printf( "%u個:\n", _cubes );
+
+    for( const auto & MODE : DRAW_MODES ) {
+        const auto  RESULT = measure(
+            _context
+            , _scene
+            , MODE
+            , _frames
+        );
+
+        std::printf(
+            "  %-10s フレーム %9.3fms (CPU %9.3fms)  描画呼び出し %8llu回/フレーム %12.1f回/秒  %12.0f個/秒\n"
+            , toString( MODE )
+            , RESULT.frameSeconds * 1000
+            , RESULT.submitSeconds * 1000
+            , RESULT.drawCalls
+            , RESULT.drawCalls / RESULT.frameSeconds
+            , _cubes / RESULT.frameSeconds
+        );
+
+        if( _dump ) {
+            if( dumpImage(
+                _context
+                , MODE
+                , _cubes
+            ) == false ) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// 比較用に、SIMD命令を明示的に使わない実装を用意する
+void multiplyMat4Reference(
+    Mat4 &          _matrix
+    , const Mat4 &  _LEFT
+    , const Mat4 &  _RIGHT
+)
+{
+    for( std::size_t column = 0 ; column < 4 ; column++ ) {
+        for( std::size_t row = 0 ; row < 4 ; row++ ) {
+            dp::Float   sum = 0;
+            for( std::size_t i = 0 ; i < 4 ; i++ ) {
+                sum += _LEFT.elements[ i * 4 + row ] * _RIGHT.elements[ column * 4 + i ];
+            }
+
+            _matrix.elements[ column * 4 + row ] = sum;
+        }
+    }
+}
+
+void transformVec4Reference(
+    Vec4 &          _vector
+    , const Mat4 &  _MATRIX
+    , const Vec4 &  _VECTOR
+)
+{
+    for( std::size_t row = 0 ; row < 4 ; row++ ) {
+        dp::Float   sum = 0;
+        for( std::size_t i = 0 ; i < 4 ; i++ ) {
+            sum += _MATRIX.elements[ i * 4 + row ] * _VECTOR.elements[ i ];
+        }
+
+        _vector.elements[ row ] = sum;
+    }
+}
+
+// MATH_BENCH_REPEATS回実行し、最も短い時間(秒)を返す
+template< typename PROC_T >
+double measureBest(
+    PROC_T  _proc
+)
+{
+    auto    best = std::chrono::steady_clock::duration::max();
+    for( auto i = 0 ; i < MATH_BENCH_REPEATS ; i++ ) {
+        const auto  BEGIN = std::chrono::steady_clock::now();
+
+        _proc();
+
+        best = std::min(
+            best
+            , std::chrono::steady_clock::now() - BEGIN
+        );
+    }
+
+    return std::chrono::duration_cast< std::chrono::duration< double > >( best ).count();
+}
+
+dp::Float maxDifference(
+    const dp::Float *   _ELEMENTS1
+    , const dp::Float * _ELEMENTS2
+    , std::size_t       _count
+)
+{
+    dp::Float   difference = 0;
+    for( std::size_t i = 0 ; i < _count ; i++ ) {
+        difference = std::max(
+            difference
+            , std::abs( _ELEMENTS1[ i ] - _ELEMENTS2[ i ] )
+        );
+    }
+
+    return difference;
+}
+
+void printMathBench(
+    const char *    _NAME
+    , double        _referenceSeconds
+    , double        _simdSeconds
+    , dp::Float     _difference
+)
+{
+    std::printf(
+        "  %-10s 基準 %8.3fms (%5.2fns/個)  %s %8.3fms (%5.2fns/個)  %.2f倍  最大誤差 %g\n"
+        , _NAME
+        , _referenceSeconds * 1000
+        , _referenceSeconds * 1e9 / MATH_BENCH_COUNT
+        , getVecMathImplementation()
+        , _simdSeconds * 1000
+        , _simdSeconds * 1e9 / MATH_BENCH_COUNT
+        , _referenceSeconds / _simdSeconds
+        , _difference
+    );
+}
+
+// インスタンスの行列へビュー行列と投影行列をかける処理と、頂点の変換を計測する
+void benchmarkMath(
+)
+{
+    InstanceMatrices    models;
+    generateMatrices(
+        models
+        , MATH_BENCH_COUNT
+    );
+
+    Mat4    projection;
+    setMat4Perspective(
+        projection
+        , 3.14159265f / 3
+        , static_cast< dp::Float >( WIDTH ) / HEIGHT
+        , 1
+        , 10
+    );
+
+    Mat4    view;
+    setMat4Translation(
+        view
+        , 0
+        , 0
+        , -5
+    );
+
+    Mat4    viewProjection;
+    multiplyMat4(
+        viewProjection
+        , projection
+        , view
+    );
+
+    // 各インスタンスの原点
+    std::vector< Vec4 > positions( MATH_BENCH_COUNT );
+    for( std::size_t i = 0 ; i < MATH_BENCH_COUNT ; i++ ) {
+        std::copy(
+            models[ i ].elements + 12
+            , models[ i ].elements + 16
+            , positions[ i ].elements
+        );
+    }
+
+    std::printf( "%u個の変換、%u回中の最短:\n", MATH_BENCH_COUNT, MATH_BENCH_REPEATS );
+
+    InstanceMatrices    referenceMatrices( MATH_BENCH_COUNT );
+    InstanceMatrices    simdMatrices( MATH_BENCH_COUNT );
+
+    const auto  MATRIX_REFERENCE_SECONDS = measureBest(
+        [
+            &models
+            , &referenceMatrices
+            , &viewProjection
+        ]
+        {
+            for( std::size_t i = 0 ; i < MATH_BENCH_COUNT ; i++ ) {
+                multiplyMat4Reference(
+                    referenceMatrices[ i ]
+                    , viewProjection
+                    , models[ i ]
+                );
+            }
+        }
+    );
+    const auto  MATRIX_SIMD_SECONDS = measureBest(
+        [
+            &models
+            , &simdMatrices
+            , &viewProjection
+        ]
+        {
+            multiplyMat4Array(
+                simdMatrices.data()
+                , viewProjection
+                , models.data()
+                , MATH_BENCH_COUNT
+            );
+        }
+    );
+    printMathBench(
+        "行列の積"
+        , MATRIX_REFERENCE_SECONDS
+        , MATRIX_SIMD_SECONDS
+        , maxDifference(
+            referenceMatrices.data()->elements
+            , simdMatrices.data()->elements
+            , MATH_BENCH_COUNT * 16
+        )
+    );
+
+    std::vector< Vec4 > referenceVectors( MATH_BENCH_COUNT );
+    std::vector< Vec4 > simdVectors( MATH_BENCH_COUNT );
+
+    const auto  VECTOR_REFERENCE_SECONDS = measureBest(
+        [
+            &positions
+            , &referenceVectors
+            , &viewProjection
+        ]
+        {
+            for( std::size_t i = 0 ; i < MATH_BENCH_COUNT ; i++ ) {
+                transformVec4Reference(
+                    referenceVectors[ i ]
+                    , viewProjection
+                    , positions[ i ]
+                );
+            }
+        }
+    );
+    const auto  VECTOR_SIMD_SECONDS = measureBest(
+        [
+            &positions
+            , &simdVectors
+            , &viewProjection
+        ]
+        {
+            transformVec4Array(
+                simdVectors.data()
+                , viewProjection
+                , positions.data()
+                , MATH_BENCH_COUNT
+            );
+        }
+    );
+    printMathBench(
+        "ベクトル"
+        , VECTOR_REFERENCE_SECONDS
+        , VECTOR_SIMD_SECONDS
+        , maxDifference(
+            referenceVectors.data()->elements
+            , simdVectors.data()->elements
+            , MATH_BENCH_COUNT * 4
+        )
+    );
+}
+
+dp::Int dpMain(
+    dp::Args &  _args
+)
+{
+    std::vector< dp::UInt > cubeCounts;
+    dp::UInt                frames = DEFAULT_FRAMES;
+    dp::Bool                dump = false;
+    dp::Bool                recompile = false;
+    dp::Bool                mathBench = false;
+
+    for( std::size_t i = 1 ; i < _args.size() ; i++ ) {
+        dp::String  option;
+        dp::toString(
+            option
+            , _args[ i ]
+        );
+
+        dp::String  name;
+        dp::UInt    value;
+
+        if( option == "--dump" ) {
+            dump = true;
+
+            continue;
+        } else if( option == "--recompile" ) {
+            recompile = true;
+
+            continue;
+        } else if( option == "--math-bench" ) {
+            mathBench = true;
+
+            continue;
+        } else if( parseValueOption(
+            option
+            , name
+            , value
+        ) ) {
+            if( name == "--cubes" && value > 0 ) {
+                cubeCounts.push_back( value );
+
+                continue;
+            } else if( name == "--frames" && value > 0 ) {
+                frames = value;
+
+                continue;
+            }
+        }
+
+        dp::String  command;
+        dp::toString(
+            command
+            , _args[ 0 ]
+        );
+
+        std::printf( "使い方: %s [--cubes=個数...] [--frames=フレーム数] [--dump] [--recompile] [--math-bench]\n", command.c_str() );
+
+        return 1;
+    }
+
+    // GLを使用しないため、コンテキストを生成せずに終了する
+    if( mathBench ) {
+        benchmarkMath();
+
+        return 0;
+    }
+
+    if( cubeCounts.empty() ) {
+        cubeCounts.assign(
+            std::begin( DEFAULT_CUBES )
+            , std::end( DEFAULT_CUBES )
+        );
+    }
+
+    std::unique_ptr< OffscreenGLContext >   contextUnique(
+        newOffscreenGLContext(
+            WIDTH
+            , HEIGHT
+        )
+    );
+    if( contextUnique.get() == nullptr ) {
+        std::printf( "オフスクリーンのGLコンテキスト生成に失敗\n" );
+
+        return 1;
+    }
+    auto &  context = *contextUnique;
+
+    if( loadGLProcs() == false ) {
+        std::printf( "GL関数のロードに失敗\n" );
+
+        return 1;
+    }
+
+    const auto  INIT_BEGIN = std::chrono::steady_clock::now();
+
+    StressScene scene;
+    if( initScene(
+        scene
+        , recompile
+    ) == false ) {
+        return 1;
+    }
+
+    std::printf(
+        "シーンの初期化: %.3fms\n"
+        , std::chrono::duration_cast< std::chrono::duration< double, std::milli > >( std::chrono::steady_clock::now() - INIT_BEGIN ).count()
+    );
+
+    std::printf( "%s\n", reinterpret_cast< const char * >( scene.procs.getString( GLEXT_RENDERER ) ) );
+    std::printf( "%dx%d、%uフレームの平均\n", WIDTH, HEIGHT, frames );
+
+    for( const auto & CUBES : cubeCounts ) {
+        if( benchmark(
+            context
+            , scene
+            , CUBES
+            , frames
+            , dump
+        ) == false ) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+﻿#include "dp/cli.h"
+#include "dp/common/primitives.h"
+#include "dp/common/stringconverter.h"
+#include "dp/file/filer.h"
+
+#include "wav.h"
+#include "adpcm.h"
+#include "elapsed.h"
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+const auto  READ_FRAMES = 4096;
+const auto  DECODE_REPEATS = 10;
+
+typedef std::chrono::steady_clock   Clock;
+
+// 再生時と同じくREAD_FRAMESずつ読み込み、読み込みと展開にかかった時間を返す
+dp::Bool measureRead(
+    const dp::Utf32 &   _FILE_PATH
+    , Clock::duration & _elapsed
+)
+{
+    const auto  BEGIN = Clock::now();
+
+    WavReader   reader;
+    if( openWav(
+        _FILE_PATH
+        , reader
+    ) == false ) {
+        return false;
+    }
+
+    WaveData    buffer( READ_FRAMES * reader.frameSize );
+    while( 1 ) {
+        dp::ULong   size = buffer.size();
+        if( readWavData(
+            reader
+            , buffer.data()
+            , size
+        ) == false ) {
+            return false;
+        }
+
+        if( size <= 0 ) {
+            break;
+        }
+    }
+
+    _elapsed = Clock::now() - BEGIN;
+
+    return true;
+}
+
+// 波形データをメモリへ読み込んだ上で展開だけを繰り返し、1回あたりの展開時間を返す
+dp::Bool measureDecode(
+    WavReader &         _reader
+    , Clock::duration & _elapsed
+)
+{
+    WaveData    encodedData( _reader.encodedDataSize );
+
+    dp::ULong   size = encodedData.size();
+    if( dp::read(
+        *( _reader.fileUnique )
+        , encodedData.data()
+        , size
+    ) == false || size != encodedData.size() ) {
+        std::printf( "波形データの読み込みに失敗\n" );
+
+        return false;
+    }
+
+    const auto &    DECODER = _reader.decoder;
+
+    std::vector< std::int16_t > decodedBlock( DECODER.samplesPerBlock * _reader.channels );
+
+    const auto  BEGIN = Clock::now();
+
+    for( dp::Int i = 0 ; i < DECODE_REPEATS ; i++ ) {
+        for( std::size_t offset = 0 ; offset < encodedData.size() ; offset += DECODER.blockSize ) {
+            decodeAdpcmBlock(
+                DECODER
+                , encodedData.data() + offset
+                , std::min(
+                    encodedData.size() - offset
+                    , static_cast< std::size_t >( DECODER.blockSize )
+                )
+                , decodedBlock.data()
+            );
+        }
+    }
+
+    _elapsed = ( Clock::now() - BEGIN ) / DECODE_REPEATS;
+
+    return true;
+}
+
+dp::Bool benchmark(
+    const dp::Utf32 &   _FILE_PATH
+)
+{
+    WavReader   reader;
+    if( openWav(
+        _FILE_PATH
+        , reader
+    ) == false ) {
+        return false;
+    }
+
+    const auto  BYTES_PER_SECOND = static_cast< double >( reader.sampleRate ) * reader.frameSize;
+    const auto  SECONDS = reader.dataSize / BYTES_PER_SECOND;
+
+    std::printf( "長さ: %.2f秒\n", SECONDS );
+    std::printf( "展開後のサイズ: %llu\n", reader.dataSize );
+    std::printf( "ファイル上のサイズ: %llu (%.2f倍に圧縮)\n", reader.encodedDataSize, static_cast< double >( reader.dataSize ) / reader.encodedDataSize );
+    std::printf( "1ストリームあたりの読み込み量: %.1fKB/s (PCM比 %.1fKB/s削減)\n", reader.encodedDataSize / SECONDS / 1024, ( reader.dataSize - reader.encodedDataSize ) / SECONDS / 1024 );
+
+    Clock::duration readElapsed;
+    if( measureRead(
+        _FILE_PATH
+        , readElapsed
+    ) == false ) {
+        return false;
+    }
+    std::printf( "読み込み時間(展開込み): %.3fms (実時間比 %.0f倍)\n", toSeconds( readElapsed ) * 1000, SECONDS / toSeconds( readElapsed ) );
+
+    if( reader.compressed == false ) {
+        return true;
+    }
+
+    Clock::duration decodeElapsed;
+    if( measureDecode(
+        reader
+        , decodeElapsed
+    ) == false ) {
+        return false;
+    }
+
+    const auto  DECODE_SECONDS = toSeconds( decodeElapsed );
+
+    std::printf( "展開時間: %.3fms (1ストリーム1秒あたり %.1fus)\n", DECODE_SECONDS * 1000, DECODE_SECONDS / SECONDS * 1000000 );
+    std::printf( "1コアで展開可能なストリーム数(推定): %.0f\n", SECONDS / DECODE_SECONDS );
+
+    return true;
+}
+
+dp::Int dpMain(
+    dp::Args &  _args
+)
+{
+    if( _args.size() < 2 ) {
+        dp::String  command;
+        dp::toString(
+            command
+            , _args[ 0 ]
+        );
+
+        std::printf( "使い方: %s ファイルパス...\n", command.c_str() );
+
+        return 1;
+    }
+
+    for( std::size_t i = 1 ; i < _args.size() ; i++ ) {
+        dp::String  filePath;
+        dp::toString(
+            filePath
+            , _args[ i ]
+        );
+
+        std::printf( "%s\n", filePath.c_str() );
+
+        if( benchmark( _args[ i ] ) == false ) {
+            std::printf( "ファイルの解析に失敗\n" );
+        }
+
+        std::printf( "\n" );
+    }
+
+    return 0;
+}
@@ -0,0 +1,559 @@
+﻿#include "dp/cli.h"
+#include "dp/common/primitives.h"
+#include "dp/common/stringconverter.h"
+#include "dp/file/filew.h"
+
+#include "wav.h"
+#include "directory.h"
+#include "taskpool.h"
+#include "option.h"
+#include "elapsed.h"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+typedef std::chrono::steady_clock   Clock;
+
+// バイナリ形式の索引
+// 先頭にBINARY_MAGICとファイル数(4バイト)を置き、続けてファイルごとに以下を並べる
+// パスの長さ(2バイト)、パス、形式ID(2バイト)、チャンネル数(2バイト)、サンプリングレート(4バイト)、
+// ビット数(2バイト)、フレーム数(8バイト)、チャンク数(2バイト)、
+// チャンクごとの識別子(4バイト)、位置(8バイト)、サイズ(8バイト)
+// 値は全てリトルエンディアンとする
+const dp::Byte  BINARY_MAGIC[] = { 'W', 'S', 'C', '1' };
+
+struct ScanResult
+{
+    dp::String      path;
+    dp::UShort      formatId;
+    dp::UInt        channels;
+    dp::UInt        sampleRate;
+    dp::UInt        bitsPerSample;
+    dp::ULong       frames;
+    WavChunkInfos   chunks;
+};
+
+typedef std::vector< ScanResult > ScanResults;
+
+// 結果はワーカーごとに分けて集め、ロックを避ける
+struct ScanContext
+{
+    std::vector< ScanResults >  workerResults;
+
+    std::atomic< dp::ULong >    directories;
+    std::atomic< dp::ULong >    invalidFiles;
+
+    explicit ScanContext(
+        dp::UInt    _workers
+    )
+        : workerResults( _workers )
+        , directories( 0 )
+        , invalidFiles( 0 )
+    {
+    }
+};
+
+dp::Bool isWavFileName(
+    const dp::String &  _NAME
+)
+{
+    const dp::String    EXTENSION = ".wav";
+
+    if( _NAME.size() < EXTENSION.size() ) {
+        return false;
+    }
+
+    for( std::size_t i = 0 ; i < EXTENSION.size() ; i++ ) {
+        const auto  CHAR = _NAME[ _NAME.size() - EXTENSION.size() + i ];
+
+        if( ( CHAR >= 'A' && CHAR <= 'Z' ? CHAR - 'A' + 'a' : CHAR ) != EXTENSION[ i ] ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void scanFile(
+    ScanContext &           _context
+    , dp::UInt              _workerIndex
+    , const dp::String &    _PATH
+)
+{
+    dp::Utf32   path;
+    if( dp::toUtf32(
+        path
+        , _PATH
+    ) == false ) {
+        _context.invalidFiles.fetch_add( 1 );
+
+        return;
+    }
+
+    ScanResult  result;
+    result.path = _PATH;
+
+    WavScanInfo info;
+    if( scanWav(
+        path
+        , info
+    ) == false ) {
+        std::printf( "ヘッダの解析に失敗[%s]\n", _PATH.c_str() );
+
+        _context.invalidFiles.fetch_add( 1 );
+
+        return;
+    }
+
+    result.formatId = info.formatId;
+    result.channels = info.channels;
+    result.sampleRate = info.sampleRate;
+    result.bitsPerSample = info.bitsPerSample;
+    result.frames = info.frames;
+    result.chunks = std::move( info.chunks );
+
+    _context.workerResults[ _workerIndex ].push_back( std::move( result ) );
+}
+
+// サブディレクトリとファイルはそれぞれ別のタスクとして実行中のワーカーへ積み、
+// 手の空いたワーカーに奪わせる
+void scanDirectory(
+    TaskPool &              _pool
+    , ScanContext &         _context
+    , dp::UInt              _workerIndex
+    , const dp::String &    _PATH
+)
+{
+    DirectoryEntries    entries;
+    if( readDirectory(
+        _PATH
+        , entries
+    ) == false ) {
+        std::printf( "ディレクトリの読み込みに失敗[%s]\n", _PATH.c_str() );
+
+        return;
+    }
+
+    _context.directories.fetch_add( 1 );
+
+    for( const auto & ENTRY : entries ) {
+        const auto  PATH = joinPath(
+            _PATH
+            , ENTRY.name
+        );
+
+        if( ENTRY.directory ) {
+            pushTask(
+                _pool
+                , _workerIndex
+                , [
+                    &_context
+                    , PATH
+                ]
+                (
+                    TaskPool &  _pool
+                    , dp::UInt  _workerIndex
+                )
+                {
+                    scanDirectory(
+                        _pool
+                        , _context
+                        , _workerIndex
+                        , PATH
+                    );
+                }
+            );
+        } else if( isWavFileName( ENTRY.name ) ) {
+            pushTask(
+                _pool
+                , _workerIndex
+                , [
+                    &_context
+                    , PATH
+                ]
+                (
+                    TaskPool &
+                    , dp::UInt  _workerIndex
+                )
+                {
+                    scanFile(
+                        _context
+                        , _workerIndex
+                        , PATH
+                    );
+                }
+            );
+        }
+    }
+}
+
+void appendBytes(
+    dp::String &    _output
+    , const void *  _DATA
+    , std::size_t   _size
+)
+{
+    _output.append(
+        static_cast< const char * >( _DATA )
+        , _size
+    );
+}
+
+void appendValue(
+    dp::String &    _output
+    , dp::ULong     _value
+    , std::size_t   _size
+)
+{
+    for( std::size_t i = 0 ; i < _size ; i++ ) {
+        _output.push_back( static_cast< char >( _value >> ( i * 8 ) ) );
+    }
+}
+
+void toBinary(
+    dp::String &            _output
+    , const ScanResults &   _RESULTS
+)
+{
+    appendBytes(
+        _output
+        , BINARY_MAGIC
+        , sizeof( BINARY_MAGIC )
+    );
+    appendValue(
+        _output
+        , _RESULTS.size()
+        , 4
+    );
+
+    for( const auto & RESULT : _RESULTS ) {
+        appendValue(
+            _output
+            , RESULT.path.size()
+            , 2
+        );
+        appendBytes(
+            _output
+            , RESULT.path.data()
+            , RESULT.path.size()
+        );
+        appendValue(
+            _output
+            , RESULT.formatId
+            , 2
+        );
+        appendValue(
+            _output
+            , RESULT.channels
+            , 2
+        );
+        appendValue(
+            _output
+            , RESULT.sampleRate
+            , 4
+        );
+        appendValue(
+            _output
+            , RESULT.bitsPerSample
+            , 2
+        );
+        appendValue(
+            _output
+            , RESULT.frames
+            , 8
+        );
+        appendValue(
+            _output
+            , RESULT.chunks.size()
+            , 2
+        );
+
+        for( const auto & CHUNK : RESULT.chunks ) {
+            appendBytes(
+                _output
+                , CHUNK.tag
+                , sizeof( CHUNK.tag )
+            );
+            appendValue(
+                _output
+                , CHUNK.offset
+                , 8
+            );
+            appendValue(
+                _output
+                , CHUNK.size
+                , 8
+            );
+        }
+    }
+}
+
+// パスに区切り文字や引用符を含む場合は引用符で囲む
+void appendCsvField(
+    dp::String &            _output
+    , const dp::String &    _FIELD
+)
+{
+    if( _FIELD.find_first_of( ",\"\n" ) == dp::String::npos ) {
+        _output += _FIELD;
+
+        return;
+    }
+
+    _output += '"';
+    for( const auto CHAR : _FIELD ) {
+        if( CHAR == '"' ) {
+            _output += '"';
+        }
+        _output += CHAR;
+    }
+    _output += '"';
+}
+
+// チャンクの列は"識別子@位置+サイズ"を空白で区切る
+void toCsv(
+    dp::String &            _output
+    , const ScanResults &   _RESULTS
+)
+{
+    _output += "path,format_id,channels,sample_rate,bits_per_sample,frames,seconds,chunks\n";
+
+    char    buffer[ 256 ];
+    for( const auto & RESULT : _RESULTS ) {
+        appendCsvField(
+            _output
+            , RESULT.path
+        );
+
+        std::snprintf(
+            buffer
+            , sizeof( buffer )
+            , ",%u,%u,%u,%u,%llu,%.3f,"
+            , RESULT.formatId
+            , RESULT.channels
+            , RESULT.sampleRate
+            , RESULT.bitsPerSample
+            , RESULT.frames
+            , RESULT.sampleRate > 0 ? static_cast< double >( RESULT.frames ) / RESULT.sampleRate : 0
+        );
+        _output += buffer;
+
+        for( std::size_t i = 0 ; i < RESULT.chunks.size() ; i++ ) {
+            const auto &    CHUNK = RESULT.chunks[ i ];
+
+            std::snprintf(
+                buffer
+                , sizeof( buffer )
+                , "%s%.4s@%llu+%llu"
+                , i > 0 ? " " : ""
+                , reinterpret_cast< const char * >( CHUNK.tag )
+                , CHUNK.offset
+                , CHUNK.size
+            );
+            _output += buffer;
+        }
+
+        _output += '\n';
+    }
+}
+
+dp::Bool writeIndex(
+    const dp::String &      _FILE_PATH
+    , const dp::String &    _DATA
+)
+{
+    dp::Utf32   filePath;
+    if( dp::toUtf32(
+        filePath
+        , _FILE_PATH
+    ) == false ) {
+        return false;
+    }
+
+    auto    fileUnique = dp::unique( dp::newFileW( filePath ) );
+    if( fileUnique.get() == nullptr ) {
+        std::printf( "dp::FileWの生成に失敗\n" );
+
+        return false;
+    }
+
+    dp::ULong   size = _DATA.size();
+    if( dp::write(
+        *fileUnique
+        , _DATA.data()
+        , size
+    ) == false || size != _DATA.size() ) {
+        std::printf( "索引の書き込みに失敗\n" );
+
+        return false;
+    }
+
+    return true;
+}
+
+dp::Int dpMain(
+    dp::Args &  _args
+)
+{
+    dp::UInt    threads = 0;
+    dp::String  csvPath;
+    dp::String  binaryPath;
+
+    std::size_t argIndex = 1;
+    for( ; argIndex < _args.size() ; argIndex++ ) {
+        dp::String  option;
+        dp::toString(
+            option
+            , _args[ argIndex ]
+        );
+
+        dp::String  name;
+        dp::String  value;
+        if( parseValueOption(
+            option
+            , name
+            , value
+        ) == false ) {
+            break;
+        }
+
+        if( name == "--threads" ) {
+            threads = static_cast< dp::UInt >( std::atoi( value.c_str() ) );
+        } else if( name == "--csv" ) {
+            csvPath = value;
+        } else if( name == "--binary" ) {
+            binaryPath = value;
+        } else {
+            break;
+        }
+    }
+
+    if( argIndex >= _args.size() ) {
+        dp::String  command;
+        dp::toString(
+            command
+            , _args[ 0 ]
+        );
+
+        std::printf( "使い方: %s [--threads=スレッド数] [--csv=出力ファイルパス] [--binary=出力ファイルパス] ディレクトリ...\n", command.c_str() );
+
+        return 1;
+    }
+
+    std::unique_ptr< TaskPool > poolUnique( newTaskPool( threads ) );
+    auto &                      pool = *poolUnique;
+
+    const auto  WORKERS = getWorkerCount( pool );
+
+    ScanContext context( WORKERS );
+
+    const auto  BEGIN = Clock::now();
+
+    for( ; argIndex < _args.size() ; argIndex++ ) {
+        dp::String  path;
+        dp::toString(
+            path
+            , _args[ argIndex ]
+        );
+
+        pushTask(
+            pool
+            , static_cast< dp::UInt >( argIndex )
+            , [
+                &context
+                , path
+            ]
+            (
+                TaskPool &  _pool
+                , dp::UInt  _workerIndex
+            )
+            {
+                scanDirectory(
+                    _pool
+                    , context
+                    , _workerIndex
+                    , path
+                );
+            }
+        );
+    }
+
+    waitTaskPool( pool );
+
+    const auto  ELAPSED_SECONDS = toSeconds( Clock::now() - BEGIN );
+
+    ScanResults results;
+    for( auto & workerResults : context.workerResults ) {
+        std::move(
+            workerResults.begin()
+            , workerResults.end()
+            , std::back_inserter( results )
+        );
+    }
+    std::sort(
+        results.begin()
+        , results.end()
+        , [](
+            const ScanResult &      _RESULT1
+            , const ScanResult &    _RESULT2
+        )
+        {
+            return _RESULT1.path < _RESULT2.path;
+        }
+    );
+
+    const auto  FILES = results.size() + context.invalidFiles.load();
+
+    std::printf( "ワーカー数: %u\n", WORKERS );
+    std::printf( "ディレクトリ数: %llu\n", context.directories.load() );
+    std::printf( "ファイル数: %llu (解析に失敗: %llu)\n", static_cast< dp::ULong >( FILES ), context.invalidFiles.load() );
+    std::printf( "所要時間: %.3f秒\n", ELAPSED_SECONDS );
+    if( ELAPSED_SECONDS > 0 ) {
+        std::printf( "ファイル数毎秒: %.0f\n", FILES / ELAPSED_SECONDS );
+    }
+    for( dp::UInt i = 0 ; i < WORKERS ; i++ ) {
+        const auto &    WORKER = *( pool.workers[ i ] );
+
+        std::printf( "ワーカー[%u]: 実行したタスク数 %llu、奪ったタスク数 %llu\n", i, WORKER.executedTasks.load(), WORKER.stolenTasks.load() );
+    }
+
+    if( csvPath.empty() == false ) {
+        dp::String  csv;
+        toCsv(
+            csv
+            , results
+        );
+
+        if( writeIndex(
+            csvPath
+            , csv
+        ) == false ) {
+            return 1;
+        }
+    }
+
+    if( binaryPath.empty() == false ) {
+        dp::String  binary;
+        toBinary(
+            binary
+            , results
+        );
+
+        if( writeIndex(
+            binaryPath
+            , binary
+        ) == false ) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -4,6 +4,8 @@
 #include "dp/common/stringconverter.h"
 #include "dp/common/thread.h"
 
+#include "triplebuffer.h"
+
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -49,6 +51,21 @@ struct Bounds
     }
 };
 
+// 位置とサイズのイベントハンドラで更新し、描画のイベントハンドラから参照する
+// 更新はイベントハンドラ間でのみ排他し、描画側はロックを取らずに最新の状態を読み込む
+struct SharedBounds
+{
+    std::mutex              mutexForWrite;
+    Bounds                  bounds;     // 更新途中の状態。書き込み側のみ参照する
+    TripleBuffer< Bounds >  published;
+
+    SharedBounds(
+    )
+        : published( Bounds() )
+    {
+    }
+};
+
 dp::Bool generateTitle(
     dp::Utf32 &             _title
     , const dp::Utf32 &     _HEADER
@@ -140,8 +157,7 @@ void setTitle(
 
 dp::Window * newWindow(
     const dp::Utf32 &           _TITLE
-    , std::mutex &              _mutexForBounds
-    , Bounds &                  _bounds
+    , SharedBounds &            _bounds
     , const dp::StringChar *    _DESCRIPTION
     , std::mutex &              _mutexForClosed
     , std::condition_variable & _condForClosed
@@ -197,8 +213,7 @@ dp::Window * newWindow(
     dp::setPositionEventHandler(
         info
         , [
-            &_mutexForBounds
-            , &_bounds
+            &_bounds
             , titleString
         ]
         (
@@ -207,15 +222,19 @@ dp::Window * newWindow(
             , dp::Int       _y
         )
         {
-            std::unique_lock< std::mutex >  lock( _mutexForBounds );
+            std::unique_lock< std::mutex >  lock( _bounds.mutexForWrite );
+
+            auto &  bounds = _bounds.bounds;
 
-            _bounds.initializePosition = true;
-            _bounds.x = _x;
-            _bounds.y = _y;
+            bounds.initializePosition = true;
+            bounds.x = _x;
+            bounds.y = _y;
+
+            _bounds.published.write( bounds );
 
             setTitle(
                 _window
-                , _bounds
+                , bounds
                 , titleString
             );
         }
@@ -224,8 +243,7 @@ dp::Window * newWindow(
     dp::setSizeEventHandler(
         info
         , [
-            &_mutexForBounds
-            , &_bounds
+            &_bounds
             , titleString
         ]
         (
@@ -234,15 +252,19 @@ dp::Window * newWindow(
             , dp::Int       _height
         )
         {
-            std::unique_lock< std::mutex >  lock( _mutexForBounds );
+            std::unique_lock< std::mutex >  lock( _bounds.mutexForWrite );
+
+            auto &  bounds = _bounds.bounds;
+
+            bounds.initializeSize = true;
+            bounds.width = _width;
+            bounds.height = _height;
 
-            _bounds.initializeSize = true;
-            _bounds.width = _width;
-            _bounds.height = _height;
+            _bounds.published.write( bounds );
 
             setTitle(
                 _window
-                , _bounds
+                , bounds
                 , titleString
             );
         }
@@ -283,7 +305,8 @@ dp::Window * newWindow(
     dp::setPaintEventHandler(
         info
         , [
-            titleString
+            &_bounds
+            , titleString
         ]
         (
             dp::Window &    _window
@@ -293,12 +316,30 @@ dp::Window * newWindow(
             , dp::Int       _height
         )
         {
+            const auto &    BOUNDS = _bounds.published.read();
+            if( BOUNDS.initializePosition == false || BOUNDS.initializeSize == false ) {
+                std::printf(
+                    "paint %dx%d+%d+%d [%s]\n"
+                    , _width
+                    , _height
+                    , _x
+                    , _y
+                    , titleString.c_str()
+                );
+
+                return;
+            }
+
             std::printf(
-                "paint %dx%d+%d+%d [%s]\n"
+                "paint %dx%d+%d+%d in %dx%d+%d+%d [%s]\n"
                 , _width
                 , _height
                 , _x
                 , _y
+                , BOUNDS.width
+                , BOUNDS.height
+                , BOUNDS.x
+                , BOUNDS.y
                 , titleString.c_str()
             );
         }
@@ -312,8 +353,7 @@ dp::Window * newWindow(
 
 dp::Window * newWindow(
     const dp::Utf32 &           _TITLE
-    , std::mutex &              _mutexForBounds
-    , Bounds &                  _bounds
+    , SharedBounds &            _bounds
     , const dp::StringChar *    _DESCRIPTION
     , std::mutex &              _mutexForClosed
     , std::condition_variable & _condForClosed
@@ -322,7 +362,6 @@ dp::Window * newWindow(
 {
     return newWindow(
         _TITLE
-        , _mutexForBounds
         , _bounds
         , _DESCRIPTION
         , _mutexForClosed
@@ -345,8 +384,7 @@ dp::Window * newWindow(
 
 dp::Window * newWindow(
     const dp::Utf32 &           _TITLE
-    , std::mutex &              _mutexForBounds
-    , Bounds &                  _bounds
+    , SharedBounds &            _bounds
     , const dp::StringChar *    _DESCRIPTION
     , dp::WindowFlags           _flags
     , std::mutex &              _mutexForClosed
@@ -356,7 +394,6 @@ dp::Window * newWindow(
 {
     return newWindow(
         _TITLE
-        , _mutexForBounds
         , _bounds
         , _DESCRIPTION
         , _mutexForClosed
@@ -383,8 +420,7 @@ dp::Window * newWindow(
 
 dp::Window * newWindowWithPosition(
     const dp::Utf32 &           _TITLE
-    , std::mutex &              _mutexForBounds
-    , Bounds &                  _bounds
+    , SharedBounds &            _bounds
     , const dp::StringChar *    _DESCRIPTION
     , std::mutex &              _mutexForClosed
     , std::condition_variable & _condForClosed
@@ -393,7 +429,6 @@ dp::Window * newWindowWithPosition(
 {
     return newWindow(
         _TITLE
-        , _mutexForBounds
         , _bounds
         , _DESCRIPTION
         , _mutexForClosed
@@ -418,8 +453,7 @@ dp::Window * newWindowWithPosition(
 
 dp::Window * newWindowWithPosition(
     const dp::Utf32 &           _TITLE
-    , std::mutex &              _mutexForBounds
-    , Bounds &                  _bounds
+    , SharedBounds &            _bounds
     , const dp::StringChar *    _DESCRIPTION
     , dp::WindowFlags           _flags
     , std::mutex &              _mutexForClosed
@@ -429,7 +463,6 @@ dp::Window * newWindowWithPosition(
 {
     return newWindow(
         _TITLE
-        , _mutexForBounds
         , _bounds
         , _DESCRIPTION
         , _mutexForClosed
@@ -512,15 +545,13 @@ dp::Int dpMain(
         title = _args[ 1 ];
     }
 
-    std::mutex  mutexForNoneFlagsBounds;
-    Bounds      noneFlagsBounds;
+    SharedBounds    noneFlagsBounds;
     std::thread noneFlags(
         ThreadProc(
             mutex
             , cond
             , [
                 &title
-                , &mutexForNoneFlagsBounds
                 , &noneFlagsBounds
             ]
             (
@@ -531,7 +562,6 @@ dp::Int dpMain(
             {
                 return newWindow(
                     title
-                    , mutexForNoneFlagsBounds
                     , noneFlagsBounds
                     , "none WindowFlags"
                     , _mutex
@@ -543,15 +573,13 @@ dp::Int dpMain(
     );
     dp::ThreadJoiner    noneFlagsJoiner( &noneFlags );
 
-    std::mutex  mutexForPlainBounds;
-    Bounds      plainBounds;
+    SharedBounds    plainBounds;
     std::thread plain(
         ThreadProc(
             mutex
             , cond
             , [
                 &title
-                , &mutexForPlainBounds
                 , &plainBounds
             ]
             (
@@ -562,7 +590,6 @@ dp::Int dpMain(
             {
                 return newWindow(
                     title
-                    , mutexForPlainBounds
                     , plainBounds
                     , "PLAIN"
                     , _mutex
@@ -574,15 +601,13 @@ dp::Int dpMain(
     );
     dp::ThreadJoiner    plainJoiner( &plain );
 
-    std::mutex  mutexForUnresizableBounds;
-    Bounds      unresizableBounds;
+    SharedBounds    unresizableBounds;
     std::thread unresizable(
         ThreadProc(
             mutex
             , cond
             , [
                 &title
-                , &mutexForUnresizableBounds
                 , &unresizableBounds
             ]
             (
@@ -593,7 +618,6 @@ dp::Int dpMain(
             {
                 return newWindow(
                     title
-                    , mutexForUnresizableBounds
                     , unresizableBounds
                     , "UNRESIZABLE"
                     , dp::WindowFlags::UNRESIZABLE
@@ -606,15 +630,13 @@ dp::Int dpMain(
     );
     dp::ThreadJoiner    unresizableJoiner( &unresizable );
 
-    std::mutex  mutexForAlwaysOnTopBounds;
-    Bounds      alwaysOnTopBounds;
+    SharedBounds    alwaysOnTopBounds;
     std::thread alwaysOnTop(
         ThreadProc(
             mutex
             , cond
             , [
                 &title
-                , &mutexForAlwaysOnTopBounds
                 , &alwaysOnTopBounds
             ]
             (
@@ -625,7 +647,6 @@ dp::Int dpMain(
             {
                 return newWindow(
                     title
-                    , mutexForAlwaysOnTopBounds
                     , alwaysOnTopBounds
                     , "ALWAYS_ON_TOP"
                     , dp::WindowFlags::ALWAYS_ON_TOP
@@ -638,15 +659,13 @@ dp::Int dpMain(
     );
     dp::ThreadJoiner    alwaysOnTopJoiner( &alwaysOnTop );
 
-    std::mutex  mutexForNoneFlagsWithPositionBounds;
-    Bounds      noneFlagsWithPositionBounds;
+    SharedBounds    noneFlagsWithPositionBounds;
     std::thread noneFlagsWithPosition(
         ThreadProc(
             mutex
             , cond
             , [
                 &title
-                , &mutexForNoneFlagsWithPositionBounds
                 , &noneFlagsWithPositionBounds
             ]
             (
@@ -657,7 +676,6 @@ dp::Int dpMain(
             {
                 return newWindowWithPosition(
                     title
-                    , mutexForNoneFlagsWithPositionBounds
                     , noneFlagsWithPositionBounds
                     , "none WindowFlags with position"
                     , _mutex
@@ -669,15 +687,13 @@ dp::Int dpMain(
     );
     dp::ThreadJoiner    noneFlagsWithPositionJoiner( &noneFlagsWithPosition );
 
-    std::mutex  mutexForMultiFlagsWithPositionBounds;
-    Bounds      multiFlagsWithPositionBounds;
+    SharedBounds    multiFlagsWithPositionBounds;
     std::thread multiFlagsWithPosition(
         ThreadProc(
             mutex
             , cond
             , [
                 &title
-                , &mutexForMultiFlagsWithPositionBounds
                 , &multiFlagsWithPositionBounds
             ]
             (
@@ -688,7 +704,6 @@ dp::Int dpMain(
             {
                 return newWindowWithPosition(
                     title
-                    , mutexForMultiFlagsWithPositionBounds
                     , multiFlagsWithPositionBounds
                     , "UNRESIZABLE | ALWAYS_ON_TOP with position"
                     , dp::WindowFlags::UNRESIZABLE | dp::WindowFlags::ALWAYS_ON_TOP
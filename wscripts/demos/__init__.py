@@ -11,8 +11,17 @@ from . import keyboard
 from . import mouse
 
 from . import opengl_simple
+from . import opengl_stress
 
 from . import audiooutput_simple
+from . import audiomixer_simple
+from . import audiolatency_simple
+from . import wavdecode_simple
+from . import audiogain_simple
+from . import audiorender_simple
+from . import wavscan
+from . import audioseek_simple
+from . import audiohandoff_simple
 
 from . import readfile_simple
 from . import readfilesize_simple
@@ -34,8 +43,17 @@ def build( _ctx ):
     mouse.build( _ctx )
 
     opengl_simple.build( _ctx )
+    opengl_stress.build( _ctx )
 
     audiooutput_simple.build( _ctx )
+    audiomixer_simple.build( _ctx )
+    audiolatency_simple.build( _ctx )
+    wavdecode_simple.build( _ctx )
+    audiogain_simple.build( _ctx )
+    audiorender_simple.build( _ctx )
+    wavscan.build( _ctx )
+    audioseek_simple.build( _ctx )
+    audiohandoff_simple.build( _ctx )
 
     readfile_simple.build( _ctx )
     readfilesize_simple.build( _ctx )
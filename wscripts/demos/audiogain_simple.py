@@ -0,0 +1,26 @@
+# -*- coding: utf-8 -*-
+
+from wscripts import common
+
+import builder
+
+def build( _ctx ):
+    sources = {
+        'main',
+    }
+
+    commonSources = {
+        'gain',
+    }
+
+    libraries = {
+        common.generateLibraryName( 'common' ),
+    }
+
+    builder.build(
+        _ctx,
+        'audiogain_simple',
+        sources,
+        libraries = libraries,
+        commonSources = commonSources,
+    )
@@ -0,0 +1,32 @@
+# -*- coding: utf-8 -*-
+
+from wscripts import common
+
+import builder
+
+def build( _ctx ):
+    sources = {
+        'main',
+    }
+
+    commonSources = {
+        'audiooutput',
+        'realtimethread',
+        'wav',
+        'adpcm',
+        'option',
+    }
+
+    libraries = {
+        common.generateLibraryName( 'common' ),
+        common.generateLibraryName( 'audio' ),
+        common.generateLibraryName( 'file' ),
+    }
+
+    builder.build(
+        _ctx,
+        'audiolatency_simple',
+        sources,
+        libraries = libraries,
+        commonSources = commonSources,
+    )
@@ -0,0 +1,34 @@
+# -*- coding: utf-8 -*-
+
+from wscripts import common
+
+import builder
+
+def build( _ctx ):
+    sources = {
+        'main',
+    }
+
+    commonSources = {
+        'audiooutput',
+        'realtimethread',
+        'speaker',
+        'wav',
+        'adpcm',
+        'audioconvert',
+        'mixer',
+    }
+
+    libraries = {
+        common.generateLibraryName( 'common' ),
+        common.generateLibraryName( 'audio' ),
+        common.generateLibraryName( 'file' ),
+    }
+
+    builder.build(
+        _ctx,
+        'audiomixer_simple',
+        sources,
+        libraries = libraries,
+        commonSources = commonSources,
+    )
@@ -7,7 +7,21 @@ import builder
 def build( _ctx ):
     sources = {
         'main',
+    }
+
+    commonSources = {
+        'audiooutput',
+        'gain',
+        'realtimethread',
+        'speaker',
         'wav',
+        'adpcm',
+        'playeventrecorder',
+        'playlist',
+        'audioconvert',
+        'analyzer',
+        'fft',
+        'option',
     }
 
     libraries = {
@@ -21,4 +35,5 @@ def build( _ctx ):
         'audiooutput_simple',
         sources,
         libraries = libraries,
+        commonSources = commonSources,
     )
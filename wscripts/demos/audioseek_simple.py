@@ -0,0 +1,33 @@
+# -*- coding: utf-8 -*-
+
+from wscripts import common
+
+import builder
+
+def build( _ctx ):
+    sources = {
+        'main',
+    }
+
+    commonSources = {
+        'audiooutput',
+        'realtimethread',
+        'speaker',
+        'wav',
+        'adpcm',
+        'option',
+    }
+
+    libraries = {
+        common.generateLibraryName( 'common' ),
+        common.generateLibraryName( 'audio' ),
+        common.generateLibraryName( 'file' ),
+    }
+
+    builder.build(
+        _ctx,
+        'audioseek_simple',
+        sources,
+        libraries = libraries,
+        commonSources = commonSources,
+    )
@@ -9,6 +9,7 @@ def build(
     _sampleName,
     _sources,
     libraries = set(),
+    commonSources = set(),
 ):
     common.buildDemo(
         _ctx,
@@ -21,6 +22,8 @@ def build(
         _generateSources(
             _sampleName,
             _sources,
+        ) | _generateCommonSources(
+            commonSources,
         ),
         libraries,
     )
@@ -66,6 +69,19 @@ def _generateSources(
         for s in _sources
     }
 
+def _generateCommonSources(
+    _sources,
+):
+    return {
+        os.path.join(
+            common.DEMOS_DIR,
+            common.COMMON,
+            common.SOURCE_DIR,
+            s + '.cpp',
+        )
+        for s in _sources
+    }
+
 def _generateDemosBaseDir( _sampleName ):
     return os.path.join(
         common.DEMOS_DIR,
@@ -9,15 +9,35 @@ def build( _ctx ):
         'main',
     }
 
+    commonSources = {
+        'glext',
+        'offscreen',
+        'frameprofiler',
+        'frameclock',
+        'glstatecache',
+        'vecmath',
+        'option',
+    }
+
     libraries = {
         common.generateLibraryName( 'common' ),
         common.generateLibraryName( 'window' ),
         common.generateLibraryName( 'opengl' ),
+        common.generateLibraryName( 'file' ),
     }
 
+    # dp::gl*に含まれない関数を取得するため、GLのライブラリを直接リンクする
+    # オフスクリーン描画のコンテキストはEGLで生成する
+    if _ctx.osName == common.LINUX:
+        libraries.add( 'GL' )
+        libraries.add( 'EGL' )
+    elif _ctx.osName == common.WINDOWS:
+        libraries.add( 'opengl32' )
+
     builder.build(
         _ctx,
         'opengl_simple',
         sources,
         libraries = libraries,
+        commonSources = commonSources,
     )
@@ -0,0 +1,40 @@
+# -*- coding: utf-8 -*-
+
+from wscripts import common
+
+import builder
+
+def build( _ctx ):
+    sources = {
+        'main',
+    }
+
+    commonSources = {
+        'glext',
+        'glprogram',
+        'offscreen',
+        'vecmath',
+        'option',
+    }
+
+    libraries = {
+        common.generateLibraryName( 'common' ),
+        common.generateLibraryName( 'opengl' ),
+        common.generateLibraryName( 'file' ),
+    }
+
+    # dp::gl*に含まれない関数を取得するため、GLのライブラリを直接リンクする
+    # オフスクリーン描画のコンテキストはEGLで生成する
+    if _ctx.osName == common.LINUX:
+        libraries.add( 'GL' )
+        libraries.add( 'EGL' )
+    elif _ctx.osName == common.WINDOWS:
+        libraries.add( 'opengl32' )
+
+    builder.build(
+        _ctx,
+        'opengl_stress',
+        sources,
+        libraries = libraries,
+        commonSources = commonSources,
+    )
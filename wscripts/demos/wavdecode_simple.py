@@ -0,0 +1,29 @@
+# -*- coding: utf-8 -*-
+
+from wscripts import common
+
+import builder
+
+def build( _ctx ):
+    sources = {
+        'main',
+    }
+
+    commonSources = {
+        'wav',
+        'adpcm',
+        'elapsed',
+    }
+
+    libraries = {
+        common.generateLibraryName( 'common' ),
+        common.generateLibraryName( 'file' ),
+    }
+
+    builder.build(
+        _ctx,
+        'wavdecode_simple',
+        sources,
+        libraries = libraries,
+        commonSources = commonSources,
+    )
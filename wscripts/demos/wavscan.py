@@ -0,0 +1,32 @@
+# -*- coding: utf-8 -*-
+
+from wscripts import common
+
+import builder
+
+def build( _ctx ):
+    sources = {
+        'main',
+    }
+
+    commonSources = {
+        'wav',
+        'adpcm',
+        'directory',
+        'taskpool',
+        'option',
+        'elapsed',
+    }
+
+    libraries = {
+        common.generateLibraryName( 'common' ),
+        common.generateLibraryName( 'file' ),
+    }
+
+    builder.build(
+        _ctx,
+        'wavscan',
+        sources,
+        libraries = libraries,
+        commonSources = commonSources,
+    )